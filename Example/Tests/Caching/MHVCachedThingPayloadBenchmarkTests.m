@@ -0,0 +1,114 @@
+//
+// MHVCachedThingPayloadBenchmarkTests.m
+// MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+#import "MHVCachedThingPayload.h"
+#import "MHVThingInternal.h"
+#import "MHVThingTypes.h"
+#import "Kiwi.h"
+
+//
+// Cache read benchmarks, comparing the payload with the xml it replaced.
+// The default path deserializes the typed data, which is still xml inside the payload.
+// The deferred path only reads the thing's envelope.
+//
+
+static const NSUInteger c_benchmarkIterations = 2000;
+
+SPEC_BEGIN(MHVCachedThingPayloadBenchmarkTests)
+
+describe(@"Cached thing payload benchmarks", ^
+{
+    if (!MHV_BENCHMARKS_ENABLED)
+    {
+        return;
+    }
+
+    MHVThing *(^newThing)(void) = ^MHVThing *
+    {
+        MHVAllergy *allergy = [[MHVAllergy alloc] initWithName:@"Allergy to Nuts"];
+        NSMutableString *reaction = [NSMutableString new];
+        for (NSUInteger i = 0; i < 20; i++)
+        {
+            [reaction appendFormat:@"Reaction %lu. ", (unsigned long)i];
+        }
+        allergy.reaction = [[MHVCodableValue alloc] initWithText:reaction];
+
+        MHVThing *thing = [[MHVThing alloc] initWithTypedData:allergy];
+        thing.key = [[MHVThingKey alloc] initWithID:@"22222222-bbbb-2222-2222-222222222222" andVersion:@"3"];
+        thing.state = MHVThingStateActive;
+        thing.effectiveDate = [NSDate dateWithTimeIntervalSinceReferenceDate:500000000.5];
+        thing.created = [[MHVAudit alloc] init];
+        thing.created.when = [NSDate dateWithTimeIntervalSinceReferenceDate:400000000];
+        thing.created.appID = [[NSUUID alloc] initWithUUIDString:@"1AB6BD6A-2D68-4AF7-9C2E-4A7C1E4B9E21"];
+        thing.data.common.note = @"A note";
+
+        return thing;
+    };
+
+    // Microseconds per read
+    double (^measure)(MHVThing *(^)(void)) = ^double (MHVThing *(^read)(void))
+    {
+        NSUInteger failedCount = 0;
+        NSDate *start = [NSDate date];
+        for (NSUInteger i = 0; i < c_benchmarkIterations; i++)
+        {
+            @autoreleasepool
+            {
+                failedCount += read() ? 0 : 1;
+            }
+        }
+        NSTimeInterval duration = [[NSDate date] timeIntervalSinceDate:start];
+
+        [[theValue(failedCount) should] equal:theValue(0)];
+
+        return duration * 1000000 / c_benchmarkIterations;
+    };
+
+    it(@"should measure cache reads", ^
+       {
+           MHVThing *thing = newThing();
+           NSString *xml = [thing toXmlString];
+           NSData *data = [MHVCachedThingPayload dataWithThing:thing];
+
+           double xmlTyped = measure(^MHVThing *
+           {
+               MHVThing *read = [MHVThing newFromXmlString:xml deferData:NO];
+               return read.data.typed ? read : nil;
+           });
+           double payloadTyped = measure(^MHVThing *
+           {
+               MHVThing *read = [MHVCachedThingPayload newThingWithData:data deferData:NO];
+               return read.data.typed ? read : nil;
+           });
+           double xmlDeferred = measure(^MHVThing *
+           {
+               return [MHVThing newFromXmlString:xml deferData:YES];
+           });
+           double payloadDeferred = measure(^MHVThing *
+           {
+               return [MHVCachedThingPayload newThingWithData:data deferData:YES];
+           });
+
+           NSLog(@"Cached thing reads, xml %lu bytes, payload %lu bytes", (unsigned long)xml.length, (unsigned long)data.length);
+           NSLog(@"Typed data: xml %0.2f us, payload %0.2f us (%0.1fx)", xmlTyped, payloadTyped, xmlTyped / payloadTyped);
+           NSLog(@"Deferred data: xml %0.2f us, payload %0.2f us (%0.1fx)", xmlDeferred, payloadDeferred, xmlDeferred / payloadDeferred);
+       });
+});
+
+SPEC_END
@@ -0,0 +1,139 @@
+//
+// MHVCachedThingPayloadTests.m
+// MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+#import "MHVCachedThingPayload.h"
+#import "MHVThingInternal.h"
+#import "MHVThingTypes.h"
+#import "Kiwi.h"
+
+SPEC_BEGIN(MHVCachedThingPayloadTests)
+
+describe(@"MHVCachedThingPayload", ^
+{
+    MHVThing *(^newThing)(NSUInteger) = ^MHVThing *(NSUInteger reactionCount)
+    {
+        MHVAllergy *allergy = [[MHVAllergy alloc] initWithName:@"Allergy to Nuts"];
+        NSMutableString *reaction = [NSMutableString new];
+        for (NSUInteger i = 0; i < reactionCount; i++)
+        {
+            [reaction appendFormat:@"Reaction %lu. ", (unsigned long)i];
+        }
+        allergy.reaction = [[MHVCodableValue alloc] initWithText:reaction];
+
+        MHVThing *thing = [[MHVThing alloc] initWithTypedData:allergy];
+        thing.key = [[MHVThingKey alloc] initWithID:@"22222222-bbbb-2222-2222-222222222222" andVersion:@"3"];
+        thing.type.name = @"Allergy";
+        thing.state = MHVThingStateActive;
+        thing.flags = 2;
+        thing.effectiveDate = [NSDate dateWithTimeIntervalSinceReferenceDate:500000000.5];
+        thing.created = [[MHVAudit alloc] init];
+        thing.created.when = [NSDate dateWithTimeIntervalSinceReferenceDate:400000000];
+        thing.created.appID = [[NSUUID alloc] initWithUUIDString:@"1AB6BD6A-2D68-4AF7-9C2E-4A7C1E4B9E21"];
+        thing.created.personID = [[NSUUID alloc] initWithUUIDString:@"9C48A2B8-952C-4F5A-935D-F3292326BF54"];
+        thing.created.action = @"Created";
+        thing.data.common.note = @"A note";
+
+        return thing;
+    };
+
+    context(@"Round trip", ^
+            {
+                it(@"should restore the thing", ^
+                   {
+                       MHVThing *thing = newThing(1);
+
+                       NSData *data = [MHVCachedThingPayload dataWithThing:thing];
+                       MHVThing *decoded = [MHVCachedThingPayload newThingWithData:data deferData:NO];
+
+                       [[decoded.key.thingID should] equal:thing.key.thingID];
+                       [[decoded.key.version should] equal:@"3"];
+                       [[decoded.type.typeID should] equal:thing.type.typeID];
+                       [[decoded.type.name should] equal:@"Allergy"];
+                       [[theValue(decoded.state) should] equal:theValue(MHVThingStateActive)];
+                       [[theValue(decoded.flags) should] equal:theValue(2)];
+                       [[decoded.effectiveDate should] equal:thing.effectiveDate];
+                       [[decoded.created.when should] equal:thing.created.when];
+                       [[decoded.created.appID should] equal:thing.created.appID];
+                       [[decoded.created.personID should] equal:thing.created.personID];
+                       [[decoded.created.action should] equal:@"Created"];
+                       [[decoded.updated should] beNil];
+                       [[theValue(decoded.hasDeferredData) should] beNo];
+                       [[((MHVAllergy *)decoded.data.typed).name.text should] equal:@"Allergy to Nuts"];
+                       [[decoded.note should] equal:@"A note"];
+
+                       [[[decoded toXmlString] should] equal:[thing toXmlString]];
+                   });
+
+                it(@"should defer the data when asked", ^
+                   {
+                       NSData *data = [MHVCachedThingPayload dataWithThing:newThing(1)];
+                       MHVThing *decoded = [MHVCachedThingPayload newThingWithData:data deferData:YES];
+
+                       [[theValue(decoded.hasDeferredData) should] beYes];
+                       [[((MHVAllergy *)decoded.data.typed).name.text should] equal:@"Allergy to Nuts"];
+                   });
+
+                it(@"should encode deferred data without deserializing it", ^
+                   {
+                       MHVThing *deferred = [MHVThing newFromXmlString:[newThing(1) toXmlString] deferData:YES];
+
+                       NSData *data = [MHVCachedThingPayload dataWithThing:deferred];
+
+                       [[theValue(deferred.hasDeferredData) should] beYes];
+                       [[[[MHVCachedThingPayload newThingWithData:data deferData:NO] toXmlString] should] equal:[deferred toXmlString]];
+                   });
+
+                it(@"should be smaller than the xml for large data", ^
+                   {
+                       MHVThing *thing = newThing(200);
+
+                       NSData *data = [MHVCachedThingPayload dataWithThing:thing];
+                       NSUInteger xmlLength = [[thing toXmlString] lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+
+                       [[theValue(data.length) should] beLessThan:theValue(xmlLength / 2)];
+                       [[[[MHVCachedThingPayload newThingWithData:data deferData:NO] toXmlString] should] equal:[thing toXmlString]];
+                   });
+            });
+
+    context(@"Versions", ^
+            {
+                it(@"should skip fields it doesn't know", ^
+                   {
+                       NSMutableData *data = [[MHVCachedThingPayload dataWithThing:newThing(1)] mutableCopy];
+                       const uint8_t unknownField[] = { 200, 3, 'a', 'b', 'c' };
+                       [data appendBytes:unknownField length:sizeof(unknownField)];
+
+                       MHVThing *decoded = [MHVCachedThingPayload newThingWithData:data deferData:NO];
+
+                       [[decoded.key.version should] equal:@"3"];
+                   });
+
+                it(@"should reject newer versions and truncated payloads", ^
+                   {
+                       NSMutableData *data = [[MHVCachedThingPayload dataWithThing:newThing(1)] mutableCopy];
+
+                       [[[MHVCachedThingPayload newThingWithData:[data subdataWithRange:NSMakeRange(0, data.length - 1)] deferData:YES] should] beNil];
+
+                       ((uint8_t *)data.mutableBytes)[0] = 2;
+                       [[[MHVCachedThingPayload newThingWithData:data deferData:YES] should] beNil];
+                   });
+            });
+});
+
+SPEC_END
@@ -0,0 +1,317 @@
+//
+// MHVThingClientBlobResumeTests.m
+// MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import "MHVThingClient.h"
+#import "MHVConnectionProtocol.h"
+#import "MHVMethod.h"
+#import "MHVFile.h"
+#import "MHVBlobUploadRequest.h"
+#import "MHVBlobSource.h"
+#import "MHVPendingBlobUploadStore.h"
+#import "MHVErrorConstants.h"
+#import "NSError+MHVError.h"
+#import "MHVServiceResponse.h"
+#import "MHVHttpServiceResponse.h"
+#import "NSArray+MHVThing.h"
+#import "Kiwi.h"
+
+@interface MHVPendingBlobUploadStore (Testing)
+
+@property (nonatomic, strong) dispatch_queue_t ioQueue;
+
+@end
+
+static NSUInteger const kChunkSize = 123456;
+
+// Stand-in chunk digests for the length stored; the upload itself checks them against the blob
+static NSData *MHVChunkDigests(NSUInteger committedLength)
+{
+    return [NSMutableData dataWithLength:(committedLength + kChunkSize - 1) / kChunkSize * 32];
+}
+
+static MHVServiceResponse *MHVXmlResponse(NSString *xml)
+{
+    MHVHttpServiceResponse *response = [[MHVHttpServiceResponse alloc] initWithResponseData:[xml dataUsingEncoding:NSUTF8StringEncoding]
+                                                                                statusCode:0];
+
+    return [[MHVServiceResponse alloc] initWithWebResponse:response isXML:YES];
+}
+
+SPEC_BEGIN(MHVThingClientBlobResumeTests)
+
+describe(@"MHVThingClient", ^
+{
+    // Requests made through the mock connection
+    __block NSUInteger beginPutBlobCount;
+    __block NSMutableArray<MHVBlobUploadRequest *> *uploadRequests;
+    __block NSUInteger putThingsCount;
+
+    // Responses the mock connection gives to each blob upload, in order
+    __block NSMutableArray<NSError *> *uploadErrors;
+    __block NSUInteger uploadCommittedLength;
+    __block BOOL isSignedOutDuringUpload;
+
+    __block NSURL *directoryURL;
+    __block MHVPendingBlobUploadStore *store;
+    __block MHVThingClient *thingClient;
+    __block MHVThing *resultThing;
+    __block NSError *resultError;
+    __block BOOL isFinished;
+
+    NSUUID *recordId = [[NSUUID alloc] initWithUUIDString:@"20000000-2000-2000-2000-200000000000"];
+    NSMutableData *blobData = [NSMutableData dataWithLength:kChunkSize * 3 + 10];
+    MHVBlobMemorySource *blobSource = [[MHVBlobMemorySource alloc] initWithData:blobData];
+
+    KWMock<MHVConnectionProtocol> *mockConnection = [KWMock mockForProtocol:@protocol(MHVConnectionProtocol)];
+    [mockConnection stub:@selector(executeHttpServiceOperation:completion:) withBlock:^id (NSArray *params)
+     {
+         void (^completion)(MHVServiceResponse *_Nullable response, NSError *_Nullable error) = params[1];
+
+         if ([params[0] isKindOfClass:[MHVBlobUploadRequest class]])
+         {
+             MHVBlobUploadRequest *request = params[0];
+             [uploadRequests addObject:request];
+
+             if (isSignedOutDuringUpload)
+             {
+                 [store removeAllUploads];
+             }
+
+             NSError *error = uploadErrors.firstObject;
+             if (error)
+             {
+                 [uploadErrors removeObjectAtIndex:0];
+                 request.committedLengthHandler(uploadCommittedLength, MHVChunkDigests(uploadCommittedLength));
+                 completion(nil, error);
+             }
+             else
+             {
+                 request.committedLengthHandler(blobData.length, MHVChunkDigests(blobData.length));
+                 completion([MHVServiceResponse new], nil);
+             }
+         }
+         else if ([((MHVMethod *)params[0]).name isEqualToString:@"BeginPutBlob"])
+         {
+             beginPutBlobCount += 1;
+             completion(MHVXmlResponse([NSString stringWithFormat:@"<response><status><code>0</code></status><wc:info xmlns:wc=\"urn:com.microsoft.wc.methods.response.BeginPutBlob\"><blob-ref-url>https://platform.healthvault-ppe.com/streaming/wildcatblob.ashx?blob-ref-token=TOKEN%lu</blob-ref-url><blob-chunk-size>%lu</blob-chunk-size><max-blob-size>1073741824</max-blob-size></wc:info></response>", (unsigned long)beginPutBlobCount, (unsigned long)kChunkSize]), nil);
+         }
+         else
+         {
+             putThingsCount += 1;
+             completion(MHVXmlResponse(@"<response><status><code>0</code></status><wc:info xmlns:wc=\"urn:com.microsoft.wc.methods.response.PutThings\"><thing-id version-stamp=\"11111111-1111-1111-1111-111111111111\">22222222-2222-2222-2222-222222222222</thing-id></wc:info></response>"), nil);
+         }
+
+         return nil;
+     }];
+
+    // Adds the blob source to a new file thing, waiting for the result
+    void (^addBlobSource)(id<MHVBlobSourceProtocol>) = ^(id<MHVBlobSourceProtocol> source)
+    {
+        isFinished = NO;
+
+        [thingClient addBlobSource:source
+                           toThing:[MHVFile newThingWithName:@"FileName" andContentType:@"content/type"]
+                              name:nil
+                       contentType:@"text/text"
+                          recordId:recordId
+                        completion:^(MHVThing *_Nullable thing, NSError *_Nullable error)
+         {
+             resultThing = thing;
+             resultError = error;
+             isFinished = YES;
+         }];
+
+        [[expectFutureValue(theValue(isFinished)) shouldEventually] beYes];
+
+        dispatch_sync(store.ioQueue, ^{ });
+    };
+
+    void (^addBlob)(void) = ^
+    {
+        addBlobSource(blobSource);
+    };
+
+    NSString *(^key)(void) = ^
+    {
+        return [MHVPendingBlobUploadStore keyForBlobSource:blobSource name:@"" thingId:nil recordId:recordId];
+    };
+
+    beforeEach(^
+    {
+        beginPutBlobCount = 0;
+        uploadRequests = [NSMutableArray new];
+        putThingsCount = 0;
+        uploadErrors = [NSMutableArray new];
+        uploadCommittedLength = 0;
+        isSignedOutDuringUpload = NO;
+        resultThing = nil;
+        resultError = nil;
+
+        directoryURL = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:[NSUUID UUID].UUIDString isDirectory:YES];
+        store = [[MHVPendingBlobUploadStore alloc] initWithDirectoryURL:directoryURL];
+
+        thingClient = [[MHVThingClient alloc] initWithConnection:mockConnection cache:nil blobUploadStore:store];
+    });
+
+    afterEach(^
+    {
+        [[NSFileManager defaultManager] removeItemAtURL:directoryURL error:nil];
+    });
+
+    context(@"Resume", ^
+            {
+                it(@"should keep the committed length when the connection is lost", ^
+                   {
+                       uploadCommittedLength = kChunkSize * 2;
+                       [uploadErrors addObject:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil]];
+
+                       addBlob();
+
+                       [[resultError should] beNonNil];
+                       [[theValue([store uploadForKey:key()].committedLength) should] equal:theValue(kChunkSize * 2)];
+                   });
+
+                it(@"should not keep an upload that was in progress when every upload was removed", ^
+                   {
+                       uploadCommittedLength = kChunkSize * 2;
+                       isSignedOutDuringUpload = YES;
+                       [uploadErrors addObject:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil]];
+
+                       addBlob();
+
+                       [[resultError should] beNonNil];
+                       [[[store uploadForKey:key()] should] beNil];
+                   });
+
+                it(@"should continue from the committed length without beginning a new upload", ^
+                   {
+                       uploadCommittedLength = kChunkSize * 2;
+                       [uploadErrors addObject:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil]];
+                       addBlob();
+
+                       addBlob();
+
+                       [[expectFutureValue(resultError) shouldEventually] beNil];
+                       [[theValue(beginPutBlobCount) should] equal:theValue(1)];
+                       [[theValue(uploadRequests.lastObject.startOffset) should] equal:theValue(kChunkSize * 2)];
+                       [[theValue(putThingsCount) should] equal:theValue(1)];
+                       [[theValue([resultThing.blobs.getDefaultBlob.blobUrl hasSuffix:@"TOKEN1"]) should] beYes];
+                       [[expectFutureValue([store uploadForKey:key()]) shouldEventually] beNil];
+                   });
+
+                it(@"should only check and attach the blob when it was stored before the connection was lost", ^
+                   {
+                       uploadCommittedLength = blobData.length;
+                       [uploadErrors addObject:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorTimedOut userInfo:nil]];
+                       addBlob();
+
+                       addBlob();
+
+                       [[expectFutureValue(resultError) shouldEventually] beNil];
+                       [[theValue(beginPutBlobCount) should] equal:theValue(1)];
+                       [[theValue(uploadRequests.lastObject.startOffset) should] equal:theValue(blobData.length)];
+                       [[uploadRequests.lastObject.storedChunkDigests should] equal:MHVChunkDigests(blobData.length)];
+                       [[theValue(putThingsCount) should] equal:theValue(1)];
+                   });
+
+                it(@"should not continue an upload kept without chunk digests", ^
+                   {
+                       uploadCommittedLength = kChunkSize * 2;
+                       [uploadErrors addObject:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil]];
+                       addBlob();
+
+                       MHVPendingBlobUpload *upload = [store uploadForKey:key()];
+                       upload.chunkDigests = [NSData data];
+                       [store setUpload:upload];
+                       dispatch_sync(store.ioQueue, ^{ });
+
+                       [[[store uploadForKey:key()] should] beNil];
+                   });
+
+                it(@"should start again when blob storage refuses the resumed upload", ^
+                   {
+                       uploadCommittedLength = kChunkSize;
+                       [uploadErrors addObject:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil]];
+                       [uploadErrors addObject:[NSError MHVOperationCannotBePerformed]];
+                       addBlob();
+
+                       addBlob();
+
+                       [[expectFutureValue(resultError) shouldEventually] beNil];
+                       [[theValue(beginPutBlobCount) should] equal:theValue(2)];
+                       [[theValue(uploadRequests.lastObject.startOffset) should] equal:theValue(0)];
+                       [[theValue([resultThing.blobs.getDefaultBlob.blobUrl hasSuffix:@"TOKEN2"]) should] beYes];
+                   });
+
+                it(@"should not resume a failed upload that wasn't resumed", ^
+                   {
+                       [uploadErrors addObject:[NSError MHVOperationCannotBePerformed]];
+
+                       addBlob();
+
+                       [[resultError should] beNonNil];
+                       [[theValue(beginPutBlobCount) should] equal:theValue(1)];
+                       [[expectFutureValue([store uploadForKey:key()]) shouldEventually] beNil];
+                   });
+            });
+
+    context(@"Stream source", ^
+            {
+                // Can only be read once, so a failed upload can't be sent again from the start
+                MHVBlobStreamSource *(^streamSource)(void) = ^
+                {
+                    return [[MHVBlobStreamSource alloc] initWithInputStream:[NSInputStream inputStreamWithData:blobData] length:blobData.length];
+                };
+
+                it(@"should fail without starting again when the upload fails part way", ^
+                   {
+                       uploadCommittedLength = kChunkSize;
+                       [uploadErrors addObject:[NSError MHVOperationCannotBePerformed]];
+
+                       addBlobSource(streamSource());
+
+                       [[resultError should] beNonNil];
+                       [[theValue(beginPutBlobCount) should] equal:theValue(1)];
+                       [[theValue(uploadRequests.count) should] equal:theValue(1)];
+                       [[theValue(putThingsCount) should] equal:theValue(0)];
+                   });
+
+                it(@"should not keep the upload when the connection is lost part way", ^
+                   {
+                       uploadCommittedLength = kChunkSize * 2;
+                       [uploadErrors addObject:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNetworkConnectionLost userInfo:nil]];
+
+                       addBlobSource(streamSource());
+
+                       [[resultError should] beNonNil];
+                       [[theValue(uploadRequests.count) should] equal:theValue(1)];
+                       [[[store uploadForKey:key()] should] beNil];
+
+                       // Given the blob again, the upload begins again from the start
+                       addBlobSource(streamSource());
+
+                       [[expectFutureValue(resultError) shouldEventually] beNil];
+                       [[theValue(beginPutBlobCount) should] equal:theValue(2)];
+                       [[theValue(uploadRequests.lastObject.startOffset) should] equal:theValue(0)];
+                   });
+            });
+});
+
+SPEC_END
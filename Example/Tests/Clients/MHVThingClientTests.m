@@ -27,7 +27,15 @@
 #import "MHVBlobDownloadRequest.h"
 #import "MHVErrorConstants.h"
 #import "MHVThingCacheProtocol.h"
+#import "MHVCryptographer.h"
 #import "Kiwi.h"
+#import <malloc/malloc.h>
+
+@interface MHVThingClient (Tests)
+
+- (NSData *)bodyForThingCollection:(NSArray<MHVThing *> *)things hash:(NSString **)hash;
+
+@end
 
 SPEC_BEGIN(MHVThingClientTests)
 
@@ -165,6 +173,31 @@ describe(@"MHVThingClient", ^
                                    "<format><section>core</section><xml/></format></group></info>"]) should] beYes];
                    });
                 
+                it(@"should send interactive queries at interactive priority", ^
+                   {
+                       MHVThingQuery *query = [MHVThingQuery new];
+                       query.isInteractive = YES;
+                       
+                       [thingClient getThingsForThingClass:[MHVAllergy class]
+                                                     query:query
+                                                  recordId:recordId
+                                                completion:^(MHVThingQueryResult *_Nullable result, NSError *_Nullable error) { }];
+                       
+                       [[theValue(requestedServiceOperation.priority) should] equal:theValue(MHVRequestPriorityInteractive)];
+                   });
+                
+                it(@"should send other queries at the client's priority", ^
+                   {
+                       thingClient.priority = MHVRequestPriorityBackgroundSync;
+                       
+                       [thingClient getThingsForThingClass:[MHVAllergy class]
+                                                     query:[MHVThingQuery new]
+                                                  recordId:recordId
+                                                completion:^(MHVThingQueryResult *_Nullable result, NSError *_Nullable error) { }];
+                       
+                       [[theValue(requestedServiceOperation.priority) should] equal:theValue(MHVRequestPriorityBackgroundSync)];
+                   });
+                
                 it(@"should fail if thing id is nil", ^
                    {
                        __block NSError *requestError;
@@ -228,6 +261,67 @@ describe(@"MHVThingClient", ^
                         "<type-id>52bf9104-2c5e-4f1f-a66d-552ebcc53df7</type-id><flags>0</flags><data-xml>"\
                         "<allergy><name><text>Bees</text></name><reaction><text>Itching</text></reaction></allergy><common/></data-xml></thing></info>"];
                    });
+                
+                it(@"should hash the body while writing it", ^
+                   {
+                       [thingClient createNewThing:allergyThing
+                                          recordId:recordId
+                                        completion:^(MHVThingKey *_Nullable thingKey, NSError *error) { }];
+                       
+                       MHVMethod *method = (MHVMethod *)requestedServiceOperation;
+                       
+                       [[method.parametersHash should] equal:[[MHVCryptographer new] computeSha256HashOfData:method.parametersData]];
+                   });
+                
+                it(@"should build large bodies with fewer allocations than through strings", ^
+                   {
+                       NSMutableArray<MHVThing *> *things = [NSMutableArray new];
+                       for (NSUInteger i = 0; i < 1000; i++)
+                       {
+                           [things addObject:allergyThing];
+                       }
+                       
+                       malloc_statistics_t before;
+                       malloc_statistics_t after;
+                       
+                       // Reference: the previous path, string copies all the way to the HTTP body
+                       NSUInteger referenceBytes;
+                       NSData *referenceBody;
+                       @autoreleasepool
+                       {
+                           malloc_zone_statistics(NULL, &before);
+                           
+                           XWriter *writer = [[XWriter alloc] initWithBufferSize:2048];
+                           [writer writeStartElement:@"info"];
+                           for (MHVThing *thing in things)
+                           {
+                               [XSerializer serialize:thing withRoot:@"thing" toWriter:writer];
+                           }
+                           [writer writeEndElement];
+                           
+                           NSMutableString *message = [NSMutableString new];
+                           [message appendString:[writer newXmlString]];
+                           referenceBody = [message dataUsingEncoding:NSUTF8StringEncoding];
+                           
+                           malloc_zone_statistics(NULL, &after);
+                           referenceBytes = after.size_in_use - before.size_in_use;
+                       }
+                       
+                       NSUInteger bytes;
+                       NSData *body;
+                       @autoreleasepool
+                       {
+                           malloc_zone_statistics(NULL, &before);
+                           
+                           body = [thingClient bodyForThingCollection:things hash:NULL];
+                           
+                           malloc_zone_statistics(NULL, &after);
+                           bytes = after.size_in_use - before.size_in_use;
+                       }
+                       
+                       [[body should] equal:referenceBody];
+                       [[theValue(bytes) should] beLessThan:theValue(referenceBytes)];
+                   });
             });
 
     context(@"DeleteThings", ^
@@ -246,7 +340,43 @@ describe(@"MHVThingClient", ^
                        [[method.parameters should] equal:@"<info><thing-id version-stamp=\"AllergyVersion\">AllergyThingKey</thing-id></info>"];
                    });
             });
-    
+
+    context(@"GetRecordOperations", ^
+            {
+                __block MHVGetRecordOperationsResult *operationsResult;
+
+                beforeEach(^
+                {
+                    NSString *response = @"<response><status><code>0</code></status><wc:info xmlns:wc=\"urn:com.microsoft.wc.methods.response.GetRecordOperations\">"\
+                                          "<latest-record-operation-sequence-number>42</latest-record-operation-sequence-number></wc:info></response>";
+
+                    MHVHttpServiceResponse *httpResponse = [[MHVHttpServiceResponse alloc] initWithResponseData:[response dataUsingEncoding:NSUTF8StringEncoding]
+                                                                                                     statusCode:0];
+
+                    serviceResponse = [[MHVServiceResponse alloc] initWithWebResponse:httpResponse isXML:YES];
+
+                    [thingClient getRecordOperations:0
+                                            recordId:recordId
+                                          completion:^(MHVGetRecordOperationsResult *_Nullable result, NSError *_Nullable error)
+                     {
+                         operationsResult = result;
+                         requestError = error;
+                     }];
+                });
+
+                it(@"should read the info directly from the response data", ^
+                   {
+                       [[requestError should] beNil];
+                       [[theValue(operationsResult.latestRecordOperationSequenceNumber) should] equal:theValue(42)];
+                   });
+
+                it(@"should still provide the info xml", ^
+                   {
+                       [[theValue([serviceResponse.infoXml hasPrefix:@"<wc:info"]) should] beYes];
+                       [[theValue([serviceResponse.infoXml containsString:@"<latest-record-operation-sequence-number>42</latest-record-operation-sequence-number>"]) should] beYes];
+                   });
+            });
+
     context(@"when getThingsWithQueries is called with multiple queries that have various cache requirements and is successful", ^
             {
                 __block NSArray<MHVThingQuery *> *queries;
@@ -316,7 +446,73 @@ describe(@"MHVThingClient", ^
                        [[expectFutureValue(queries[3].name) shouldEventually] equal:resultsCollection[3].name];
                    });
             });
+
     
+    context(@"when getThingsWithQuery is called several times with a batching interval", ^
+            {
+                __block NSInteger requestCount;
+                __block MHVMethod *batchedMethod;
+                __block NSMutableDictionary<NSString *, MHVThingQueryResult *> *resultsByCaller;
+                
+                KWMock<MHVConnectionProtocol> *batchingConnection = [KWMock mockForProtocol:@protocol(MHVConnectionProtocol)];
+                [batchingConnection stub:@selector(executeHttpServiceOperation:completion:) withBlock:^id(NSArray *params)
+                {
+                    requestCount++;
+                    batchedMethod = params[0];
+                    
+                    NSString *response = @"<response><status><code>0</code></status><wc:info xmlns:wc=\"urn:com.microsoft.wc.methods.response.GetThings3\">"\
+                                          "<group name=\"second\"></group><group name=\"first\"></group><group name=\"third\"></group></wc:info></response>";
+                    MHVHttpServiceResponse *httpResponse = [[MHVHttpServiceResponse alloc] initWithResponseData:[response dataUsingEncoding:NSUTF8StringEncoding]
+                                                                                                     statusCode:0];
+                    
+                    void (^completion)(MHVServiceResponse *_Nullable response, NSError *_Nullable error) = params[1];
+                    completion([[MHVServiceResponse alloc] initWithWebResponse:httpResponse isXML:YES], nil);
+                    return nil;
+                }];
+                
+                beforeEach(^
+                {
+                    requestCount = 0;
+                    batchedMethod = nil;
+                    resultsByCaller = [NSMutableDictionary new];
+                    
+                    MHVThingClient *batchingClient = [[MHVThingClient alloc] initWithConnection:batchingConnection cache:nil];
+                    batchingClient.queryBatchInterval = 0.05;
+                    
+                    for (NSString *name in @[@"first", @"second", @"third"])
+                    {
+                        MHVThingQuery *query = [MHVThingQuery new];
+                        query.name = name;
+                        query.shouldUseCachedResults = NO;
+                        
+                        [batchingClient getThingsWithQuery:query
+                                                  recordId:recordId
+                                                completion:^(MHVThingQueryResult *_Nullable result, NSError *_Nullable error)
+                         {
+                             @synchronized (resultsByCaller)
+                             {
+                                 resultsByCaller[name] = result;
+                             }
+                         }];
+                    }
+                });
+                
+                it(@"should send one request with every query", ^
+                   {
+                       [[expectFutureValue(theValue(resultsByCaller.count)) shouldEventually] equal:theValue(3)];
+                       [[theValue(requestCount) should] equal:theValue(1)];
+                       [[batchedMethod.parameters should] containString:@"<group name=\"first\">"];
+                       [[batchedMethod.parameters should] containString:@"<group name=\"third\">"];
+                   });
+                
+                it(@"should give each caller the result for its query", ^
+                   {
+                       [[expectFutureValue(theValue(resultsByCaller.count)) shouldEventually] equal:theValue(3)];
+                       [[resultsByCaller[@"first"].name should] equal:@"first"];
+                       [[resultsByCaller[@"second"].name should] equal:@"second"];
+                       [[resultsByCaller[@"third"].name should] equal:@"third"];
+                   });
+            });    
     
 #pragma mark - Invalid Things
     
@@ -0,0 +1,240 @@
+//
+//  MHVBlobCacheTests.m
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import "MHVBlobCache.h"
+#import "MHVBlobPayloadThing.h"
+#import "MHVBlobDownloadRequest.h"
+#import "MHVServiceResponse.h"
+#import "MHVHttpServiceResponse.h"
+#import "MHVHttpServiceProtocol.h"
+#import "MHVConfiguration.h"
+#import "MHVSodaConnection.h"
+#import "MHVClientFactory.h"
+#import "MHVKeychainServiceProtocol.h"
+#import "MHVShellAuthServiceProtocol.h"
+#import "Kiwi.h"
+
+@interface MHVBlobCache (Testing)
+
+@property (nonatomic, strong) dispatch_queue_t ioQueue;
+
+@end
+
+static NSData *MHVBlobData(NSString *string)
+{
+    return [string dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+static MHVBlobPayloadThing *MHVBlobWithHash(NSString *url, NSString *hash)
+{
+    MHVBlobPayloadThing *blob = [[MHVBlobPayloadThing alloc] initWithBlobName:@"" contentType:@"image/jpeg" length:4 andUrl:url];
+
+    if (hash)
+    {
+        blob.blobInfo.hashInfo = [MHVBlobHashInfo new];
+        blob.blobInfo.hashInfo.algorithm = @"SHA256Block";
+        blob.blobInfo.hashInfo.hash = hash;
+    }
+
+    return blob;
+}
+
+SPEC_BEGIN(MHVBlobCacheTests)
+
+describe(@"MHVBlobCache", ^
+{
+    __block NSURL *directoryURL;
+    __block MHVBlobCache *cache;
+
+    // Waits for the cache's writes to disk
+    void (^flush)(MHVBlobCache *) = ^(MHVBlobCache *cacheToFlush)
+    {
+        dispatch_sync(cacheToFlush.ioQueue, ^{ });
+    };
+
+    beforeEach(^
+    {
+        directoryURL = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:[NSUUID UUID].UUIDString isDirectory:YES];
+        cache = [[MHVBlobCache alloc] initWithDirectoryURL:directoryURL sizeLimit:10];
+    });
+
+    afterEach(^
+    {
+        flush(cache);
+        [[NSFileManager defaultManager] removeItemAtURL:directoryURL error:nil];
+    });
+
+    context(@"Keys", ^
+            {
+                it(@"should key blobs by their hash when there is one", ^
+                   {
+                       NSString *key = [MHVBlobCache keyForBlobPayloadThing:MHVBlobWithHash(@"https://blob.url/1?token=A", @"HASH")];
+
+                       [[[MHVBlobCache keyForBlobPayloadThing:MHVBlobWithHash(@"https://blob.url/1?token=B", @"HASH")] should] equal:key];
+                       [[[MHVBlobCache keyForBlobPayloadThing:MHVBlobWithHash(@"https://blob.url/1?token=A", @"OTHER")] shouldNot] equal:key];
+                   });
+
+                it(@"should key blobs without a hash by their URL and length", ^
+                   {
+                       MHVBlobPayloadThing *blob = MHVBlobWithHash(@"https://blob.url/1", nil);
+                       NSString *key = [MHVBlobCache keyForBlobPayloadThing:blob];
+
+                       [[key should] beNonNil];
+
+                       blob.length = 5;
+                       [[[MHVBlobCache keyForBlobPayloadThing:blob] shouldNot] equal:key];
+                   });
+            });
+
+    context(@"Storage", ^
+            {
+                it(@"should read blobs from disk after a relaunch", ^
+                   {
+                       [cache setData:MHVBlobData(@"AAAA") forKey:@"a" generation:cache.generation];
+                       flush(cache);
+
+                       MHVBlobCache *relaunchedCache = [[MHVBlobCache alloc] initWithDirectoryURL:directoryURL sizeLimit:10];
+
+                       [[[relaunchedCache dataForKey:@"a"] should] equal:MHVBlobData(@"AAAA")];
+                   });
+
+                it(@"should copy blobs to and from files", ^
+                   {
+                       NSString *downloadPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+                       NSString *copyPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+                       [MHVBlobData(@"AAAA") writeToFile:downloadPath atomically:YES];
+
+                       [cache setBlobWithFilePath:downloadPath forKey:@"a" generation:cache.generation];
+                       [[NSFileManager defaultManager] removeItemAtPath:downloadPath error:nil];
+
+                       [[theValue([cache copyBlobForKey:@"a" toFilePath:copyPath]) should] beYes];
+                       [[[NSData dataWithContentsOfFile:copyPath] should] equal:MHVBlobData(@"AAAA")];
+
+                       [[NSFileManager defaultManager] removeItemAtPath:copyPath error:nil];
+                   });
+
+                it(@"should remove the least recently used blobs when over the size limit", ^
+                   {
+                       [cache setData:MHVBlobData(@"AAAA") forKey:@"a" generation:cache.generation];
+                       [cache setData:MHVBlobData(@"BBBB") forKey:@"b" generation:cache.generation];
+                       [cache dataForKey:@"a"];
+                       [cache setData:MHVBlobData(@"CCCC") forKey:@"c" generation:cache.generation];
+
+                       [[[cache dataForKey:@"a"] should] beNonNil];
+                       [[[cache dataForKey:@"b"] should] beNil];
+                       [[[cache dataForKey:@"c"] should] beNonNil];
+                   });
+
+                it(@"should not keep blobs larger than the size limit", ^
+                   {
+                       [cache setData:MHVBlobData(@"ABCDEFGHIJK") forKey:@"a" generation:cache.generation];
+
+                       [[[cache dataForKey:@"a"] should] beNil];
+                   });
+
+                it(@"should not keep a blob downloaded before every blob was removed", ^
+                   {
+                       NSUInteger generation = cache.generation;
+
+                       [cache removeAllBlobs];
+                       [cache setData:MHVBlobData(@"AAAA") forKey:@"a" generation:generation];
+
+                       [[[cache dataForKey:@"a"] should] beNil];
+                   });
+
+                it(@"should count hits and the bytes they saved", ^
+                   {
+                       [cache setData:MHVBlobData(@"AAAA") forKey:@"a" generation:cache.generation];
+
+                       [cache dataForKey:@"a"];
+                       [cache dataForKey:@"a"];
+                       [cache dataForKey:@"b"];
+
+                       [[theValue(cache.hitCount) should] equal:theValue(2)];
+                       [[theValue(cache.missCount) should] equal:theValue(1)];
+                       [[theValue(cache.bytesSaved) should] equal:theValue(8)];
+                       [[theValue(cache.hitRate) should] equal:2.0 / 3.0 withDelta:0.001];
+                   });
+            });
+
+    context(@"Connection", ^
+            {
+                __block MHVConnection *connection;
+                __block NSUInteger requestCount;
+
+                beforeEach(^
+                {
+                    requestCount = 0;
+
+                    KWMock<MHVHttpServiceProtocol> *httpService = [KWMock mockForProtocol:@protocol(MHVHttpServiceProtocol)];
+                    [httpService stub:@selector(sendRequestForURL:httpMethod:body:headers:completion:) withBlock:^id(NSArray *params)
+                     {
+                         requestCount += 1;
+
+                         void (^completion)(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error) = params[4];
+                         completion([[MHVHttpServiceResponse alloc] initWithResponseData:MHVBlobData(@"AAAA") statusCode:200], nil);
+
+                         return nil;
+                     }];
+
+                    connection = [[MHVSodaConnection alloc] initWithConfiguration:[MHVConfiguration new]
+                                                                cacheSynchronizer:nil
+                                                               cacheConfiguration:nil
+                                                                    clientFactory:[MHVClientFactory nullMock]
+                                                                      httpService:httpService
+                                                                  keychainService:[KWMock nullMockForProtocol:@protocol(MHVKeychainServiceProtocol)]
+                                                                 shellAuthService:[KWMock nullMockForProtocol:@protocol(MHVShellAuthServiceProtocol)]];
+
+                    [connection setValue:cache forKey:@"blobCache"];
+                });
+
+                NSData *(^download)(NSString *) = ^NSData *(NSString *url)
+                {
+                    __block NSData *result = nil;
+
+                    MHVBlobPayloadThing *blob = MHVBlobWithHash(url, @"HASH");
+                    MHVBlobDownloadRequest *request = [[MHVBlobDownloadRequest alloc] initWithURL:[NSURL URLWithString:url] toFilePath:nil];
+                    request.blobCacheKey = [MHVBlobCache keyForBlobPayloadThing:blob];
+                    request.blobLength = blob.length;
+
+                    [connection executeHttpServiceOperation:request completion:^(MHVServiceResponse * _Nullable response, NSError * _Nullable error)
+                     {
+                         result = response.responseData;
+                     }];
+
+                    [[expectFutureValue(result) shouldEventually] beNonNil];
+
+                    return result;
+                };
+
+                it(@"should download a blob with the same hash only once", ^
+                   {
+                       NSData *first = download(@"https://blob.url/1?token=A");
+                       NSData *second = download(@"https://blob.url/1?token=B");
+
+                       [[theValue(requestCount) should] equal:theValue(1)];
+                       [[second should] equal:first];
+                       [[theValue(connection.blobCacheBytesSaved) should] equal:theValue(4)];
+                       [[theValue(connection.blobCacheHitRate) should] equal:0.5 withDelta:0.001];
+                   });
+            });
+});
+
+SPEC_END
@@ -100,6 +100,9 @@ describe(@"MHVConnectionTests", ^
     __block MHVHttpServiceResponse *requestCompletionResponse;
     __block NSError *requestCompletionError;
     
+    // Completions for requests the stub left unanswered, which are failed after each test
+    __block NSMutableArray *openRequestCompletions = [NSMutableArray new];
+    
     beforeEach(^{
         requestedURL = nil;
         requestedHttpMethod = nil;
@@ -113,6 +116,21 @@ describe(@"MHVConnectionTests", ^
         testConnection.sessionCredential = [[MHVSessionCredential alloc] initWithToken:kDefaultToken sharedSecret:kDefaultSharedSecret];
     });
     
+    afterEach(^{
+        // Like cancelled tasks, so requests from one test are never still in progress in the next
+        NSArray *completions = nil;
+        @synchronized (openRequestCompletions)
+        {
+            completions = [openRequestCompletions copy];
+            [openRequestCompletions removeAllObjects];
+        }
+        
+        for (void (^completion)(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error) in completions)
+        {
+            completion(nil, [NSError MHVNetworkError]);
+        }
+    });
+    
     [httpService stub:@selector(sendRequestForURL:httpMethod:body:headers:completion:) withBlock:^id(NSArray *params)
      {
          requestedURL = params[0];
@@ -121,11 +139,19 @@ describe(@"MHVConnectionTests", ^
          requestedHeaders = params[3];
          requestCount = @(requestCount.integerValue + 1);
          
+         void (^completion)(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error) = params[4];
+         
          if (requestCompletionResponse || requestCompletionError)
          {
-             void (^completion)(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error) = params[4];
              completion(requestCompletionResponse, requestCompletionError);
          }
+         else
+         {
+             @synchronized (openRequestCompletions)
+             {
+                 [openRequestCompletions addObject:completion];
+             }
+         }
          
          return nil;
      }];
@@ -168,6 +194,62 @@ describe(@"MHVConnectionTests", ^
                    });
             });
     
+    context(@"MHVMethod identical read-only calls in progress", ^
+            {
+                __block NSUInteger initialCollapsedCount;
+                __block NSMutableArray<MHVServiceResponse *> *responses;
+                
+                beforeEach(^{
+                    initialCollapsedCount = testConnection.collapsedMethodCount;
+                    responses = [NSMutableArray new];
+                    
+                    for (NSUInteger i = 0; i < 3; i++)
+                    {
+                        MHVMethod *method = [MHVMethod getThings];
+                        method.parameters = @"SHAREDBODY";
+                        [testConnection executeHttpServiceOperation:method
+                                                         completion:^(MHVServiceResponse * _Nullable response, NSError * _Nullable error)
+                         {
+                             @synchronized (responses)
+                             {
+                                 [responses addObject:response ?: (id)[NSNull null]];
+                             }
+                         }];
+                    }
+                    
+                    MHVMethod *putMethod = [MHVMethod putThings];
+                    putMethod.parameters = @"SHAREDBODY";
+                    [testConnection executeHttpServiceOperation:putMethod completion:nil];
+                    
+                    MHVMethod *otherMethod = [MHVMethod getThings];
+                    otherMethod.parameters = @"OTHERBODY";
+                    [testConnection executeHttpServiceOperation:otherMethod completion:nil];
+                });
+                
+                it(@"should send identical Get methods once, and others normally", ^
+                   {
+                       [[expectFutureValue(requestCount) shouldEventually] equal:@(3)];
+                       [[expectFutureValue(theValue(testConnection.collapsedMethodCount)) shouldEventually] equal:theValue(initialCollapsedCount + 2)];
+                   });
+                
+                it(@"should give every caller the response", ^
+                   {
+                       [[expectFutureValue(requestCount) shouldEventually] equal:@(3)];
+                       
+                       NSString *xmlResponse = @"<response><status><code>0</code></status><wc:info xmlns:wc=\"urn:com.microsoft.wc.methods.response.GetThings3\">INFOXML</wc:info></response>";
+                       MHVHttpServiceResponse *response = [[MHVHttpServiceResponse alloc] initWithResponseData:[xmlResponse dataUsingEncoding:NSUTF8StringEncoding]
+                                                                                                  statusCode:0];
+                       void (^completion)(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error) = openRequestCompletions.firstObject;
+                       [openRequestCompletions removeObjectAtIndex:0];
+                       completion(response, nil);
+                       
+                       [[theValue(responses.count) should] equal:theValue(3)];
+                       [[responses[0].infoXml should] equal:@"<wc:info xmlns:wc=\"urn:com.microsoft.wc.methods.response.GetThings3\">INFOXML</wc:info>"];
+                       [[responses[1].infoXml should] equal:responses[0].infoXml];
+                       [[responses[2].infoXml should] equal:responses[0].infoXml];
+                   });
+            });
+    
     context(@"MHVMethod putThings", ^
             {
                 beforeEach(^{
@@ -264,6 +346,108 @@ describe(@"MHVConnectionTests", ^
                    });
             });
     
+    context(@"MHVMethod Token Refresh for concurrent unauthorized requests", ^
+            {
+                __block NSNumber *refreshCount;
+                __block NSNumber *completedCount;
+                __block NSNumber *failedCount;
+                
+                beforeEach(^{
+                    refreshCount = @(0);
+                    completedCount = @(0);
+                    failedCount = @(0);
+                    
+                    requestCompletionError = [NSError MHVUnauthorizedError];
+                    
+                    // The refresh takes a moment, so the other requests are rejected while it is in progress
+                    [credentialClient stub:@selector(getSessionCredentialWithSharedSecret:completion:) withBlock:^id(NSArray *params)
+                     {
+                         void (^completion)(MHVSessionCredential *_Nullable credential, NSError *_Nullable error) = params[1];
+                         
+                         refreshCount = @(refreshCount.integerValue + 1);
+                         
+                         dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.2 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^
+                         {
+                             requestCompletionError = nil;
+                             requestCompletionResponse = [[MHVHttpServiceResponse alloc] initWithResponseData:[@"<response><status><code>0</code></status></response>" dataUsingEncoding:NSUTF8StringEncoding]
+                                                                                                   statusCode:0];
+                             
+                             completion([[MHVSessionCredential alloc] initWithToken:kRefreshedToken sharedSecret:kDefaultSharedSecret], nil);
+                         });
+                         
+                         return nil;
+                     }];
+                    
+                    for (NSInteger i = 0; i < 20; i++)
+                    {
+                        MHVMethod *method = [MHVMethod putThings];
+                        method.parameters = [NSString stringWithFormat:@"PUTTHINGSBODY%li", (long)i];
+                        [testConnection executeHttpServiceOperation:method
+                                                         completion:^(MHVServiceResponse * _Nullable response, NSError * _Nullable error)
+                         {
+                             dispatch_async(dispatch_get_main_queue(), ^
+                             {
+                                 completedCount = @(completedCount.integerValue + 1);
+                                 failedCount = @(failedCount.integerValue + (error ? 1 : 0));
+                             });
+                         }];
+                    }
+                });
+                
+                it(@"should refresh the token once and reissue every request", ^
+                   {
+                       [[expectFutureValue(completedCount) shouldEventuallyBeforeTimingOutAfter(5)] equal:@(20)];
+                       [[failedCount should] equal:@(0)];
+                       [[refreshCount should] equal:@(1)];
+                   });
+            });
+    
+    context(@"MHVMethod Token Refresh before the token is due to expire", ^
+            {
+                __block NSNumber *refreshCount;
+                
+                beforeEach(^{
+                    refreshCount = @(0);
+                    
+                    // Any credential is old enough to be refreshed
+                    configuration.sessionCredentialRefreshInterval = DBL_MIN;
+                    
+                    [credentialClient stub:@selector(getSessionCredentialWithSharedSecret:completion:) withBlock:^id(NSArray *params)
+                     {
+                         void (^completion)(MHVSessionCredential *_Nullable credential, NSError *_Nullable error) = params[1];
+                         
+                         refreshCount = @(refreshCount.integerValue + 1);
+                         
+                         // Refreshed credentials stay valid for the rest of the test
+                         configuration.sessionCredentialRefreshInterval = 0;
+                         
+                         completion([[MHVSessionCredential alloc] initWithToken:kRefreshedToken sharedSecret:kDefaultSharedSecret], nil);
+                         
+                         return nil;
+                     }];
+                    
+                    MHVMethod *method = [MHVMethod getThings];
+                    method.parameters = @"GETTHINGSBODY";
+                    [testConnection executeHttpServiceOperation:method
+                                                     completion:^(MHVServiceResponse * _Nullable response, NSError * _Nullable error) { }];
+                });
+                
+                afterEach(^{
+                    configuration.sessionCredentialRefreshInterval = 60 * 20;
+                });
+                
+                it(@"should send the request once with the refreshed token", ^
+                   {
+                       [[expectFutureValue(requestedBody) shouldEventually] beNonNil];
+                       
+                       NSString *bodyString = [[NSString alloc] initWithData:requestedBody encoding:NSUTF8StringEncoding];
+                       
+                       [[theValue([bodyString containsString:@"<auth-token>REFRESHED-TOKEN</auth-token>"]) should] beYes];
+                       [[refreshCount should] equal:@(1)];
+                       [[requestCount should] equal:@(1)];
+                   });
+            });
+    
     context(@"MHVRestRequest not anonymous", ^
             {
                 beforeEach(^{
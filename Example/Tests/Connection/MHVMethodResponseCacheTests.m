@@ -0,0 +1,375 @@
+//
+//  MHVMethodResponseCacheTests.m
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import "MHVMethodResponseCache.h"
+#import "MHVMethod.h"
+#import "MHVServiceResponse.h"
+#import "MHVHttpServiceResponse.h"
+#import "MHVHttpServiceProtocol.h"
+#import "MHVConfiguration.h"
+#import "MHVSodaConnection.h"
+#import "MHVClientFactory.h"
+#import "MHVKeychainServiceProtocol.h"
+#import "MHVShellAuthServiceProtocol.h"
+#import "MHVSessionCredential.h"
+#import "MHVServiceInstance.h"
+#import "MHVResponseCacheGenerations.h"
+#import "Kiwi.h"
+
+static NSString *const kRecordA = @"11111111-1111-1111-1111-111111111111";
+static NSString *const kRecordB = @"22222222-2222-2222-2222-222222222222";
+
+@interface MHVMethodResponseCache (Testing)
+
+@property (nonatomic, strong) MHVResponseCacheGenerations *generations;
+
+@end
+
+@interface MHVConnection (ResponseCacheTesting)
+
+@property (nonatomic, strong, nullable) MHVSessionCredential *sessionCredential;
+
+@end
+
+static MHVHttpServiceResponse *MHVResponseWithInfo(NSString *info)
+{
+    NSString *xml = [NSString stringWithFormat:@"<response><status><code>0</code></status><wc:info xmlns:wc=\"urn:com.microsoft.wc.methods.response.GetThings3\">%@</wc:info></response>", info];
+
+    return [[MHVHttpServiceResponse alloc] initWithResponseData:[xml dataUsingEncoding:NSUTF8StringEncoding] statusCode:200];
+}
+
+static MHVMethod *MHVMethodForRecord(MHVMethod *method, NSString *recordId, NSString *parameters)
+{
+    method.recordId = [[NSUUID alloc] initWithUUIDString:recordId];
+    method.parameters = parameters;
+
+    return method;
+}
+
+SPEC_BEGIN(MHVMethodResponseCacheTests)
+
+describe(@"MHVMethodResponseCache", ^
+{
+    __block NSURL *directoryURL;
+    __block MHVMethodResponseCache *cache;
+    __block BOOL isStale;
+
+    // Waits for the cache's writes to disk
+    void (^flush)(MHVMethodResponseCache *) = ^(MHVMethodResponseCache *cacheToFlush)
+    {
+        [cacheToFlush.generations read:^{ }];
+    };
+
+    beforeEach(^
+    {
+        directoryURL = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:[NSUUID UUID].UUIDString isDirectory:YES];
+        cache = [[MHVMethodResponseCache alloc] initWithDirectoryURL:directoryURL];
+        isStale = NO;
+    });
+
+    afterEach(^
+    {
+        flush(cache);
+        [[NSFileManager defaultManager] removeItemAtURL:directoryURL error:nil];
+    });
+
+    context(@"Keys", ^
+            {
+                it(@"should group keys by record and method", ^
+                   {
+                       NSString *key = [cache keyForMethod:MHVMethodForRecord([MHVMethod getThings], kRecordA, @"<info/>") personId:nil];
+
+                       [[[key stringByDeletingLastPathComponent] should] equal:[NSString stringWithFormat:@"%@/GetThings", kRecordA]];
+                       [[theValue([key lastPathComponent].length) should] equal:theValue(64)];
+                   });
+
+                it(@"should give the same request the same key", ^
+                   {
+                       NSString *key = [cache keyForMethod:MHVMethodForRecord([MHVMethod getThings], kRecordA, @"<info/>") personId:nil];
+
+                       [[[cache keyForMethod:MHVMethodForRecord([MHVMethod getThings], kRecordA, @"<info/>") personId:nil] should] equal:key];
+                   });
+
+                it(@"should give different requests and people different keys", ^
+                   {
+                       NSString *key = [cache keyForMethod:MHVMethodForRecord([MHVMethod getThings], kRecordA, @"<info/>") personId:nil];
+
+                       [[[cache keyForMethod:MHVMethodForRecord([MHVMethod getThings], kRecordA, @"<info>2</info>") personId:nil] shouldNot] equal:key];
+                       [[[cache keyForMethod:MHVMethodForRecord([MHVMethod getThings], kRecordA, @"<info/>") personId:[NSUUID UUID]] shouldNot] equal:key];
+                   });
+            });
+
+    context(@"Time to live", ^
+            {
+                __block NSString *key;
+
+                beforeEach(^
+                {
+                    key = [cache keyForMethod:[MHVMethod getVocabulary] personId:nil];
+                    [cache setResponse:MHVResponseWithInfo(@"VOCABULARY") forKey:key generation:[cache generationForKey:key]];
+                });
+
+                it(@"should return a current response", ^
+                   {
+                       MHVServiceResponse *response = [cache responseForKey:key timeToLive:60 staleDuration:0 isStale:&isStale];
+
+                       [[response.infoXml should] containString:@"VOCABULARY"];
+                       [[theValue(isStale) should] beNo];
+                   });
+
+                it(@"should return a stale response in the stale duration", ^
+                   {
+                       MHVServiceResponse *response = [cache responseForKey:key timeToLive:0 staleDuration:60 isStale:&isStale];
+
+                       [[response should] beNonNil];
+                       [[theValue(isStale) should] beYes];
+                   });
+
+                it(@"should not return an expired response", ^
+                   {
+                       [[[cache responseForKey:key timeToLive:0 staleDuration:0 isStale:&isStale] should] beNil];
+                       [[[cache responseForKey:key timeToLive:60 staleDuration:0 isStale:&isStale] should] beNil];
+                   });
+
+                it(@"should not keep error responses", ^
+                   {
+                       NSString *otherKey = [cache keyForMethod:[MHVMethod getThingType] personId:nil];
+                       [cache setResponse:[[MHVHttpServiceResponse alloc] initWithResponseData:nil statusCode:500] forKey:otherKey generation:0];
+
+                       [[[cache responseForKey:otherKey timeToLive:60 staleDuration:0 isStale:&isStale] should] beNil];
+                   });
+            });
+
+    context(@"Persistence", ^
+            {
+                it(@"should return responses from disk after a relaunch", ^
+                   {
+                       NSString *key = [cache keyForMethod:[MHVMethod getVocabulary] personId:nil];
+                       [cache setResponse:MHVResponseWithInfo(@"VOCABULARY") forKey:key generation:[cache generationForKey:key]];
+                       flush(cache);
+
+                       MHVMethodResponseCache *relaunchedCache = [[MHVMethodResponseCache alloc] initWithDirectoryURL:directoryURL];
+                       MHVServiceResponse *response = [relaunchedCache responseForKey:key timeToLive:60 staleDuration:0 isStale:&isStale];
+
+                       [[response.infoXml should] containString:@"VOCABULARY"];
+                   });
+
+                it(@"should remove every response", ^
+                   {
+                       NSString *key = [cache keyForMethod:[MHVMethod getVocabulary] personId:nil];
+                       [cache setResponse:MHVResponseWithInfo(@"VOCABULARY") forKey:key generation:[cache generationForKey:key]];
+
+                       [cache removeAllResponses];
+                       flush(cache);
+
+                       [[[cache responseForKey:key timeToLive:60 staleDuration:0 isStale:&isStale] should] beNil];
+                       [[theValue([[NSFileManager defaultManager] fileExistsAtPath:directoryURL.path]) should] beNo];
+                   });
+            });
+
+    context(@"Invalidation", ^
+            {
+                __block NSString *recordAKey;
+                __block NSString *recordBKey;
+                __block NSString *vocabularyKey;
+
+                beforeEach(^
+                {
+                    recordAKey = [cache keyForMethod:MHVMethodForRecord([MHVMethod getThings], kRecordA, @"<info/>") personId:nil];
+                    recordBKey = [cache keyForMethod:MHVMethodForRecord([MHVMethod getThings], kRecordB, @"<info/>") personId:nil];
+                    vocabularyKey = [cache keyForMethod:[MHVMethod getVocabulary] personId:nil];
+
+                    for (NSString *key in @[recordAKey, recordBKey, vocabularyKey])
+                    {
+                        [cache setResponse:MHVResponseWithInfo(@"THINGS") forKey:key generation:[cache generationForKey:key]];
+                    }
+                });
+
+                it(@"should remove GetThings responses for a record changed by PutThings", ^
+                   {
+                       [cache removeResponsesChangedByMethod:MHVMethodForRecord([MHVMethod putThings], kRecordA, @"<info/>")];
+
+                       [[[cache responseForKey:recordAKey timeToLive:60 staleDuration:0 isStale:&isStale] should] beNil];
+                       [[[cache responseForKey:recordBKey timeToLive:60 staleDuration:0 isStale:&isStale] should] beNonNil];
+                       [[[cache responseForKey:vocabularyKey timeToLive:60 staleDuration:0 isStale:&isStale] should] beNonNil];
+                   });
+
+                it(@"should remove GetThings responses for a record changed by RemoveThings from disk", ^
+                   {
+                       flush(cache);
+                       [cache removeResponsesChangedByMethod:MHVMethodForRecord([MHVMethod removeThings], kRecordB, @"<info/>")];
+                       flush(cache);
+
+                       MHVMethodResponseCache *relaunchedCache = [[MHVMethodResponseCache alloc] initWithDirectoryURL:directoryURL];
+
+                       [[[relaunchedCache responseForKey:recordBKey timeToLive:60 staleDuration:0 isStale:&isStale] should] beNil];
+                       [[[relaunchedCache responseForKey:recordAKey timeToLive:60 staleDuration:0 isStale:&isStale] should] beNonNil];
+                   });
+
+                it(@"should not keep a response read while the record was changed", ^
+                   {
+                       NSString *key = [cache keyForMethod:MHVMethodForRecord([MHVMethod getThings], kRecordA, @"<info>2</info>") personId:nil];
+                       NSUInteger generation = [cache generationForKey:key];
+
+                       [cache removeResponsesChangedByMethod:MHVMethodForRecord([MHVMethod putThings], kRecordA, @"<info/>")];
+                       [cache setResponse:MHVResponseWithInfo(@"OLD") forKey:key generation:generation];
+
+                       [[[cache responseForKey:key timeToLive:60 staleDuration:0 isStale:&isStale] should] beNil];
+                   });
+
+                it(@"should not write a response to disk after the removal that made it out of date", ^
+                   {
+                       MHVResponseCacheGenerations *generations = [[MHVResponseCacheGenerations alloc] initWithLabel:@"MHVMethodResponseCacheTests.ioQueue"];
+                       dispatch_semaphore_t hold = dispatch_semaphore_create(0);
+                       __block NSMutableArray<NSString *> *writtenKeys = [NSMutableArray new];
+
+                       // Holds the queue, so the writes are still waiting when the group is made out of date
+                       [generations write:^
+                       {
+                           dispatch_semaphore_wait(hold, DISPATCH_TIME_FOREVER);
+                       }];
+
+                       for (NSString *key in @[recordAKey, recordBKey])
+                       {
+                           [generations writeForKey:key generation:[generations generationForKey:key] block:^
+                           {
+                               [writtenKeys addObject:key];
+                           }];
+                       }
+
+                       [generations incrementGenerationForGroup:[recordAKey stringByDeletingLastPathComponent]];
+                       dispatch_semaphore_signal(hold);
+                       [generations read:^{ }];
+
+                       [[writtenKeys should] equal:@[recordBKey]];
+                   });
+            });
+
+    context(@"Connection", ^
+            {
+                __block MHVConfiguration *configuration;
+                __block MHVConnection *connection;
+                __block NSInteger requestCount;
+
+                beforeEach(^
+                {
+                    requestCount = 0;
+
+                    configuration = [MHVConfiguration new];
+
+                    KWMock<MHVHttpServiceProtocol> *httpService = [KWMock mockForProtocol:@protocol(MHVHttpServiceProtocol)];
+                    [httpService stub:@selector(sendRequestForURL:httpMethod:body:headers:completion:) withBlock:^id(NSArray *params)
+                     {
+                         void (^completion)(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error) = params[4];
+                         completion(MHVResponseWithInfo([NSString stringWithFormat:@"RESPONSE %li", (long)requestCount + 1]), nil);
+
+                         // Counted once the response has been handled, so a counted response is already kept
+                         requestCount += 1;
+
+                         return nil;
+                     }];
+
+                    connection = [[MHVSodaConnection alloc] initWithConfiguration:configuration
+                                                                cacheSynchronizer:nil
+                                                               cacheConfiguration:nil
+                                                                    clientFactory:[MHVClientFactory nullMock]
+                                                                      httpService:httpService
+                                                                  keychainService:[KWMock nullMockForProtocol:@protocol(MHVKeychainServiceProtocol)]
+                                                                 shellAuthService:[KWMock nullMockForProtocol:@protocol(MHVShellAuthServiceProtocol)]];
+
+                    [connection setValue:cache forKey:@"responseCache"];
+                    connection.serviceInstance = [[MHVServiceInstance alloc] init];
+                    connection.serviceInstance.healthServiceUrl = [NSURL URLWithString:@"https://service.url/"];
+                    connection.sessionCredential = [[MHVSessionCredential alloc] initWithToken:@"TOKEN" sharedSecret:@"SECRET"];
+                });
+
+                NSString *(^execute)(MHVMethod *) = ^NSString *(MHVMethod *method)
+                {
+                    __block NSString *info = nil;
+
+                    [connection executeHttpServiceOperation:method completion:^(MHVServiceResponse * _Nullable response, NSError * _Nullable error)
+                     {
+                         info = response.infoXml ?: @"";
+                     }];
+
+                    [[expectFutureValue(info) shouldEventually] beNonNil];
+
+                    return info;
+                };
+
+                it(@"should return a kept response without sending the method", ^
+                   {
+                       [[execute([MHVMethod getVocabulary]) should] containString:@"RESPONSE 1"];
+                       [[execute([MHVMethod getVocabulary]) should] containString:@"RESPONSE 1"];
+
+                       [[theValue(requestCount) should] equal:theValue(1)];
+                   });
+
+                it(@"should return a stale response and fetch it again", ^
+                   {
+                       configuration.methodResponseTimeToLiveDurations = @{@"GetVocabulary" : @(0.01)};
+
+                       [[execute([MHVMethod getVocabulary]) should] containString:@"RESPONSE 1"];
+                       [NSThread sleepForTimeInterval:0.02];
+
+                       [[execute([MHVMethod getVocabulary]) should] containString:@"RESPONSE 1"];
+                       [[expectFutureValue(theValue(requestCount)) shouldEventually] equal:theValue(2)];
+
+                       [[execute([MHVMethod getVocabulary]) should] containString:@"RESPONSE 2"];
+                   });
+
+                it(@"should not change the caller's method when fetching a stale response again", ^
+                   {
+                       configuration.methodResponseTimeToLiveDurations = @{@"GetVocabulary" : @(0.01)};
+
+                       execute([MHVMethod getVocabulary]);
+                       [NSThread sleepForTimeInterval:0.02];
+
+                       MHVMethod *method = [MHVMethod getVocabulary];
+                       method.priority = MHVRequestPriorityInteractive;
+                       execute(method);
+
+                       [[expectFutureValue(theValue(requestCount)) shouldEventually] equal:theValue(2)];
+                       [[theValue(method.priority) should] equal:theValue(MHVRequestPriorityInteractive)];
+                   });
+
+                it(@"should not keep responses for methods without a time to live", ^
+                   {
+                       execute(MHVMethodForRecord([MHVMethod getThings], kRecordA, @"<info/>"));
+                       execute(MHVMethodForRecord([MHVMethod getThings], kRecordA, @"<info/>"));
+
+                       [[theValue(requestCount) should] equal:theValue(2)];
+                   });
+
+                it(@"should fetch GetThings again after PutThings changes the record", ^
+                   {
+                       configuration.methodResponseTimeToLiveDurations = @{@"GetThings" : @(60)};
+
+                       [[execute(MHVMethodForRecord([MHVMethod getThings], kRecordA, @"<info/>")) should] containString:@"RESPONSE 1"];
+                       [[execute(MHVMethodForRecord([MHVMethod getThings], kRecordA, @"<info/>")) should] containString:@"RESPONSE 1"];
+
+                       execute(MHVMethodForRecord([MHVMethod putThings], kRecordA, @"<info/>"));
+
+                       [[execute(MHVMethodForRecord([MHVMethod getThings], kRecordA, @"<info/>")) should] containString:@"RESPONSE 3"];
+                   });
+            });
+});
+
+SPEC_END
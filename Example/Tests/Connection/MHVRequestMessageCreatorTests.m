@@ -0,0 +1,254 @@
+//
+//  MHVRequestMessageCreatorTests.m
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import "MHVRequestMessageCreator.h"
+#import "MHVRequestMessageFragments.h"
+#import "MHVMethod.h"
+#import "MHVAuthSession.h"
+#import "MHVConfiguration.h"
+#import "MHVCryptographer.h"
+#import "MHVClientInfo.h"
+#import "MHVDateExtensions.h"
+#import "Kiwi.h"
+
+static NSString *const kSharedSecret = @"c2VjcmV0S2V5";
+
+// The envelope as it was built before requests were written as bytes
+static NSString *MHVReferenceRequest(MHVMethod *method, NSString *sharedSecret, MHVAuthSession *authSession,
+                                     MHVConfiguration *configuration, NSUUID *appId, NSDate *messageTime)
+{
+    MHVCryptographer *cryptographer = [MHVCryptographer new];
+    NSString *info = method.parameters != nil ? method.parameters : @"<info />";
+
+    NSMutableString *header = [NSMutableString stringWithFormat:@"<header><method>%@</method><method-version>%li</method-version>",
+                               method.name, (long)method.version];
+    if (method.recordId)
+    {
+        [header appendFormat:@"<record-id>%@</record-id>", method.recordId.UUIDString];
+    }
+    if (authSession.authToken.length == 0 || method.isAnonymous)
+    {
+        [header appendFormat:@"<app-id>%@</app-id>", (appId != nil ? appId : configuration.masterApplicationId).UUIDString];
+    }
+    else
+    {
+        [header appendFormat:@"<auth-session><auth-token>%@</auth-token>", authSession.authToken];
+        if (authSession.userAuthToken)
+        {
+            [header appendFormat:@"<user-auth-token>%@</user-auth-token>", authSession.userAuthToken];
+        }
+        else if (authSession.offlinePersonId)
+        {
+            [header appendFormat:@"<offline-person-info><offline-person-id>%@</offline-person-id></offline-person-info>",
+             authSession.offlinePersonId.UUIDString];
+        }
+        [header appendString:@"</auth-session>"];
+    }
+    [header appendFormat:@"<msg-time>%@</msg-time><msg-ttl>%ld</msg-ttl><version>%@</version>",
+     [messageTime dateToUtcString], (long)configuration.requestTimeToLiveDuration, [MHVClientInfo telemetryInfo]];
+    if (!method.isAnonymous)
+    {
+        [header appendFormat:@"<info-hash><hash-data algName=\"SHA256\">%@</hash-data></info-hash>",
+         [cryptographer computeSha256Hash:info]];
+    }
+    [header appendString:@"</header>"];
+
+    NSMutableString *xml = [NSMutableString stringWithString:@"<wc-request:request xmlns:wc-request=\"urn:com.microsoft.wc.request\">"];
+    if (sharedSecret && !method.isAnonymous)
+    {
+        NSData *key = [[NSData alloc] initWithBase64EncodedString:sharedSecret options:0];
+        [xml appendFormat:@"<auth><hmac-data algName=\"HMACSHA256\">%@</hmac-data></auth>", [cryptographer computeSha256Hmac:key data:header]];
+    }
+    [xml appendFormat:@"%@%@</wc-request:request>", header, info];
+
+    return xml;
+}
+
+SPEC_BEGIN(MHVRequestMessageCreatorTests)
+
+describe(@"MHVRequestMessageCreator", ^
+{
+    MHVConfiguration *configuration = [MHVConfiguration new];
+    configuration.masterApplicationId = [[NSUUID alloc] initWithUUIDString:@"99999999-9999-9999-9999-999999999999"];
+    NSUUID *appId = [[NSUUID alloc] initWithUUIDString:@"11111111-1111-1111-1111-111111111111"];
+    NSDate *messageTime = [NSDate dateWithTimeIntervalSinceReferenceDate:500000000.25];
+
+    MHVAuthSession *authSession = [MHVAuthSession new];
+    authSession.authToken = @"TOKEN";
+    authSession.offlinePersonId = [[NSUUID alloc] initWithUUIDString:@"22222222-2222-2222-2222-222222222222"];
+
+    MHVMethod *(^getThings)(void) = ^MHVMethod *(void)
+    {
+        MHVMethod *method = [MHVMethod getThings];
+        method.recordId = [[NSUUID alloc] initWithUUIDString:@"33333333-3333-3333-3333-333333333333"];
+        method.parameters = @"<info><group><id>12345678-1234-1234-1234-123456789012</id></group></info>";
+        return method;
+    };
+
+    NSString *(^build)(MHVMethod *, NSString *, MHVAuthSession *) = ^NSString *(MHVMethod *method, NSString *sharedSecret, MHVAuthSession *session)
+    {
+        MHVRequestMessageCreator *creator = [[MHVRequestMessageCreator alloc] initWithMethod:method
+                                                                                sharedSecret:sharedSecret
+                                                                                 authSession:session
+                                                                               configuration:configuration
+                                                                                       appId:appId
+                                                                                 messageTime:messageTime
+                                                                               cryptographer:[MHVCryptographer new]];
+        return creator.xmlString;
+    };
+
+    context(@"Envelope", ^
+            {
+                it(@"should match the string built request for a signed record method", ^
+                   {
+                       MHVMethod *method = getThings();
+
+                       [[build(method, kSharedSecret, authSession) should] equal:MHVReferenceRequest(method, kSharedSecret, authSession, configuration, appId, messageTime)];
+                   });
+
+                it(@"should match for a user auth token", ^
+                   {
+                       MHVAuthSession *userSession = [MHVAuthSession new];
+                       userSession.authToken = @"TOKEN";
+                       userSession.userAuthToken = @"USERTOKEN";
+                       MHVMethod *method = getThings();
+
+                       [[build(method, kSharedSecret, userSession) should] equal:MHVReferenceRequest(method, kSharedSecret, userSession, configuration, appId, messageTime)];
+                   });
+
+                it(@"should match for anonymous methods and unsigned requests", ^
+                   {
+                       MHVMethod *anonymous = [MHVMethod createAuthenticatedSessionToken];
+                       anonymous.parameters = @"<info><auth-info /></info>";
+                       MHVMethod *method = getThings();
+                       MHVAuthSession *emptySession = [MHVAuthSession new];
+
+                       [[build(anonymous, kSharedSecret, authSession) should] equal:MHVReferenceRequest(anonymous, kSharedSecret, authSession, configuration, appId, messageTime)];
+                       [[build(method, nil, authSession) should] equal:MHVReferenceRequest(method, nil, authSession, configuration, appId, messageTime)];
+                       [[build(method, nil, emptySession) should] equal:MHVReferenceRequest(method, nil, emptySession, configuration, appId, messageTime)];
+                   });
+
+                it(@"should produce the same request from shared fragments", ^
+                   {
+                       MHVRequestMessageFragments *fragments = [[MHVRequestMessageFragments alloc] initWithSharedSecret:kSharedSecret
+                                                                                                            authSession:authSession
+                                                                                                          configuration:configuration
+                                                                                                                  appId:appId];
+                       MHVMethod *method = getThings();
+
+                       for (NSUInteger i = 0; i < 2; i++)
+                       {
+                           MHVRequestMessageCreator *creator = [[MHVRequestMessageCreator alloc] initWithMethod:method
+                                                                                                     fragments:fragments
+                                                                                                   messageTime:messageTime
+                                                                                                 cryptographer:[MHVCryptographer new]];
+
+                           [[creator.xmlString should] equal:build(method, kSharedSecret, authSession)];
+                       }
+                   });
+            });
+
+    context(@"Fragments", ^
+            {
+                it(@"should only match the values they were built from", ^
+                   {
+                       MHVRequestMessageFragments *fragments = [[MHVRequestMessageFragments alloc] initWithSharedSecret:kSharedSecret
+                                                                                                            authSession:authSession
+                                                                                                          configuration:configuration
+                                                                                                                  appId:appId];
+                       MHVAuthSession *sameSession = [MHVAuthSession new];
+                       sameSession.authToken = @"TOKEN";
+                       sameSession.offlinePersonId = authSession.offlinePersonId;
+                       MHVAuthSession *refreshedSession = [MHVAuthSession new];
+                       refreshedSession.authToken = @"REFRESHED";
+                       refreshedSession.offlinePersonId = authSession.offlinePersonId;
+
+                       [[theValue([fragments matchesSharedSecret:kSharedSecret authSession:sameSession configuration:configuration appId:appId]) should] beYes];
+                       [[theValue([fragments matchesSharedSecret:kSharedSecret authSession:refreshedSession configuration:configuration appId:appId]) should] beNo];
+                       [[theValue([fragments matchesSharedSecret:nil authSession:sameSession configuration:configuration appId:appId]) should] beNo];
+                       [[theValue([fragments matchesSharedSecret:kSharedSecret authSession:sameSession configuration:configuration appId:nil]) should] beNo];
+                   });
+            });
+
+    context(@"Signing", ^
+            {
+                it(@"should compute an HMAC of data", ^
+                   {
+                       NSData *key = [@"Jefe" dataUsingEncoding:NSUTF8StringEncoding];
+                       NSData *message = [@"what do ya want for nothing?" dataUsingEncoding:NSUTF8StringEncoding];
+
+                       [[[[MHVCryptographer new] computeSha256HmacOfData:message key:key] should] equal:@"W9zBRr9gdU5qBCQmCJV1x1oAPwidJzmDnexYuWTsOEM="];
+                   });
+
+                it(@"should hash data in chunks", ^
+                   {
+                       MHVSha256Hash *hash = [MHVSha256Hash new];
+                       for (NSUInteger i = 0; i < 1000; i++)
+                       {
+                           [hash updateWithBytes:"abc" length:3];
+                       }
+
+                       [[[hash base64Digest] should] equal:@"Mo3o8Ylfi7CfbmtMIBLvKypvBnzQAnlLdQqgQKb22L0="];
+                   });
+
+                it(@"should use a hash computed while the parameters were written", ^
+                   {
+                       MHVMethod *method = getThings();
+                       method.parametersData = [method.parameters dataUsingEncoding:NSUTF8StringEncoding];
+                       method.parametersHash = @"PRECOMPUTED";
+
+                       [[build(method, kSharedSecret, authSession) should] containString:@"<hash-data algName=\"SHA256\">PRECOMPUTED</hash-data>"];
+                   });
+            });
+
+    context(@"Performance", ^
+            {
+                it(@"should build requests faster than strings", ^
+                   {
+                       MHVMethod *method = getThings();
+                       MHVRequestMessageFragments *fragments = [[MHVRequestMessageFragments alloc] initWithSharedSecret:kSharedSecret
+                                                                                                            authSession:authSession
+                                                                                                          configuration:configuration
+                                                                                                                  appId:appId];
+                       NSUInteger iterations = 2000;
+
+                       NSDate *start = [NSDate date];
+                       for (NSUInteger i = 0; i < iterations; i++)
+                       {
+                           [MHVReferenceRequest(method, kSharedSecret, authSession, configuration, appId, messageTime) dataUsingEncoding:NSUTF8StringEncoding];
+                       }
+                       NSTimeInterval stringDuration = [[NSDate date] timeIntervalSinceDate:start];
+
+                       start = [NSDate date];
+                       for (NSUInteger i = 0; i < iterations; i++)
+                       {
+                           [[[MHVRequestMessageCreator alloc] initWithMethod:method
+                                                                   fragments:fragments
+                                                                 messageTime:messageTime
+                                                               cryptographer:[MHVCryptographer new]] xmlData];
+                       }
+                       NSTimeInterval dataDuration = [[NSDate date] timeIntervalSinceDate:start];
+
+                       [[theValue(dataDuration) should] beLessThan:theValue(stringDuration)];
+                   });
+            });
+});
+
+SPEC_END
@@ -0,0 +1,227 @@
+//
+//  MHVRequestSchedulerTests.m
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import "MHVRequestScheduler.h"
+#import "Kiwi.h"
+
+// Schedules background requests, then requests with the given priority, and returns how long each
+// of the later requests waited to start. Every request takes 10ms.
+static NSArray<NSNumber *> *MHVWaitTimesBehindBackgroundRequests(MHVRequestPriority priority)
+{
+    MHVRequestScheduler *scheduler = [MHVRequestScheduler new];
+    dispatch_group_t group = dispatch_group_create();
+    NSMutableArray<NSNumber *> *waitTimes = [NSMutableArray new];
+
+    void (^schedule)(MHVRequestPriority, BOOL) = ^(MHVRequestPriority requestPriority, BOOL isMeasured)
+    {
+        NSDate *scheduled = [NSDate date];
+        dispatch_group_enter(group);
+
+        [scheduler scheduleWithPriority:requestPriority request:^(MHVScheduledRequestFinished finished)
+        {
+            if (isMeasured)
+            {
+                @synchronized (waitTimes)
+                {
+                    [waitTimes addObject:@([[NSDate date] timeIntervalSinceDate:scheduled])];
+                }
+            }
+
+            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.01 * NSEC_PER_SEC)), dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^
+            {
+                finished();
+                dispatch_group_leave(group);
+            });
+        }];
+    };
+
+    for (NSInteger i = 0; i < 40; i++)
+    {
+        schedule(MHVRequestPriorityBackgroundSync, NO);
+    }
+
+    for (NSInteger i = 0; i < 20; i++)
+    {
+        schedule(priority, YES);
+    }
+
+    dispatch_group_wait(group, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(10 * NSEC_PER_SEC)));
+
+    return [waitTimes sortedArrayUsingSelector:@selector(compare:)];
+}
+
+static NSTimeInterval MHVPercentile(NSArray<NSNumber *> *sortedValues, double percentile)
+{
+    if (sortedValues.count == 0)
+    {
+        return 0;
+    }
+
+    NSUInteger index = (NSUInteger)ceil(percentile * sortedValues.count);
+
+    return sortedValues[MAX(index, 1) - 1].doubleValue;
+}
+
+SPEC_BEGIN(MHVRequestSchedulerTests)
+
+describe(@"MHVRequestScheduler", ^
+{
+    __block MHVRequestScheduler *scheduler;
+    __block NSMutableArray<NSString *> *startedRequests;
+    __block NSMutableArray<MHVScheduledRequestFinished> *runningRequests;
+
+    void (^schedule)(MHVRequestPriority, NSString *) = ^(MHVRequestPriority priority, NSString *name)
+    {
+        // Requests left waiting at the end of a test still record into that test's arrays
+        NSMutableArray<NSString *> *started = startedRequests;
+        NSMutableArray<MHVScheduledRequestFinished> *running = runningRequests;
+
+        [scheduler scheduleWithPriority:priority request:^(MHVScheduledRequestFinished finished)
+        {
+            @synchronized (started)
+            {
+                [started addObject:name];
+                [running addObject:finished];
+            }
+        }];
+    };
+
+    void (^finishRunningRequests)(void) = ^
+    {
+        NSArray<MHVScheduledRequestFinished> *requests = nil;
+        @synchronized (startedRequests)
+        {
+            requests = [runningRequests copy];
+            [runningRequests removeAllObjects];
+        }
+
+        for (MHVScheduledRequestFinished finished in requests)
+        {
+            finished();
+        }
+    };
+
+    beforeEach(^
+    {
+        scheduler = [MHVRequestScheduler new];
+        startedRequests = [NSMutableArray new];
+        runningRequests = [NSMutableArray new];
+    });
+
+    afterEach(^
+    {
+        finishRunningRequests();
+    });
+
+    context(@"Ordering", ^
+            {
+                it(@"should start waiting requests in priority order", ^
+                   {
+                       scheduler.maxConcurrentRequests = 1;
+
+                       schedule(MHVRequestPriorityUserInitiated, @"First");
+                       [[expectFutureValue(startedRequests) shouldEventually] haveCountOf:1];
+
+                       schedule(MHVRequestPriorityBlobTransfer, @"Blob");
+                       schedule(MHVRequestPriorityBackgroundSync, @"Sync");
+                       schedule(MHVRequestPriorityUserInitiated, @"User");
+                       schedule(MHVRequestPriorityInteractive, @"Interactive");
+
+                       for (NSUInteger count = 2; count <= 5; count++)
+                       {
+                           finishRunningRequests();
+                           [[expectFutureValue(startedRequests) shouldEventually] haveCountOf:count];
+                       }
+
+                       [[startedRequests should] equal:@[@"First", @"Interactive", @"User", @"Sync", @"Blob"]];
+                   });
+
+                it(@"should start requests with the same priority in the order they were scheduled", ^
+                   {
+                       scheduler.maxConcurrentRequests = 1;
+
+                       schedule(MHVRequestPriorityBackgroundSync, @"1");
+                       schedule(MHVRequestPriorityBackgroundSync, @"2");
+                       schedule(MHVRequestPriorityBackgroundSync, @"3");
+
+                       for (NSUInteger count = 1; count <= 3; count++)
+                       {
+                           [[expectFutureValue(startedRequests) shouldEventually] haveCountOf:count];
+                           finishRunningRequests();
+                       }
+
+                       [[startedRequests should] equal:@[@"1", @"2", @"3"]];
+                   });
+            });
+
+    context(@"Limits", ^
+            {
+                it(@"should limit requests in progress for a priority", ^
+                   {
+                       [scheduler setLimit:2 forPriority:MHVRequestPriorityBackgroundSync];
+                       [[theValue([scheduler limitForPriority:MHVRequestPriorityBackgroundSync]) should] equal:theValue(2)];
+
+                       for (NSInteger i = 0; i < 5; i++)
+                       {
+                           schedule(MHVRequestPriorityBackgroundSync, @"Sync");
+                       }
+
+                       [[expectFutureValue(startedRequests) shouldEventually] haveCountOf:2];
+
+                       // Other priorities aren't held up by the background requests
+                       schedule(MHVRequestPriorityInteractive, @"Interactive");
+                       [[expectFutureValue(startedRequests) shouldEventually] haveCountOf:3];
+                       [[startedRequests.lastObject should] equal:@"Interactive"];
+
+                       finishRunningRequests();
+                       [[expectFutureValue(startedRequests) shouldEventually] haveCountOf:5];
+                   });
+
+                it(@"should limit requests in progress across priorities", ^
+                   {
+                       scheduler.maxConcurrentRequests = 3;
+
+                       schedule(MHVRequestPriorityInteractive, @"Interactive");
+                       schedule(MHVRequestPriorityUserInitiated, @"User");
+                       schedule(MHVRequestPriorityBackgroundSync, @"Sync");
+                       schedule(MHVRequestPriorityBlobTransfer, @"Blob");
+
+                       [[expectFutureValue(startedRequests) shouldEventually] haveCountOf:3];
+                       [[startedRequests shouldNot] contain:@"Blob"];
+
+                       finishRunningRequests();
+                       [[expectFutureValue(startedRequests) shouldEventually] haveCountOf:4];
+                   });
+            });
+
+    context(@"Latency", ^
+            {
+                it(@"should start interactive requests ahead of queued background requests", ^
+                   {
+                       NSArray<NSNumber *> *unprioritized = MHVWaitTimesBehindBackgroundRequests(MHVRequestPriorityBackgroundSync);
+                       NSArray<NSNumber *> *prioritized = MHVWaitTimesBehindBackgroundRequests(MHVRequestPriorityInteractive);
+
+                       [[theValue(prioritized.count) should] equal:theValue(20)];
+                       [[theValue(MHVPercentile(prioritized, 0.95)) should] beLessThan:theValue(MHVPercentile(unprioritized, 0.95))];
+                   });
+            });
+});
+
+SPEC_END
@@ -0,0 +1,328 @@
+//
+//  MHVRestResponseCacheTests.m
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import "MHVRestResponseCache.h"
+#import "MHVRestRequest.h"
+#import "MHVServiceResponse.h"
+#import "MHVHttpServiceResponse.h"
+#import "MHVHttpServiceProtocol.h"
+#import "MHVConfiguration.h"
+#import "MHVSodaConnection.h"
+#import "MHVClientFactory.h"
+#import "MHVKeychainServiceProtocol.h"
+#import "MHVShellAuthServiceProtocol.h"
+#import "MHVSessionCredential.h"
+#import "MHVServiceInstance.h"
+#import "MHVResponseCacheGenerations.h"
+#import "Kiwi.h"
+
+static NSString *const kTimelineJson = @"{\"startDate\":\"2017-06-01\",\"tasks\":[1,2,3]}";
+
+@interface MHVRestResponseCache (Testing)
+
+@property (nonatomic, strong) MHVResponseCacheGenerations *generations;
+
+@end
+
+@interface MHVConnection (RestCacheTesting)
+
+@property (nonatomic, strong, nullable) MHVSessionCredential *sessionCredential;
+
+@end
+
+static MHVRestRequest *MHVRestRequestWithPath(NSString *path, NSString *httpMethod)
+{
+    MHVRestRequest *request = [[MHVRestRequest alloc] initWithPath:path httpMethod:httpMethod pathParams:nil queryParams:nil body:nil isAnonymous:NO];
+    [request updateUrlWithServiceUrl:[NSURL URLWithString:@"https://rest.url/"]];
+
+    return request;
+}
+
+static MHVHttpServiceResponse *MHVRestResponse(NSInteger statusCode, NSDictionary *headers)
+{
+    NSData *data = statusCode == 304 ? nil : [kTimelineJson dataUsingEncoding:NSUTF8StringEncoding];
+
+    return [[MHVHttpServiceResponse alloc] initWithResponseData:data statusCode:statusCode headers:headers];
+}
+
+SPEC_BEGIN(MHVRestResponseCacheTests)
+
+describe(@"MHVRestResponseCache", ^
+{
+    __block NSURL *directoryURL;
+    __block MHVRestResponseCache *cache;
+    __block NSString *key;
+
+    // Waits for the cache's writes to disk
+    void (^flush)(MHVRestResponseCache *) = ^(MHVRestResponseCache *cacheToFlush)
+    {
+        [cacheToFlush.generations read:^{ }];
+    };
+
+    beforeEach(^
+    {
+        directoryURL = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:[NSUUID UUID].UUIDString isDirectory:YES];
+        cache = [[MHVRestResponseCache alloc] initWithDirectoryURL:directoryURL];
+        key = [cache keyForRequest:MHVRestRequestWithPath(@"Timeline", @"GET") personId:nil recordId:nil version:@"1.0"];
+    });
+
+    afterEach(^
+    {
+        flush(cache);
+        [[NSFileManager defaultManager] removeItemAtURL:directoryURL error:nil];
+    });
+
+    context(@"Headers", ^
+            {
+                it(@"should keep a response with a max-age as fresh", ^
+                   {
+                       [cache setResponse:MHVRestResponse(200, @{@"Cache-Control" : @"private, max-age=60"}) forKey:key generation:0];
+
+                       MHVCachedRestResponse *cached = [cache responseForKey:key];
+                       [[theValue(cached.isFresh) should] beYes];
+                       [[theValue(cached.maxAge) should] equal:theValue(60)];
+                   });
+
+                it(@"should keep a response with an ETag to revalidate", ^
+                   {
+                       [cache setResponse:MHVRestResponse(200, @{@"ETag" : @"\"v1\""}) forKey:key generation:0];
+
+                       MHVCachedRestResponse *cached = [cache responseForKey:key];
+                       [[theValue(cached.isFresh) should] beNo];
+                       [[cached.etag should] equal:@"\"v1\""];
+                   });
+
+                it(@"should not keep no-store responses or responses without caching headers", ^
+                   {
+                       [cache setResponse:MHVRestResponse(200, @{@"Cache-Control" : @"no-store, max-age=60", @"ETag" : @"\"v1\""}) forKey:key generation:0];
+                       [[[cache responseForKey:key] should] beNil];
+
+                       [cache setResponse:MHVRestResponse(200, @{}) forKey:key generation:0];
+                       [[[cache responseForKey:key] should] beNil];
+                   });
+
+                it(@"should make a response fresh again when it's not modified", ^
+                   {
+                       [cache setResponse:MHVRestResponse(200, @{@"ETag" : @"\"v1\"", @"Cache-Control" : @"no-cache"}) forKey:key generation:0];
+                       [[theValue([cache responseForKey:key].isFresh) should] beNo];
+
+                       MHVCachedRestResponse *refreshed = [cache refreshResponseForKey:key headers:@{@"cache-control" : @"max-age=60"}];
+
+                       [[theValue(refreshed.isFresh) should] beYes];
+                       [[refreshed.responseData should] equal:[kTimelineJson dataUsingEncoding:NSUTF8StringEncoding]];
+                   });
+            });
+
+    context(@"Models", ^
+            {
+                beforeEach(^
+                {
+                    [cache setResponse:MHVRestResponse(200, @{@"ETag" : @"\"v1\""}) forKey:key generation:0];
+                });
+
+                it(@"should keep models with the response", ^
+                   {
+                       NSDictionary *model = @{@"startDate" : @"2017-06-01"};
+                       [cache setObject:model ofClass:[NSDictionary class] forKey:key];
+
+                       [[[cache objectOfClass:[NSDictionary class] forKey:key] should] equal:model];
+                       [[[cache objectOfClass:[NSArray class] forKey:key] should] beNil];
+                   });
+
+                it(@"should read models from disk after a relaunch", ^
+                   {
+                       [cache setObject:@{@"startDate" : @"2017-06-01"} ofClass:[NSDictionary class] forKey:key];
+                       flush(cache);
+
+                       MHVRestResponseCache *relaunchedCache = [[MHVRestResponseCache alloc] initWithDirectoryURL:directoryURL];
+
+                       [[[relaunchedCache responseForKey:key].etag should] equal:@"\"v1\""];
+                       [[[relaunchedCache objectOfClass:[NSDictionary class] forKey:key] should] equal:@{@"startDate" : @"2017-06-01"}];
+                   });
+
+                it(@"should remove models when the response is replaced", ^
+                   {
+                       [cache setObject:@{@"startDate" : @"2017-06-01"} ofClass:[NSDictionary class] forKey:key];
+                       [cache setResponse:MHVRestResponse(200, @{@"ETag" : @"\"v2\""}) forKey:key generation:0];
+                       flush(cache);
+
+                       [[[cache objectOfClass:[NSDictionary class] forKey:key] should] beNil];
+                   });
+            });
+
+    context(@"Invalidation", ^
+            {
+                it(@"should remove responses under the path a write changes", ^
+                   {
+                       NSString *planKey = [cache keyForRequest:MHVRestRequestWithPath(@"ActionPlans", @"GET") personId:nil recordId:nil version:@"1.0"];
+                       NSUInteger generation = [cache generationForKey:planKey];
+
+                       [cache setResponse:MHVRestResponse(200, @{@"ETag" : @"\"v1\""}) forKey:planKey generation:generation];
+                       [cache setResponse:MHVRestResponse(200, @{@"ETag" : @"\"v1\""}) forKey:key generation:0];
+
+                       [cache removeResponsesChangedByRequest:MHVRestRequestWithPath(@"ActionPlans/1234", @"PATCH")];
+
+                       [[[cache responseForKey:planKey] should] beNil];
+                       [[[cache responseForKey:key] should] beNonNil];
+
+                       // A read that was in progress during the write isn't kept
+                       [cache setResponse:MHVRestResponse(200, @{@"ETag" : @"\"v1\""}) forKey:planKey generation:generation];
+                       [[[cache responseForKey:planKey] should] beNil];
+                   });
+
+                it(@"should not remove responses for a GET", ^
+                   {
+                       [cache setResponse:MHVRestResponse(200, @{@"ETag" : @"\"v1\""}) forKey:key generation:0];
+                       [cache removeResponsesChangedByRequest:MHVRestRequestWithPath(@"Timeline", @"GET")];
+
+                       [[[cache responseForKey:key] should] beNonNil];
+                   });
+            });
+
+    context(@"Connection", ^
+            {
+                __block MHVConnection *connection;
+                __block NSMutableArray<MHVHttpServiceResponse *> *responses;
+                __block NSMutableArray<NSDictionary *> *requestedHeaders;
+                __block BOOL removesResponsesBeforeNotModified;
+
+                beforeEach(^
+                {
+                    responses = [NSMutableArray new];
+                    requestedHeaders = [NSMutableArray new];
+                    removesResponsesBeforeNotModified = NO;
+
+                    KWMock<MHVHttpServiceProtocol> *httpService = [KWMock mockForProtocol:@protocol(MHVHttpServiceProtocol)];
+                    [httpService stub:@selector(sendRequestForURL:httpMethod:body:headers:completion:) withBlock:^id(NSArray *params)
+                     {
+                         [requestedHeaders addObject:params[3]];
+
+                         MHVHttpServiceResponse *response = responses.firstObject;
+                         [responses removeObjectAtIndex:0];
+
+                         // Stand-in for the cached response being evicted while the request is in progress
+                         if (removesResponsesBeforeNotModified && response.statusCode == 304)
+                         {
+                             [cache removeAllResponses];
+                             flush(cache);
+                         }
+
+                         void (^completion)(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error) = params[4];
+                         completion(response, nil);
+
+                         return nil;
+                     }];
+
+                    connection = [[MHVSodaConnection alloc] initWithConfiguration:[MHVConfiguration new]
+                                                                cacheSynchronizer:nil
+                                                               cacheConfiguration:nil
+                                                                    clientFactory:[MHVClientFactory nullMock]
+                                                                      httpService:httpService
+                                                                  keychainService:[KWMock nullMockForProtocol:@protocol(MHVKeychainServiceProtocol)]
+                                                                 shellAuthService:[KWMock nullMockForProtocol:@protocol(MHVShellAuthServiceProtocol)]];
+
+                    [connection setValue:cache forKey:@"restResponseCache"];
+                    connection.serviceInstance = [[MHVServiceInstance alloc] init];
+                    connection.sessionCredential = [[MHVSessionCredential alloc] initWithToken:@"TOKEN" sharedSecret:@"SECRET"];
+                });
+
+                MHVServiceResponse *(^execute)(void) = ^MHVServiceResponse *
+                {
+                    __block MHVServiceResponse *result = nil;
+
+                    MHVRestRequest *request = MHVRestRequestWithPath(@"Timeline", @"GET");
+                    request.resultClass = [NSDictionary class];
+
+                    [connection executeHttpServiceOperation:request completion:^(MHVServiceResponse * _Nullable response, NSError * _Nullable error)
+                     {
+                         result = response;
+                     }];
+
+                    [[expectFutureValue(result) shouldEventually] beNonNil];
+
+                    return result;
+                };
+
+                it(@"should use a fresh response without a request or deserializing", ^
+                   {
+                       [responses addObject:MHVRestResponse(200, @{@"Cache-Control" : @"max-age=60"})];
+
+                       MHVServiceResponse *first = execute();
+                       MHVServiceResponse *second = execute();
+
+                       [[theValue(requestedHeaders.count) should] equal:theValue(1)];
+                       [[first.resultObject[@"startDate"] should] equal:@"2017-06-01"];
+                       [[second.resultObject should] equal:first.resultObject];
+                   });
+
+                it(@"should revalidate with the ETag and reuse the result when not modified", ^
+                   {
+                       [responses addObject:MHVRestResponse(200, @{@"ETag" : @"\"v1\""})];
+                       [responses addObject:MHVRestResponse(304, @{@"ETag" : @"\"v1\""})];
+
+                       MHVServiceResponse *first = execute();
+                       MHVServiceResponse *second = execute();
+
+                       [[theValue(requestedHeaders.count) should] equal:theValue(2)];
+                       [[requestedHeaders[0][@"If-None-Match"] should] beNil];
+                       [[requestedHeaders[1][@"If-None-Match"] should] equal:@"\"v1\""];
+                       [[second.resultObject should] equal:first.resultObject];
+                   });
+
+                it(@"should send the request again without the ETag when not modified but no longer cached", ^
+                   {
+                       [responses addObject:MHVRestResponse(200, @{@"ETag" : @"\"v1\""})];
+                       [responses addObject:MHVRestResponse(304, @{@"ETag" : @"\"v1\""})];
+                       [responses addObject:MHVRestResponse(200, @{@"ETag" : @"\"v1\""})];
+                       removesResponsesBeforeNotModified = YES;
+
+                       execute();
+                       MHVServiceResponse *second = execute();
+
+                       [[theValue(requestedHeaders.count) should] equal:theValue(3)];
+                       [[requestedHeaders[1][@"If-None-Match"] should] equal:@"\"v1\""];
+                       [[requestedHeaders[2][@"If-None-Match"] should] beNil];
+                       [[second.resultObject[@"startDate"] should] equal:@"2017-06-01"];
+                   });
+
+                it(@"should only keep responses when the configuration enables it", ^
+                   {
+                       MHVConfiguration *configuration = [MHVConfiguration new];
+                       MHVConnection *(^newConnection)(void) = ^MHVConnection *
+                       {
+                           return [[MHVSodaConnection alloc] initWithConfiguration:configuration
+                                                                 cacheSynchronizer:nil
+                                                                cacheConfiguration:nil
+                                                                     clientFactory:[MHVClientFactory nullMock]
+                                                                       httpService:[KWMock nullMockForProtocol:@protocol(MHVHttpServiceProtocol)]
+                                                                   keychainService:[KWMock nullMockForProtocol:@protocol(MHVKeychainServiceProtocol)]
+                                                                  shellAuthService:[KWMock nullMockForProtocol:@protocol(MHVShellAuthServiceProtocol)]];
+                       };
+
+                       [[[newConnection() valueForKey:@"restResponseCache"] should] beNil];
+
+                       configuration.isRestResponseCacheEnabled = YES;
+
+                       [[[newConnection() valueForKey:@"restResponseCache"] should] beNonNil];
+                   });
+            });
+});
+
+SPEC_END
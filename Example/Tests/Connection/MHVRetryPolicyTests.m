@@ -0,0 +1,401 @@
+//
+//  MHVRetryPolicyTests.m
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import "MHVRetryPolicy.h"
+#import "MHVConfiguration.h"
+#import "MHVSodaConnection.h"
+#import "MHVMethod.h"
+#import "MHVHttpService.h"
+#import "MHVClientFactory.h"
+#import "MHVKeychainServiceProtocol.h"
+#import "MHVShellAuthServiceProtocol.h"
+#import "MHVSessionCredential.h"
+#import "MHVServiceInstance.h"
+#import "MHVServiceResponse.h"
+#import "Kiwi.h"
+
+static NSString *const kStandInHost = @"standin.test";
+static NSString *const kSuccessResponse = @"<response><status><code>0</code></status><wc:info xmlns:wc=\"urn:com.microsoft.wc.methods.response.GetThings3\">INFOXML</wc:info></response>";
+
+@interface MHVConnection (RetryTesting)
+
+@property (nonatomic, strong, nullable) MHVSessionCredential *sessionCredential;
+
+@end
+
+/**
+ A stand-in for the HealthVault service. Each request gets the next scripted response, which is
+ an NSError to fail with, or an NSHTTPURLResponse status code and headers with a success body.
+ */
+@interface MHVStandInServerProtocol : NSURLProtocol
+
++ (void)scriptResponses:(NSArray *)responses;
++ (NSArray<NSDate *> *)requestDates;
+
+@end
+
+@implementation MHVStandInServerProtocol
+
+static NSMutableArray *gScriptedResponses;
+static NSMutableArray<NSDate *> *gRequestDates;
+
++ (void)scriptResponses:(NSArray *)responses
+{
+    @synchronized (self)
+    {
+        gScriptedResponses = [responses mutableCopy];
+        gRequestDates = [NSMutableArray new];
+    }
+}
+
++ (NSArray<NSDate *> *)requestDates
+{
+    @synchronized (self)
+    {
+        return [gRequestDates copy];
+    }
+}
+
++ (BOOL)canInitWithRequest:(NSURLRequest *)request
+{
+    return [request.URL.host isEqualToString:kStandInHost];
+}
+
++ (NSURLRequest *)canonicalRequestForRequest:(NSURLRequest *)request
+{
+    return request;
+}
+
+- (void)startLoading
+{
+    id scripted = nil;
+
+    @synchronized ([self class])
+    {
+        [gRequestDates addObject:[NSDate date]];
+
+        if (gScriptedResponses.count > 0)
+        {
+            scripted = gScriptedResponses.firstObject;
+            [gScriptedResponses removeObjectAtIndex:0];
+        }
+    }
+
+    if ([scripted isKindOfClass:[NSError class]])
+    {
+        [self.client URLProtocol:self didFailWithError:scripted];
+        return;
+    }
+
+    NSInteger statusCode = scripted ? [scripted[@"status"] integerValue] : 200;
+    NSDictionary *headers = scripted[@"headers"] ?: @{};
+
+    NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:self.request.URL
+                                                              statusCode:statusCode
+                                                             HTTPVersion:@"HTTP/1.1"
+                                                            headerFields:headers];
+
+    [self.client URLProtocol:self didReceiveResponse:response cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+
+    if (statusCode == 200)
+    {
+        [self.client URLProtocol:self didLoadData:[kSuccessResponse dataUsingEncoding:NSUTF8StringEncoding]];
+    }
+
+    [self.client URLProtocolDidFinishLoading:self];
+}
+
+- (void)stopLoading
+{
+}
+
+@end
+
+SPEC_BEGIN(MHVRetryPolicyTests)
+
+describe(@"MHVRetryPolicy", ^
+{
+    context(@"Delays", ^
+            {
+                it(@"should back off exponentially with jitter", ^
+                   {
+                       MHVRetryPolicy *policy = [MHVRetryPolicy new];
+                       policy.maxRetryCount = 10;
+                       policy.baseDelay = 1;
+                       policy.maxDelay = 4;
+                       policy.retryBudgetCapacity = 1000;
+
+                       NSMutableSet<NSNumber *> *delays = [NSMutableSet new];
+
+                       for (NSInteger attempt = 0; attempt < 4; attempt++)
+                       {
+                           NSTimeInterval limit = MIN(4, pow(2, attempt));
+
+                           for (NSInteger i = 0; i < 50; i++)
+                           {
+                               NSTimeInterval delay = [policy retryDelayForAttempt:attempt statusCode:503 headers:nil error:nil];
+
+                               [[theValue(delay) should] beGreaterThanOrEqualTo:theValue(0)];
+                               [[theValue(delay) should] beLessThanOrEqualTo:theValue(limit)];
+
+                               [delays addObject:@(delay)];
+                           }
+                       }
+
+                       [[theValue(delays.count) should] beGreaterThan:theValue(100)];
+                   });
+
+                it(@"should wait for Retry-After in seconds", ^
+                   {
+                       MHVRetryPolicy *policy = [MHVRetryPolicy new];
+
+                       NSTimeInterval delay = [policy retryDelayForAttempt:0 statusCode:503 headers:@{ @"retry-after" : @"7" } error:nil];
+
+                       [[theValue(delay) should] beBetween:theValue(6.9) and:theValue(7.1)];
+                   });
+
+                it(@"should wait for Retry-After as a date", ^
+                   {
+                       NSDateFormatter *formatter = [NSDateFormatter new];
+                       formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+                       formatter.timeZone = [NSTimeZone timeZoneWithAbbreviation:@"GMT"];
+                       formatter.dateFormat = @"EEE',' dd MMM yyyy HH':'mm':'ss 'GMT'";
+
+                       NSString *retryAfter = [formatter stringFromDate:[NSDate dateWithTimeIntervalSinceNow:10]];
+
+                       MHVRetryPolicy *policy = [MHVRetryPolicy new];
+                       NSTimeInterval delay = [policy retryDelayForAttempt:0 statusCode:503 headers:@{ @"Retry-After" : retryAfter } error:nil];
+
+                       [[theValue(delay) should] beBetween:theValue(8.9) and:theValue(10.1)];
+                   });
+
+                it(@"should not retry when Retry-After is longer than the longest delay", ^
+                   {
+                       MHVRetryPolicy *policy = [MHVRetryPolicy new];
+                       policy.maxDelay = 30;
+
+                       NSTimeInterval delay = [policy retryDelayForAttempt:0 statusCode:503 headers:@{ @"Retry-After" : @"120" } error:nil];
+
+                       [[theValue(delay) should] equal:theValue(MHVRetryPolicyNoRetry)];
+                   });
+            });
+
+    context(@"Failures", ^
+            {
+                it(@"should retry server errors and timeouts, but not client errors", ^
+                   {
+                       MHVRetryPolicy *policy = [MHVRetryPolicy new];
+                       NSError *timeout = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorTimedOut userInfo:nil];
+                       NSError *offline = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorNotConnectedToInternet userInfo:nil];
+
+                       [[theValue([policy retryDelayForAttempt:0 statusCode:500 headers:nil error:nil]) should] beGreaterThanOrEqualTo:theValue(0)];
+                       [[theValue([policy retryDelayForAttempt:0 statusCode:503 headers:nil error:nil]) should] beGreaterThanOrEqualTo:theValue(0)];
+                       [[theValue([policy retryDelayForAttempt:0 statusCode:504 headers:nil error:nil]) should] beGreaterThanOrEqualTo:theValue(0)];
+                       [[theValue([policy retryDelayForAttempt:0 statusCode:0 headers:nil error:timeout]) should] beGreaterThanOrEqualTo:theValue(0)];
+                       [[theValue([policy retryDelayForAttempt:0 statusCode:400 headers:nil error:nil]) should] equal:theValue(MHVRetryPolicyNoRetry)];
+                       [[theValue([policy retryDelayForAttempt:0 statusCode:0 headers:nil error:offline]) should] equal:theValue(MHVRetryPolicyNoRetry)];
+                   });
+
+                it(@"should stop after the most retries", ^
+                   {
+                       MHVRetryPolicy *policy = [MHVRetryPolicy new];
+                       policy.maxRetryCount = 2;
+
+                       [[theValue([policy retryDelayForAttempt:1 statusCode:503 headers:nil error:nil]) should] beGreaterThanOrEqualTo:theValue(0)];
+                       [[theValue([policy retryDelayForAttempt:2 statusCode:503 headers:nil error:nil]) should] equal:theValue(MHVRetryPolicyNoRetry)];
+                   });
+
+                it(@"should limit retries to the budget", ^
+                   {
+                       MHVRetryPolicy *policy = [MHVRetryPolicy new];
+                       policy.retryBudgetCapacity = 2;
+                       policy.retryBudgetRatio = 0.5;
+
+                       [[theValue([policy retryDelayForAttempt:0 statusCode:503 headers:nil error:nil]) should] beGreaterThanOrEqualTo:theValue(0)];
+                       [[theValue([policy retryDelayForAttempt:0 statusCode:503 headers:nil error:nil]) should] beGreaterThanOrEqualTo:theValue(0)];
+                       [[theValue([policy retryDelayForAttempt:0 statusCode:503 headers:nil error:nil]) should] equal:theValue(MHVRetryPolicyNoRetry)];
+
+                       // Two more requests earn one more retry
+                       [policy didSendRequest];
+                       [policy didSendRequest];
+
+                       [[theValue([policy retryDelayForAttempt:0 statusCode:503 headers:nil error:nil]) should] beGreaterThanOrEqualTo:theValue(0)];
+                       [[theValue([policy retryDelayForAttempt:0 statusCode:503 headers:nil error:nil]) should] equal:theValue(MHVRetryPolicyNoRetry)];
+                   });
+            });
+
+    context(@"Connection with a stand-in server", ^
+            {
+                __block MHVConfiguration *configuration;
+                __block MHVConnection *connection;
+                __block MHVServiceResponse *resultResponse;
+                __block NSError *resultError;
+                __block NSNumber *isComplete;
+
+                void (^execute)(MHVMethod *) = ^(MHVMethod *method)
+                {
+                    [connection executeHttpServiceOperation:method
+                                                 completion:^(MHVServiceResponse * _Nullable response, NSError * _Nullable error)
+                     {
+                         resultResponse = response;
+                         resultError = error;
+                         isComplete = @(YES);
+                     }];
+                };
+
+                beforeEach(^{
+                    resultResponse = nil;
+                    resultError = nil;
+                    isComplete = @(NO);
+
+                    configuration = [MHVConfiguration new];
+                    configuration.defaultHealthVaultUrl = [NSURL URLWithString:[NSString stringWithFormat:@"https://%@/platform/", kStandInHost]];
+                    configuration.retryPolicy.baseDelay = 0.05;
+
+                    NSURLSessionConfiguration *sessionConfiguration = [NSURLSessionConfiguration ephemeralSessionConfiguration];
+                    sessionConfiguration.protocolClasses = @[[MHVStandInServerProtocol class]];
+                    MHVHttpService *httpService = [[MHVHttpService alloc] initWithURLSession:[NSURLSession sessionWithConfiguration:sessionConfiguration]];
+
+                    KWMock<MHVKeychainServiceProtocol> *keychainService = [KWMock nullMockForProtocol:@protocol(MHVKeychainServiceProtocol)];
+                    KWMock<MHVShellAuthServiceProtocol> *authService = [KWMock nullMockForProtocol:@protocol(MHVShellAuthServiceProtocol)];
+
+                    connection = [[MHVSodaConnection alloc] initWithConfiguration:configuration
+                                                                cacheSynchronizer:nil
+                                                               cacheConfiguration:nil
+                                                                    clientFactory:[MHVClientFactory nullMock]
+                                                                      httpService:httpService
+                                                                  keychainService:keychainService
+                                                                 shellAuthService:authService];
+
+                    connection.serviceInstance = [[MHVServiceInstance alloc] init];
+                    connection.serviceInstance.healthServiceUrl = configuration.defaultHealthVaultUrl;
+                    connection.sessionCredential = [[MHVSessionCredential alloc] initWithToken:@"TOKEN" sharedSecret:@"SECRET"];
+                });
+
+                it(@"should retry 503s until the server recovers", ^
+                   {
+                       [MHVStandInServerProtocol scriptResponses:@[@{ @"status" : @(503), @"headers" : @{ @"Retry-After" : @"0" } },
+                                                                   @{ @"status" : @(503) },
+                                                                   @{ @"status" : @(200) }]];
+
+                       execute([MHVMethod getThings]);
+
+                       [[expectFutureValue(isComplete) shouldEventually] beYes];
+                       [[resultError should] beNil];
+                       [[resultResponse.infoXml should] containString:@"INFOXML"];
+                       [[theValue([MHVStandInServerProtocol requestDates].count) should] equal:theValue(3)];
+                   });
+
+                it(@"should wait for Retry-After", ^
+                   {
+                       [MHVStandInServerProtocol scriptResponses:@[@{ @"status" : @(503), @"headers" : @{ @"Retry-After" : @"1" } },
+                                                                   @{ @"status" : @(200) }]];
+
+                       execute([MHVMethod getThings]);
+
+                       [[expectFutureValue(isComplete) shouldEventuallyBeforeTimingOutAfter(5)] beYes];
+                       [[resultError should] beNil];
+
+                       NSArray<NSDate *> *requestDates = [MHVStandInServerProtocol requestDates];
+                       [[theValue(requestDates.count) should] equal:theValue(2)];
+                       [[theValue([requestDates[1] timeIntervalSinceDate:requestDates[0]]) should] beGreaterThanOrEqualTo:theValue(0.9)];
+                   });
+
+                it(@"should give up after the most retries", ^
+                   {
+                       [MHVStandInServerProtocol scriptResponses:@[@{ @"status" : @(500) },
+                                                                   @{ @"status" : @(500) },
+                                                                   @{ @"status" : @(500) },
+                                                                   @{ @"status" : @(500) }]];
+
+                       execute([MHVMethod getThings]);
+
+                       [[expectFutureValue(isComplete) shouldEventually] beYes];
+                       [[resultError shouldNot] beNil];
+                       [[theValue([MHVStandInServerProtocol requestDates].count) should] equal:theValue(3)];
+                   });
+
+                it(@"should retry read-only methods that time out", ^
+                   {
+                       [MHVStandInServerProtocol scriptResponses:@[[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorTimedOut userInfo:nil],
+                                                                   @{ @"status" : @(200) }]];
+
+                       execute([MHVMethod getThings]);
+
+                       [[expectFutureValue(isComplete) shouldEventually] beYes];
+                       [[resultError should] beNil];
+                       [[theValue([MHVStandInServerProtocol requestDates].count) should] equal:theValue(2)];
+                   });
+
+                it(@"should not retry methods that change data when they time out", ^
+                   {
+                       [MHVStandInServerProtocol scriptResponses:@[[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorTimedOut userInfo:nil],
+                                                                   @{ @"status" : @(200) }]];
+
+                       execute([MHVMethod putThings]);
+
+                       [[expectFutureValue(isComplete) shouldEventually] beYes];
+                       [[resultError shouldNot] beNil];
+                       [[theValue([MHVStandInServerProtocol requestDates].count) should] equal:theValue(1)];
+                   });
+
+                it(@"should retry gateway errors for read-only methods", ^
+                   {
+                       [MHVStandInServerProtocol scriptResponses:@[@{ @"status" : @(504) },
+                                                                   @{ @"status" : @(200) }]];
+
+                       execute([MHVMethod getThings]);
+
+                       [[expectFutureValue(isComplete) shouldEventually] beYes];
+                       [[resultError should] beNil];
+                       [[theValue([MHVStandInServerProtocol requestDates].count) should] equal:theValue(2)];
+                   });
+
+                it(@"should not retry methods that change data after a gateway error", ^
+                   {
+                       [MHVStandInServerProtocol scriptResponses:@[@{ @"status" : @(502) },
+                                                                   @{ @"status" : @(200) }]];
+
+                       execute([MHVMethod putThings]);
+
+                       [[expectFutureValue(isComplete) shouldEventually] beYes];
+                       [[resultError shouldNot] beNil];
+                       [[theValue([MHVStandInServerProtocol requestDates].count) should] equal:theValue(1)];
+                   });
+
+                it(@"should stop retrying when the budget is used", ^
+                   {
+                       configuration.retryPolicy.retryBudgetCapacity = 1;
+                       configuration.retryPolicy.retryBudgetRatio = 0;
+
+                       [MHVStandInServerProtocol scriptResponses:@[@{ @"status" : @(503) },
+                                                                   @{ @"status" : @(503) },
+                                                                   @{ @"status" : @(503) }]];
+
+                       execute([MHVMethod getThings]);
+
+                       [[expectFutureValue(isComplete) shouldEventually] beYes];
+                       [[resultError shouldNot] beNil];
+                       [[theValue([MHVStandInServerProtocol requestDates].count) should] equal:theValue(2)];
+                   });
+            });
+});
+
+SPEC_END
@@ -0,0 +1,595 @@
+//
+//  MHVBlobUploadTests.m
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import "MHVHttpService.h"
+#import "MHVHttpServiceResponse.h"
+#import "MHVHttpTaskProtocol.h"
+#import "MHVBlobSource.h"
+#import "MHVBlobHasher.h"
+#import "MHVBlobHashInfo.h"
+#import "MHVErrorConstants.h"
+#import "Kiwi.h"
+
+static NSString *const kBlobHost = @"blob.test";
+
+/**
+ A stand-in for HealthVault blob storage. Keeps each chunk by the offset in its Content-Range,
+ responding after a fixed latency, and records how many chunks were in flight at once.
+ */
+@interface MHVBlobStorageServerProtocol : NSURLProtocol
+
++ (void)resetWithLatency:(NSTimeInterval)latency failingOffset:(NSInteger)failingOffset;
++ (NSData *)storedBlob;
+
+// Keeps the stored chunks, e.g. for a connection that comes back, and starts counting received bytes again
++ (void)setFailingOffset:(NSInteger)failingOffset;
++ (NSUInteger)receivedLength;
++ (NSUInteger)maxInFlightCount;
+
+// YES if the chunk with the x-hv-blob-complete header arrived after every other chunk was stored
++ (BOOL)completedAfterOtherChunks;
+
+@end
+
+@implementation MHVBlobStorageServerProtocol
+
+static NSTimeInterval gLatency;
+static NSInteger gFailingOffset;
+static NSMutableDictionary<NSNumber *, NSData *> *gChunks;
+static NSUInteger gInFlightCount;
+static NSUInteger gReceivedLength;
+static NSUInteger gMaxInFlightCount;
+static BOOL gCompletedAfterOtherChunks;
+
++ (void)resetWithLatency:(NSTimeInterval)latency failingOffset:(NSInteger)failingOffset
+{
+    @synchronized (self)
+    {
+        gLatency = latency;
+        gFailingOffset = failingOffset;
+        gChunks = [NSMutableDictionary new];
+        gInFlightCount = 0;
+        gReceivedLength = 0;
+        gMaxInFlightCount = 0;
+        gCompletedAfterOtherChunks = NO;
+    }
+}
+
++ (NSData *)storedBlob
+{
+    @synchronized (self)
+    {
+        NSMutableData *blob = [NSMutableData new];
+
+        for (NSNumber *offset in [gChunks.allKeys sortedArrayUsingSelector:@selector(compare:)])
+        {
+            if (offset.unsignedIntegerValue != blob.length)
+            {
+                return nil;
+            }
+
+            [blob appendData:gChunks[offset]];
+        }
+
+        return blob;
+    }
+}
+
++ (void)setFailingOffset:(NSInteger)failingOffset
+{
+    @synchronized (self)
+    {
+        gFailingOffset = failingOffset;
+        gReceivedLength = 0;
+    }
+}
+
++ (NSUInteger)receivedLength
+{
+    @synchronized (self)
+    {
+        return gReceivedLength;
+    }
+}
+
++ (NSUInteger)maxInFlightCount
+{
+    @synchronized (self)
+    {
+        return gMaxInFlightCount;
+    }
+}
+
++ (BOOL)completedAfterOtherChunks
+{
+    @synchronized (self)
+    {
+        return gCompletedAfterOtherChunks;
+    }
+}
+
++ (BOOL)canInitWithRequest:(NSURLRequest *)request
+{
+    return [request.URL.host isEqualToString:kBlobHost];
+}
+
++ (NSURLRequest *)canonicalRequestForRequest:(NSURLRequest *)request
+{
+    return request;
+}
+
+- (NSData *)body
+{
+    if (self.request.HTTPBody)
+    {
+        return self.request.HTTPBody;
+    }
+
+    NSMutableData *body = [NSMutableData new];
+    NSInputStream *stream = self.request.HTTPBodyStream;
+    uint8_t buffer[16 * 1024];
+
+    [stream open];
+    for (NSInteger count = [stream read:buffer maxLength:sizeof(buffer)]; count > 0; count = [stream read:buffer maxLength:sizeof(buffer)])
+    {
+        [body appendBytes:buffer length:count];
+    }
+    [stream close];
+
+    return body;
+}
+
+- (void)startLoading
+{
+    NSData *body = [self body];
+    NSString *contentRange = [self.request valueForHTTPHeaderField:@"Content-Range"];
+    NSInteger offset = [[contentRange substringFromIndex:@"bytes ".length] integerValue];
+    BOOL isComplete = [[self.request valueForHTTPHeaderField:@"x-hv-blob-complete"] isEqualToString:@"1"];
+    NSTimeInterval latency = 0;
+
+    @synchronized ([MHVBlobStorageServerProtocol class])
+    {
+        gInFlightCount += 1;
+        gReceivedLength += body.length;
+        gMaxInFlightCount = MAX(gMaxInFlightCount, gInFlightCount);
+        latency = gLatency;
+
+        if (isComplete)
+        {
+            gCompletedAfterOtherChunks = gInFlightCount == 1;
+        }
+    }
+
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(latency * NSEC_PER_SEC)), dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^
+    {
+        NSInteger statusCode = 200;
+
+        @synchronized ([MHVBlobStorageServerProtocol class])
+        {
+            gInFlightCount -= 1;
+
+            if (offset == gFailingOffset)
+            {
+                statusCode = 500;
+            }
+            else
+            {
+                gChunks[@(offset)] = body;
+            }
+        }
+
+        NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:self.request.URL statusCode:statusCode HTTPVersion:@"HTTP/1.1" headerFields:@{}];
+
+        [self.client URLProtocol:self didReceiveResponse:response cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+        [self.client URLProtocolDidFinishLoading:self];
+    });
+}
+
+- (void)stopLoading
+{
+}
+
+@end
+
+static NSData *MHVBlobDataOfLength(NSUInteger length)
+{
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    uint8_t *bytes = data.mutableBytes;
+
+    for (NSUInteger i = 0; i < length; i++)
+    {
+        bytes[i] = (uint8_t)(i * 31 + i / 256);
+    }
+
+    return data;
+}
+
+SPEC_BEGIN(MHVBlobUploadTests)
+
+describe(@"MHVHttpService", ^
+{
+    __block MHVHttpService *httpService;
+
+    // The chunk digests last given with the committed length, which a continued upload is checked against
+    __block NSData *chunkDigests;
+
+    NSUInteger chunkSize = 32 * 1024;
+    NSData *blobData = MHVBlobDataOfLength(chunkSize * 15 + 1000);
+
+    beforeEach(^
+    {
+        NSURLSessionConfiguration *sessionConfiguration = [NSURLSessionConfiguration ephemeralSessionConfiguration];
+        sessionConfiguration.protocolClasses = @[[MHVBlobStorageServerProtocol class]];
+        sessionConfiguration.HTTPMaximumConnectionsPerHost = 16;
+
+        httpService = [[MHVHttpService alloc] initWithURLSession:[NSURLSession sessionWithConfiguration:sessionConfiguration]];
+        chunkDigests = nil;
+    });
+
+    // Uploads the blob from an offset, hashing it if there's a hasher, and returns the final response and the last committed length reported
+    MHVHttpServiceResponse *(^hashAndResumeData)(NSData *, NSUInteger, NSUInteger *, MHVBlobHasher *, NSError **) = ^MHVHttpServiceResponse *(NSData *data, NSUInteger startOffset, NSUInteger *committedLength, MHVBlobHasher *blobHasher, NSError **error)
+    {
+        dispatch_semaphore_t done = dispatch_semaphore_create(0);
+        __block MHVHttpServiceResponse *result = nil;
+        __block NSError *resultError = nil;
+        __block NSUInteger lastCommittedLength = startOffset;
+
+        [httpService uploadBlobSource:[[MHVBlobMemorySource alloc] initWithData:data]
+                                toUrl:[NSURL URLWithString:[NSString stringWithFormat:@"https://%@/streaming/wildcatblob.ashx", kBlobHost]]
+                            chunkSize:chunkSize
+                          startOffset:startOffset
+                   storedChunkDigests:chunkDigests
+               committedLengthHandler:^(NSUInteger length, NSData *digests)
+         {
+             lastCommittedLength = length;
+             chunkDigests = digests;
+         }
+                           blobHasher:blobHasher
+                           completion:^(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error)
+         {
+             result = response;
+             resultError = error;
+             dispatch_semaphore_signal(done);
+         }];
+
+        dispatch_semaphore_wait(done, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(30 * NSEC_PER_SEC)));
+
+        if (committedLength)
+        {
+            *committedLength = lastCommittedLength;
+        }
+
+        if (error)
+        {
+            *error = resultError;
+        }
+
+        return result;
+    };
+
+    MHVHttpServiceResponse *(^hashAndResume)(NSUInteger, NSUInteger *, MHVBlobHasher *) = ^MHVHttpServiceResponse *(NSUInteger startOffset, NSUInteger *committedLength, MHVBlobHasher *blobHasher)
+    {
+        return hashAndResumeData(blobData, startOffset, committedLength, blobHasher, nil);
+    };
+
+    MHVHttpServiceResponse *(^resume)(NSUInteger, NSUInteger *) = ^MHVHttpServiceResponse *(NSUInteger startOffset, NSUInteger *committedLength)
+    {
+        return hashAndResume(startOffset, committedLength, nil);
+    };
+
+    // Uploads the blob, returning the final response and the time it took
+    MHVHttpServiceResponse *(^upload)(NSTimeInterval *) = ^MHVHttpServiceResponse *(NSTimeInterval *duration)
+    {
+        NSDate *start = [NSDate date];
+
+        MHVHttpServiceResponse *result = resume(0, nil);
+
+        if (duration)
+        {
+            *duration = [[NSDate date] timeIntervalSinceDate:start];
+        }
+
+        return result;
+    };
+
+    context(@"Blob upload", ^
+            {
+                it(@"should send several chunks at a time and complete the blob last", ^
+                   {
+                       [MHVBlobStorageServerProtocol resetWithLatency:0.02 failingOffset:-1];
+                       httpService.blobUploadConcurrentChunkCount = 4;
+
+                       MHVHttpServiceResponse *response = upload(nil);
+
+                       [[theValue(response.statusCode) should] equal:theValue(200)];
+                       [[[MHVBlobStorageServerProtocol storedBlob] should] equal:blobData];
+                       [[theValue([MHVBlobStorageServerProtocol maxInFlightCount]) should] equal:theValue(4)];
+                       [[theValue([MHVBlobStorageServerProtocol completedAfterOtherChunks]) should] beYes];
+                   });
+
+                it(@"should send several chunks at a time by default", ^
+                   {
+                       [MHVBlobStorageServerProtocol resetWithLatency:0.02 failingOffset:-1];
+
+                       upload(nil);
+
+                       [[[MHVBlobStorageServerProtocol storedBlob] should] equal:blobData];
+                       [[theValue([MHVBlobStorageServerProtocol maxInFlightCount]) should] beGreaterThan:theValue(1)];
+                   });
+
+                it(@"should send one chunk at a time when the count is 1", ^
+                   {
+                       [MHVBlobStorageServerProtocol resetWithLatency:0 failingOffset:-1];
+                       httpService.blobUploadConcurrentChunkCount = 1;
+
+                       upload(nil);
+
+                       [[[MHVBlobStorageServerProtocol storedBlob] should] equal:blobData];
+                       [[theValue([MHVBlobStorageServerProtocol maxInFlightCount]) should] equal:theValue(1)];
+                   });
+
+                it(@"should stop with the response of a chunk that fails", ^
+                   {
+                       [MHVBlobStorageServerProtocol resetWithLatency:0.02 failingOffset:chunkSize * 2];
+                       httpService.blobUploadConcurrentChunkCount = 4;
+
+                       MHVHttpServiceResponse *response = upload(nil);
+
+                       [[theValue(response.statusCode) should] equal:theValue(500)];
+                       [[theValue([MHVBlobStorageServerProtocol completedAfterOtherChunks]) should] beNo];
+                   });
+
+                it(@"should fail when the blob source ends before its length", ^
+                   {
+                       [MHVBlobStorageServerProtocol resetWithLatency:0 failingOffset:-1];
+
+                       dispatch_semaphore_t done = dispatch_semaphore_create(0);
+                       __block NSError *result = nil;
+
+                       // Claims the whole blob, but the stream holds a little over 2 chunks
+                       NSInputStream *stream = [NSInputStream inputStreamWithData:[blobData subdataWithRange:NSMakeRange(0, chunkSize * 2 + 100)]];
+
+                       [httpService uploadBlobSource:[[MHVBlobStreamSource alloc] initWithInputStream:stream length:blobData.length]
+                                               toUrl:[NSURL URLWithString:[NSString stringWithFormat:@"https://%@/streaming/wildcatblob.ashx", kBlobHost]]
+                                           chunkSize:chunkSize
+                                         startOffset:0
+                                  storedChunkDigests:nil
+                              committedLengthHandler:nil
+                                          blobHasher:nil
+                                          completion:^(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error)
+                        {
+                            result = error;
+                            dispatch_semaphore_signal(done);
+                        }];
+
+                       dispatch_semaphore_wait(done, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(30 * NSEC_PER_SEC)));
+
+                       [[theValue(result.code) should] equal:theValue(MHVErrorTypeIOError)];
+                       [[theValue([MHVBlobStorageServerProtocol completedAfterOtherChunks]) should] beNo];
+                   });
+
+                it(@"should store the chunks sent while the blob source waits for more of the blob", ^
+                   {
+                       [MHVBlobStorageServerProtocol resetWithLatency:0 failingOffset:-1];
+
+                       dispatch_semaphore_t done = dispatch_semaphore_create(0);
+                       __block MHVHttpServiceResponse *result = nil;
+                       __block NSUInteger committedLength = 0;
+                       NSOutputStream *outputStream = nil;
+                       NSUInteger firstPartLength = chunkSize * 2 + 100;
+
+                       MHVBlobStreamSource *source = [[MHVBlobStreamSource alloc] initWithLength:blobData.length bufferSize:blobData.length outputStream:&outputStream];
+                       [outputStream open];
+                       [outputStream write:blobData.bytes maxLength:firstPartLength];
+
+                       [httpService uploadBlobSource:source
+                                               toUrl:[NSURL URLWithString:[NSString stringWithFormat:@"https://%@/streaming/wildcatblob.ashx", kBlobHost]]
+                                           chunkSize:chunkSize
+                                         startOffset:0
+                                  storedChunkDigests:nil
+                              committedLengthHandler:^(NSUInteger length, NSData *digests)
+                        {
+                            committedLength = length;
+                        }
+                                          blobHasher:nil
+                                          completion:^(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error)
+                        {
+                            result = response;
+                            dispatch_semaphore_signal(done);
+                        }];
+
+                       // The third chunk waits for the rest of the blob, but the first two are stored meanwhile
+                       [[expectFutureValue(theValue(committedLength)) shouldEventually] equal:theValue(chunkSize * 2)];
+
+                       [outputStream write:(const uint8_t *)blobData.bytes + firstPartLength maxLength:blobData.length - firstPartLength];
+                       [outputStream close];
+
+                       dispatch_semaphore_wait(done, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(30 * NSEC_PER_SEC)));
+
+                       [[theValue(result.statusCode) should] equal:theValue(200)];
+                       [[[MHVBlobStorageServerProtocol storedBlob] should] equal:blobData];
+                   });
+            });
+
+    context(@"Resume", ^
+            {
+                it(@"should not count chunks stored after one that failed", ^
+                   {
+                       [MHVBlobStorageServerProtocol resetWithLatency:0.02 failingOffset:0];
+                       httpService.blobUploadConcurrentChunkCount = 4;
+
+                       NSUInteger committedLength = 0;
+                       resume(0, &committedLength);
+
+                       [[theValue(committedLength) should] equal:theValue(0)];
+                   });
+
+                it(@"should continue from the committed length and send only the rest of the blob", ^
+                   {
+                       [MHVBlobStorageServerProtocol resetWithLatency:0 failingOffset:chunkSize * 10];
+                       httpService.blobUploadConcurrentChunkCount = 1;
+
+                       NSUInteger committedLength = 0;
+                       resume(0, &committedLength);
+
+                       [MHVBlobStorageServerProtocol setFailingOffset:-1];
+
+                       MHVHttpServiceResponse *response = resume(committedLength, &committedLength);
+
+                       [[theValue(response.statusCode) should] equal:theValue(200)];
+                       [[theValue(committedLength) should] equal:theValue(blobData.length)];
+                       [[theValue([MHVBlobStorageServerProtocol receivedLength]) should] equal:theValue(blobData.length - chunkSize * 10)];
+                       [[[MHVBlobStorageServerProtocol storedBlob] should] equal:blobData];
+                   });
+
+                it(@"should not continue when the stored part of the blob has changed", ^
+                   {
+                       [MHVBlobStorageServerProtocol resetWithLatency:0 failingOffset:chunkSize * 10];
+                       httpService.blobUploadConcurrentChunkCount = 1;
+
+                       NSUInteger committedLength = 0;
+                       resume(0, &committedLength);
+
+                       [MHVBlobStorageServerProtocol setFailingOffset:-1];
+
+                       // The same length, with a byte changed in the middle
+                       NSMutableData *changedData = [blobData mutableCopy];
+                       ((uint8_t *)changedData.mutableBytes)[chunkSize * 5 + 7] ^= 0xFF;
+
+                       NSError *error = nil;
+                       hashAndResumeData(changedData, committedLength, nil, nil, &error);
+
+                       [[theValue(error.code) should] equal:theValue(MHVErrorTypeOperationCannotBePerformed)];
+                       [[theValue([MHVBlobStorageServerProtocol receivedLength]) should] equal:theValue(0)];
+                   });
+
+                it(@"should check and hash a blob that was already stored without sending it", ^
+                   {
+                       [MHVBlobStorageServerProtocol resetWithLatency:0 failingOffset:-1];
+
+                       NSUInteger committedLength = 0;
+                       resume(0, &committedLength);
+
+                       [MHVBlobStorageServerProtocol setFailingOffset:-1];
+
+                       MHVBlobHasher *hasher = [[MHVBlobHasher alloc] initWithBlockSize:chunkSize];
+                       MHVHttpServiceResponse *response = hashAndResume(committedLength, nil, hasher);
+
+                       [[theValue(response.statusCode) should] equal:theValue(200)];
+                       [[theValue([MHVBlobStorageServerProtocol receivedLength]) should] equal:theValue(0)];
+                       [[theValue(hasher.length) should] equal:theValue(blobData.length)];
+                   });
+            });
+
+    context(@"Hash", ^
+            {
+                it(@"should hash each block, then the block hashes", ^
+                   {
+                       MHVBlobHasher *hasher = [[MHVBlobHasher alloc] initWithBlockSize:4];
+                       [hasher appendData:[@"abc" dataUsingEncoding:NSUTF8StringEncoding]];
+                       [hasher appendData:[@"defghij" dataUsingEncoding:NSUTF8StringEncoding]];
+
+                       MHVBlobHashInfo *hashInfo = [hasher hashInfo];
+
+                       [[hashInfo.algorithm should] equal:@"SHA256Block"];
+                       [[theValue(hashInfo.params.blockSize.value) should] equal:theValue(4)];
+                       [[hashInfo.hash should] equal:@"Obym+jYZ9n7k1vjfUUkVWFYPQpkgWT9/ZJEZuj8oXtk="];
+                   });
+
+                it(@"should hash blobs that end on a block and empty blobs", ^
+                   {
+                       MHVBlobHasher *hasher = [[MHVBlobHasher alloc] initWithBlockSize:4];
+                       [hasher appendData:[@"abcdefgh" dataUsingEncoding:NSUTF8StringEncoding]];
+
+                       [[[hasher hashInfo].hash should] equal:@"fVRzcSFy+ewUlLqgPaPYc00S04XRymNAhWdxw9kzguY="];
+                       [[[[[MHVBlobHasher alloc] initWithBlockSize:4] hashInfo].hash should] equal:@"Xfbg4nYTWdMKgnUFjimfzAOBU0VF9Vz0PkGYP11MlFY="];
+                   });
+
+                it(@"should hash the blob as it's uploaded, and the stored part when continuing", ^
+                   {
+                       MHVBlobHasher *expectedHasher = [[MHVBlobHasher alloc] initWithBlockSize:chunkSize * 2 + 100];
+                       [expectedHasher appendData:blobData];
+                       NSString *expectedHash = [expectedHasher hashInfo].hash;
+
+                       [MHVBlobStorageServerProtocol resetWithLatency:0.01 failingOffset:-1];
+                       httpService.blobUploadConcurrentChunkCount = 4;
+
+                       MHVBlobHasher *hasher = [[MHVBlobHasher alloc] initWithBlockSize:chunkSize * 2 + 100];
+                       hashAndResume(0, nil, hasher);
+
+                       [[theValue(hasher.length) should] equal:theValue(blobData.length)];
+                       [[[hasher hashInfo].hash should] equal:expectedHash];
+
+                       MHVBlobHasher *resumedHasher = [[MHVBlobHasher alloc] initWithBlockSize:chunkSize * 2 + 100];
+                       hashAndResume(chunkSize * 5, nil, resumedHasher);
+
+                       [[[resumedHasher hashInfo].hash should] equal:expectedHash];
+                   });
+            });
+
+    context(@"Performance", ^
+            {
+                it(@"should upload faster with chunks in flight over a high latency link", ^
+                   {
+                       NSTimeInterval latency = 0.1;
+                       NSTimeInterval sequentialDuration = 0;
+                       NSTimeInterval pipelinedDuration = 0;
+
+                       [MHVBlobStorageServerProtocol resetWithLatency:latency failingOffset:-1];
+                       httpService.blobUploadConcurrentChunkCount = 1;
+                       upload(&sequentialDuration);
+
+                       [MHVBlobStorageServerProtocol resetWithLatency:latency failingOffset:-1];
+                       httpService.blobUploadConcurrentChunkCount = 4;
+                       upload(&pipelinedDuration);
+
+                       [[[MHVBlobStorageServerProtocol storedBlob] should] equal:blobData];
+                       [[theValue(pipelinedDuration * 2) should] beLessThan:theValue(sequentialDuration)];
+                   });
+
+                it(@"should hash the blob as it's uploaded without slowing the upload", ^
+                   {
+                       // Without latency the upload time is mostly the work on the upload's queue, which hashing adds to.
+                       // The fastest of a few uploads is compared, as single upload times are noisy
+                       httpService.blobUploadConcurrentChunkCount = 4;
+
+                       NSTimeInterval uploadDuration = DBL_MAX;
+                       NSTimeInterval hashedUploadDuration = DBL_MAX;
+
+                       for (NSUInteger i = 0; i < 3; i++)
+                       {
+                           [MHVBlobStorageServerProtocol resetWithLatency:0 failingOffset:-1];
+                           NSDate *start = [NSDate date];
+                           resume(0, nil);
+                           uploadDuration = MIN(uploadDuration, [[NSDate date] timeIntervalSinceDate:start]);
+
+                           [MHVBlobStorageServerProtocol resetWithLatency:0 failingOffset:-1];
+                           start = [NSDate date];
+                           hashAndResume(0, nil, [[MHVBlobHasher alloc] initWithBlockSize:chunkSize * 2]);
+                           hashedUploadDuration = MIN(hashedUploadDuration, [[NSDate date] timeIntervalSinceDate:start]);
+                       }
+
+                       [[[MHVBlobStorageServerProtocol storedBlob] should] equal:blobData];
+                       [[theValue(hashedUploadDuration) should] beLessThan:theValue(uploadDuration * 1.05)];
+                   });
+            });
+});
+
+SPEC_END
@@ -0,0 +1,302 @@
+//
+//  MHVCompressionTests.m
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import "NSData+Utils.h"
+#import "NSData+Decompression.h"
+#import "MHVHttpService.h"
+#import "MHVHttpServiceResponse.h"
+#import "MHVHttpServiceProtocol.h"
+#import "MHVConfiguration.h"
+#import "MHVSodaConnection.h"
+#import "MHVMethod.h"
+#import "MHVClientFactory.h"
+#import "MHVKeychainServiceProtocol.h"
+#import "MHVShellAuthServiceProtocol.h"
+#import "MHVSessionCredential.h"
+#import "MHVServiceInstance.h"
+#import "Kiwi.h"
+
+static NSString *const kCompressingHost = @"compressing.test";
+
+// Bytes per second of the link the stand-in server simulates
+static double const kLinkBandwidth = 1024 * 1024;
+
+@interface MHVConnection (CompressionTesting)
+
+@property (nonatomic, strong, nullable) MHVSessionCredential *sessionCredential;
+
+@end
+
+// A GetThings response with many similar things, like a sync of a week of readings
+static NSData *MHVGetThingsResponseData(NSUInteger thingCount)
+{
+    NSMutableString *xml = [NSMutableString stringWithString:@"<response><status><code>0</code></status><wc:info xmlns:wc=\"urn:com.microsoft.wc.methods.response.GetThings3\"><group>"];
+
+    for (NSUInteger i = 0; i < thingCount; i++)
+    {
+        [xml appendFormat:@"<thing><thing-id version-stamp=\"%@\">%@</thing-id><type-id name=\"Weight Measurement\">3d34d87e-7fc1-4153-800f-f56592cb0d17</type-id>"
+                          "<thing-state>Active</thing-state><flags>0</flags><eff-date>2017-06-%02lu</eff-date><data-xml><weight><when><date><y>2017</y><m>6</m><d>%lu</d></date>"
+                          "<time><h>%lu</h><m>%lu</m><s>0</s></time></when><value><kg>%lu.%lu</kg><display units=\"lb\">%lu</display></value></weight><common/></data-xml></thing>",
+                          [NSUUID UUID].UUIDString, [NSUUID UUID].UUIDString, (unsigned long)(i % 28 + 1), (unsigned long)(i % 28 + 1),
+                          (unsigned long)(i % 24), (unsigned long)(i % 60), (unsigned long)(60 + i % 20), (unsigned long)(i % 10), (unsigned long)(132 + i % 44)];
+    }
+
+    [xml appendString:@"</group></wc:info></response>"];
+
+    return [xml dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+/**
+ A stand-in for a compressing server on a slow link. Responds with the body it's given, taking as long as
+ the body would take to arrive over the link, compressed if the stand-in compresses.
+ */
+@interface MHVCompressingServerProtocol : NSURLProtocol
+
+@property (class, nonatomic, strong) NSData *responseData;
+@property (class, nonatomic, assign) BOOL compressesResponses;
+
+@end
+
+@implementation MHVCompressingServerProtocol
+
+static NSData *gResponseData;
+static BOOL gCompressesResponses;
+
++ (NSData *)responseData
+{
+    return gResponseData;
+}
+
++ (void)setResponseData:(NSData *)responseData
+{
+    gResponseData = responseData;
+}
+
++ (BOOL)compressesResponses
+{
+    return gCompressesResponses;
+}
+
++ (void)setCompressesResponses:(BOOL)compressesResponses
+{
+    gCompressesResponses = compressesResponses;
+}
+
++ (BOOL)canInitWithRequest:(NSURLRequest *)request
+{
+    return [request.URL.host isEqualToString:kCompressingHost];
+}
+
++ (NSURLRequest *)canonicalRequestForRequest:(NSURLRequest *)request
+{
+    return request;
+}
+
+- (void)startLoading
+{
+    NSData *body = gResponseData;
+    NSUInteger transferLength = body.length;
+
+    if (gCompressesResponses && [[self.request valueForHTTPHeaderField:@"Accept-Encoding"] containsString:@"gzip"])
+    {
+        NSData *compressed = [body compressedDataWithContentEncoding:@"gzip"];
+        transferLength = compressed.length;
+
+        // URL loading decodes gzip before delivering the body, so decode as it would
+        body = [compressed decompressedData];
+    }
+
+    NSTimeInterval transferDuration = transferLength / kLinkBandwidth;
+
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(transferDuration * NSEC_PER_SEC)), dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^
+    {
+        NSHTTPURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:self.request.URL statusCode:200 HTTPVersion:@"HTTP/1.1" headerFields:@{}];
+
+        [self.client URLProtocol:self didReceiveResponse:response cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+        [self.client URLProtocol:self didLoadData:body];
+        [self.client URLProtocolDidFinishLoading:self];
+    });
+}
+
+- (void)stopLoading
+{
+}
+
+@end
+
+SPEC_BEGIN(MHVCompressionTests)
+
+describe(@"Compression", ^
+{
+    context(@"NSData", ^
+            {
+                NSData *data = MHVGetThingsResponseData(50);
+
+                it(@"should round trip gzip", ^
+                   {
+                       NSData *compressed = [data compressedDataWithContentEncoding:@"gzip"];
+
+                       const uint8_t *bytes = compressed.bytes;
+                       [[theValue(bytes[0]) should] equal:theValue(0x1f)];
+                       [[theValue(bytes[1]) should] equal:theValue(0x8b)];
+                       [[theValue(compressed.length) should] beLessThan:theValue(data.length)];
+                       [[[compressed decompressedData] should] equal:data];
+                   });
+
+                it(@"should round trip deflate", ^
+                   {
+                       NSData *compressed = [data compressedDataWithContentEncoding:@"deflate"];
+
+                       [[theValue(compressed.length) should] beLessThan:theValue(data.length)];
+                       [[[compressed decompressedData] should] equal:data];
+                   });
+
+                it(@"should not compress with an unknown encoding", ^
+                   {
+                       [[[data compressedDataWithContentEncoding:@"br"] should] beNil];
+                   });
+
+                it(@"should not decompress data that isn't compressed", ^
+                   {
+                       [[[data decompressedData] should] beNil];
+                   });
+            });
+
+    context(@"Connection", ^
+            {
+                __block MHVConfiguration *configuration;
+                __block MHVConnection *connection;
+                __block NSData *requestedBody;
+                __block NSDictionary *requestedHeaders;
+
+                beforeEach(^{
+                    requestedBody = nil;
+                    requestedHeaders = nil;
+
+                    configuration = [MHVConfiguration new];
+                    configuration.requestCompressionMethod = @"gzip";
+                    configuration.requestCompressionThreshold = 1024;
+
+                    KWMock<MHVHttpServiceProtocol> *httpService = [KWMock mockForProtocol:@protocol(MHVHttpServiceProtocol)];
+                    [httpService stub:@selector(sendRequestForURL:httpMethod:body:headers:completion:) withBlock:^id(NSArray *params)
+                     {
+                         requestedBody = params[2];
+                         requestedHeaders = params[3];
+                         return nil;
+                     }];
+
+                    connection = [[MHVSodaConnection alloc] initWithConfiguration:configuration
+                                                                cacheSynchronizer:nil
+                                                               cacheConfiguration:nil
+                                                                    clientFactory:[MHVClientFactory nullMock]
+                                                                      httpService:httpService
+                                                                  keychainService:[KWMock nullMockForProtocol:@protocol(MHVKeychainServiceProtocol)]
+                                                                 shellAuthService:[KWMock nullMockForProtocol:@protocol(MHVShellAuthServiceProtocol)]];
+
+                    connection.serviceInstance = [[MHVServiceInstance alloc] init];
+                    connection.serviceInstance.healthServiceUrl = [NSURL URLWithString:@"https://service.url/"];
+                    connection.sessionCredential = [[MHVSessionCredential alloc] initWithToken:@"TOKEN" sharedSecret:@"SECRET"];
+                });
+
+                it(@"should compress large request bodies", ^
+                   {
+                       MHVMethod *method = [MHVMethod putThings];
+                       method.parametersData = MHVGetThingsResponseData(20);
+                       [connection executeHttpServiceOperation:method completion:nil];
+
+                       [[expectFutureValue(requestedBody) shouldEventually] beNonNil];
+                       [[requestedHeaders[@"Content-Encoding"] should] equal:@"gzip"];
+
+                       NSString *body = [[NSString alloc] initWithData:[requestedBody decompressedData] encoding:NSUTF8StringEncoding];
+                       [[body should] containString:@"<method>PutThings</method>"];
+                       [[theValue(requestedBody.length) should] beLessThan:theValue(body.length)];
+                   });
+
+                it(@"should not compress small request bodies", ^
+                   {
+                       MHVMethod *method = [MHVMethod putThings];
+                       method.parameters = @"<info/>";
+                       [connection executeHttpServiceOperation:method completion:nil];
+
+                       [[expectFutureValue(requestedBody) shouldEventually] beNonNil];
+                       [[requestedHeaders[@"Content-Encoding"] should] beNil];
+
+                       NSString *body = [[NSString alloc] initWithData:requestedBody encoding:NSUTF8StringEncoding];
+                       [[body should] containString:@"<method>PutThings</method>"];
+                   });
+
+                it(@"should not compress without a compression method", ^
+                   {
+                       configuration.requestCompressionMethod = nil;
+
+                       MHVMethod *method = [MHVMethod putThings];
+                       method.parametersData = MHVGetThingsResponseData(20);
+                       [connection executeHttpServiceOperation:method completion:nil];
+
+                       [[expectFutureValue(requestedBody) shouldEventually] beNonNil];
+                       [[requestedHeaders[@"Content-Encoding"] should] beNil];
+                   });
+            });
+
+    context(@"Performance", ^
+            {
+                it(@"should make a GetThings response smaller and quicker to receive over a slow link", ^
+                   {
+                       NSData *response = MHVGetThingsResponseData(500);
+                       NSData *compressed = [response compressedDataWithContentEncoding:@"gzip"];
+
+                       NSURLSessionConfiguration *sessionConfiguration = [NSURLSessionConfiguration ephemeralSessionConfiguration];
+                       sessionConfiguration.protocolClasses = @[[MHVCompressingServerProtocol class]];
+                       MHVHttpService *httpService = [[MHVHttpService alloc] initWithURLSession:[NSURLSession sessionWithConfiguration:sessionConfiguration]];
+                       MHVCompressingServerProtocol.responseData = response;
+
+                       NSTimeInterval (^latency)(BOOL) = ^NSTimeInterval(BOOL compresses)
+                       {
+                           MHVCompressingServerProtocol.compressesResponses = compresses;
+
+                           dispatch_semaphore_t done = dispatch_semaphore_create(0);
+                           __block NSUInteger receivedLength = 0;
+                           NSDate *requestStart = [NSDate date];
+
+                           [httpService sendRequestForURL:[NSURL URLWithString:[NSString stringWithFormat:@"https://%@/platform/wildcat.ashx", kCompressingHost]]
+                                                     body:[@"<request/>" dataUsingEncoding:NSUTF8StringEncoding]
+                                               completion:^(MHVHttpServiceResponse * _Nullable httpResponse, NSError * _Nullable error)
+                            {
+                                receivedLength = httpResponse.responseAsData.length;
+                                dispatch_semaphore_signal(done);
+                            }];
+
+                           dispatch_semaphore_wait(done, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(10 * NSEC_PER_SEC)));
+
+                           [[theValue(receivedLength) should] equal:theValue(response.length)];
+
+                           return [[NSDate date] timeIntervalSinceDate:requestStart];
+                       };
+
+                       NSTimeInterval uncompressedLatency = latency(NO);
+                       NSTimeInterval compressedLatency = latency(YES);
+
+                       [[theValue(compressed.length * 4) should] beLessThan:theValue(response.length)];
+                       [[theValue(compressedLatency) should] beLessThan:theValue(uncompressedLatency)];
+                   });
+            });
+});
+
+SPEC_END
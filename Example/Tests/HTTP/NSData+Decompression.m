@@ -0,0 +1,61 @@
+//
+// NSData+Decompression.m
+// healthvault-ios-sdk
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <zlib.h>
+#import "NSData+Decompression.h"
+
+// zlib window bits: 15 is the largest window, +32 detects a gzip or zlib wrapper
+static int const kDetectWindowBits = 15 + 32;
+
+@implementation NSData (Decompression)
+
+- (NSData *)decompressedData
+{
+    z_stream stream = {0};
+    if (inflateInit2(&stream, kDetectWindowBits) != Z_OK)
+    {
+        return nil;
+    }
+    
+    NSMutableData *decompressed = [[NSMutableData alloc] initWithLength:MAX(self.length * 4, 1024)];
+    
+    stream.next_in = (Bytef *)self.bytes;
+    stream.avail_in = (uInt)self.length;
+    
+    int result = Z_OK;
+    while (result == Z_OK)
+    {
+        if (stream.total_out >= decompressed.length)
+        {
+            decompressed.length *= 2;
+        }
+        
+        stream.next_out = (Bytef *)decompressed.mutableBytes + stream.total_out;
+        stream.avail_out = (uInt)(decompressed.length - stream.total_out);
+        
+        result = inflate(&stream, Z_NO_FLUSH);
+    }
+    
+    decompressed.length = stream.total_out;
+    inflateEnd(&stream);
+    
+    return result == Z_STREAM_END ? decompressed : nil;
+}
+
+@end
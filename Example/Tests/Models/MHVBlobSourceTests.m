@@ -0,0 +1,221 @@
+//
+//  MHVBlobSourceTests.m
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <mach/mach.h>
+#import "MHVBlobSource.h"
+#import "Kiwi.h"
+
+static NSData *MHVSourceDataOfLength(NSUInteger length)
+{
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    uint8_t *bytes = data.mutableBytes;
+
+    for (NSUInteger i = 0; i < length; i++)
+    {
+        bytes[i] = (uint8_t)(i * 7 + i / 251);
+    }
+
+    return data;
+}
+
+// The memory the app is charged for. Pages of a mapped file that haven't been written aren't counted
+static unsigned long long MHVPhysicalFootprint(void)
+{
+    task_vm_info_data_t info;
+    mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+
+    if (task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+    {
+        return 0;
+    }
+
+    return info.phys_footprint;
+}
+
+SPEC_BEGIN(MHVBlobSourceTests)
+
+describe(@"MHVBlobSource", ^
+{
+    __block NSString *filePath;
+
+    beforeEach(^
+    {
+        filePath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    });
+
+    afterEach(^
+    {
+        [[NSFileManager defaultManager] removeItemAtPath:filePath error:nil];
+    });
+
+    context(@"MHVBlobMappedFileSource", ^
+            {
+                it(@"should read the same chunks as a file handle", ^
+                   {
+                       NSData *data = MHVSourceDataOfLength(100000);
+                       [data writeToFile:filePath atomically:YES];
+
+                       MHVBlobMappedFileSource *mappedSource = [[MHVBlobMappedFileSource alloc] initWithFilePath:filePath];
+                       MHVBlobFileHandleSource *fileHandleSource = [[MHVBlobFileHandleSource alloc] initWithFilePath:filePath];
+
+                       [[theValue(mappedSource.length) should] equal:theValue(data.length)];
+
+                       for (NSUInteger offset = 0; offset < data.length; offset += 30000)
+                       {
+                           NSUInteger chunkSize = MIN(30000, data.length - offset);
+
+                           [[[mappedSource readStartAt:offset chunkSize:chunkSize] should] equal:[fileHandleSource readStartAt:offset chunkSize:chunkSize]];
+                       }
+                   });
+
+                it(@"should keep chunks readable after the source is released", ^
+                   {
+                       NSData *data = MHVSourceDataOfLength(10000);
+                       [data writeToFile:filePath atomically:YES];
+
+                       NSData *chunk = nil;
+
+                       @autoreleasepool
+                       {
+                           MHVBlobMappedFileSource *source = [[MHVBlobMappedFileSource alloc] initWithFilePath:filePath];
+                           chunk = [source readStartAt:5000 chunkSize:5000];
+                       }
+
+                       [[chunk should] equal:[data subdataWithRange:NSMakeRange(5000, 5000)]];
+                   });
+
+                it(@"should read an empty file", ^
+                   {
+                       [[NSData data] writeToFile:filePath atomically:YES];
+
+                       MHVBlobMappedFileSource *source = [[MHVBlobMappedFileSource alloc] initWithFilePath:filePath];
+
+                       [[theValue(source.length) should] equal:theValue(0)];
+                       [[theValue([source readStartAt:0 chunkSize:100].length) should] equal:theValue(0)];
+                   });
+
+                it(@"should give a short read instead of faulting when the file is truncated", ^
+                   {
+                       NSData *data = MHVSourceDataOfLength(100000);
+                       [data writeToFile:filePath atomically:YES];
+
+                       MHVBlobMappedFileSource *source = [[MHVBlobMappedFileSource alloc] initWithFilePath:filePath];
+
+                       NSFileHandle *file = [NSFileHandle fileHandleForWritingAtPath:filePath];
+                       [file truncateFileAtOffset:20000];
+                       [file closeFile];
+
+                       [[[source readStartAt:0 chunkSize:20000] should] equal:[data subdataWithRange:NSMakeRange(0, 20000)]];
+                       [[theValue([source readStartAt:60000 chunkSize:20000].length) should] equal:theValue(0)];
+                   });
+
+                it(@"should not be charged for the file while reading it", ^
+                   {
+                       NSUInteger chunkSize = 1024 * 1024;
+                       NSUInteger length = chunkSize * 64;
+
+                       [[NSFileManager defaultManager] createFileAtPath:filePath contents:nil attributes:nil];
+                       NSFileHandle *file = [NSFileHandle fileHandleForWritingAtPath:filePath];
+                       NSData *chunkData = MHVSourceDataOfLength(chunkSize);
+                       for (NSUInteger offset = 0; offset < length; offset += chunkSize)
+                       {
+                           [file writeData:chunkData];
+                       }
+                       [file closeFile];
+
+                       MHVBlobMappedFileSource *source = [[MHVBlobMappedFileSource alloc] initWithFilePath:filePath];
+                       NSMutableArray<NSData *> *inFlightChunks = [NSMutableArray new];
+                       unsigned long long startFootprint = MHVPhysicalFootprint();
+                       unsigned long long peakFootprint = startFootprint;
+                       uint8_t checksum = 0;
+
+                       // Holds 4 chunks at a time, like an upload with 4 chunks in flight
+                       for (NSUInteger offset = 0; offset < length; offset += chunkSize)
+                       {
+                           @autoreleasepool
+                           {
+                               NSData *chunk = [source readStartAt:offset chunkSize:chunkSize];
+                               checksum ^= ((const uint8_t *)chunk.bytes)[chunk.length - 1];
+
+                               [inFlightChunks addObject:chunk];
+                               if (inFlightChunks.count > 4)
+                               {
+                                   [inFlightChunks removeObjectAtIndex:0];
+                               }
+                           }
+
+                           peakFootprint = MAX(peakFootprint, MHVPhysicalFootprint());
+                       }
+
+                       // Every chunk ends with the same byte, and there's an even number of them
+                       [[theValue(checksum) should] equal:theValue(0)];
+                       [[theValue(peakFootprint - startFootprint) should] beLessThan:theValue(chunkSize * 8)];
+                   });
+            });
+
+    context(@"MHVBlobStreamSource", ^
+            {
+                it(@"should read a blob written through a small buffer", ^
+                   {
+                       NSData *data = MHVSourceDataOfLength(100000);
+                       NSOutputStream *outputStream = nil;
+
+                       MHVBlobStreamSource *source = [[MHVBlobStreamSource alloc] initWithLength:data.length bufferSize:4096 outputStream:&outputStream];
+
+                       // The writer waits for the reader whenever 4096 bytes are buffered
+                       dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^
+                       {
+                           [outputStream open];
+
+                           NSUInteger written = 0;
+                           while (written < data.length)
+                           {
+                               NSInteger count = [outputStream write:(const uint8_t *)data.bytes + written maxLength:data.length - written];
+                               if (count <= 0)
+                               {
+                                   break;
+                               }
+                               written += count;
+                           }
+
+                           [outputStream close];
+                       });
+
+                       NSMutableData *readData = [NSMutableData new];
+                       for (NSUInteger offset = 0; offset < data.length; offset += 32768)
+                       {
+                           [readData appendData:[source readStartAt:offset chunkSize:MIN(32768, data.length - offset)]];
+                       }
+
+                       [[theValue(source.isSequential) should] beYes];
+                       [[readData should] equal:data];
+                   });
+
+                it(@"should return a short chunk when the stream ends early", ^
+                   {
+                       NSData *data = MHVSourceDataOfLength(1000);
+                       MHVBlobStreamSource *source = [[MHVBlobStreamSource alloc] initWithInputStream:[NSInputStream inputStreamWithData:data] length:2000];
+
+                       [[theValue([source readStartAt:0 chunkSize:2000].length) should] equal:theValue(1000)];
+                   });
+            });
+});
+
+SPEC_END
@@ -0,0 +1,552 @@
+//
+// MHVXmlBenchmarkTests.m
+// MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+#import <objc/runtime.h>
+#import <malloc/malloc.h>
+#import "MHVThingTypes.h"
+#import "MHVPositiveDouble.h"
+#import "MHVNonNegativeInt.h"
+#import "Kiwi.h"
+
+//
+// Serializer benchmarks for every type registered in MHVTypeSystem.
+//
+// Each type gets a corpus thing sized by profile: small vitals, mid-size records
+// and huge documents (CCD, CCR, medical image studies). Deserialize, serialize and
+// round trip throughput plus retained allocations are written as JSON to
+// MHV_XML_BENCHMARK_OUTPUT (default: MHVXmlBenchmark.json in the temp directory).
+// MHV_XML_BENCHMARK_SECONDS sets the minimum time spent on each measurement.
+//
+
+static NSString *const c_benchmarkOutputVariable = @"MHV_XML_BENCHMARK_OUTPUT";
+static NSString *const c_benchmarkSecondsVariable = @"MHV_XML_BENCHMARK_SECONDS";
+static const NSTimeInterval c_defaultBenchmarkSeconds = 0.05;
+static const NSUInteger c_minBenchmarkIterations = 3;
+static const NSUInteger c_maxPopulateDepth = 5;
+
+typedef NS_ENUM(NSInteger, MHVBenchmarkProfile)
+{
+    MHVBenchmarkProfileSmall,
+    MHVBenchmarkProfileMedium,
+    MHVBenchmarkProfileLarge
+};
+
+// NSArray properties lose their element type at runtime
+static NSDictionary<NSString *, NSString *> *benchmarkArrayElementClasses(void)
+{
+    return @{
+             @"MHVAddress.street" : @"NSString",
+             @"MHVAdditionalNutritionFacts.facts" : @"MHVNutritionFact",
+             @"MHVAssessment.results" : @"MHVAssessmentField",
+             @"MHVAsthmaInhaler.alert" : @"MHVAlert",
+             @"MHVCodableValue.codes" : @"MHVCodedValue",
+             @"MHVContact.address" : @"MHVAddress",
+             @"MHVContact.email" : @"MHVEmail",
+             @"MHVContact.phone" : @"MHVPhone",
+             @"MHVDelivery.anesthesia" : @"MHVCodableValue",
+             @"MHVDelivery.complications" : @"MHVCodableValue",
+             @"MHVExercise.details" : @"MHVNameValue",
+             @"MHVExplanationOfBenefits.services" : @"MHVEOBService",
+             @"MHVFamilyHistory.conditions" : @"MHVConditionEntry",
+             @"MHVHealthGoal.goalAdditionalRanges" : @"MHVGoalRangeType",
+             @"MHVInsight.dataUsedPivot" : @"NSString",
+             @"MHVInsight.links" : @"MHVStructuredInsightValue",
+             @"MHVInsight.tags" : @"MHVString1024NW",
+             @"MHVInsight.values" : @"MHVStructuredInsightValue",
+             @"MHVLabTestResultValue.ranges" : @"MHVTestResultRange",
+             @"MHVLabTestResults.labGroup" : @"MHVLabTestResultsGroup",
+             @"MHVLabTestResultsGroup.results" : @"MHVLabTestResultsDetails",
+             @"MHVLabTestResultsGroup.subGroups" : @"MHVLabTestResultsGroup",
+             @"MHVMedicalImageStudy.keyImages" : @"MHVMedicalImageStudySeriesImage",
+             @"MHVMedicalImageStudy.series" : @"MHVMedicalImageStudySeries",
+             @"MHVMedicalImageStudySeries.images" : @"MHVMedicalImageStudySeriesImage",
+             @"MHVMessage.attachments" : @"MHVMessageAttachment",
+             @"MHVMessage.headers" : @"MHVMessageHeaderThing",
+             @"MHVPlanObjectiveList.objective" : @"MHVPlanObjective",
+             @"MHVPlanOutcomeList.outcome" : @"MHVPlanOutcome",
+             @"MHVPregnancy.delivery" : @"MHVDelivery",
+             @"MHVQuestionAnswer.answerChoices" : @"MHVCodableValue",
+             @"MHVQuestionAnswer.answers" : @"MHVCodableValue",
+             @"MHVSleepJournalAM.awakenings" : @"MHVOccurence",
+             @"MHVSleepJournalPM.alcoholIntakeTimes" : @"MHVTime",
+             @"MHVSleepJournalPM.caffeineIntakeTimes" : @"MHVTime",
+             @"MHVSleepJournalPM.exercise" : @"MHVOccurence",
+             @"MHVSleepJournalPM.naps" : @"MHVOccurence",
+             @"MHVTaskOccurrenceMetrics.targets" : @"MHVTaskRangeMetrics",
+             @"MHVTaskSchedules.schedule" : @"MHVTaskSchedule",
+             @"MHVTaskTargetEvent.elementValues" : @"MHVString",
+             @"MHVTaskTargetEvents.targetEvent" : @"MHVTaskTargetEvent",
+             @"MHVTrackingSourceTypes.sourceType" : @"NSString",
+             @"MHVTrackingTriggerTypes.triggerType" : @"NSString",
+             @"MHVVitalSigns.results" : @"MHVVitalSignResult",
+             };
+}
+
+static MHVBenchmarkProfile benchmarkProfileForClass(Class cls)
+{
+    static NSSet<NSString *> *small;
+    static NSSet<NSString *> *large;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^
+    {
+        small = [NSSet setWithArray:@[@"MHVWeight", @"MHVBloodPressure", @"MHVCholesterol", @"MHVBloodGlucose",
+                                      @"MHVHeartRate", @"MHVHeight", @"MHVPeakFlow"]];
+        large = [NSSet setWithArray:@[@"MHVCCD", @"MHVCCR", @"MHVMedicalImageStudy"]];
+    });
+
+    NSString *name = NSStringFromClass(cls);
+    if ([small containsObject:name])
+    {
+        return MHVBenchmarkProfileSmall;
+    }
+
+    return [large containsObject:name] ? MHVBenchmarkProfileLarge : MHVBenchmarkProfileMedium;
+}
+
+static NSString *benchmarkProfileName(MHVBenchmarkProfile profile)
+{
+    switch (profile)
+    {
+        case MHVBenchmarkProfileSmall:
+            return @"small";
+        case MHVBenchmarkProfileLarge:
+            return @"large";
+        default:
+            return @"medium";
+    }
+}
+
+static NSUInteger benchmarkArrayCount(MHVBenchmarkProfile profile, NSUInteger depth)
+{
+    // Only the outer lists grow with the profile, so nested codes etc. stay realistic
+    if (depth > 1)
+    {
+        return 1;
+    }
+
+    switch (profile)
+    {
+        case MHVBenchmarkProfileSmall:
+            return 1;
+        case MHVBenchmarkProfileLarge:
+            return 24;
+        default:
+            return 3;
+    }
+}
+
+static id newBenchmarkValue(NSString *typeName, MHVBenchmarkProfile profile, NSUInteger depth);
+
+//
+// Fills every writable property with sample values, recursing into nested types
+//
+static void populateBenchmarkObject(id object, MHVBenchmarkProfile profile, NSUInteger depth)
+{
+    NSDictionary<NSString *, NSString *> *arrayElements = benchmarkArrayElementClasses();
+
+    for (Class cls = [object class]; cls && cls != [XSerializableType class] && cls != [NSObject class]; cls = class_getSuperclass(cls))
+    {
+        unsigned int count = 0;
+        objc_property_t *properties = class_copyPropertyList(cls, &count);
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            char *readonly = property_copyAttributeValue(properties[i], "R");
+            char *encoding = property_copyAttributeValue(properties[i], "T");
+            NSString *name = [NSString stringWithUTF8String:property_getName(properties[i])];
+            id value = nil;
+
+            if (!readonly && encoding)
+            {
+                NSString *type = [NSString stringWithUTF8String:encoding];
+
+                if ([type hasPrefix:@"@\""])
+                {
+                    NSString *className = [type substringWithRange:NSMakeRange(2, type.length - 3)];
+                    NSString *elementName = arrayElements[[NSString stringWithFormat:@"%@.%@", NSStringFromClass(cls), name]];
+
+                    if ([className isEqualToString:@"NSArray"] || [className isEqualToString:@"NSMutableArray"])
+                    {
+                        if (elementName && depth < c_maxPopulateDepth)
+                        {
+                            NSMutableArray *elements = [NSMutableArray new];
+                            NSUInteger elementCount = benchmarkArrayCount(profile, depth);
+                            for (NSUInteger e = 0; e < elementCount; e++)
+                            {
+                                id element = newBenchmarkValue(elementName, profile, depth + 1);
+                                if (element)
+                                {
+                                    [elements addObject:element];
+                                }
+                            }
+                            value = elements;
+                        }
+                    }
+                    else
+                    {
+                        value = newBenchmarkValue(className, profile, depth + 1);
+                    }
+                }
+                else if (type.length == 1)
+                {
+                    switch ([type characterAtIndex:0])
+                    {
+                        case 'd':
+                        case 'f':
+                            value = @(12.5);
+                            break;
+                        case 'B':
+                        case 'c':
+                        case 'i':
+                        case 's':
+                        case 'l':
+                        case 'q':
+                        case 'I':
+                        case 'S':
+                        case 'L':
+                        case 'Q':
+                            value = @(1);
+                            break;
+                        default:
+                            break;
+                    }
+                }
+            }
+
+            if (value)
+            {
+                @try
+                {
+                    [object setValue:value forKey:name];
+                }
+                @catch (NSException *exception)
+                {
+                    // Computed or constrained properties may refuse sample values
+                }
+            }
+
+            free(readonly);
+            free(encoding);
+        }
+
+        free(properties);
+    }
+}
+
+static id newBenchmarkValue(NSString *typeName, MHVBenchmarkProfile profile, NSUInteger depth)
+{
+    if ([typeName isEqualToString:@"NSString"])
+    {
+        return [NSString stringWithFormat:@"Sample value %lu", (unsigned long)depth];
+    }
+    if ([typeName isEqualToString:@"NSNumber"])
+    {
+        return @(1);
+    }
+    if ([typeName isEqualToString:@"NSDate"])
+    {
+        return [NSDate dateWithTimeIntervalSinceReferenceDate:500000000];
+    }
+    if ([typeName isEqualToString:@"NSUUID"])
+    {
+        return [[NSUUID alloc] initWithUUIDString:@"1AB6BD6A-2D68-4AF7-9C2E-4A7C1E4B9E21"];
+    }
+
+    Class cls = NSClassFromString(typeName);
+    if (!cls || ![cls isSubclassOfClass:[XSerializableType class]] || depth > c_maxPopulateDepth)
+    {
+        return nil;
+    }
+
+    id value = [[cls alloc] init];
+    populateBenchmarkObject(value, profile, depth);
+
+    return value;
+}
+
+//
+// Raw types (CCD, CCR) carry whole clinical documents
+//
+static NSString *newBenchmarkRawDocument(Class cls, MHVBenchmarkProfile profile)
+{
+    NSUInteger entryCount = (profile == MHVBenchmarkProfileLarge) ? 2000 : 20;
+    NSString *root = [cls XRootElement];
+    NSMutableString *xml = [NSMutableString new];
+
+    if ([root isEqualToString:@"ContinuityOfCareRecord"])
+    {
+        [xml appendString:@"<ContinuityOfCareRecord xmlns=\"urn:astm-org:CCR\"><CCRDocumentObjectID>1</CCRDocumentObjectID><Body><Medications>"];
+        for (NSUInteger i = 0; i < entryCount; i++)
+        {
+            [xml appendFormat:@"<Medication><CCRDataObjectID>%lu</CCRDataObjectID><DateTime><ExactDateTime>2017-03-08T10:15:30Z</ExactDateTime></DateTime>"\
+             "<Description><Text>Medication %lu</Text></Description><Status><Text>Active</Text></Status>"\
+             "<Product><ProductName><Text>Aspirin</Text><Code><Value>%lu</Value><CodingSystem>RxNorm</CodingSystem></Code></ProductName>"\
+             "<Strength><Value>81</Value><Units><Unit>mg</Unit></Units></Strength></Product></Medication>",
+             (unsigned long)i, (unsigned long)i, (unsigned long)i];
+        }
+        [xml appendString:@"</Medications></Body></ContinuityOfCareRecord>"];
+    }
+    else
+    {
+        [xml appendFormat:@"<%@ xmlns=\"urn:hl7-org:v3\"><title>Continuity of Care Document</title><component><structuredBody>", root];
+        for (NSUInteger i = 0; i < entryCount; i++)
+        {
+            [xml appendFormat:@"<component><section><code code=\"10160-0\" codeSystem=\"2.16.840.1.113883.6.1\"/><title>Medications</title>"\
+             "<entry><substanceAdministration classCode=\"SBADM\" moodCode=\"EVN\"><effectiveTime value=\"20170308\"/>"\
+             "<consumable><manufacturedProduct><manufacturedMaterial><code code=\"%lu\" codeSystem=\"2.16.840.1.113883.6.88\" displayName=\"Medication %lu\"/>"\
+             "</manufacturedMaterial></manufacturedProduct></consumable></substanceAdministration></entry></section></component>",
+             (unsigned long)i, (unsigned long)i];
+        }
+        [xml appendFormat:@"</structuredBody></component></%@>", root];
+    }
+
+    return xml;
+}
+
+static NSString *newBenchmarkThingXml(NSString *typeID, MHVBenchmarkProfile profile)
+{
+    Class cls = [[MHVTypeSystem current] getClassForTypeID:typeID];
+    MHVThingDataTyped *typed = [[cls alloc] init];
+
+    if (typed.hasRawData)
+    {
+        return [NSString stringWithFormat:@"<info><thing-id version-stamp=\"1\">1AB6BD6A-2D68-4AF7-9C2E-4A7C1E4B9E21</thing-id>"\
+                "<type-id>%@</type-id><thing-state>Active</thing-state><flags>0</flags><eff-date>2017-03-08T10:15:30.123</eff-date>"\
+                "<data-xml>%@<common/></data-xml></info>", typeID, newBenchmarkRawDocument(cls, profile)];
+    }
+
+    populateBenchmarkObject(typed, profile, 0);
+
+    MHVThing *thing = [[MHVThing alloc] initWithTypedData:typed];
+    thing.key = [[MHVThingKey alloc] initWithID:@"1AB6BD6A-2D68-4AF7-9C2E-4A7C1E4B9E21" andVersion:@"1"];
+
+    return [thing toXmlString];
+}
+
+//
+// Runs block until both the minimum time and iteration count are reached
+//
+static NSDictionary *measureBenchmark(NSTimeInterval seconds, NSUInteger bytesPerIteration, void (^block)(void))
+{
+    NSUInteger iterations = 0;
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    CFAbsoluteTime elapsed = 0;
+
+    do
+    {
+        @autoreleasepool
+        {
+            block();
+        }
+        iterations++;
+        elapsed = CFAbsoluteTimeGetCurrent() - start;
+    }
+    while (elapsed < seconds || iterations < c_minBenchmarkIterations);
+
+    return @{
+             @"iterations" : @(iterations),
+             @"seconds" : @(elapsed),
+             @"thingsPerSecond" : @(iterations / elapsed),
+             @"mbPerSecond" : @((double)bytesPerIteration * iterations / elapsed / (1024 * 1024)),
+             };
+}
+
+SPEC_BEGIN(MHVXmlBenchmarkTests)
+
+describe(@"XML benchmarks", ^
+{
+    if (!MHV_BENCHMARKS_ENABLED)
+    {
+        return;
+    }
+
+    it(@"should measure every registered thing type", ^
+       {
+           NSDictionary<NSString *, NSString *> *environment = [NSProcessInfo processInfo].environment;
+           NSTimeInterval seconds = environment[c_benchmarkSecondsVariable] ? [environment[c_benchmarkSecondsVariable] doubleValue] : c_defaultBenchmarkSeconds;
+           NSString *outputPath = environment[c_benchmarkOutputVariable];
+           if (!outputPath)
+           {
+               outputPath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"MHVXmlBenchmark.json"];
+           }
+
+           NSArray<NSString *> *typeIDs = [[MHVTypeSystem current] typeIDs];
+           NSMutableArray<NSDictionary *> *results = [NSMutableArray new];
+
+           for (NSString *typeID in typeIDs)
+           {
+               Class cls = [[MHVTypeSystem current] getClassForTypeID:typeID];
+               MHVBenchmarkProfile profile = benchmarkProfileForClass(cls);
+               NSMutableDictionary *result = [@{
+                                                @"type" : NSStringFromClass(cls),
+                                                @"typeID" : typeID,
+                                                @"profile" : benchmarkProfileName(profile),
+                                                } mutableCopy];
+
+               @try
+               {
+                   NSString *xml = newBenchmarkThingXml(typeID, profile);
+                   NSUInteger bytes = [xml lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+                   result[@"bytes"] = @(bytes);
+
+                   // Memory retained by one deserialized thing
+                   malloc_statistics_t before;
+                   malloc_statistics_t after;
+                   MHVThing *thing;
+                   @autoreleasepool
+                   {
+                       malloc_zone_statistics(NULL, &before);
+                       thing = [MHVThing newFromXmlString:xml];
+                       malloc_zone_statistics(NULL, &after);
+                   }
+
+                   if (![thing.data.typed isKindOfClass:cls])
+                   {
+                       [NSException raise:NSInternalInconsistencyException format:@"Corpus did not deserialize as %@", NSStringFromClass(cls)];
+                   }
+
+                   result[@"allocations"] = @{
+                                              @"liveBlocks" : @((NSInteger)(after.blocks_in_use - before.blocks_in_use)),
+                                              @"liveBytes" : @((NSInteger)(after.size_in_use - before.size_in_use)),
+                                              };
+
+                   result[@"deserialize"] = measureBenchmark(seconds, bytes, ^
+                                                             {
+                                                                 [MHVThing newFromXmlString:xml];
+                                                             });
+                   result[@"serialize"] = measureBenchmark(seconds, bytes, ^
+                                                           {
+                                                               [thing toXmlString];
+                                                           });
+                   result[@"roundTrip"] = measureBenchmark(seconds, bytes, ^
+                                                           {
+                                                               [[MHVThing newFromXmlString:xml] toXmlString];
+                                                           });
+               }
+               @catch (NSException *exception)
+               {
+                   result[@"error"] = exception.reason ? exception.reason : exception.name;
+               }
+
+               NSLog(@"%@ (%@, %@ bytes): deserialize %0.2f MB/s, serialize %0.2f MB/s, round trip %0.0f things/s%@",
+                     result[@"type"], result[@"profile"], result[@"bytes"],
+                     [result[@"deserialize"][@"mbPerSecond"] doubleValue],
+                     [result[@"serialize"][@"mbPerSecond"] doubleValue],
+                     [result[@"roundTrip"][@"thingsPerSecond"] doubleValue],
+                     result[@"error"] ? [NSString stringWithFormat:@" error: %@", result[@"error"]] : @"");
+
+               [results addObject:result];
+           }
+
+           NSData *json = [NSJSONSerialization dataWithJSONObject:results options:NSJSONWritingPrettyPrinted error:nil];
+           [[theValue([json writeToFile:outputPath atomically:YES]) should] beYes];
+
+           NSLog(@"XML benchmark results written to %@", outputPath);
+
+           [[theValue(results.count) should] equal:theValue(typeIDs.count)];
+           [[theValue(typeIDs.count) should] beGreaterThan:theValue(0)];
+       });
+
+    it(@"should measure base type reads and writes", ^
+       {
+           NSUInteger count = 2000;
+           NSMutableString *xml = [@"<values>" mutableCopy];
+           for (NSUInteger i = 0; i < count; i++)
+           {
+               [xml appendFormat:@"<double>%.15g</double><int>%lu</int>", i * 1.37, (unsigned long)i];
+           }
+           [xml appendString:@"</values>"];
+
+           // Reference: the previous path, through an NSString value and NSScanner
+           NSDate *start = [NSDate date];
+           XReader *reader = [[XReader alloc] initFromString:xml];
+           [reader readStartElement];
+           for (NSUInteger i = 0; i < count; i++)
+           {
+               double doubleValue;
+               int intValue;
+               [[NSScanner scannerWithString:[reader readStringElement:@"double"]] scanDouble:&doubleValue];
+               [[NSScanner scannerWithString:[reader readStringElement:@"int"]] scanInt:&intValue];
+           }
+           NSTimeInterval referenceDuration = [[NSDate date] timeIntervalSinceDate:start];
+
+           start = [NSDate date];
+           reader = [[XReader alloc] initFromString:xml];
+           [reader readStartElement];
+           NSMutableArray *values = [NSMutableArray new];
+           for (NSUInteger i = 0; i < count; i++)
+           {
+               [values addObject:[reader readElement:@"double" asClass:[MHVPositiveDouble class]]];
+               [values addObject:[reader readElement:@"int" asClass:[MHVNonNegativeInt class]]];
+           }
+           NSTimeInterval readDuration = [[NSDate date] timeIntervalSinceDate:start];
+
+           start = [NSDate date];
+           XWriter *writer = [[XWriter alloc] initWithBufferSize:64 * 1024];
+           for (id value in values)
+           {
+               [writer writeElement:@"value" content:value];
+           }
+           NSTimeInterval writeDuration = [[NSDate date] timeIntervalSinceDate:start];
+
+           NSLog(@"%lu base type values: NSString+NSScanner read %0.4f seconds, XReader read %0.4f seconds, XWriter write %0.4f seconds",
+                 (unsigned long)values.count, referenceDuration, readDuration, writeDuration);
+
+           [[theValue(values.count) should] equal:theValue(count * 2)];
+       });
+
+    it(@"should measure deserialization on each number of threads", ^
+       {
+           NSUInteger count = 10000;
+           NSMutableString *xml = [@"<info><group name=\"Things\">" mutableCopy];
+           for (NSUInteger i = 0; i < count; i++)
+           {
+               [xml appendFormat:@"<thing><thing-id version-stamp=\"%lu\">%08lu-0000-0000-0000-000000000000</thing-id>"\
+                "<type-id>52bf9104-2c5e-4f1f-a66d-552ebcc53df7</type-id><thing-state>Active</thing-state><flags>0</flags>"\
+                "<eff-date>2017-03-08T10:15:30.123</eff-date>"\
+                "<data-xml><allergy><name><text>Allergy %lu</text></name><reaction><text>Itching</text></reaction></allergy><common/></data-xml></thing>",
+                (unsigned long)i, (unsigned long)i, (unsigned long)i];
+           }
+           [xml appendString:@"</group></info>"];
+
+           for (NSUInteger threads = 1; threads <= MAX([NSProcessInfo processInfo].activeProcessorCount, 2); threads *= 2)
+           {
+               XReader *reader = [[XReader alloc] initFromString:xml];
+               [reader readStartElement];
+               [reader readStartElement];
+
+               NSDate *start = [NSDate date];
+               NSArray *things = [reader readElementArrayWithXmlName:(const xmlChar *)"thing"
+                                                     sequentialCount:64
+                                                      maxConcurrency:threads
+                                                           newObject:^id<XSerializable>
+                                  {
+                                      return [[MHVThing alloc] init];
+                                  }];
+               NSTimeInterval duration = [[NSDate date] timeIntervalSinceDate:start];
+
+               NSLog(@"Deserialized %lu things on %lu threads in %0.4f seconds",
+                     (unsigned long)things.count, (unsigned long)threads, duration);
+
+               [[theValue(things.count) should] equal:theValue(count)];
+           }
+       });
+});
+
+SPEC_END
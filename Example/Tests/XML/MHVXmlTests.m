@@ -21,6 +21,14 @@
 #import <XCTest/XCTest.h>
 #import "MHVAllergy.h"
 #import "MHVHeartRate.h"
+#import "MHVServiceResponse.h"
+#import "MHVHttpResponseStream.h"
+#import "MHVDateExtensions.h"
+#import "MHVPositiveDouble.h"
+#import "MHVNonNegativeInt.h"
+#import "MHVThingInternal.h"
+#import "MHVThingQueryResults.h"
+#import "MHVThingTypes.h"
 #import "Kiwi.h"
 
 SPEC_BEGIN(MHVXmlTests)
@@ -78,6 +86,26 @@ describe(@"XML", ^
                    });
             });
     
+    context(@"Serialize into data", ^
+            {
+                it(@"should write the same xml as the buffer writer", ^
+                   {
+                       MHVAllergy *allergy = [[MHVAllergy alloc] initWithName:@"TestAllergy"];
+                       MHVThing *thing = [[MHVThing alloc] initWithTypedData:allergy];
+                       
+                       XWriter *bufferWriter = [[XWriter alloc] initWithBufferSize:2048];
+                       [XSerializer serialize:thing withRoot:@"thing" toWriter:bufferWriter];
+                       
+                       NSMutableData *data = [NSMutableData new];
+                       XWriter *dataWriter = [[XWriter alloc] initWithData:data];
+                       [XSerializer serialize:thing withRoot:@"thing" toWriter:dataWriter];
+                       [dataWriter flush];
+                       
+                       [[[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] should] equal:[bufferWriter newXmlString]];
+                       [[theValue([dataWriter getLength]) should] equal:theValue(data.length)];
+                   });
+            });
+    
     context(@"Deserialize", ^
             {
                 it(@"should deserialize thing", ^
@@ -111,6 +139,460 @@ describe(@"XML", ^
                        MHVHeartRate *heartRate = (MHVHeartRate *)thing.data.typed;
                        [[theValue(heartRate.bpmValue) should] equal:@(106)];
                    });
+                
+                it(@"should deliver things while the response is still arriving", ^
+                   {
+                       NSString *thingXml = (@"<thing><thing-id version-stamp=\"ad57ba08-3ee2-4080-8886-165b61979301\">a9ce136b-43d5-4bdf-a7f6-e64c7e3f728c</thing-id>"\
+                                             "<type-id name=\"Heart rate\">b81eb4a6-6eac-4292-ae93-3872d6870994</type-id>"\
+                                             "<thing-state>Active</thing-state><flags>0</flags><eff-date>2017-05-02T13:18:32</eff-date>"\
+                                             "<data-xml><heart-rate><when><date><y>2017</y><m>5</m><d>2</d></date><time><h>13</h><m>18</m><s>32</s></time></when>"\
+                                             "<value>106</value></heart-rate></data-xml></thing>");
+                       NSString *xml = [NSString stringWithFormat:(@"<response><status><code>0</code></status>"\
+                                                                   "<wc:info xmlns:wc=\"urn:com.microsoft.wc.methods.response.GetThings3\">"\
+                                                                   "<group name=\"TestGroup\">%@%@%@</group></wc:info></response>"), thingXml, thingXml, thingXml];
+                       NSData *data = [xml dataUsingEncoding:NSUTF8StringEncoding];
+                       
+                       // Stand-in for a slow connection: the body arrives in small chunks, with a delay between each
+                       MHVHttpResponseStream *responseStream = [[MHVHttpResponseStream alloc] initWithBufferSize:256];
+                       __block volatile NSUInteger bytesSent = 0;
+                       
+                       dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^
+                                      {
+                                          NSUInteger chunkSize = 64;
+                                          for (NSUInteger offset = 0; offset < data.length; offset += chunkSize)
+                                          {
+                                              NSData *chunk = [data subdataWithRange:NSMakeRange(offset, MIN(chunkSize, data.length - offset))];
+                                              bytesSent += chunk.length;
+                                              [responseStream appendData:chunk];
+                                              [NSThread sleepForTimeInterval:0.005];
+                                          }
+                                          [responseStream finish];
+                                      });
+                       
+                       NSMutableArray<MHVThing *> *things = [NSMutableArray new];
+                       __block NSUInteger bytesSentAtFirstThing = 0;
+                       
+                       MHVThingQueryResults *results = [[MHVThingQueryResults alloc] init];
+                       results.thingHandler = ^(MHVThing *thing, NSString *resultName)
+                       {
+                           if (things.count == 0)
+                           {
+                               bytesSentAtFirstThing = bytesSent;
+                           }
+                           [[resultName should] equal:@"TestGroup"];
+                           [things addObject:thing];
+                       };
+                       
+                       MHVServiceResponse *response = [[MHVServiceResponse alloc] initWithStatusCode:200
+                                                                                              stream:responseStream.inputStream
+                                                                                                info:results];
+                       
+                       [[response.error should] beNil];
+                       [[theValue(things.count) should] equal:@(3)];
+                       [[theValue(results.firstResult.streamedThingCount) should] equal:@(3)];
+                       [[theValue(results.firstResult.things.count) should] equal:@(0)];
+                       [[((MHVThing *)things.lastObject).data.typed should] beKindOfClass:[MHVHeartRate class]];
+                       
+                       // The first thing was parsed before the whole body had been received
+                       [[theValue(bytesSentAtFirstThing) should] beLessThan:theValue(data.length)];
+                   });
+                
+                it(@"should pause the writer while the buffer is full instead of blocking it", ^
+                   {
+                       MHVHttpResponseStream *responseStream = [[MHVHttpResponseStream alloc] initWithBufferSize:256];
+                       __block NSInteger pauseCount = 0;
+                       __block NSInteger resumeCount = 0;
+                       responseStream.pauseHandler = ^{ pauseCount += 1; };
+                       responseStream.resumeHandler = ^{ resumeCount += 1; };
+                       
+                       NSMutableData *data = [NSMutableData dataWithLength:1024];
+                       
+                       // Returns at once, with nothing reading
+                       [responseStream appendData:data];
+                       [responseStream appendData:data];
+                       
+                       [[theValue(pauseCount) should] equal:theValue(1)];
+                       [[theValue(resumeCount) should] equal:theValue(0)];
+                       
+                       uint8_t buffer[512];
+                       NSInteger readLength = 0;
+                       while (readLength < 2048 - 100)
+                       {
+                           readLength += [responseStream.inputStream read:buffer maxLength:sizeof(buffer)];
+                       }
+                       
+                       [[theValue(resumeCount) should] equal:theValue(1)];
+                       
+                       [responseStream finish];
+                       while ([responseStream.inputStream read:buffer maxLength:sizeof(buffer)] > 0)
+                       {
+                       }
+                       
+                       [[theValue(responseStream.inputStream.streamStatus) should] equal:theValue(NSStreamStatusAtEnd)];
+                   });
+                
+                it(@"should report an error for a streamed response that is not a HealthVault response", ^
+                   {
+                       MHVHttpResponseStream *responseStream = [[MHVHttpResponseStream alloc] initWithBufferSize:256];
+                       [responseStream appendData:[@"<html><body>Service Unavailable</body></html>" dataUsingEncoding:NSUTF8StringEncoding]];
+                       [responseStream finish];
+                       
+                       MHVServiceResponse *response = [[MHVServiceResponse alloc] initWithStatusCode:200
+                                                                                              stream:responseStream.inputStream
+                                                                                                info:[[MHVThingQueryResults alloc] init]];
+                       
+                       [[response.error shouldNot] beNil];
+                   });
+            });
+    
+    context(@"Dates", ^
+            {
+                // Timestamps as they appear in eff-date, created/timestamp and updated elements
+                NSArray<NSString *> *corpus = @[@"2017-05-02T13:18:32Z",
+                                                @"2017-05-02T13:18:32.373Z",
+                                                @"2017-05-02T13:18:32.000Z",
+                                                @"2016-02-29T23:59:59.999Z",
+                                                @"2017-01-01T00:00:00Z",
+                                                @"2017-05-02T13:18:32.373-07:00",
+                                                @"2017-05-02T13:18:32+05:30",
+                                                @"2017-11-05T08:30:00.120+00:00",
+                                                @"2017-05-02",
+                                                @"1999-12-31"];
+                
+                // The NSDateFormatter based parsing XConverter used previously, as the reference
+                NSDateFormatter *parser = [NSDateFormatter new];
+                parser.locale = [[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"];
+                
+                NSDate *(^referenceParse)(NSString *) = ^NSDate *(NSString *string)
+                {
+                    NSString *stripped = [string stringByReplacingOccurrencesOfString:@":" withString:@""];
+                    
+                    for (NSString *format in @[@"yyyy'-'MM'-'dd'T'HHmmss'Z'",
+                                               @"yyyy'-'MM'-'dd'T'HHmmss.SSS'Z'",
+                                               @"yyyy'-'MM'-'dd'T'HHmmss.SSSZZZZ",
+                                               @"yyyy'-'MM'-'dd'T'HHmmssZZZZ",
+                                               @"yyyy'-'MM'-'dd"])
+                    {
+                        parser.dateFormat = format;
+                        NSDate *date = [parser dateFromString:stripped];
+                        if (date)
+                        {
+                            return date;
+                        }
+                    }
+                    return nil;
+                };
+                
+                let(converter, ^
+                    {
+                        return [[XConverter alloc] init];
+                    });
+                
+                it(@"should parse the same dates as NSDateFormatter", ^
+                   {
+                       for (NSString *string in corpus)
+                       {
+                           NSDate *expected = referenceParse(string);
+                           NSDate *actual = [converter stringToDate:string];
+                           
+                           [[actual shouldNot] beNil];
+                           [[theValue(fabs([actual timeIntervalSinceDate:expected])) should] beLessThan:theValue(0.0005)];
+                       }
+                   });
+                
+                it(@"should format the same strings as NSDateFormatter", ^
+                   {
+                       NSDateFormatter *formatter = [NSDateFormatter new];
+                       formatter.locale = [[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"];
+                       formatter.dateFormat = @"yyyy'-'MM'-'dd'T'HH:mm:ss.SSS'Z'";
+                       
+                       for (NSString *string in corpus)
+                       {
+                           NSDate *date = referenceParse(string);
+                           
+                           [[[converter dateToString:date] should] equal:[formatter stringFromDate:date]];
+                       }
+                       
+                       formatter.timeZone = [NSTimeZone timeZoneWithAbbreviation:@"UTC"];
+                       NSDate *date = [NSDate dateWithTimeIntervalSince1970:1493731112.373];
+                       
+                       [[[date dateToUtcString] should] equal:[formatter stringFromDate:date]];
+                       [[[date dateToUtcString] should] equal:@"2017-05-02T13:18:32.373Z"];
+                   });
+                
+                it(@"should round trip dates", ^
+                   {
+                       for (NSString *string in corpus)
+                       {
+                           NSDate *date = [converter stringToDate:string];
+                           NSDate *parsedBack = [converter stringToDate:[converter dateToString:date]];
+                           
+                           [[theValue(fabs([parsedBack timeIntervalSinceDate:date])) should] beLessThan:theValue(0.001)];
+                       }
+                   });
+                
+                it(@"should reject malformed dates", ^
+                   {
+                       for (NSString *string in @[@"", @"2017", @"2017-13-01", @"2017-02-29", @"2017-05-02T25:00:00Z",
+                                                  @"2017-05-02T13:18Z", @"2017-05-02T13:18:32.Z", @"2017-05-02 13:18:32", @"not a date"])
+                       {
+                           NSDate *date = nil;
+                           [[theValue([converter tryString:string toDate:&date]) should] beNo];
+                       }
+                   });
+                
+                it(@"should parse faster than NSDateFormatter", ^
+                   {
+                       NSUInteger iterations = 2000;
+                       
+                       NSDate *start = [NSDate date];
+                       for (NSUInteger i = 0; i < iterations; i++)
+                       {
+                           referenceParse(corpus[i % corpus.count]);
+                       }
+                       NSTimeInterval referenceDuration = [[NSDate date] timeIntervalSinceDate:start];
+                       
+                       start = [NSDate date];
+                       for (NSUInteger i = 0; i < iterations; i++)
+                       {
+                           [converter stringToDate:corpus[i % corpus.count]];
+                       }
+                       NSTimeInterval duration = [[NSDate date] timeIntervalSinceDate:start];
+                       
+                       [[theValue(duration) should] beLessThan:theValue(referenceDuration)];
+                   });
+            });
+    
+    context(@"Numbers", ^
+            {
+                let(converter, ^
+                    {
+                        return [[XConverter alloc] init];
+                    });
+                
+                it(@"should parse numbers like NSScanner", ^
+                   {
+                       for (NSString *string in @[@"42", @" -17", @"+5", @"12abc", @"99999999999", @"-99999999999"])
+                       {
+                           int expected = 0;
+                           [[NSScanner scannerWithString:string] scanInt:&expected];
+                           
+                           [[theValue([converter stringToInt:string]) should] equal:theValue(expected)];
+                       }
+                       
+                       for (NSString *string in @[@"106", @"1.5", @" 2e3", @"-.5", @"7.", @"0.30000000000000004", @"72.574779", @"1e-300"])
+                       {
+                           double expected = 0;
+                           [[NSScanner scannerWithString:string] scanDouble:&expected];
+                           
+                           [[theValue([converter stringToDouble:string]) should] equal:theValue(expected)];
+                           [[theValue([converter stringToFloat:string]) should] equal:theValue((float)expected)];
+                       }
+                       
+                       [[theValue([converter stringToDouble:@"INF"]) should] equal:theValue(INFINITY)];
+                       [[theValue([converter stringToDouble:@"-INF"]) should] equal:theValue(-INFINITY)];
+                       [[theValue([converter stringToDouble:@"abc"]) should] equal:theValue(-1)];
+                       [[theValue([converter stringToInt:@"abc"]) should] equal:theValue(-1)];
+                   });
+                
+                it(@"should format numbers as before", ^
+                   {
+                       [[[converter intToString:-2147483647 - 1] should] equal:@"-2147483648"];
+                       [[[converter intToString:106] should] equal:@"106"];
+                       [[[converter floatToString:1.5f] should] equal:@"1.500000"];
+                       [[[converter doubleToString:INFINITY] should] equal:@"INF"];
+                       
+                       for (NSNumber *number in @[@(0.1), @(106), @(72.574779), @(1.0 / 3), @(0.1 + 0.2), @(1e300), @(-2.5)])
+                       {
+                           double value = number.doubleValue;
+                           NSString *previous = [NSString stringWithFormat:@"%.15g", value];
+                           if ([previous doubleValue] != value)
+                           {
+                               previous = [NSString stringWithFormat:@"%.17g", value];
+                           }
+                           
+                           NSString *formatted = [converter doubleToString:value];
+                           
+                           [[theValue([formatted doubleValue]) should] equal:theValue(value)];
+                           [[theValue(formatted.length) should] beLessThanOrEqualTo:theValue(previous.length)];
+                       }
+                   });
+                
+                it(@"should round trip base types", ^
+                   {
+                       MHVDouble *doubleValue = [[MHVDouble alloc] initWith:0.1 + 0.2];
+                       NSString *xml = [doubleValue toXmlStringWithRoot:@"value"];
+                       [[xml should] containString:@">0.30000000000000004<"];
+                       
+                       MHVDouble *doubleResult = [NSObject newFromString:xml withRoot:@"value" asClass:[MHVPositiveDouble class]];
+                       [[theValue(doubleResult.value) should] equal:theValue(0.1 + 0.2)];
+                       
+                       MHVInt *intValue = [[MHVInt alloc] initWith:-42];
+                       xml = [intValue toXmlStringWithRoot:@"value"];
+                       [[xml should] containString:@">-42<"];
+                       
+                       MHVInt *intResult = [NSObject newFromString:xml withRoot:@"value" asClass:[MHVNonNegativeInt class]];
+                       [[theValue(intResult.value) should] equal:theValue(-42)];
+                   });
+            });
+    
+    context(@"Deferred thing data", ^
+            {
+                let(thingXml, ^
+                    {
+                        MHVAllergy *allergy = [[MHVAllergy alloc] initWithName:@"TestAllergy"];
+                        allergy.reaction = [[MHVCodableValue alloc] initWithText:@"TestReaction"];
+                        
+                        MHVThing *thing = [[MHVThing alloc] initWithTypedData:allergy];
+                        thing.key = [[MHVThingKey alloc] initWithID:@"1AB6BD6A-2D68-4AF7-9C2E-4A7C1E4B9E21" andVersion:@"2"];
+                        
+                        return [thing toXmlString];
+                    });
+                
+                it(@"should serialize untouched data verbatim", ^
+                   {
+                       MHVThing *thing = [MHVThing newFromXmlString:thingXml deferData:YES];
+                       
+                       [[theValue(thing.hasDeferredData) should] beYes];
+                       [[theValue(thing.hasData) should] beYes];
+                       [[[thing toXmlString] should] equal:thingXml];
+                       [[theValue(thing.hasDeferredData) should] beYes];
+                       
+                       MHVThing *clone = [thing shallowClone];
+                       [[theValue(clone.hasDeferredData) should] beYes];
+                   });
+                
+                it(@"should deserialize data on first access", ^
+                   {
+                       MHVThing *thing = [MHVThing newFromXmlString:thingXml deferData:YES];
+                       
+                       MHVAllergy *allergy = (MHVAllergy *)thing.data.typed;
+                       
+                       [[allergy should] beKindOfClass:[MHVAllergy class]];
+                       [[allergy.name.text should] equal:@"TestAllergy"];
+                       [[theValue(thing.hasDeferredData) should] beNo];
+                       
+                       allergy.name = [[MHVCodableValue alloc] initWithText:@"Changed"];
+                       
+                       [[[thing toXmlString] should] containString:@"<name><text>Changed</text></name>"];
+                   });
+                
+                it(@"should keep the xml when it can't be deserialized", ^
+                   {
+                       MHVThing *thing = [MHVThing newFromXmlString:thingXml deferData:YES];
+                       [thing setValue:@"<data-xml><common><note>Unclosed</common></data-xml>" forKey:@"dataXml"];
+                       
+                       [[(id)thing.data should] beNil];
+                       [[theValue(thing.hasDeferredData) should] beYes];
+                       [[[thing toXmlString] should] containString:@"<note>Unclosed</common>"];
+                   });
+                
+                it(@"should deserialize data once when it is first accessed from several threads", ^
+                   {
+                       MHVThing *thing = [MHVThing newFromXmlString:thingXml deferData:YES];
+                       NSMutableArray *datas = [NSMutableArray new];
+                       
+                       dispatch_apply(8, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i)
+                       {
+                           MHVThingData *data = thing.data;
+                           @synchronized (datas)
+                           {
+                               [datas addObject:data ?: [NSNull null]];
+                           }
+                       });
+                       
+                       [[theValue(datas.count) should] equal:theValue(8)];
+                       for (id data in datas)
+                       {
+                           [[data should] beIdenticalTo:datas.firstObject];
+                       }
+                       [[datas.firstObject should] beKindOfClass:[MHVThingData class]];
+                   });
+                
+                it(@"should defer data only for the named results", ^
+                   {
+                       NSString *thingContent = [thingXml substringWithRange:NSMakeRange(@"<info>".length, thingXml.length - @"<info></info>".length)];
+                       NSString *xml = [NSString stringWithFormat:@"<info><group name=\"Deferred\"><thing>%@</thing></group><group name=\"Eager\"><thing>%@</thing></group></info>",
+                                        thingContent, thingContent];
+                       
+                       MHVThingQueryResults *results = [[MHVThingQueryResults alloc] init];
+                       results.deferredResultNames = [NSSet setWithObject:@"Deferred"];
+                       
+                       XReader *reader = [[XReader alloc] initFromString:xml];
+                       [XSerializer deserialize:reader withRoot:@"info" into:results];
+                       
+                       [[theValue(results.results.count) should] equal:theValue(2)];
+                       [[theValue(results.results[0].things[0].hasDeferredData) should] beYes];
+                       [[theValue(results.results[1].things[0].hasDeferredData) should] beNo];
+                       [[results.results[1].things[0].data.typed should] beKindOfClass:[MHVAllergy class]];
+                   });
+            });
+    
+    context(@"Concurrent deserialization", ^
+            {
+                NSString *(^newGroupXml)(NSUInteger) = ^NSString *(NSUInteger count)
+                {
+                    NSMutableString *xml = [@"<info><group name=\"Things\">" mutableCopy];
+                    for (NSUInteger i = 0; i < count; i++)
+                    {
+                        [xml appendFormat:@"<thing><thing-id version-stamp=\"%lu\">%08lu-0000-0000-0000-000000000000</thing-id>"\
+                         "<type-id>52bf9104-2c5e-4f1f-a66d-552ebcc53df7</type-id><thing-state>Active</thing-state><flags>0</flags>"\
+                         "<eff-date>2017-03-08T10:15:30.123</eff-date>"\
+                         "<data-xml><allergy><name><text>Allergy %lu</text></name><reaction><text>Itching</text></reaction></allergy><common/></data-xml></thing>",
+                         (unsigned long)i, (unsigned long)i, (unsigned long)i];
+                    }
+                    [xml appendString:@"</group></info>"];
+                    return xml;
+                };
+                
+                it(@"should keep the order of the things", ^
+                   {
+                       NSUInteger count = 500;
+                       MHVThingQueryResults *results = [NSObject newFromString:newGroupXml(count) withRoot:@"info" asClass:[MHVThingQueryResults class]];
+                       NSArray<MHVThing *> *things = results.firstResult.things;
+                       
+                       [[theValue(things.count) should] equal:theValue(count)];
+                       for (NSUInteger i = 0; i < count; i++)
+                       {
+                           [[things[i].key.version should] equal:[NSString stringWithFormat:@"%lu", (unsigned long)i]];
+                           [[((MHVAllergy *)things[i].data.typed).name.text should] equal:[NSString stringWithFormat:@"Allergy %lu", (unsigned long)i]];
+                       }
+                   });
+                
+                it(@"should read a copy of an element with the namespaces of its ancestors", ^
+                   {
+                       XReader *reader = [[XReader alloc] initFromString:@"<info xmlns:wc=\"urn:test\"><thing><wc:name>First</wc:name></thing><thing/></info>"];
+                       [reader readStartElementWithName:@"info"];
+                       
+                       XReader *copy = [reader newReaderForElementCopyWithConverter:[[XConverter alloc] init]];
+                       [reader skip];
+                       
+                       [[theValue([reader isStartElementWithName:@"thing"]) should] beYes];
+                       [[theValue(reader.isEmptyElement) should] beYes];
+                       
+                       [[theValue([copy readStartElementWithName:@"thing"]) should] beYes];
+                       [[copy.localName should] equal:@"name"];
+                       [[copy.namespaceUri should] equal:@"urn:test"];
+                       [[[copy readElementString] should] equal:@"First"];
+                   });
+            });
+    
+    context(@"Element checks", ^
+            {
+                it(@"should answer misses on the current element from the cached name", ^
+                   {
+                       XReader *reader = [[XReader alloc] initFromString:@"<root><when>1</when></root>"];
+                       [reader readStartElement];
+                       
+                       [[theValue([reader isStartElementWithXmlName:(const xmlChar *)"where"]) should] beNo];
+                       [[theValue([reader isStartElementWithXmlName:(const xmlChar *)"value"]) should] beNo];
+                       [[theValue([reader isStartElementWithXmlName:(const xmlChar *)"when"]) should] beYes];
+                       [[theValue([reader isStartElementWithXmlName:reader.localNameRaw]) should] beYes];
+                       
+                       [reader skipSingleElement];
+                       
+                       [[theValue([reader isStartElementWithXmlName:(const xmlChar *)"when"]) should] beNo];
+                   });
             });
 });
 
@@ -237,6 +237,7 @@ static const NSUInteger c_thingLimit = 50;
     
     __block MHVThingQuery *query = [[MHVThingQuery alloc] init];
     query.shouldUseCachedResults = self.useCache;
+    query.isInteractive = YES;
     query.limit = range.length;
     query.offset = range.location;
     
@@ -18,6 +18,7 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nullable, nonatomic, copy) NSString *createdByAppId;
 @property (nullable, nonatomic, copy) NSString *createdByPersonId;
 @property (nullable, nonatomic, copy) NSDate *effectiveDate;
+@property (nullable, nonatomic, retain) NSData *thingData;
 @property (nullable, nonatomic, copy) NSString *thingId;
 @property (nullable, nonatomic, copy) NSString *typeId;
 @property (nullable, nonatomic, copy) NSDate *updateDate;
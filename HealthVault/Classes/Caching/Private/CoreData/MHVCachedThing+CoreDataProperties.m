@@ -17,6 +17,7 @@
 @dynamic createdByAppId;
 @dynamic createdByPersonId;
 @dynamic effectiveDate;
+@dynamic thingData;
 @dynamic thingId;
 @dynamic typeId;
 @dynamic updateDate;
@@ -73,6 +73,7 @@ static NSString *const kPredicateVariable = @"predicateVariable";
     
     kIgnoreMap = @{
                    @"shouldUseCachedResults" : @"ignore",
+                   @"shouldDeferTypedData" : @"ignore",
                    @"keys" : @"ignore",
                    @"filters" : @"ignore",
                    @"view" : @"ignore",
@@ -38,6 +38,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (MHVThing *_Nullable)toThing;
 
+/**
+ Convert MHVCachedThing back into a MHVThing.
+ Things still stored as XML are converted to the binary payload, so the context should be saved afterwards
+
+ @param deferData If YES, the thing's data xml is only deserialized when its data is first accessed
+ @return the MHVThing result
+ */
+- (MHVThing *_Nullable)toThingDeferringData:(BOOL)deferData;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -19,6 +19,8 @@
 
 #import "MHVCachedThing+Cache.h"
 #import "MHVTypes.h"
+#import "MHVThingInternal.h"
+#import "MHVCachedThingPayload.h"
 
 @implementation MHVCachedThing (Cache)
 
@@ -39,14 +41,38 @@
     
     self.effectiveDate = thing.effectiveDate ?: self.effectiveDate;
     
-    self.xmlString = [thing toXmlString];
+    self.thingData = [MHVCachedThingPayload dataWithThing:thing];
+    self.xmlString = self.thingData ? nil : [thing toXmlString];
     
     self.isPlaceholder = NO;
 }
 
 - (MHVThing *)toThing
 {
-    return [MHVThing newFromXmlString:self.xmlString];
+    return [self toThingDeferringData:NO];
+}
+
+- (MHVThing *)toThingDeferringData:(BOOL)deferData
+{
+    if (self.thingData)
+    {
+        return [MHVCachedThingPayload newThingWithData:self.thingData deferData:deferData];
+    }
+    
+    MHVThing *thing = [MHVThing newFromXmlString:self.xmlString deferData:deferData];
+    
+    // Rows cached before the binary payload are converted the first time they are read
+    if (thing)
+    {
+        NSData *thingData = [MHVCachedThingPayload dataWithThing:thing];
+        if (thingData)
+        {
+            self.thingData = thingData;
+            self.xmlString = nil;
+        }
+    }
+    
+    return thing;
 }
 
 @end
@@ -0,0 +1,53 @@
+//
+// MHVCachedThingPayload.h
+// MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+@class MHVThing;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Versioned binary encoding of a MHVThing, stored in the thing cache.
+
+ The thing's key, type, state, dates and audits are encoded as tagged binary fields,
+ so reading them back needs no XML parsing. The typed data is kept as its <data-xml>
+ element (deflated when large) and is only parsed when the thing's data is needed.
+ */
+@interface MHVCachedThingPayload : NSObject
+
+/**
+ Encode a thing
+
+ @param thing The thing to encode
+ @return The encoded payload, or nil if the thing could not be encoded
+ */
++ (NSData *_Nullable)dataWithThing:(MHVThing *)thing;
+
+/**
+ Decode a thing from a payload created by dataWithThing:
+
+ @param data The encoded payload
+ @param deferData If YES, the thing's data xml is only deserialized when its data is first accessed
+ @return The thing, or nil if the payload is invalid or from a newer version
+ */
++ (MHVThing *_Nullable)newThingWithData:(NSData *)data deferData:(BOOL)deferData;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,472 @@
+//
+// MHVCachedThingPayload.m
+// MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "MHVCachedThingPayload.h"
+#import <zlib.h>
+#import "MHVValidator.h"
+#import "MHVTypes.h"
+#import "MHVThingInternal.h"
+
+//
+// Layout: one version byte, then fields of <tag byte><varint length><bytes>.
+// Readers skip tags they don't know, so fields can be added without a new version.
+// A new version is only needed when existing fields change meaning.
+//
+static const uint8_t c_payloadVersion = 1;
+
+// Smaller data xml isn't worth the inflate on every read
+static const NSUInteger c_minDeflateLength = 256;
+
+static NSString *const c_element_blobs = @"blob-payload";
+static NSString *const c_element_updatedEndDate = @"updated-end-date";
+
+typedef NS_ENUM(uint8_t, MHVPayloadField)
+{
+    MHVPayloadFieldThingID = 1,
+    MHVPayloadFieldVersion = 2,
+    MHVPayloadFieldTypeID = 3,
+    MHVPayloadFieldTypeName = 4,
+    MHVPayloadFieldState = 5,
+    MHVPayloadFieldFlags = 6,
+    MHVPayloadFieldEffectiveDate = 7,
+    MHVPayloadFieldCreated = 8,
+    MHVPayloadFieldUpdated = 9,
+    MHVPayloadFieldDataXml = 10,
+    MHVPayloadFieldDeflatedDataXml = 11,
+    MHVPayloadFieldBlobsXml = 12,
+    MHVPayloadFieldUpdatedEndDateXml = 13
+};
+
+typedef NS_ENUM(uint8_t, MHVPayloadAuditField)
+{
+    MHVPayloadAuditFieldWhen = 1,
+    MHVPayloadAuditFieldAppID = 2,
+    MHVPayloadAuditFieldPersonID = 3,
+    MHVPayloadAuditFieldAction = 4
+};
+
+typedef struct
+{
+    const uint8_t *bytes;
+    NSUInteger length;
+    NSUInteger offset;
+} MHVPayloadCursor;
+
+#pragma mark - Encoding
+
+static NSUInteger encodeVarint(uint64_t value, uint8_t *buffer)
+{
+    NSUInteger length = 0;
+
+    do
+    {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        if (value)
+        {
+            byte |= 0x80;
+        }
+        buffer[length++] = byte;
+    }
+    while (value);
+
+    return length;
+}
+
+static void appendField(NSMutableData *data, uint8_t field, const void *bytes, NSUInteger length)
+{
+    uint8_t header[11];
+    header[0] = field;
+    NSUInteger headerLength = 1 + encodeVarint(length, header + 1);
+
+    [data appendBytes:header length:headerLength];
+    [data appendBytes:bytes length:length];
+}
+
+static void appendStringField(NSMutableData *data, uint8_t field, NSString *value)
+{
+    if (value)
+    {
+        const char *utf8 = value.UTF8String;
+        appendField(data, field, utf8, strlen(utf8));
+    }
+}
+
+static void appendVarintField(NSMutableData *data, uint8_t field, uint64_t value)
+{
+    uint8_t buffer[10];
+    appendField(data, field, buffer, encodeVarint(value, buffer));
+}
+
+static void appendDateField(NSMutableData *data, uint8_t field, NSDate *value)
+{
+    if (value)
+    {
+        double interval = value.timeIntervalSinceReferenceDate;
+        uint64_t bits;
+        memcpy(&bits, &interval, sizeof(bits));
+        bits = CFSwapInt64HostToLittle(bits);
+
+        appendField(data, field, &bits, sizeof(bits));
+    }
+}
+
+static void appendUuidField(NSMutableData *data, uint8_t field, NSUUID *value)
+{
+    if (value)
+    {
+        uuid_t bytes;
+        [value getUUIDBytes:bytes];
+
+        appendField(data, field, bytes, sizeof(bytes));
+    }
+}
+
+static void appendAuditField(NSMutableData *data, uint8_t field, MHVAudit *audit)
+{
+    if (audit)
+    {
+        NSMutableData *auditData = [NSMutableData new];
+        appendDateField(auditData, MHVPayloadAuditFieldWhen, audit.when);
+        appendUuidField(auditData, MHVPayloadAuditFieldAppID, audit.appID);
+        appendUuidField(auditData, MHVPayloadAuditFieldPersonID, audit.personID);
+        appendStringField(auditData, MHVPayloadAuditFieldAction, audit.action);
+
+        appendField(data, field, auditData.bytes, auditData.length);
+    }
+}
+
+static void appendDataXmlField(NSMutableData *data, NSString *xml)
+{
+    if (!xml)
+    {
+        return;
+    }
+
+    const char *utf8 = xml.UTF8String;
+    NSUInteger length = strlen(utf8);
+
+    if (length >= c_minDeflateLength)
+    {
+        uLongf deflatedLength = compressBound(length);
+        NSMutableData *field = [[NSMutableData alloc] initWithLength:10 + deflatedLength];
+        uint8_t *bytes = field.mutableBytes;
+        NSUInteger prefixLength = encodeVarint(length, bytes);
+
+        if (compress2(bytes + prefixLength, &deflatedLength, (const Bytef *)utf8, length, Z_BEST_SPEED) == Z_OK &&
+            prefixLength + deflatedLength < length)
+        {
+            appendField(data, MHVPayloadFieldDeflatedDataXml, bytes, prefixLength + deflatedLength);
+            return;
+        }
+    }
+
+    appendField(data, MHVPayloadFieldDataXml, utf8, length);
+}
+
+#pragma mark - Decoding
+
+static BOOL readVarint(MHVPayloadCursor *cursor, uint64_t *value)
+{
+    uint64_t result = 0;
+
+    for (NSUInteger shift = 0; shift < 64 && cursor->offset < cursor->length; shift += 7)
+    {
+        uint8_t byte = cursor->bytes[cursor->offset++];
+        result |= (uint64_t)(byte & 0x7F) << shift;
+
+        if (!(byte & 0x80))
+        {
+            *value = result;
+            return YES;
+        }
+    }
+
+    return NO;
+}
+
+static BOOL readField(MHVPayloadCursor *cursor, uint8_t *field, MHVPayloadCursor *value)
+{
+    if (cursor->offset >= cursor->length)
+    {
+        return NO;
+    }
+
+    *field = cursor->bytes[cursor->offset++];
+
+    uint64_t length;
+    if (!readVarint(cursor, &length) || length > cursor->length - cursor->offset)
+    {
+        return NO;
+    }
+
+    value->bytes = cursor->bytes + cursor->offset;
+    value->length = (NSUInteger)length;
+    value->offset = 0;
+
+    cursor->offset += (NSUInteger)length;
+
+    return YES;
+}
+
+static NSString *stringFromField(MHVPayloadCursor *value)
+{
+    return [[NSString alloc] initWithBytes:value->bytes length:value->length encoding:NSUTF8StringEncoding];
+}
+
+static NSDate *dateFromField(MHVPayloadCursor *value)
+{
+    uint64_t bits;
+    if (value->length != sizeof(bits))
+    {
+        return nil;
+    }
+
+    memcpy(&bits, value->bytes, sizeof(bits));
+    bits = CFSwapInt64LittleToHost(bits);
+
+    double interval;
+    memcpy(&interval, &bits, sizeof(interval));
+
+    return [NSDate dateWithTimeIntervalSinceReferenceDate:interval];
+}
+
+static NSUUID *uuidFromField(MHVPayloadCursor *value)
+{
+    if (value->length != sizeof(uuid_t))
+    {
+        return nil;
+    }
+
+    return [[NSUUID alloc] initWithUUIDBytes:value->bytes];
+}
+
+static MHVAudit *auditFromField(MHVPayloadCursor *value)
+{
+    MHVAudit *audit = [[MHVAudit alloc] init];
+    uint8_t field;
+    MHVPayloadCursor fieldValue;
+
+    while (value->offset < value->length)
+    {
+        if (!readField(value, &field, &fieldValue))
+        {
+            return nil;
+        }
+
+        switch (field)
+        {
+            case MHVPayloadAuditFieldWhen:
+                audit.when = dateFromField(&fieldValue);
+                break;
+            case MHVPayloadAuditFieldAppID:
+                audit.appID = uuidFromField(&fieldValue);
+                break;
+            case MHVPayloadAuditFieldPersonID:
+                audit.personID = uuidFromField(&fieldValue);
+                break;
+            case MHVPayloadAuditFieldAction:
+                audit.action = stringFromField(&fieldValue);
+                break;
+            default:
+                break;
+        }
+    }
+
+    return audit;
+}
+
+static NSString *inflatedStringFromField(MHVPayloadCursor *value)
+{
+    uint64_t length;
+    if (!readVarint(value, &length) || length == 0 || length > UINT32_MAX)
+    {
+        return nil;
+    }
+
+    Bytef *buffer = malloc((size_t)length);
+    MHVCHECK_OOM(buffer);
+
+    uLongf inflatedLength = (uLongf)length;
+    if (uncompress(buffer, &inflatedLength, value->bytes + value->offset, value->length - value->offset) != Z_OK ||
+        inflatedLength != length)
+    {
+        free(buffer);
+        return nil;
+    }
+
+    return [[NSString alloc] initWithBytesNoCopy:buffer length:inflatedLength encoding:NSUTF8StringEncoding freeWhenDone:YES];
+}
+
+@implementation MHVCachedThingPayload
+
++ (NSData *)dataWithThing:(MHVThing *)thing
+{
+    MHVCHECK_NOTNULL(thing);
+
+    NSMutableData *data = [NSMutableData new];
+    MHVCHECK_OOM(data);
+
+    [data appendBytes:&c_payloadVersion length:1];
+
+    appendStringField(data, MHVPayloadFieldThingID, thing.key.thingID);
+    appendStringField(data, MHVPayloadFieldVersion, thing.key.version);
+    appendStringField(data, MHVPayloadFieldTypeID, thing.type.typeID);
+    appendStringField(data, MHVPayloadFieldTypeName, thing.type.name);
+    appendVarintField(data, MHVPayloadFieldState, (uint64_t)thing.state);
+    appendVarintField(data, MHVPayloadFieldFlags, (uint32_t)thing.flags);
+    appendDateField(data, MHVPayloadFieldEffectiveDate, thing.effectiveDate);
+    appendAuditField(data, MHVPayloadFieldCreated, thing.created);
+    appendAuditField(data, MHVPayloadFieldUpdated, thing.updated);
+
+    if (thing.hasDeferredData)
+    {
+        appendDataXmlField(data, thing.dataXml);
+    }
+    else if (thing.data)
+    {
+        NSString *dataXml = [XSerializer serializeToString:thing.data withRoot:@"data-xml"];
+        MHVCHECK_NOTNULL(dataXml);
+
+        appendDataXmlField(data, dataXml);
+    }
+
+    if (thing.hasBlobData)
+    {
+        appendStringField(data, MHVPayloadFieldBlobsXml, [XSerializer serializeToString:thing.blobs withRoot:c_element_blobs]);
+    }
+
+    if (thing.hasUpdatedEndDate)
+    {
+        appendStringField(data, MHVPayloadFieldUpdatedEndDateXml, [XSerializer serializeToString:thing.updatedEndDate withRoot:c_element_updatedEndDate]);
+    }
+
+    return data;
+}
+
++ (MHVThing *)newThingWithData:(NSData *)data deferData:(BOOL)deferData
+{
+    MHVCHECK_NOTNULL(data);
+
+    MHVPayloadCursor cursor = { data.bytes, data.length, 0 };
+    if (cursor.length < 1 || cursor.bytes[0] > c_payloadVersion)
+    {
+        return nil;
+    }
+    cursor.offset = 1;
+
+    MHVThing *thing = [[MHVThing alloc] init];
+    MHVCHECK_OOM(thing);
+
+    NSString *thingID = nil;
+    NSString *version = nil;
+    NSString *typeID = nil;
+    NSString *typeName = nil;
+    NSString *dataXml = nil;
+    uint8_t field;
+    MHVPayloadCursor value;
+    uint64_t number;
+
+    while (cursor.offset < cursor.length)
+    {
+        if (!readField(&cursor, &field, &value))
+        {
+            return nil;
+        }
+
+        switch (field)
+        {
+            case MHVPayloadFieldThingID:
+                thingID = stringFromField(&value);
+                break;
+            case MHVPayloadFieldVersion:
+                version = stringFromField(&value);
+                break;
+            case MHVPayloadFieldTypeID:
+                typeID = stringFromField(&value);
+                break;
+            case MHVPayloadFieldTypeName:
+                typeName = stringFromField(&value);
+                break;
+            case MHVPayloadFieldState:
+                if (readVarint(&value, &number))
+                {
+                    thing.state = (MHVThingState)number;
+                }
+                break;
+            case MHVPayloadFieldFlags:
+                if (readVarint(&value, &number))
+                {
+                    thing.flags = (int)(uint32_t)number;
+                }
+                break;
+            case MHVPayloadFieldEffectiveDate:
+                thing.effectiveDate = dateFromField(&value);
+                break;
+            case MHVPayloadFieldCreated:
+                thing.created = auditFromField(&value);
+                break;
+            case MHVPayloadFieldUpdated:
+                thing.updated = auditFromField(&value);
+                break;
+            case MHVPayloadFieldDataXml:
+                dataXml = stringFromField(&value);
+                MHVCHECK_NOTNULL(dataXml);
+                break;
+            case MHVPayloadFieldDeflatedDataXml:
+                dataXml = inflatedStringFromField(&value);
+                MHVCHECK_NOTNULL(dataXml);
+                break;
+            case MHVPayloadFieldBlobsXml:
+                thing.blobs = [NSObject newFromString:stringFromField(&value) withRoot:c_element_blobs asClass:[MHVBlobPayload class]];
+                break;
+            case MHVPayloadFieldUpdatedEndDateXml:
+                thing.updatedEndDate = [NSObject newFromString:stringFromField(&value) withRoot:c_element_updatedEndDate asClass:[MHVConstrainedXmlDate class]];
+                break;
+            default:
+                // Written by a newer version; safe to ignore
+                break;
+        }
+    }
+
+    if (typeID)
+    {
+        thing.type = [[MHVThingType alloc] initWithTypeID:typeID];
+        thing.type.name = typeName;
+    }
+
+    if (thingID)
+    {
+        thing.key = [[MHVThingKey alloc] initWithID:thingID andVersion:version];
+    }
+
+    if (dataXml)
+    {
+        // The type is set by now, so the data can be deserialized on demand
+        thing.dataXml = dataXml;
+
+        if (!deferData)
+        {
+            MHVCHECK_NOTNULL(thing.data);
+        }
+    }
+
+    return thing;
+}
+
+@end
@@ -352,7 +352,7 @@ static NSString *kMHVCachePasswordKey = @"MHVCachePassword";
          
          NSFetchRequest *fetchRequest = [NSFetchRequest fetchRequestWithEntityName:@"MHVCachedThing"];
          fetchRequest.predicate = predicate;
-         fetchRequest.propertiesToFetch = @[@"xmlString"];
+         fetchRequest.propertiesToFetch = @[@"thingData", @"xmlString"];
          fetchRequest.sortDescriptors = @[[NSSortDescriptor sortDescriptorWithKey:@"effectiveDate" ascending:NO]];
          
          NSUInteger fetchCount = [self.managedObjectContext countForFetchRequest:fetchRequest error:&error];
@@ -381,7 +381,7 @@ static NSString *kMHVCachePasswordKey = @"MHVCachePassword";
              //Convert cached things back into MHVThings
              for (MHVCachedThing *cachedThing in fetchedThings)
              {
-                 MHVThing *thing = [cachedThing toThing];
+                 MHVThing *thing = [cachedThing toThingDeferringData:query.shouldDeferTypedData];
                  if (thing)
                  {
                      [thingCollection addObject:thing];
@@ -392,6 +392,16 @@ static NSString *kMHVCachePasswordKey = @"MHVCachePassword";
                      return;
                  }
              }
+             
+             // Persist any XML rows that were converted to binary payloads while reading
+             if (self.managedObjectContext.hasChanges)
+             {
+                 NSError *saveError = [self saveContext];
+                 if (saveError)
+                 {
+                     MHVLOG(@"ThingCacheDatabase: Could not save converted things: %@", saveError.localizedDescription);
+                 }
+             }
          }
          
          MHVThingQueryResult *queryResult = [[MHVThingQueryResult alloc] initWithName:query.name
@@ -1242,10 +1252,19 @@ static NSString *kMHVCachePasswordKey = @"MHVCachePassword";
         return;
     }
     
+    // Older model versions are looked up in the model's bundle for lightweight migration
+    EncryptedStoreFileManagerConfiguration *storeConfiguration = [[EncryptedStoreFileManagerConfiguration alloc] initWithOptions:@{
+                                                                                                                                    EncryptedStoreFileManagerConfiguration.optionBundle : bundle,
+                                                                                                                                    }];
+    EncryptedStoreFileManager *storeFileManager = [[EncryptedStoreFileManager alloc] initWithConfiguration:storeConfiguration];
+    
     // PersistentSoreCoordinator
     self.persistentStoreCoordinator = [EncryptedStore makeStoreWithOptions:@{
                                                                              EncryptedStorePassphraseKey : [self.keychainService stringForKey:kMHVCachePasswordKey],
                                                                              EncryptedStoreDatabaseLocation : self.databaseUrl,
+                                                                             EncryptedStoreFileManagerOption : storeFileManager,
+                                                                             NSMigratePersistentStoresAutomaticallyOption : @(YES),
+                                                                             NSInferMappingModelAutomaticallyOption : @(YES),
                                                                              }
                                                         managedObjectModel:objectModel];
     if (!self.persistentStoreCoordinator)
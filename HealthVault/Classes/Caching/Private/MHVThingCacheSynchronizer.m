@@ -22,6 +22,7 @@
 #import "MHVThingCacheDatabaseProtocol.h"
 #import "MHVConnectionProtocol.h"
 #import "MHVThingClientProtocol.h"
+#import "MHVThingClient.h"
 #import "MHVPersonInfo.h"
 #import "NSError+MHVError.h"
 #import "MHVThingCacheDatabase+CoreDataModel.h"
@@ -45,6 +46,7 @@ typedef void (^MHVSyncResultCompletion)(NSInteger syncedItemCount, NSError *_Nul
 
 static NSString *const kPersonInfoKeyPath = @"personInfo";
 static NSUInteger const kMaxRecordBatchSize = 240;
+static NSUInteger const kStreamedThingBatchSize = 40;
 static NSString *const kCacheStatusKey = @"CacheStatus";
 static NSString *const kRecordOperationsKey = @"RecordOperations";
 static NSString *const kSyncedItemCountKey = @"SyncedItemCount";
@@ -59,6 +61,9 @@ static NSString *const kSyncedItemCountKey = @"SyncedItemCount";
 @property (nonatomic, strong) NSNumber                                              *isSyncing;
 @property (nonatomic, strong) NSTimer                                               *syncTimer;
 
+// Sends the sync methods at background priority, so they don't hold up the app's own requests
+@property (nonatomic, strong) MHVThingClient                                        *thingClient;
+
 @end
 
 @implementation MHVThingCacheSynchronizer
@@ -101,6 +106,9 @@ static NSString *const kSyncedItemCountKey = @"SyncedItemCount";
     
     _connection = connection;
     
+    _thingClient = [[MHVThingClient alloc] initWithConnection:connection cache:nil];
+    _thingClient.priority = MHVRequestPriorityBackgroundSync;
+    
     [self startObserving];
 }
 
@@ -589,9 +597,9 @@ static NSString *const kSyncedItemCountKey = @"SyncedItemCount";
                 
                 MHVLOG(@"\nChecking HealthVault for new record operations created since %@.\n", status.lastCacheConsistencyDate);
                 
-                [self.connection.thingClient getRecordOperations:status.newestCacheSequenceNumber
-                                                        recordId:[[NSUUID alloc] initWithUUIDString:recordId]
-                                                      completion:^(MHVGetRecordOperationsResult * _Nullable result, NSError * _Nullable error)
+                [self.thingClient getRecordOperations:status.newestCacheSequenceNumber
+                                            recordId:[[NSUUID alloc] initWithUUIDString:recordId]
+                                          completion:^(MHVGetRecordOperationsResult * _Nullable result, NSError * _Nullable error)
                  {
                      if (error)
                      {
@@ -916,29 +924,79 @@ static NSString *const kSyncedItemCountKey = @"SyncedItemCount";
     
     MHVThingQuery *query = [[MHVThingQuery alloc] initWithThingIDs:thingIds];
     query.shouldUseCachedResults = NO;
+    // Things are only stored, so keep their data xml as returned rather than building the typed objects
+    query.shouldDeferTypedData = YES;
     
     __weak __typeof__(self)weakSelf = self;
     
-    [self.connection.thingClient getThingsWithQuery:query
-                                           recordId:[[NSUUID alloc] initWithUUIDString:recordId]
-                                         completion:^(MHVThingQueryResult * _Nullable result, NSError * _Nullable error)
+    // Things are written to the database in batches while the rest of the response is still downloading.
+    // The newest thing is always held back, so the final write (which also records the sequence numbers) is never empty.
+    __block NSMutableArray<MHVThing *> *batch = [NSMutableArray new];
+    __block NSInteger syncedItemCount = 0;
+    __block NSError *syncError = nil;
+    dispatch_group_t writeGroup = dispatch_group_create();
+    
+    void (^itemsSynchronized)(NSInteger, NSError *) = ^(NSInteger count, NSError *error)
+    {
+        @synchronized(writeGroup)
+        {
+            syncedItemCount += count;
+            syncError = syncError ?: error;
+        }
+        dispatch_group_leave(writeGroup);
+    };
+    
+    [self.thingClient getThingsWithQuery:query
+                                recordId:[[NSUUID alloc] initWithUUIDString:recordId]
+                            thingHandler:^(MHVThing *thing)
+     {
+         [batch addObject:thing];
+         
+         if (batch.count > kStreamedThingBatchSize)
+         {
+             NSArray<MHVThing *> *things = [batch subarrayWithRange:NSMakeRange(0, kStreamedThingBatchSize)];
+             [batch removeObjectsInRange:NSMakeRange(0, kStreamedThingBatchSize)];
+             
+             dispatch_group_enter(writeGroup);
+             [weakSelf.database synchronizeThings:things
+                                         recordId:recordId
+                              batchSequenceNumber:-1
+                             latestSequenceNumber:-1
+                                       completion:itemsSynchronized];
+         }
+     }
+                              completion:^(NSError * _Nullable error)
      {
          if (error)
          {
              MHVLOG(@"ThingCache: Error performing GetThings: %@", error);
-             if (completion)
-             {
-                 completion(0, error);
-             }
          }
-         else
+         
+         dispatch_group_notify(writeGroup, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^
          {
-             [weakSelf.database synchronizeThings:result.things
+             NSError *resultError = error ?: syncError;
+             
+             if (resultError)
+             {
+                 if (completion)
+                 {
+                     completion(0, resultError);
+                 }
+                 return;
+             }
+             
+             [weakSelf.database synchronizeThings:batch
                                          recordId:recordId
                               batchSequenceNumber:batchSequenceNumber
                              latestSequenceNumber:latestSequenceNumber
-                                       completion:completion];
-         }
+                                       completion:^(NSInteger count, NSError * _Nullable databaseError)
+              {
+                  if (completion)
+                  {
+                      completion(syncedItemCount + count, databaseError);
+                  }
+              }];
+         });
      }];
 }
 
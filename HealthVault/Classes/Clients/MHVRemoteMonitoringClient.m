@@ -20,7 +20,6 @@
 #import <Foundation/Foundation.h>
 #import "MHVValidator.h"
 #import "MHVRemoteMonitoringClient.h"
-#import "MHVJsonSerializer.h"
 #import "MHVConnectionProtocol.h"
 #import "MHVRestRequest.h"
 #import "MHVServiceResponse.h"
@@ -67,6 +66,7 @@
                                                            queryParams:queryParams
                                                                   body:body
                                                            isAnonymous:NO];
+    restRequest.resultClass = resultClass;
     
     [self.connection executeHttpServiceOperation:restRequest
                                       completion:^(MHVServiceResponse *_Nullable response, NSError *_Nullable error)
@@ -82,11 +82,8 @@
          {
              if (completion)
              {
-                 id result = [MHVJsonSerializer deserialize:[[NSString alloc] initWithData:response.responseData encoding:NSUTF8StringEncoding]
-                                                    toClass:[resultClass class]
-                                                shouldCache:YES];
-                 
-                 completion(result, nil);
+                 // Deserialized by the connection, which keeps the result with cached responses
+                 completion(response.resultObject, nil);
              }
          }
      }];
@@ -18,6 +18,7 @@
 
 #import <UIKit/UIKit.h>
 #import "MHVClientProtocol.h"
+#import "MHVRequestPriority.h"
 
 @class MHVThing, MHVThingQuery, MHVThing, MHVThingQueryResult, MHVBlobPayloadThing, MHVGetRecordOperationsResult, MHVThingKey;
 
@@ -27,6 +28,25 @@ NS_ASSUME_NONNULL_BEGIN
 
 @protocol MHVThingClientProtocol <NSObject>
 
+/**
+ * How long GetThings calls wait for other calls for the same record, so their queries can be sent
+ * together as one request. Each caller still gets only the results for its own queries.
+ * Useful when a screen issues many queries at once. Defaults to 0, which sends every call straight away.
+ */
+@property (nonatomic, assign) NSTimeInterval queryBatchInterval;
+
+/**
+ * The most queries sent together in one batched request. A batch is sent as soon as it is full.
+ * 0 means no limit. Defaults to 20. Only used when queryBatchInterval is greater than 0.
+ */
+@property (nonatomic, assign) NSUInteger queryBatchLimit;
+
+/**
+ * When the client's methods are sent if the connection is busy. Defaults to MHVRequestPriorityUserInitiated.
+ * A GetThings call with an interactive query is always sent as MHVRequestPriorityInteractive.
+ */
+@property (nonatomic, assign) MHVRequestPriority priority;
+
 /**
  * Gets the an individual thing by its ID
  *
@@ -53,6 +73,23 @@ NS_ASSUME_NONNULL_BEGIN
                   recordId:(NSUUID *)recordId
                 completion:(void(^)(MHVThingQueryResult *_Nullable result, NSError *_Nullable error))completion;
 
+/**
+ * Get a collection of things, receiving each thing as soon as it has been downloaded
+ * rather than once the whole response has arrived.
+ * The response is parsed while it downloads, so only one thing at a time is held in memory.
+ * Things are always retrieved from HealthVault, not the thing cache.
+ *
+ * @param query A thing query to perform
+ * @param recordId an authorized person's record ID.
+ * @param thingHandler Envoked on a background queue for each thing, in the order HealthVault returns them.
+ * @param completion Envoked when the operation completes, after the last thing has been delivered.
+ *        NSError object will be nil if there is no error when performing the operation.
+ */
+- (void)getThingsWithQuery:(MHVThingQuery *)query
+                  recordId:(NSUUID *)recordId
+              thingHandler:(void(^)(MHVThing *thing))thingHandler
+                completion:(void(^)(NSError *_Nullable error))completion;
+
 /**
  * Get several collections of things
  *
@@ -190,6 +227,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 /**
  * Download a blob as NSData
+ * A blob that has been downloaded before is read from the blob cache. See MHVConfiguration blobCacheSizeLimit.
  *
  * @param blobPayloadThing The blob to be downloaded
  * @param completion Envoked when the operation completes.
@@ -201,6 +239,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 /**
  * Download a blob and save it to a file
+ * A blob that has been downloaded before is copied from the blob cache. See MHVConfiguration blobCacheSizeLimit.
  *
  * @param blobPayloadThing The blob to be downloaded
  * @param toFilePath The location where the blob file should be saved
@@ -213,6 +252,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 /**
  * Gets the personal image for a record
+ * The image is downloaded with downloadBlobData:, so it's read from the blob cache if it hasn't changed.
  *
  * @param recordId The record ID to retrieve the personal image
  * @param completion Envoked when the operation completes.
@@ -239,8 +279,11 @@ NS_ASSUME_NONNULL_BEGIN
 
 /**
  * Add a blob to a Thing
+ * If an earlier call with the same blob, name, thing and record stopped part way, e.g. because the network was lost,
+ * the upload continues from the last part HealthVault stored instead of sending the whole blob again.
  *
  * @param blobSource The blob source data to be added to the thing
+ *        Use MHVBlobMappedFileSource for a large file, or MHVBlobStreamSource for data that is still being produced
  * @param toThing The thing to add the blob
  * @param name The name of the blob
  *        If an existing blob on the thing has the same name, it will be updated to the new blobSource
@@ -18,7 +18,7 @@
 
 #import <Foundation/Foundation.h>
 
-@class MHVConfiguration;
+@class MHVConfiguration, MHVPendingBlobUploadStore;
 
 @protocol MHVConnectionProtocol, MHVPersonClientProtocol, MHVPlatformClientProtocol, MHVThingClientProtocol, MHVVocabularyClientProtocol, MHVSessionCredentialClientProtocol, MHVRemoteMonitoringClientProtocol, MHVThingCacheDatabaseProtocol;
 
@@ -33,7 +33,8 @@ NS_ASSUME_NONNULL_BEGIN
 -(id<MHVRemoteMonitoringClientProtocol>)remoteMonitoringClientWithConnection:(id<MHVConnectionProtocol>)connection;
 
 - (id<MHVThingClientProtocol>)thingClientWithConnection:(id<MHVConnectionProtocol>)connection
-                                     thingCacheDatabase:(id<MHVThingCacheDatabaseProtocol>_Nullable)thingCacheDatabase;
+                                     thingCacheDatabase:(id<MHVThingCacheDatabaseProtocol>_Nullable)thingCacheDatabase
+                                        blobUploadStore:(MHVPendingBlobUploadStore *)blobUploadStore;
 
 - (id<MHVVocabularyClientProtocol>)vocabularyClientWithConnection:(id<MHVConnectionProtocol>)connection;
 
@@ -51,14 +51,15 @@
 
 - (id<MHVThingClientProtocol>)thingClientWithConnection:(id<MHVConnectionProtocol>)connection
                                      thingCacheDatabase:(id<MHVThingCacheDatabaseProtocol>_Nullable)thingCacheDatabase
+                                        blobUploadStore:(MHVPendingBlobUploadStore *)blobUploadStore
 {
 #if THING_CACHE
     MHVThingCache *thingCache = [[MHVThingCache alloc] initWithCacheDatabase:thingCacheDatabase
                                                                   connection:connection];
         
-    return [[MHVThingClient alloc] initWithConnection:connection cache:thingCache];
+    return [[MHVThingClient alloc] initWithConnection:connection cache:thingCache blobUploadStore:blobUploadStore];
 #else
-    return [[MHVThingClient alloc] initWithConnection:connection cache:nil];
+    return [[MHVThingClient alloc] initWithConnection:connection cache:nil blobUploadStore:blobUploadStore];
 #endif
 }
 
@@ -0,0 +1,121 @@
+//
+//  MHVPendingBlobUploadStore.h
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+@protocol MHVBlobSourceProtocol;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A blob upload that hasn't been attached to its thing yet
+ */
+@interface MHVPendingBlobUpload : NSObject
+
+// nil for an upload that isn't kept, because its blob source can only be read once
+@property (nonatomic, strong, nullable) NSString *key;
+@property (nonatomic, strong) NSURL *url;
+@property (nonatomic, assign) NSUInteger chunkSize;
+@property (nonatomic, assign) NSUInteger length;
+
+/**
+ The length of the blob stored from its start, acknowledged by HealthVault
+ */
+@property (nonatomic, assign) NSUInteger committedLength;
+
+/**
+ The SHA256 of each chunk in committedLength, so a blob that changed since isn't continued
+ */
+@property (nonatomic, strong) NSData *chunkDigests;
+
+@property (nonatomic, strong) NSString *name;
+@property (nonatomic, strong) NSString *contentType;
+@property (nonatomic, strong, nullable) NSString *thingId;
+@property (nonatomic, strong) NSUUID *recordId;
+@property (nonatomic, strong) NSDate *startDate;
+
+/**
+ Whether the blob's hash is computed as it's uploaded, and its block size. A block size of 0 uses the configuration's
+ */
+@property (nonatomic, assign) BOOL shouldComputeHash;
+@property (nonatomic, assign) NSUInteger hashBlockSize;
+
+/**
+ The store's generation when the upload started. Not kept on disk
+ */
+@property (nonatomic, assign) NSUInteger generation;
+
+@end
+
+/**
+ Keeps the state of blob uploads on disk, so an upload that fails part way, or is stopped when the app is
+ suspended, can continue from the last chunk HealthVault stored instead of from the start.
+
+ Reads, writes and removals are made in order on one queue, so a connection and its clients share one store.
+ */
+@interface MHVPendingBlobUploadStore : NSObject
+
+/**
+ Application Support/MHVPendingBlobUploads in the app's container
+ */
++ (NSURL *)defaultDirectoryURL;
+
+/**
+ The key an upload is kept under. The same blob added to the same thing has the same key, even after a relaunch.
+
+ @param blobSource The blob being uploaded. Its start and end are read to tell it apart from other blobs of the same length.
+ @param name The blob's name
+ @param thingId The thing the blob is added to
+ @param recordId The record of the thing
+ @return The key
+ */
++ (NSString *)keyForBlobSource:(id<MHVBlobSourceProtocol>)blobSource
+                          name:(NSString *)name
+                       thingId:(NSString *_Nullable)thingId
+                      recordId:(NSUUID *)recordId;
+
+- (instancetype)initWithDirectoryURL:(NSURL *)directoryURL;
+
+/**
+ Changes each time every upload is removed. An upload is only kept if the generation is the same as when it started.
+ */
+@property (nonatomic, assign, readonly) NSUInteger generation;
+
+/**
+ Get an upload
+
+ @param key The upload's key
+ @return The upload, with the current generation, or nil if there isn't one or its upload URL is too old to use
+ */
+- (MHVPendingBlobUpload *_Nullable)uploadForKey:(NSString *)key;
+
+/**
+ Keep an upload, replacing the upload with the same key. Ignored if every upload was removed since the upload's generation
+ */
+- (void)setUpload:(MHVPendingBlobUpload *)upload;
+
+- (void)removeUploadForKey:(NSString *)key;
+
+/**
+ Remove every upload, e.g. when the person signs out.
+ */
+- (void)removeAllUploads;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,269 @@
+//
+//  MHVPendingBlobUploadStore.m
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <CommonCrypto/CommonDigest.h>
+#import "MHVPendingBlobUploadStore.h"
+#import "MHVValidator.h"
+#import "MHVLogger.h"
+#import "MHVBlobSource.h"
+#import "NSData+Utils.h"
+
+static NSString *const kUrlKey = @"url";
+static NSString *const kChunkSizeKey = @"chunkSize";
+static NSString *const kLengthKey = @"length";
+static NSString *const kCommittedLengthKey = @"committedLength";
+static NSString *const kChunkDigestsKey = @"chunkDigests";
+static NSString *const kNameKey = @"name";
+static NSString *const kContentTypeKey = @"contentType";
+static NSString *const kThingIdKey = @"thingId";
+static NSString *const kRecordIdKey = @"recordId";
+static NSString *const kStartDateKey = @"startDate";
+static NSString *const kShouldComputeHashKey = @"shouldComputeHash";
+static NSString *const kHashBlockSizeKey = @"hashBlockSize";
+
+// Bytes read from each end of a blob to tell it apart from other blobs of the same length
+static NSUInteger const kFingerprintLength = 64 * 1024;
+
+// Blob upload URLs expire, so an older upload starts again
+static NSTimeInterval const kPendingUploadLifetime = 60 * 60 * 24;
+
+@implementation MHVPendingBlobUpload
+
+@end
+
+@interface MHVPendingBlobUploadStore ()
+
+@property (nonatomic, strong) NSURL *directoryURL;
+@property (nonatomic, strong) NSFileManager *fileManager;
+
+// Reads are synchronous and writes asynchronous, both in order on this queue
+@property (nonatomic, strong) dispatch_queue_t ioQueue;
+
+// Guarded by @synchronized (self)
+@property (nonatomic, assign) NSUInteger removeAllCount;
+
+@end
+
+@implementation MHVPendingBlobUploadStore
+
++ (NSURL *)defaultDirectoryURL
+{
+    NSURL *applicationSupportURL = [[[NSFileManager defaultManager] URLsForDirectory:NSApplicationSupportDirectory inDomains:NSUserDomainMask] lastObject];
+
+    return [applicationSupportURL URLByAppendingPathComponent:@"MHVPendingBlobUploads" isDirectory:YES];
+}
+
++ (NSString *)keyForBlobSource:(id<MHVBlobSourceProtocol>)blobSource
+                          name:(NSString *)name
+                       thingId:(NSString *_Nullable)thingId
+                      recordId:(NSUUID *)recordId
+{
+    MHVASSERT_PARAMETER(blobSource);
+    MHVASSERT_PARAMETER(recordId);
+
+    NSString *upload = [NSString stringWithFormat:@"%@|%@|%@|%lu|", recordId.UUIDString, thingId ?: @"", name ?: @"", (unsigned long)blobSource.length];
+
+    NSMutableData *canonical = [[upload dataUsingEncoding:NSUTF8StringEncoding] mutableCopy];
+
+    NSUInteger fingerprintLength = MIN(kFingerprintLength, blobSource.length);
+    if (fingerprintLength > 0)
+    {
+        [canonical appendData:[blobSource readStartAt:0 chunkSize:fingerprintLength]];
+        [canonical appendData:[blobSource readStartAt:blobSource.length - fingerprintLength chunkSize:fingerprintLength]];
+    }
+
+    return [canonical SHA256];
+}
+
+- (instancetype)initWithDirectoryURL:(NSURL *)directoryURL
+{
+    MHVASSERT_PARAMETER(directoryURL);
+
+    self = [super init];
+
+    if (self)
+    {
+        _directoryURL = directoryURL;
+        _fileManager = [NSFileManager new];
+        _ioQueue = dispatch_queue_create("MHVPendingBlobUploadStore.ioQueue", DISPATCH_QUEUE_SERIAL);
+    }
+
+    return self;
+}
+
+- (NSUInteger)generation
+{
+    @synchronized (self)
+    {
+        return self.removeAllCount;
+    }
+}
+
+- (MHVPendingBlobUpload *_Nullable)uploadForKey:(NSString *)key
+{
+    MHVASSERT_PARAMETER(key);
+
+    NSUInteger generation = self.generation;
+    __block NSData *data = nil;
+
+    dispatch_sync(self.ioQueue, ^
+    {
+        data = [NSData dataWithContentsOfURL:[self.directoryURL URLByAppendingPathComponent:key]];
+    });
+
+    if (!data)
+    {
+        return nil;
+    }
+
+    NSDictionary *entry = [NSPropertyListSerialization propertyListWithData:data options:NSPropertyListImmutable format:nil error:nil];
+    MHVPendingBlobUpload *upload = [self uploadFromEntry:entry key:key];
+
+    if (!upload || -[upload.startDate timeIntervalSinceNow] > kPendingUploadLifetime)
+    {
+        [self removeUploadForKey:key];
+        return nil;
+    }
+
+    upload.generation = generation;
+
+    return upload;
+}
+
+- (void)setUpload:(MHVPendingBlobUpload *)upload
+{
+    MHVASSERT_PARAMETER(upload);
+
+    NSMutableDictionary *entry = [@{kUrlKey : upload.url.absoluteString,
+                                    kChunkSizeKey : @(upload.chunkSize),
+                                    kLengthKey : @(upload.length),
+                                    kCommittedLengthKey : @(upload.committedLength),
+                                    kChunkDigestsKey : upload.chunkDigests ?: [NSData data],
+                                    kNameKey : upload.name,
+                                    kContentTypeKey : upload.contentType,
+                                    kRecordIdKey : upload.recordId.UUIDString,
+                                    kStartDateKey : upload.startDate,
+                                    kShouldComputeHashKey : @(upload.shouldComputeHash),
+                                    kHashBlockSizeKey : @(upload.hashBlockSize)} mutableCopy];
+
+    if (upload.thingId)
+    {
+        entry[kThingIdKey] = upload.thingId;
+    }
+
+    NSString *key = upload.key;
+    NSUInteger generation = upload.generation;
+
+    dispatch_async(self.ioQueue, ^
+    {
+        // An upload that was in progress when every upload was removed isn't kept again.
+        // removeAllUploads changes the generation before it queues the removal, so this write can't come after it
+        if (generation != self.generation)
+        {
+            return;
+        }
+
+        NSData *data = [NSPropertyListSerialization dataWithPropertyList:entry format:NSPropertyListBinaryFormat_v1_0 options:0 error:nil];
+
+        if (![self.fileManager fileExistsAtPath:self.directoryURL.path])
+        {
+            [self.fileManager createDirectoryAtURL:self.directoryURL withIntermediateDirectories:YES attributes:nil error:nil];
+
+            NSURL *directoryURL = self.directoryURL;
+            [directoryURL setResourceValue:@YES forKey:NSURLIsExcludedFromBackupKey error:nil];
+        }
+
+        NSError *error = nil;
+        if (![data writeToURL:[self.directoryURL URLByAppendingPathComponent:key]
+                      options:NSDataWritingAtomic | NSDataWritingFileProtectionCompleteUntilFirstUserAuthentication
+                        error:&error])
+        {
+            MHVLOG(@"Could not write pending blob upload: %@", error.localizedDescription);
+        }
+    });
+}
+
+- (void)removeUploadForKey:(NSString *)key
+{
+    MHVASSERT_PARAMETER(key);
+
+    dispatch_async(self.ioQueue, ^
+    {
+        [self.fileManager removeItemAtURL:[self.directoryURL URLByAppendingPathComponent:key] error:nil];
+    });
+}
+
+- (void)removeAllUploads
+{
+    @synchronized (self)
+    {
+        self.removeAllCount += 1;
+    }
+
+    dispatch_async(self.ioQueue, ^
+    {
+        [self.fileManager removeItemAtURL:self.directoryURL error:nil];
+    });
+}
+
+#pragma mark - Internal methods
+
+- (MHVPendingBlobUpload *_Nullable)uploadFromEntry:(NSDictionary *)entry key:(NSString *)key
+{
+    if (![entry isKindOfClass:[NSDictionary class]] ||
+        ![entry[kUrlKey] isKindOfClass:[NSString class]] ||
+        ![entry[kNameKey] isKindOfClass:[NSString class]] ||
+        ![entry[kContentTypeKey] isKindOfClass:[NSString class]] ||
+        ![entry[kRecordIdKey] isKindOfClass:[NSString class]] ||
+        ![entry[kStartDateKey] isKindOfClass:[NSDate class]] ||
+        ![entry[kChunkDigestsKey] isKindOfClass:[NSData class]])
+    {
+        return nil;
+    }
+
+    MHVPendingBlobUpload *upload = [MHVPendingBlobUpload new];
+    upload.key = key;
+    upload.url = [NSURL URLWithString:entry[kUrlKey]];
+    upload.chunkSize = [entry[kChunkSizeKey] unsignedIntegerValue];
+    upload.length = [entry[kLengthKey] unsignedIntegerValue];
+    upload.committedLength = [entry[kCommittedLengthKey] unsignedIntegerValue];
+    upload.chunkDigests = entry[kChunkDigestsKey];
+    upload.name = entry[kNameKey];
+    upload.contentType = entry[kContentTypeKey];
+    upload.thingId = entry[kThingIdKey];
+    upload.recordId = [[NSUUID alloc] initWithUUIDString:entry[kRecordIdKey]];
+    upload.startDate = entry[kStartDateKey];
+    upload.shouldComputeHash = [entry[kShouldComputeHashKey] boolValue];
+    upload.hashBlockSize = [entry[kHashBlockSizeKey] unsignedIntegerValue];
+
+    if (!upload.url || !upload.recordId || upload.chunkSize == 0 || upload.committedLength > upload.length)
+    {
+        return nil;
+    }
+    
+    // Without a digest for every stored chunk, the stored part of the blob can't be checked
+    NSUInteger committedChunkCount = (upload.committedLength + upload.chunkSize - 1) / upload.chunkSize;
+    if (upload.chunkDigests.length != committedChunkCount * CC_SHA256_DIGEST_LENGTH)
+    {
+        return nil;
+    }
+
+    return upload;
+}
+
+@end
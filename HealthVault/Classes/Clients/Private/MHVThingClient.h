@@ -20,6 +20,7 @@
 
 #import <Foundation/Foundation.h>
 #import "MHVThingClientProtocol.h"
+@class MHVPendingBlobUploadStore;
 @protocol MHVConnectionProtocol, MHVThingCacheProtocol;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -31,6 +32,15 @@ NS_ASSUME_NONNULL_BEGIN
 - (instancetype)initWithConnection:(id<MHVConnectionProtocol>)connection
                              cache:(id<MHVThingCacheProtocol> _Nullable)cache;
 
+/**
+ Create a client that keeps the state of its blob uploads in a store shared with the connection
+
+ @param blobUploadStore The store the connection removes the uploads from when it is signed out
+ */
+- (instancetype)initWithConnection:(id<MHVConnectionProtocol>)connection
+                             cache:(id<MHVThingCacheProtocol> _Nullable)cache
+                   blobUploadStore:(MHVPendingBlobUploadStore *)blobUploadStore;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -23,7 +23,10 @@
 #import "MHVMethod.h"
 #import "MHVRestRequest.h"
 #import "MHVBlobDownloadRequest.h"
+#import "MHVBlobCache.h"
 #import "MHVBlobUploadRequest.h"
+#import "MHVPendingBlobUploadStore.h"
+#import "MHVBlobHasher.h"
 #import "MHVBlobPutParameters.h"
 #import "MHVServiceResponse.h"
 #import "MHVTypes.h"
@@ -32,6 +35,7 @@
 #import "MHVConnectionProtocol.h"
 #import "MHVPersonalImage.h"
 #import "MHVLogger.h"
+#import "MHVCryptographer.h"
 #import "MHVThingQueryResults.h"
 #import "MHVThingQueryResult.h"
 #import "MHVThingQueryResultInternal.h"
@@ -40,6 +44,7 @@
 #import "NSArray+MHVThing.h"
 #import "NSArray+MHVThingQuery.h"
 #import "NSArray+MHVThingQueryResultInternal.h"
+#import "MHVThingQueryBatch.h"
 #if THING_CACHE
 #import "MHVThingCacheProtocol.h"
 #endif
@@ -48,21 +53,47 @@
 
 @property (nonatomic, weak) id<MHVConnectionProtocol> connection;
 @property (nonatomic, strong) id<MHVThingCacheProtocol> cache;
+@property (nonatomic, strong) MHVPendingBlobUploadStore *blobUploadStore;
+
+// Batches waiting to be sent, by record id. Only used on batchQueue
+@property (nonatomic, strong) NSMutableDictionary<NSUUID *, MHVThingQueryBatch *> *queryBatches;
+@property (nonatomic, strong) dispatch_queue_t batchQueue;
 
 @end
 
+static NSUInteger const kDefaultQueryBatchLimit = 20;
+
 @implementation MHVThingClient
 
+@synthesize queryBatchInterval = _queryBatchInterval;
+@synthesize queryBatchLimit = _queryBatchLimit;
+@synthesize priority = _priority;
+
+- (instancetype)initWithConnection:(id<MHVConnectionProtocol>)connection
+                             cache:(id<MHVThingCacheProtocol> _Nullable)cache
+{
+    return [self initWithConnection:connection
+                              cache:cache
+                    blobUploadStore:[[MHVPendingBlobUploadStore alloc] initWithDirectoryURL:[MHVPendingBlobUploadStore defaultDirectoryURL]]];
+}
+
 - (instancetype)initWithConnection:(id<MHVConnectionProtocol>)connection
                              cache:(id<MHVThingCacheProtocol> _Nullable)cache
+                   blobUploadStore:(MHVPendingBlobUploadStore *)blobUploadStore
 {
     MHVASSERT_PARAMETER(connection);
+    MHVASSERT_PARAMETER(blobUploadStore);
     
     self = [super init];
     if (self)
     {
         _connection = connection;
         _cache = cache;
+        _queryBatchLimit = kDefaultQueryBatchLimit;
+        _priority = MHVRequestPriorityUserInitiated;
+        _queryBatches = [NSMutableDictionary new];
+        _batchQueue = dispatch_queue_create("MHVThingClient.batchQueue", DISPATCH_QUEUE_SERIAL);
+        _blobUploadStore = blobUploadStore;
     }
     
     return self;
@@ -205,7 +236,7 @@
                  }
                  
                  //No resultCollection or error, query HealthVault
-                 [self getThingsWithQueries:queriesForCloud recordId:recordId currentResults:nil completion:^(NSArray<MHVThingQueryResult *> * _Nullable results, NSError * _Nullable error)
+                 [self sendThingsQueries:queriesForCloud recordId:recordId completion:^(NSArray<MHVThingQueryResult *> * _Nullable results, NSError * _Nullable error)
                  {
                      if (error)
                      {
@@ -232,15 +263,79 @@
     }
     else
     {
-        [self getThingsWithQueries:queries recordId:recordId currentResults:nil completion:completion];
+        [self sendThingsQueries:queries recordId:recordId completion:completion];
     }
     
 #else
     // No caching
-    [self getThingsWithQueries:queries recordId:recordId currentResults:nil completion:completion];
+    [self sendThingsQueries:queries recordId:recordId completion:completion];
 #endif
 }
 
+// Internal method that sends queries to HealthVault, batching them with other calls if queryBatchInterval is set.
+- (void)sendThingsQueries:(NSArray<MHVThingQuery *> *)queries
+                 recordId:(NSUUID *)recordId
+               completion:(void(^)(NSArray<MHVThingQueryResult *> *_Nullable results, NSError *_Nullable error))completion
+{
+    NSTimeInterval interval = self.queryBatchInterval;
+    if (interval <= 0)
+    {
+        [self getThingsWithQueries:queries recordId:recordId currentResults:nil completion:completion];
+        return;
+    }
+    
+    NSUInteger limit = self.queryBatchLimit;
+    
+    dispatch_async(self.batchQueue, ^
+    {
+        MHVThingQueryBatch *batch = self.queryBatches[recordId];
+        
+        // Query names route results back to callers, so queries with a name already in the batch start a new one
+        if (batch && ![batch canAddQueries:queries limit:limit])
+        {
+            [self sendQueryBatch:batch];
+            batch = nil;
+        }
+        
+        if (!batch)
+        {
+            batch = [[MHVThingQueryBatch alloc] initWithRecordId:recordId];
+            self.queryBatches[recordId] = batch;
+            
+            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(interval * NSEC_PER_SEC)), self.batchQueue, ^
+            {
+                if (self.queryBatches[recordId] == batch)
+                {
+                    [self sendQueryBatch:batch];
+                }
+            });
+        }
+        
+        [batch addQueries:queries completion:completion];
+        
+        if (limit > 0 && batch.queries.count >= limit)
+        {
+            [self sendQueryBatch:batch];
+        }
+    });
+}
+
+// Must be called on batchQueue
+- (void)sendQueryBatch:(MHVThingQueryBatch *)batch
+{
+    [self.queryBatches removeObjectForKey:batch.recordId];
+    
+    MHVLOG(@"ThingClient: Sending %li batched queries", (long)batch.queries.count);
+    
+    [self getThingsWithQueries:batch.queries
+                      recordId:batch.recordId
+                currentResults:nil
+                    completion:^(NSArray<MHVThingQueryResult *> *_Nullable results, NSError *_Nullable error)
+     {
+         [batch completeWithResults:results error:error];
+     }];
+}
+
 // Internal method that will fetch more pending items if not all results are returned for the query.
 - (void)getThingsWithQueries:(NSArray<MHVThingQuery *> *)queries
                     recordId:(NSUUID *)recordId
@@ -251,8 +346,11 @@
     __block NSArray<MHVThingQueryResultInternal *> *results = currentResults;
     
     MHVMethod *method = [MHVMethod getThings];
+    method.priority = [self priorityForQueries:queries];
     method.recordId = recordId;
-    method.parameters = [self bodyForQueryCollection:queries];
+    NSString *parametersHash = nil;
+    method.parametersData = [self bodyForQueryCollection:queries hash:&parametersHash];
+    method.parametersHash = parametersHash;
     
     [self.connection executeHttpServiceOperation:method
                                       completion:^(MHVServiceResponse *_Nullable response, NSError *_Nullable error)
@@ -263,7 +361,7 @@
          }
          else
          {
-             MHVThingQueryResults *queryResults = [self thingQueryResultsFromResponse:response];
+             MHVThingQueryResults *queryResults = [self thingQueryResultsFromResponse:response queries:initialQueries];
              if (!queryResults)
              {
                  completion(nil, [NSError error:[NSError MHVUnknownError] withDescription:@"MHVThingQueryResults could not be extracted from the server response."]);
@@ -299,6 +397,8 @@
                      {
                          MHVThingQuery *query = [[MHVThingQuery alloc] initWithThingKeys:keys];
                          query.name = result.name;
+                         query.shouldDeferTypedData = queryForResult.shouldDeferTypedData;
+                         query.isInteractive = queryForResult.isInteractive;
                          [queriesForPendingThings addObject:query];
                      }
                  }
@@ -341,6 +441,105 @@
      }];
 }
 
+- (void)getThingsWithQuery:(MHVThingQuery *)query
+                  recordId:(NSUUID *)recordId
+              thingHandler:(void(^)(MHVThing *thing))thingHandler
+                completion:(void(^)(NSError *_Nullable error))completion
+{
+    MHVASSERT_PARAMETER(query);
+    MHVASSERT_PARAMETER(recordId);
+    MHVASSERT_PARAMETER(thingHandler);
+    MHVASSERT_PARAMETER(completion);
+    
+    if (!completion)
+    {
+        return;
+    }
+    
+    if (!query || !recordId || !thingHandler)
+    {
+        completion([NSError MVHRequiredParameterIsNil]);
+        return;
+    }
+    
+    if ([NSString isNilOrEmpty:query.name])
+    {
+        query.name = [[NSUUID UUID] UUIDString];
+    }
+    
+    [self streamThingsWithQuery:query recordId:recordId thingHandler:thingHandler completion:completion];
+}
+
+// Internal method that streams things to the handler, then fetches any pending things the same way.
+- (void)streamThingsWithQuery:(MHVThingQuery *)query
+                     recordId:(NSUUID *)recordId
+                 thingHandler:(void(^)(MHVThing *thing))thingHandler
+                   completion:(void(^)(NSError *_Nullable error))completion
+{
+    MHVThingQueryResults *queryResults = [[MHVThingQueryResults alloc] init];
+    queryResults.thingHandler = ^(MHVThing *thing, NSString *resultName)
+    {
+        thingHandler(thing);
+    };
+    
+    if (query.shouldDeferTypedData)
+    {
+        queryResults.deferredResultNames = [NSSet setWithObject:query.name];
+    }
+    
+    MHVMethod *method = [MHVMethod getThings];
+    method.priority = [self priorityForQueries:@[query]];
+    method.recordId = recordId;
+    NSString *parametersHash = nil;
+    method.parametersData = [self bodyForQueryCollection:@[query] hash:&parametersHash];
+    method.parametersHash = parametersHash;
+    method.streamingInfo = queryResults;
+    
+    [self.connection executeHttpServiceOperation:method
+                                      completion:^(MHVServiceResponse *_Nullable response, NSError *_Nullable error)
+     {
+         if (error)
+         {
+             completion(error);
+             return;
+         }
+         
+         MHVThingQueryResultInternal *result = queryResults.firstResult;
+         
+         NSInteger pendingCount = query.limit - result.streamedThingCount;
+         
+         if (result.hasPendingThings && pendingCount > 0)
+         {
+             NSMutableArray *keys = [NSMutableArray new];
+             
+             for (NSInteger i = query.offset; i < result.pendingThings.count; i++)
+             {
+                 [keys addObject:result.pendingThings[i].key];
+                 
+                 if (keys.count == pendingCount)
+                 {
+                     break;
+                 }
+             }
+             
+             if (keys.count > 0)
+             {
+                 MHVThingQuery *queryForPendingThings = [[MHVThingQuery alloc] initWithThingKeys:keys];
+                 queryForPendingThings.name = query.name;
+                 queryForPendingThings.shouldDeferTypedData = query.shouldDeferTypedData;
+                 
+                 [self streamThingsWithQuery:queryForPendingThings
+                                    recordId:recordId
+                                thingHandler:thingHandler
+                                  completion:completion];
+                 return;
+             }
+         }
+         
+         completion(nil);
+     }];
+}
+
 - (void)getThingsForThingClass:(Class)thingClass
                          query:(MHVThingQuery *_Nullable)query
                       recordId:(NSUUID *)recordId
@@ -442,8 +641,11 @@
     }
     
     MHVMethod *method = [MHVMethod putThings];
+    method.priority = self.priority;
     method.recordId = recordId;
-    method.parameters = [self bodyForThingCollection:things];
+    NSString *parametersHash = nil;
+    method.parametersData = [self bodyForThingCollection:things hash:&parametersHash];
+    method.parametersHash = parametersHash;
     
     [self.connection executeHttpServiceOperation:method
                                       completion:^(MHVServiceResponse *_Nullable response, NSError *_Nullable error)
@@ -575,8 +777,11 @@
     }
     
     MHVMethod *method = [MHVMethod putThings];
+    method.priority = self.priority;
     method.recordId = recordId;
-    method.parameters = [self bodyForThingCollection:things];
+    NSString *parametersHash = nil;
+    method.parametersData = [self bodyForThingCollection:things hash:&parametersHash];
+    method.parametersHash = parametersHash;
     
     [self.connection executeHttpServiceOperation:method
                                       completion:^(MHVServiceResponse *_Nullable response, NSError *_Nullable error)
@@ -685,8 +890,11 @@
     }
     
     MHVMethod *method = [MHVMethod removeThings];
+    method.priority = self.priority;
     method.recordId = recordId;
-    method.parameters = [self bodyForThingIdsFromThingCollection:things];
+    NSString *parametersHash = nil;
+    method.parametersData = [self bodyForThingIdsFromThingCollection:things hash:&parametersHash];
+    method.parametersHash = parametersHash;
     
     [self.connection executeHttpServiceOperation:method
                                       completion:^(MHVServiceResponse *_Nullable response, NSError *_Nullable error)
@@ -856,8 +1064,10 @@
     
     MHVBlobDownloadRequest *request = [[MHVBlobDownloadRequest alloc] initWithURL:[NSURL URLWithString:blobPayloadThing.blobUrl]
                                                                        toFilePath:nil];
+    request.blobCacheKey = [MHVBlobCache keyForBlobPayloadThing:blobPayloadThing];
+    request.blobLength = blobPayloadThing.length;
     
-    // Download from the URL
+    // Download from the URL, unless the blob is in the connection's blob cache
     [self.connection executeHttpServiceOperation:request
                                       completion:^(MHVServiceResponse *_Nullable response, NSError *_Nullable error)
      {
@@ -908,8 +1118,10 @@
     
     MHVBlobDownloadRequest *request = [[MHVBlobDownloadRequest alloc] initWithURL:[NSURL URLWithString:blobPayloadThing.blobUrl]
                                                                        toFilePath:filePath];
+    request.blobCacheKey = [MHVBlobCache keyForBlobPayloadThing:blobPayloadThing];
+    request.blobLength = blobPayloadThing.length;
     
-    // Download from the URL
+    // Download from the URL, unless the blob is in the connection's blob cache
     [self.connection executeHttpServiceOperation:request
                                       completion:^(MHVServiceResponse *_Nullable response, NSError *_Nullable error)
      {
@@ -1068,8 +1280,85 @@
         return;
     }
 
+    // A blob that can only be read once can't be read again to resume its upload, so its upload isn't kept
+    BOOL isSequential = [blobSource respondsToSelector:@selector(isSequential)] && blobSource.isSequential;
+    
+    NSString *key = isSequential ? nil : [MHVPendingBlobUploadStore keyForBlobSource:blobSource
+                                                                                name:name
+                                                                             thingId:toThing.key.thingID
+                                                                            recordId:recordId];
+    
+    // An upload of the same blob that stopped part way continues from what HealthVault already stored
+    MHVPendingBlobUpload *upload = key ? [self.blobUploadStore uploadForKey:key] : nil;
+    
+    if (upload && upload.length == blobSource.length)
+    {
+        MHVLOG(@"Resuming blob upload at %lu of %lu bytes", (unsigned long)upload.committedLength, (unsigned long)upload.length);
+        
+        upload.contentType = contentType;
+        
+        [self continueBlobUpload:upload blobSource:blobSource toThing:toThing isResumed:YES completion:completion];
+        return;
+    }
+    
+    [self beginBlobUploadWithKey:key
+                      blobSource:blobSource
+                         toThing:toThing
+                            name:name
+                     contentType:contentType
+                        recordId:recordId
+                      completion:completion];
+}
+
+- (void)getRecordOperations:(NSUInteger)sequenceNumber
+                   recordId:(NSUUID *)recordId
+                 completion:(void (^)(MHVGetRecordOperationsResult *_Nullable result, NSError *_Nullable error))completion
+{
+    MHVASSERT_PARAMETER(recordId);
+    MHVASSERT_PARAMETER(completion);
+    
+    if (!completion || !recordId)
+    {
+        completion(nil, [NSError MVHRequiredParameterIsNil]);
+        return;
+    }
+
+    MHVMethod *method = [MHVMethod getRecordOperations];
+    method.priority = self.priority;
+    method.recordId = recordId;
+    method.parameters = [NSString stringWithFormat:@"<info><record-operation-sequence-number>%li</record-operation-sequence-number></info>", (unsigned long)sequenceNumber];
+    
+    [self.connection executeHttpServiceOperation:method
+                                      completion:^(MHVServiceResponse * _Nullable response, NSError * _Nullable error)
+     {
+         if (error)
+         {
+             completion(nil, error);
+             return;
+         }
+         
+         MHVGetRecordOperationsResult *result = (MHVGetRecordOperationsResult *)[response infoAsClass:[MHVGetRecordOperationsResult class]];
+         
+         completion(result, nil);
+     }];
+}
+
+#pragma mark - Internal methods
+
+- (void)beginBlobUploadWithKey:(NSString *_Nullable)key
+                    blobSource:(id<MHVBlobSourceProtocol>)blobSource
+                       toThing:(MHVThing *)toThing
+                          name:(NSString *)name
+                   contentType:(NSString *)contentType
+                      recordId:(NSUUID *)recordId
+                    completion:(void(^)(MHVThing *_Nullable thing, NSError *_Nullable error))completion
+{
+    // An upload started before every upload is removed, e.g. on sign-out, isn't kept
+    NSUInteger generation = self.blobUploadStore.generation;
+    
     // 1. Get the location where to upload a new blob
     MHVMethod *putMethod = [MHVMethod beginPutBlob];
+    putMethod.priority = self.priority;
     putMethod.recordId = recordId;
     
     [self.connection executeHttpServiceOperation:putMethod
@@ -1094,87 +1383,182 @@
             completion(nil, [NSError error:[NSError MHVIOError] withDescription:@"Blob size is to large to save to HealthVault"]);
             return;
         }
+        
+        MHVPendingBlobUpload *upload = [MHVPendingBlobUpload new];
+        upload.key = key;
+        upload.url = [NSURL URLWithString:putParams.url];
+        upload.chunkSize = putParams.chunkSize;
+        upload.length = blobSource.length;
+        upload.committedLength = 0;
+        upload.chunkDigests = [NSData data];
+        upload.name = name;
+        upload.contentType = contentType;
+        upload.thingId = toThing.key.thingID;
+        upload.recordId = recordId;
+        upload.startDate = [NSDate date];
+        upload.generation = generation;
+        
+        // HealthVault checks a hash given with the blob, so one is only computed with the algorithm it asked for
+        upload.shouldComputeHash = putParams.hashAlgorithm.length == 0 || [putParams.hashAlgorithm isEqualToString:kMHVBlobHashAlgorithmSHA256Block];
+        upload.hashBlockSize = (NSUInteger)MAX(putParams.hashParams.blockSize, 0);
+        
+        if (key)
+        {
+            [self.blobUploadStore setUpload:upload];
+        }
+        
+        [self continueBlobUpload:upload blobSource:blobSource toThing:toThing isResumed:NO completion:completion];
+    }];
+}
 
-        // 2. Upload the blob to the URL retrieved
-        MHVBlobUploadRequest *uploadRequest = [[MHVBlobUploadRequest alloc] initWithBlobSource:blobSource
-                                                                                destinationURL:[NSURL URLWithString:putParams.url]
-                                                                                     chunkSize:putParams.chunkSize];
+- (void)continueBlobUpload:(MHVPendingBlobUpload *)upload
+                blobSource:(id<MHVBlobSourceProtocol>)blobSource
+                   toThing:(MHVThing *)toThing
+                 isResumed:(BOOL)isResumed
+                completion:(void(^)(MHVThing *_Nullable thing, NSError *_Nullable error))completion
+{
+    // An upload that can't be resumed, e.g. because its URL expired, starts again once from BeginPutBlob.
+    // A blob that can only be read once has already been read past the start, so its upload fails instead
+    BOOL isSequential = [blobSource respondsToSelector:@selector(isSequential)] && blobSource.isSequential;
+    
+    void (^failed)(NSError *) = ^(NSError *error)
+    {
+        if ([self isTransientBlobUploadError:error])
+        {
+            completion(nil, error);
+            return;
+        }
+        
+        if (upload.key)
+        {
+            [self.blobUploadStore removeUploadForKey:upload.key];
+        }
+        
+        if (!isResumed || isSequential)
+        {
+            completion(nil, error);
+            return;
+        }
+        
+        MHVLOG(@"Could not resume blob upload, starting again: %@", error.localizedDescription);
+        
+        [self beginBlobUploadWithKey:upload.key
+                          blobSource:blobSource
+                             toThing:toThing
+                                name:upload.name
+                         contentType:upload.contentType
+                            recordId:upload.recordId
+                          completion:completion];
+    };
+    
+    // 3. Commit and save the blob by attaching it to the Thing
+    void (^commit)(MHVBlobHashInfo *) = ^(MHVBlobHashInfo *hashInfo)
+    {
+        MHVBlobPayloadThing *blob = [[MHVBlobPayloadThing alloc] initWithBlobName:upload.name
+                                                                      contentType:upload.contentType
+                                                                           length:upload.length
+                                                                           andUrl:upload.url.absoluteString];
+        blob.blobInfo.hashInfo = hashInfo;
+        [toThing.blobs addOrUpdateBlob:blob];
         
-        [self.connection executeHttpServiceOperation:uploadRequest
-                                          completion:^(MHVServiceResponse * _Nullable response, NSError * _Nullable error)
+        [self updateThing:toThing
+                 recordId:upload.recordId
+               completion:^(MHVThingKey *_Nullable thingKey, NSError * _Nullable error)
          {
              if (error)
              {
-                 completion(nil, error);
+                 failed(error);
                  return;
              }
              
-             // 3. Commit and save the blob by attaching it to the Thing
-             MHVBlobPayloadThing *blob = [[MHVBlobPayloadThing alloc] initWithBlobName:name
-                                                                           contentType:contentType
-                                                                                length:blobSource.length
-                                                                                andUrl:putParams.url];
-             [toThing.blobs addOrUpdateBlob:blob];
+             if (thingKey)
+             {
+                 toThing.key = thingKey;
+             }
              
-             [self updateThing:toThing
-                      recordId:recordId
-                    completion:^(MHVThingKey *_Nullable thingKey, NSError * _Nullable error)
+             if (upload.key)
              {
-                 if (!error && thingKey)
-                 {
-                     toThing.key = thingKey;
-                 }
-                 
-                 completion(error == nil ? toThing : nil, error);
-             }];
+                 [self.blobUploadStore removeUploadForKey:upload.key];
+             }
+             
+             completion(toThing, nil);
          }];
-    }];
-}
-
-- (void)getRecordOperations:(NSUInteger)sequenceNumber
-                   recordId:(NSUUID *)recordId
-                 completion:(void (^)(MHVGetRecordOperationsResult *_Nullable result, NSError *_Nullable error))completion
-{
-    MHVASSERT_PARAMETER(recordId);
-    MHVASSERT_PARAMETER(completion);
-    
-    if (!completion || !recordId)
+    };
+    
+    // 2. Upload the blob to the URL retrieved, from the last chunk stored. The stored part is checked against the
+    // blob first, so a blob that changed isn't attached, even when all of it was stored before
+    MHVBlobUploadRequest *uploadRequest = [[MHVBlobUploadRequest alloc] initWithBlobSource:blobSource
+                                                                            destinationURL:upload.url
+                                                                                 chunkSize:upload.chunkSize];
+    uploadRequest.startOffset = upload.committedLength;
+    uploadRequest.storedChunkDigests = upload.chunkDigests;
+    uploadRequest.shouldComputeHash = upload.shouldComputeHash;
+    uploadRequest.hashBlockSize = upload.hashBlockSize;
+    uploadRequest.committedLengthHandler = ^(NSUInteger committedLength, NSData *chunkDigests)
     {
-        completion(nil, [NSError MVHRequiredParameterIsNil]);
-        return;
-    }
-
-    MHVMethod *method = [MHVMethod getRecordOperations];
-    method.recordId = recordId;
-    method.parameters = [NSString stringWithFormat:@"<info><record-operation-sequence-number>%li</record-operation-sequence-number></info>", (unsigned long)sequenceNumber];
+        upload.committedLength = committedLength;
+        upload.chunkDigests = chunkDigests;
+        
+        if (upload.key)
+        {
+            [self.blobUploadStore setUpload:upload];
+        }
+    };
     
-    [self.connection executeHttpServiceOperation:method
+    [self.connection executeHttpServiceOperation:uploadRequest
                                       completion:^(MHVServiceResponse * _Nullable response, NSError * _Nullable error)
      {
          if (error)
          {
-             completion(nil, error);
+             failed(error);
              return;
          }
          
-         XReader *reader = [[XReader alloc] initFromString:response.infoXml];
-         
-         MHVGetRecordOperationsResult *result = (MHVGetRecordOperationsResult *)[NSObject newFromReader:reader
-                                                                                               withRoot:@"info"
-                                                                                                asClass:[MHVGetRecordOperationsResult class]];
-         completion(result, nil);
+         commit(uploadRequest.hashInfo);
      }];
 }
 
-#pragma mark - Internal methods
+// Errors from the network or blob storage keep an upload's progress so it can be resumed later
+// A query the user is waiting on is sent ahead of the client's other methods, even when batched with other queries
+- (MHVRequestPriority)priorityForQueries:(NSArray<MHVThingQuery *> *)queries
+{
+    for (MHVThingQuery *query in queries)
+    {
+        if (query.isInteractive)
+        {
+            return MHVRequestPriorityInteractive;
+        }
+    }
+    
+    return self.priority;
+}
 
-- (MHVThingQueryResults *)thingQueryResultsFromResponse:(MHVServiceResponse *)response
+- (BOOL)isTransientBlobUploadError:(NSError *)error
 {
-    XReader *reader = [[XReader alloc] initFromString:response.infoXml];
+    return [error.domain isEqualToString:NSURLErrorDomain] ||
+           ([error.domain isEqualToString:kMHVErrorDomain] && error.code == MHVErrorTypeNetworkError);
+}
+
+- (MHVThingQueryResults *)thingQueryResultsFromResponse:(MHVServiceResponse *)response queries:(NSArray<MHVThingQuery *> *)queries
+{
+    MHVThingQueryResults *queryResults = [[MHVThingQueryResults alloc] init];
+    
+    NSMutableSet<NSString *> *deferredResultNames = [NSMutableSet new];
+    for (MHVThingQuery *query in queries)
+    {
+        if (query.shouldDeferTypedData && query.name)
+        {
+            [deferredResultNames addObject:query.name];
+        }
+    }
+    queryResults.deferredResultNames = deferredResultNames;
     
-    return (MHVThingQueryResults *)[NSObject newFromReader:reader
-                                                  withRoot:@"info"
-                                                   asClass:[MHVThingQueryResults class]];
+    if (![response readInfoIntoObject:queryResults])
+    {
+        return nil;
+    }
+    
+    return queryResults;
 }
 
 - (NSArray<MHVThingKey *> *)thingKeyResultsFromResponse:(MHVServiceResponse *)response
@@ -1188,15 +1572,13 @@
 
 - (MHVBlobPutParameters *)blobPutParametersResultsFromResponse:(MHVServiceResponse *)response
 {
-    XReader *reader = [[XReader alloc] initFromString:response.infoXml];
-    return (MHVBlobPutParameters *)[NSObject newFromReader:reader
-                                                  withRoot:@"info"
-                                                   asClass:[MHVBlobPutParameters class]];
+    return (MHVBlobPutParameters *)[response infoAsClass:[MHVBlobPutParameters class]];
 }
 
-- (NSString *)bodyForQueryCollection:(NSArray<MHVThingQuery *> *)queries
+- (NSData *)bodyForQueryCollection:(NSArray<MHVThingQuery *> *)queries hash:(NSString **)hash
 {
-    XWriter *writer = [[XWriter alloc] initWithBufferSize:2048];
+    MHVSha256Hash *bodyHash = [MHVSha256Hash new];
+    XWriter *writer = [self newParametersWriterWithCapacity:2048 hash:bodyHash];
     
     [writer writeStartElement:@"info"];
     
@@ -1210,12 +1592,21 @@
     
     [writer writeEndElement];
     
-    return [writer newXmlString];
+    [writer flush];
+    
+    if (hash)
+    {
+        *hash = [bodyHash base64Digest];
+    }
+    
+    return writer.data;
 }
 
-- (NSString *)bodyForThingCollection:(NSArray<MHVThing *> *)things
+- (NSData *)bodyForThingCollection:(NSArray<MHVThing *> *)things hash:(NSString **)hash
 {
-    XWriter *writer = [[XWriter alloc] initWithBufferSize:2048];
+    // Most things serialize to well under 1KB, so this usually avoids growing the buffer
+    MHVSha256Hash *bodyHash = [MHVSha256Hash new];
+    XWriter *writer = [self newParametersWriterWithCapacity:MAX(things.count, 2) * 1024 hash:bodyHash];
     
     [writer writeStartElement:@"info"];
     {
@@ -1229,12 +1620,20 @@
     }
     [writer writeEndElement];
     
-    return [writer newXmlString];
+    [writer flush];
+    
+    if (hash)
+    {
+        *hash = [bodyHash base64Digest];
+    }
+    
+    return writer.data;
 }
 
-- (NSString *)bodyForThingIdsFromThingCollection:(NSArray<MHVThing *> *)things
+- (NSData *)bodyForThingIdsFromThingCollection:(NSArray<MHVThing *> *)things hash:(NSString **)hash
 {
-    XWriter *writer = [[XWriter alloc] initWithBufferSize:2048];
+    MHVSha256Hash *bodyHash = [MHVSha256Hash new];
+    XWriter *writer = [self newParametersWriterWithCapacity:2048 hash:bodyHash];
     
     [writer writeStartElement:@"info"];
     {
@@ -1248,7 +1647,29 @@
     }
     [writer writeEndElement];
     
-    return [writer newXmlString];
+    [writer flush];
+    
+    if (hash)
+    {
+        *hash = [bodyHash base64Digest];
+    }
+    
+    return writer.data;
+}
+
+//
+// Parameters are hashed as they are written, so large bodies aren't read again to sign the request
+//
+- (XWriter *)newParametersWriterWithCapacity:(NSUInteger)capacity hash:(MHVSha256Hash *)hash
+{
+    XWriter *writer = [[XWriter alloc] initWithData:[[NSMutableData alloc] initWithCapacity:capacity]];
+    
+    writer.dataObserver = ^(const void *bytes, NSUInteger length)
+    {
+        [hash updateWithBytes:bytes length:length];
+    };
+    
+    return writer;
 }
 
 - (BOOL)isValidObject:(id)obj
@@ -0,0 +1,55 @@
+//
+//  MHVThingQueryBatch.h
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+@class MHVThingQuery, MHVThingQueryResult;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Queries from several GetThings calls for one record, sent together as one multi-group request.
+ Each caller gets back the results for its own queries, matched by query name.
+ */
+@interface MHVThingQueryBatch : NSObject
+
+@property (nonatomic, strong, readonly) NSUUID *recordId;
+@property (nonatomic, strong, readonly) NSArray<MHVThingQuery *> *queries;
+
+- (instancetype)initWithRecordId:(NSUUID *)recordId;
+
+/**
+ Whether the queries can join this batch. A batch takes any queries while it is empty, otherwise
+ only if it stays within the limit and no query name is already used in the batch.
+
+ @param queries The queries to add, which must all have names
+ @param limit The most queries in one batch, or 0 for no limit
+ */
+- (BOOL)canAddQueries:(NSArray<MHVThingQuery *> *)queries limit:(NSUInteger)limit;
+
+- (void)addQueries:(NSArray<MHVThingQuery *> *)queries
+        completion:(void (^)(NSArray<MHVThingQueryResult *> *_Nullable results, NSError *_Nullable error))completion;
+
+/**
+ Calls each caller's completion with the results for its queries, in the order it gave them, or with the error.
+ */
+- (void)completeWithResults:(NSArray<MHVThingQueryResult *> *_Nullable)results error:(NSError *_Nullable)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
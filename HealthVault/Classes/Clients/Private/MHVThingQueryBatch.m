@@ -0,0 +1,130 @@
+//
+//  MHVThingQueryBatch.m
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "MHVThingQueryBatch.h"
+#import "MHVThingQuery.h"
+#import "MHVThingQueryResult.h"
+#import "MHVValidator.h"
+
+typedef void (^MHVThingQueryBatchCompletion)(NSArray<MHVThingQueryResult *> *_Nullable results, NSError *_Nullable error);
+
+@interface MHVThingQueryBatch ()
+
+@property (nonatomic, strong) NSMutableArray<MHVThingQuery *> *batchQueries;
+@property (nonatomic, strong) NSMutableSet<NSString *> *names;
+@property (nonatomic, strong) NSMutableArray<NSArray<MHVThingQuery *> *> *callerQueries;
+@property (nonatomic, strong) NSMutableArray<MHVThingQueryBatchCompletion> *completions;
+
+@end
+
+@implementation MHVThingQueryBatch
+
+- (instancetype)initWithRecordId:(NSUUID *)recordId
+{
+    MHVASSERT_PARAMETER(recordId);
+    
+    self = [super init];
+    
+    if (self)
+    {
+        _recordId = recordId;
+        _batchQueries = [NSMutableArray new];
+        _names = [NSMutableSet new];
+        _callerQueries = [NSMutableArray new];
+        _completions = [NSMutableArray new];
+    }
+    
+    return self;
+}
+
+- (NSArray<MHVThingQuery *> *)queries
+{
+    return [self.batchQueries copy];
+}
+
+- (BOOL)canAddQueries:(NSArray<MHVThingQuery *> *)queries limit:(NSUInteger)limit
+{
+    if (self.batchQueries.count == 0)
+    {
+        return YES;
+    }
+    
+    if (limit > 0 && self.batchQueries.count + queries.count > limit)
+    {
+        return NO;
+    }
+    
+    for (MHVThingQuery *query in queries)
+    {
+        if ([self.names containsObject:query.name])
+        {
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
+- (void)addQueries:(NSArray<MHVThingQuery *> *)queries
+        completion:(void (^)(NSArray<MHVThingQueryResult *> *_Nullable results, NSError *_Nullable error))completion
+{
+    MHVASSERT_PARAMETER(queries);
+    MHVASSERT_PARAMETER(completion);
+    
+    [self.batchQueries addObjectsFromArray:queries];
+    
+    for (MHVThingQuery *query in queries)
+    {
+        [self.names addObject:query.name];
+    }
+    
+    [self.callerQueries addObject:queries];
+    [self.completions addObject:completion];
+}
+
+- (void)completeWithResults:(NSArray<MHVThingQueryResult *> *_Nullable)results error:(NSError *_Nullable)error
+{
+    NSMutableDictionary<NSString *, MHVThingQueryResult *> *resultsByName = [NSMutableDictionary new];
+    for (MHVThingQueryResult *result in results)
+    {
+        resultsByName[result.name] = result;
+    }
+    
+    for (NSUInteger i = 0; i < self.completions.count; i++)
+    {
+        if (error)
+        {
+            self.completions[i](nil, error);
+            continue;
+        }
+        
+        NSMutableArray<MHVThingQueryResult *> *callerResults = [NSMutableArray new];
+        for (MHVThingQuery *query in self.callerQueries[i])
+        {
+            MHVThingQueryResult *result = resultsByName[query.name];
+            if (result)
+            {
+                [callerResults addObject:result];
+            }
+        }
+        
+        self.completions[i](callerResults, nil);
+    }
+}
+
+@end
@@ -17,6 +17,7 @@
 // limitations under the License.
 
 #import <Foundation/Foundation.h>
+#import "MHVRetryPolicy.h"
 @class MHVThingCacheConfiguration;
 
 @interface MHVConfiguration : NSObject
@@ -67,24 +68,87 @@
  */
 @property (nonatomic, assign) NSTimeInterval requestTimeToLiveDuration;
 
+/**
+ Gets or sets the compression used for large request bodies, @"gzip" or @"deflate".
+ 
+ @note Request bodies larger than requestCompressionThreshold are compressed and sent with a Content-Encoding header, which mostly applies to PutThings. Responses are always requested with gzip or deflate encoding. The value defaults to nil, which sends request bodies uncompressed.
+ */
+@property (nonatomic, strong) NSString *requestCompressionMethod;
+
+/**
+ Gets or sets the size in bytes a request body must be larger than to be compressed.
+ 
+ @note Only used when requestCompressionMethod is set. The value defaults to 16KB.
+ */
+@property (nonatomic, assign) NSUInteger requestCompressionThreshold;
+
+/**
+ Gets or sets how requests that fail with a transient error are retried.
+ 
+ @note Retries use exponential backoff with jitter and the server's Retry-After header, limited by a retry budget. See MHVRetryPolicy.
+ */
+@property (nonatomic, strong) MHVRetryPolicy *retryPolicy;
+
 /**
  Gets the number of retries the SDK will make when getting an internal error response (error 500) from HealthVault.
  
- @note This property corresponds to the "HV_RequestRetryOnInternal500Count" configuration value when reading from web.config. The value defaults to 2.
+ @note This property corresponds to the "HV_RequestRetryOnInternal500Count" configuration value when reading from web.config. The value defaults to 2. It is the same as retryPolicy.maxRetryCount.
  */
 @property (nonatomic, assign) NSInteger retryOnInternal500Count;
 
 /**
  Gets the sleep duration between retries due to HealthVault returning an internal error (error 500).
  
- @note This property corresponds to the "HV_RequestRetryOnInternal500SleepSeconds" configuration value when reading from web.config. The value defaults to 1 second.
+ @note This property corresponds to the "HV_RequestRetryOnInternal500SleepSeconds" configuration value when reading from web.config. The value defaults to 1 second. It is the same as retryPolicy.baseDelay, so later retries wait longer.
  */
 @property (nonatomic, assign) NSTimeInterval retryOnInternal500SleepDuration;
 
+/**
+ Gets or sets how old a session credential can get before it is refreshed ahead of the next request.
+ 
+ @note Refreshing ahead of time saves the round trip of a request that fails because the credential expired. Requests that need the credential wait while it is refreshed. Set to 0 to only refresh when HealthVault returns an unauthorized error. The value defaults to 20 minutes.
+ */
+@property (nonatomic, assign) NSTimeInterval sessionCredentialRefreshInterval;
+
+/**
+ Gets or sets how long responses to read-only methods are kept and returned without asking HealthVault again, by method name.
+ 
+ @note Responses are kept in memory and on disk with NSFileProtectionComplete, and are removed when the person signs out. GetThings responses for a record are removed when PutThings or RemoveThings changes the record. Methods that aren't listed aren't kept. The value defaults to 1 day for GetVocabulary, SearchVocabulary and GetThingType.
+ */
+@property (nonatomic, strong) NSDictionary<NSString *, NSNumber *> *methodResponseTimeToLiveDurations;
+
+/**
+ Gets or sets how long after its time to live a kept method response can still be returned.
+ 
+ @note A response in this period is returned straight away, and fetched again in the background for the next time. Set to 0 to always wait for a new response once the time to live is over. The value defaults to 7 days.
+ */
+@property (nonatomic, assign) NSTimeInterval methodResponseStaleDuration;
+
+/**
+ Gets or sets the size in bytes downloaded blobs can use on disk.
+ 
+ @note Blobs such as personal images and attachments are kept by their hash, or by their URL and length when HealthVault doesn't return a hash, and are returned without downloading them again. The least recently used blobs are removed when the cache is larger than this size, and every blob is removed when the person signs out. Cached blobs are written with NSFileProtectionComplete, so they can't be read while the device is locked. Set to 0 to always download blobs. The value defaults to 0, so blobs are only kept when the app sets a size, e.g. 50MB.
+ */
+@property (nonatomic, assign) NSUInteger blobCacheSizeLimit;
+
+/**
+ Gets or sets whether responses to REST GET requests are kept and revalidated with their ETag.
+ 
+ @note Responses are kept in memory and on disk with NSFileProtectionComplete, so they can't be read while the device is locked, and are removed when the person signs out or a request changes them. The value defaults to NO, so REST responses are only kept when the app opts in.
+ */
+@property (nonatomic, assign) BOOL isRestResponseCacheEnabled;
+
+/**
+ Gets or sets the number of chunks of a blob upload that are sent at the same time.
+ 
+ @note The next chunk is read from the blob source while earlier chunks are sent. The chunk that completes the blob is only sent once every other chunk has been stored. Set to 1 to send one chunk at a time. The value defaults to 4.
+ */
+@property (nonatomic, assign) NSUInteger blobUploadConcurrentChunkCount;
+
 /**
  Gets the size in bytes of the block used to hash inlined BLOB data.
  
- @note This property corresponds to the "HV_DefaultInlineBlobHashBlockSize" configuration value when reading from web.config. The value defaults to 2MB.
+ @note This property corresponds to the "HV_DefaultInlineBlobHashBlockSize" configuration value when reading from web.config. The value defaults to 2MB. A blob's hash is computed as the blob is uploaded, with the block size HealthVault gives when the upload begins, or this block size if it doesn't give one.
  */
 @property (nonatomic, assign) NSInteger inlineBlobHashBlockSize;
 
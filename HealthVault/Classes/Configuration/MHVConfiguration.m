@@ -34,8 +34,15 @@
         self.restVersion = kDefaultRestVersion;
         self.requestTimeoutDuration = kDefaultRequestTimeoutDurationInSeconds;
         self.requestTimeToLiveDuration = kDefaultRequestTimeToLiveDurationInSeconds;
-        self.retryOnInternal500Count = kDefaultRetryOnInternal500Count;
-        self.retryOnInternal500SleepDuration = kDefaultRetryOnInternal500SleepDurationInSeconds;
+        self.retryPolicy = [MHVRetryPolicy new];
+        self.requestCompressionThreshold = kDefaultRequestCompressionThresholdInBytes;
+        self.sessionCredentialRefreshInterval = kDefaultSessionCredentialRefreshIntervalInSeconds;
+        self.methodResponseTimeToLiveDurations = @{@"GetVocabulary" : @(kDefaultMethodResponseTimeToLiveInSeconds),
+                                                   @"SearchVocabulary" : @(kDefaultMethodResponseTimeToLiveInSeconds),
+                                                   @"GetThingType" : @(kDefaultMethodResponseTimeToLiveInSeconds)};
+        self.methodResponseStaleDuration = kDefaultMethodResponseStaleDurationInSeconds;
+        self.blobCacheSizeLimit = kDefaultBlobCacheSizeLimitInBytes;
+        self.blobUploadConcurrentChunkCount = kDefaultBlobUploadConcurrentChunkCount;
         self.inlineBlobHashBlockSize = kDefaultBlobChunkSizeInBytes;
     }
     
@@ -57,6 +64,26 @@
     _restHealthVaultUrl = [self ensureTrailingSlashOnUrl:restHealthVaultUrl];
 }
 
+- (NSInteger)retryOnInternal500Count
+{
+    return self.retryPolicy.maxRetryCount;
+}
+
+- (void)setRetryOnInternal500Count:(NSInteger)retryOnInternal500Count
+{
+    self.retryPolicy.maxRetryCount = retryOnInternal500Count;
+}
+
+- (NSTimeInterval)retryOnInternal500SleepDuration
+{
+    return self.retryPolicy.baseDelay;
+}
+
+- (void)setRetryOnInternal500SleepDuration:(NSTimeInterval)retryOnInternal500SleepDuration
+{
+    self.retryPolicy.baseDelay = retryOnInternal500SleepDuration;
+}
+
 #pragma mark - Helpers
 
 - (NSURL *)ensureTrailingSlashOnUrl:(NSURL *)url
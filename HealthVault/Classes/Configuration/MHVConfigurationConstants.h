@@ -49,6 +49,21 @@ static NSString *const kDefaultHealthVaultRootUrlString = @"https://platform.hea
  */
 static NSTimeInterval const kDefaultRetryOnInternal500SleepDurationInSeconds = 1;
 
+/*
+ The default longest delay before retrying a request.
+ */
+static NSTimeInterval const kDefaultMaxRetryDelayInSeconds = 30;
+
+/*
+ The default number of retries that can be made in a burst.
+ */
+static double const kDefaultRetryBudgetCapacity = 10;
+
+/*
+ The default fraction of requests that can be retried once the burst is used.
+ */
+static double const kDefaultRetryBudgetRatio = 0.2;
+
 /*
  The default request time to live value.
  */
@@ -59,9 +74,39 @@ static NSTimeInterval const kDefaultRequestTimeToLiveDurationInSeconds = 60 * 30
  */
 static NSTimeInterval const kDefaultRequestTimeoutDurationInSeconds = 30;
 
+/*
+ The default age of a session credential before it is refreshed ahead of the next request.
+ */
+static NSTimeInterval const kDefaultSessionCredentialRefreshIntervalInSeconds = 60 * 20;
+
+/*
+ The default time to live of responses to reference data methods, like GetVocabulary.
+ */
+static NSTimeInterval const kDefaultMethodResponseTimeToLiveInSeconds = 60 * 60 * 24;
+
+/*
+ The default time a method response can be returned after its time to live, while it is fetched again.
+ */
+static NSTimeInterval const kDefaultMethodResponseStaleDurationInSeconds = 60 * 60 * 24 * 7;
+
+/*
+ The default size of a request body before it is compressed.
+ */
+static NSUInteger const kDefaultRequestCompressionThresholdInBytes = 16 * 1024;
+
+/*
+ The default size downloaded blobs can use on disk. Blobs are health data, so they are only kept when an app opts in.
+ */
+static NSUInteger const kDefaultBlobCacheSizeLimitInBytes = 0;
+
 /*
  The default blob upload chunk size.
  */
 static NSInteger const kDefaultBlobChunkSizeInBytes = 1 << 21; // 2Mb.
 
+/*
+ The default number of blob upload chunks sent at the same time.
+ */
+static NSUInteger const kDefaultBlobUploadConcurrentChunkCount = 4;
+
 #endif /* MHVConfigurationConstants_h */
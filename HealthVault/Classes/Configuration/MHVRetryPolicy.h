@@ -0,0 +1,103 @@
+//
+//  MHVRetryPolicy.h
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Returned by retryDelayForAttempt:statusCode:headers:error: when a request should not be retried.
+ */
+static NSTimeInterval const MHVRetryPolicyNoRetry = -1;
+
+/**
+ Decides whether, and when, a request that failed with a transient error is sent again.
+
+ Retries wait for a random time between 0 and an exponentially growing limit (full jitter), so devices that
+ failed at the same time don't all retry at the same time. A server's Retry-After header is used instead when
+ there is one. Retries are also limited by a budget shared by every connection using the policy, so a service
+ that keeps failing doesn't get a retry for every request.
+ */
+@interface MHVRetryPolicy : NSObject
+
+/**
+ Gets or sets the most times a request is retried. The value defaults to 2.
+ */
+@property (nonatomic, assign) NSInteger maxRetryCount;
+
+/**
+ Gets or sets the limit on the delay before the first retry. The limit doubles for each later retry. The value defaults to 1 second.
+ */
+@property (nonatomic, assign) NSTimeInterval baseDelay;
+
+/**
+ Gets or sets the longest delay before a retry. A request whose Retry-After is longer than this is not retried. The value defaults to 30 seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval maxDelay;
+
+/**
+ Gets or sets the HTTP status codes that are retried. The value defaults to 500 and 503.
+ */
+@property (nonatomic, strong) NSSet<NSNumber *> *retryableStatusCodes;
+
+/**
+ Gets or sets the HTTP status codes that are only retried for read-only requests. A gateway that times out or
+ fails doesn't say whether the service handled the request, so the connection doesn't send writes again.
+ The value defaults to 502 and 504.
+ */
+@property (nonatomic, strong) NSSet<NSNumber *> *readOnlyRetryableStatusCodes;
+
+/**
+ Gets or sets whether requests that time out or lose their connection are retried. The connection only retries
+ these for read-only requests, since the service may have already handled the request. The value defaults to YES.
+ */
+@property (nonatomic, assign) BOOL retriesNetworkErrors;
+
+/**
+ Gets or sets the most retries that can be made in a burst. The value defaults to 10.
+ */
+@property (nonatomic, assign) double retryBudgetCapacity;
+
+/**
+ Gets or sets how much each request adds to the retry budget, up to retryBudgetCapacity. Once a burst has
+ used the budget, retries are limited to this fraction of requests. The value defaults to 0.2.
+ */
+@property (nonatomic, assign) double retryBudgetRatio;
+
+/**
+ Adds a request to the retry budget. Called by the connection for each new request.
+ */
+- (void)didSendRequest;
+
+/**
+ How long to wait before retrying a request. Takes a retry from the budget if the request should be retried.
+
+ @param retryAttempt How many times the request has already been retried
+ @param statusCode The HTTP status code, or 0 if there was no response
+ @param headers The HTTP response headers, if there was a response
+ @param error The error the request failed with, if any
+ @return The delay in seconds, or MHVRetryPolicyNoRetry
+ */
+- (NSTimeInterval)retryDelayForAttempt:(NSInteger)retryAttempt
+                            statusCode:(NSInteger)statusCode
+                               headers:(NSDictionary<NSString *, NSString *> *_Nullable)headers
+                                 error:(NSError *_Nullable)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,177 @@
+//
+//  MHVRetryPolicy.m
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "MHVRetryPolicy.h"
+#import "MHVConfigurationConstants.h"
+
+static NSString *const kRetryAfterHeader = @"Retry-After";
+
+@interface MHVRetryPolicy ()
+
+@property (nonatomic, assign) double retryBudget;
+
+@end
+
+@implementation MHVRetryPolicy
+
+- (instancetype)init
+{
+    self = [super init];
+
+    if (self)
+    {
+        _maxRetryCount = kDefaultRetryOnInternal500Count;
+        _baseDelay = kDefaultRetryOnInternal500SleepDurationInSeconds;
+        _maxDelay = kDefaultMaxRetryDelayInSeconds;
+        _retryableStatusCodes = [NSSet setWithArray:@[@(500), @(503)]];
+        _readOnlyRetryableStatusCodes = [NSSet setWithArray:@[@(502), @(504)]];
+        _retriesNetworkErrors = YES;
+        _retryBudgetCapacity = kDefaultRetryBudgetCapacity;
+        _retryBudgetRatio = kDefaultRetryBudgetRatio;
+        _retryBudget = kDefaultRetryBudgetCapacity;
+    }
+
+    return self;
+}
+
+- (void)setRetryBudgetCapacity:(double)retryBudgetCapacity
+{
+    @synchronized (self)
+    {
+        _retryBudgetCapacity = retryBudgetCapacity;
+        _retryBudget = retryBudgetCapacity;
+    }
+}
+
+- (void)didSendRequest
+{
+    @synchronized (self)
+    {
+        self.retryBudget = MIN(self.retryBudget + self.retryBudgetRatio, self.retryBudgetCapacity);
+    }
+}
+
+- (NSTimeInterval)retryDelayForAttempt:(NSInteger)retryAttempt
+                            statusCode:(NSInteger)statusCode
+                               headers:(NSDictionary<NSString *, NSString *> *_Nullable)headers
+                                 error:(NSError *_Nullable)error
+{
+    if (retryAttempt >= self.maxRetryCount)
+    {
+        return MHVRetryPolicyNoRetry;
+    }
+
+    if (![self.retryableStatusCodes containsObject:@(statusCode)] &&
+        ![self.readOnlyRetryableStatusCodes containsObject:@(statusCode)] &&
+        !(self.retriesNetworkErrors && [self isTransientNetworkError:error]))
+    {
+        return MHVRetryPolicyNoRetry;
+    }
+
+    NSTimeInterval delay;
+
+    NSDate *retryAfterDate = [self retryAfterDateFromHeaders:headers];
+    if (retryAfterDate)
+    {
+        // The server knows better than the backoff when it will be ready
+        delay = MAX([retryAfterDate timeIntervalSinceNow], 0);
+
+        if (delay > self.maxDelay)
+        {
+            return MHVRetryPolicyNoRetry;
+        }
+    }
+    else
+    {
+        NSTimeInterval limit = MIN(self.maxDelay, self.baseDelay * pow(2, retryAttempt));
+
+        delay = limit * ((double)arc4random_uniform(UINT32_MAX) / UINT32_MAX);
+    }
+
+    @synchronized (self)
+    {
+        if (self.retryBudget < 1)
+        {
+            return MHVRetryPolicyNoRetry;
+        }
+
+        self.retryBudget -= 1;
+    }
+
+    return delay;
+}
+
+#pragma mark - Internal methods
+
+- (BOOL)isTransientNetworkError:(NSError *)error
+{
+    if (![error.domain isEqualToString:NSURLErrorDomain])
+    {
+        return NO;
+    }
+
+    return (error.code == NSURLErrorTimedOut ||
+            error.code == NSURLErrorNetworkConnectionLost ||
+            error.code == NSURLErrorCannotConnectToHost);
+}
+
+- (NSDate *_Nullable)retryAfterDateFromHeaders:(NSDictionary<NSString *, NSString *> *_Nullable)headers
+{
+    NSString *retryAfter = nil;
+
+    for (NSString *key in headers)
+    {
+        if ([key caseInsensitiveCompare:kRetryAfterHeader] == NSOrderedSame)
+        {
+            retryAfter = [headers[key] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+            break;
+        }
+    }
+
+    if (retryAfter.length == 0)
+    {
+        return nil;
+    }
+
+    // Retry-After is either a number of seconds or an HTTP date
+    NSScanner *scanner = [NSScanner scannerWithString:retryAfter];
+    NSInteger seconds = 0;
+    if ([scanner scanInteger:&seconds] && scanner.isAtEnd)
+    {
+        return [NSDate dateWithTimeIntervalSinceNow:MAX(seconds, 0)];
+    }
+
+    return [[self httpDateFormatter] dateFromString:retryAfter];
+}
+
+- (NSDateFormatter *)httpDateFormatter
+{
+    static NSDateFormatter *formatter = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^
+    {
+        formatter = [NSDateFormatter new];
+        formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+        formatter.timeZone = [NSTimeZone timeZoneWithAbbreviation:@"GMT"];
+        formatter.dateFormat = @"EEE',' dd MMM yyyy HH':'mm':'ss 'GMT'";
+    });
+
+    return formatter;
+}
+
+@end
@@ -56,6 +56,23 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic, assign, readonly) BOOL isAuthenticated;
 
+/**
+ The number of method calls that were not sent, because an identical read-only call was already
+ in progress. Those calls got the response of the call in progress.
+ */
+@property (nonatomic, assign, readonly) NSUInteger collapsedMethodCount;
+
+/**
+ The fraction of blob downloads, from 0 to 1, that were read from the blob cache instead of HealthVault.
+ See MHVConfiguration blobCacheSizeLimit.
+ */
+@property (nonatomic, assign, readonly) double blobCacheHitRate;
+
+/**
+ The number of bytes of blobs that were read from the blob cache instead of downloaded.
+ */
+@property (nonatomic, assign, readonly) unsigned long long blobCacheBytesSaved;
+
 /**
  Makes Web request call to HealthVault service.
 
@@ -23,5 +23,6 @@
 #import "MHVConnectionFactoryProtocol.h"
 #import "MHVSodaConnectionProtocol.h"
 #import "MHVConfiguration.h"
+#import "MHVRequestPriority.h"
 
 #endif /* MHVConnections_h */
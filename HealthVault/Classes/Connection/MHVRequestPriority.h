@@ -0,0 +1,35 @@
+//
+//  MHVRequestPriority.h
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+/**
+ How important an operation is. When the connection is busy, waiting operations are sent
+ in this order, and each priority has its own limit on requests in progress.
+ */
+typedef NS_ENUM(NSInteger, MHVRequestPriority)
+{
+    // The user is waiting on the result, e.g. a screen that is loading
+    MHVRequestPriorityInteractive = 0,
+    // Started by the user, the default for methods and rest requests
+    MHVRequestPriorityUserInitiated,
+    // Thing cache synchronization
+    MHVRequestPriorityBackgroundSync,
+    // Blob uploads and downloads
+    MHVRequestPriorityBlobTransfer,
+};
@@ -0,0 +1,121 @@
+//
+//  MHVBlobCache.h
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+@class MHVBlobPayloadThing;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Keeps downloaded blobs on disk by their content, so a blob that is downloaded again, even from a new URL,
+ is read from disk instead. A blob's key is the hash HealthVault returns in its blob info, or its URL and
+ length when there isn't a hash. When the blobs are larger than sizeLimit, the least recently used are removed.
+ */
+@interface MHVBlobCache : NSObject
+
+/**
+ The size in bytes the blobs can use. 0 keeps no blobs.
+ */
+@property (nonatomic, assign) NSUInteger sizeLimit;
+
+/**
+ The number of blobs that were read from the cache, and the number that had to be downloaded
+ */
+@property (nonatomic, assign, readonly) NSUInteger hitCount;
+@property (nonatomic, assign, readonly) NSUInteger missCount;
+
+/**
+ The fraction of blobs read from the cache, from 0 to 1
+ */
+@property (nonatomic, assign, readonly) double hitRate;
+
+/**
+ The number of bytes read from the cache rather than downloaded
+ */
+@property (nonatomic, assign, readonly) unsigned long long bytesSaved;
+
+/**
+ Caches/MHVBlobs in the app's container
+ */
++ (NSURL *)defaultDirectoryURL;
+
+/**
+ The key a blob is kept under
+
+ @param blobPayloadThing The blob
+ @return The key, or nil if the blob has neither a hash nor a URL
+ */
++ (NSString *_Nullable)keyForBlobPayloadThing:(MHVBlobPayloadThing *)blobPayloadThing;
+
+/**
+ Create a cache
+
+ @param directoryURL Where blobs are written
+ @param sizeLimit The size in bytes the blobs can use
+ */
+- (instancetype)initWithDirectoryURL:(NSURL *)directoryURL sizeLimit:(NSUInteger)sizeLimit;
+
+/**
+ Changes each time every blob is removed. A blob is only kept if the generation is the same as when its download started.
+ */
+@property (nonatomic, assign, readonly) NSUInteger generation;
+
+/**
+ Get a blob's data
+
+ @param key The blob's key
+ @return The data, or nil if the blob isn't kept
+ */
+- (NSData *_Nullable)dataForKey:(NSString *)key;
+
+/**
+ Copy a blob to a file, replacing the file if it exists
+
+ @param key The blob's key
+ @param filePath Where the blob is copied
+ @return YES if the blob was kept and copied
+ */
+- (BOOL)copyBlobForKey:(NSString *)key toFilePath:(NSString *)filePath;
+
+/**
+ Keep a downloaded blob
+
+ @param data The blob's data
+ @param key The blob's key
+ @param generation The generation when the download started
+ */
+- (void)setData:(NSData *)data forKey:(NSString *)key generation:(NSUInteger)generation;
+
+/**
+ Keep a blob that was downloaded to a file. The file is copied before this returns, so it can be moved or removed after.
+
+ @param filePath The downloaded file
+ @param key The blob's key
+ @param generation The generation when the download started
+ */
+- (void)setBlobWithFilePath:(NSString *)filePath forKey:(NSString *)key generation:(NSUInteger)generation;
+
+/**
+ Remove every blob, e.g. when the person signs out.
+ */
+- (void)removeAllBlobs;
+
+@end
+
+NS_ASSUME_NONNULL_END
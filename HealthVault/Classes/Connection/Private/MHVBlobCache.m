@@ -0,0 +1,390 @@
+//
+//  MHVBlobCache.m
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "MHVBlobCache.h"
+#import "MHVValidator.h"
+#import "MHVLogger.h"
+#import "MHVBlobPayloadThing.h"
+#import "NSData+Utils.h"
+
+@interface MHVCachedBlob : NSObject
+
+@property (nonatomic, assign) unsigned long long size;
+@property (nonatomic, strong) NSDate *lastUsedDate;
+
+@end
+
+@implementation MHVCachedBlob
+
+@end
+
+@interface MHVBlobCache ()
+
+@property (nonatomic, strong) NSURL *directoryURL;
+@property (nonatomic, strong) NSFileManager *fileManager;
+
+// Disk reads and copies are synchronous and writes asynchronous, all in order on this queue
+@property (nonatomic, strong) dispatch_queue_t ioQueue;
+
+// The blobs on disk by key, and their total size. Only used on the ioQueue
+@property (nonatomic, strong) NSMutableDictionary<NSString *, MHVCachedBlob *> *blobs;
+@property (nonatomic, assign) unsigned long long totalSize;
+
+// Guarded by @synchronized (self)
+@property (nonatomic, assign) NSUInteger hitCount;
+@property (nonatomic, assign) NSUInteger missCount;
+@property (nonatomic, assign) unsigned long long bytesSaved;
+@property (nonatomic, assign) NSUInteger removeAllCount;
+
+@end
+
+@implementation MHVBlobCache
+
++ (NSURL *)defaultDirectoryURL
+{
+    NSURL *cachesURL = [[[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory inDomains:NSUserDomainMask] lastObject];
+
+    return [cachesURL URLByAppendingPathComponent:@"MHVBlobs" isDirectory:YES];
+}
+
++ (NSString *_Nullable)keyForBlobPayloadThing:(MHVBlobPayloadThing *)blobPayloadThing
+{
+    MHVASSERT_PARAMETER(blobPayloadThing);
+
+    MHVBlobHashInfo *hashInfo = blobPayloadThing.blobInfo.hashInfo;
+    NSString *source = nil;
+
+    if (hashInfo.hash.length > 0)
+    {
+        source = [NSString stringWithFormat:@"hash|%@|%i|%@", hashInfo.algorithm ?: @"", hashInfo.params.blockSize.value, hashInfo.hash];
+    }
+    else if (blobPayloadThing.blobUrl.length > 0)
+    {
+        source = [NSString stringWithFormat:@"url|%@|%li", blobPayloadThing.blobUrl, (long)blobPayloadThing.length];
+    }
+
+    return [[source dataUsingEncoding:NSUTF8StringEncoding] SHA256];
+}
+
+- (instancetype)initWithDirectoryURL:(NSURL *)directoryURL sizeLimit:(NSUInteger)sizeLimit
+{
+    MHVASSERT_PARAMETER(directoryURL);
+
+    self = [super init];
+
+    if (self)
+    {
+        _directoryURL = directoryURL;
+        _sizeLimit = sizeLimit;
+        _fileManager = [NSFileManager new];
+        _ioQueue = dispatch_queue_create("MHVBlobCache.ioQueue", DISPATCH_QUEUE_SERIAL);
+        _blobs = [NSMutableDictionary new];
+
+        dispatch_async(_ioQueue, ^
+        {
+            [self loadBlobs];
+            [self removeLeastRecentlyUsedBlobs];
+        });
+    }
+
+    return self;
+}
+
+- (NSUInteger)generation
+{
+    @synchronized (self)
+    {
+        return self.removeAllCount;
+    }
+}
+
+- (double)hitRate
+{
+    @synchronized (self)
+    {
+        NSUInteger count = self.hitCount + self.missCount;
+
+        return count > 0 ? (double)self.hitCount / count : 0;
+    }
+}
+
+- (NSData *_Nullable)dataForKey:(NSString *)key
+{
+    MHVASSERT_PARAMETER(key);
+
+    if (self.sizeLimit == 0)
+    {
+        return nil;
+    }
+
+    __block NSData *data = nil;
+
+    dispatch_sync(self.ioQueue, ^
+    {
+        if (self.blobs[key])
+        {
+            data = [NSData dataWithContentsOfURL:[self.directoryURL URLByAppendingPathComponent:key] options:NSDataReadingMappedIfSafe error:nil];
+
+            [self usedBlobForKey:key exists:data != nil];
+        }
+    });
+
+    [self countBlobWithSize:data ? data.length : 0 hit:data != nil];
+
+    return data;
+}
+
+- (BOOL)copyBlobForKey:(NSString *)key toFilePath:(NSString *)filePath
+{
+    MHVASSERT_PARAMETER(key);
+    MHVASSERT_PARAMETER(filePath);
+
+    if (self.sizeLimit == 0)
+    {
+        return NO;
+    }
+
+    __block BOOL copied = NO;
+    __block unsigned long long size = 0;
+
+    dispatch_sync(self.ioQueue, ^
+    {
+        NSURL *fileURL = [self.directoryURL URLByAppendingPathComponent:key];
+
+        if (self.blobs[key])
+        {
+            size = self.blobs[key].size;
+
+            [self.fileManager removeItemAtPath:filePath error:nil];
+
+            copied = [self.fileManager copyItemAtURL:fileURL toURL:[NSURL fileURLWithPath:filePath] error:nil];
+
+            [self usedBlobForKey:key exists:[self.fileManager fileExistsAtPath:fileURL.path]];
+        }
+    });
+
+    if (copied)
+    {
+        [self.fileManager setAttributes:@{NSFileProtectionKey : NSFileProtectionCompleteUntilFirstUserAuthentication}
+                           ofItemAtPath:filePath
+                                  error:nil];
+    }
+
+    [self countBlobWithSize:size hit:copied];
+
+    return copied;
+}
+
+- (void)setData:(NSData *)data forKey:(NSString *)key generation:(NSUInteger)generation
+{
+    MHVASSERT_PARAMETER(data);
+    MHVASSERT_PARAMETER(key);
+
+    if (data.length > self.sizeLimit || generation != self.generation)
+    {
+        return;
+    }
+
+    dispatch_async(self.ioQueue, ^
+    {
+        // removeAllBlobs changes the generation before it queues the removal, so this write can't come after it
+        if (generation != self.generation)
+        {
+            return;
+        }
+
+        [self.fileManager createDirectoryAtURL:self.directoryURL
+                   withIntermediateDirectories:YES
+                                    attributes:@{NSFileProtectionKey : NSFileProtectionComplete}
+                                         error:nil];
+
+        NSError *error = nil;
+        if (![data writeToURL:[self.directoryURL URLByAppendingPathComponent:key]
+                      options:NSDataWritingAtomic | NSDataWritingFileProtectionComplete
+                        error:&error])
+        {
+            MHVLOG(@"Could not write cached blob: %@", error.localizedDescription);
+            return;
+        }
+
+        [self addedBlobForKey:key size:data.length];
+    });
+}
+
+- (void)setBlobWithFilePath:(NSString *)filePath forKey:(NSString *)key generation:(NSUInteger)generation
+{
+    MHVASSERT_PARAMETER(filePath);
+    MHVASSERT_PARAMETER(key);
+
+    unsigned long long size = [[self.fileManager attributesOfItemAtPath:filePath error:nil] fileSize];
+
+    if (size == 0 || size > self.sizeLimit || generation != self.generation)
+    {
+        return;
+    }
+
+    dispatch_sync(self.ioQueue, ^
+    {
+        if (generation != self.generation)
+        {
+            return;
+        }
+
+        [self.fileManager createDirectoryAtURL:self.directoryURL
+                   withIntermediateDirectories:YES
+                                    attributes:@{NSFileProtectionKey : NSFileProtectionComplete}
+                                         error:nil];
+
+        NSURL *fileURL = [self.directoryURL URLByAppendingPathComponent:key];
+        [self.fileManager removeItemAtURL:fileURL error:nil];
+
+        NSError *error = nil;
+        if (![self.fileManager copyItemAtURL:[NSURL fileURLWithPath:filePath] toURL:fileURL error:&error])
+        {
+            MHVLOG(@"Could not copy cached blob: %@", error.localizedDescription);
+            return;
+        }
+
+        [self.fileManager setAttributes:@{NSFileProtectionKey : NSFileProtectionComplete,
+                                          NSFileModificationDate : [NSDate date]}
+                           ofItemAtPath:fileURL.path
+                                  error:nil];
+
+        [self addedBlobForKey:key size:size];
+    });
+}
+
+- (void)removeAllBlobs
+{
+    @synchronized (self)
+    {
+        self.removeAllCount += 1;
+    }
+
+    dispatch_async(self.ioQueue, ^
+    {
+        [self.fileManager removeItemAtURL:self.directoryURL error:nil];
+
+        [self.blobs removeAllObjects];
+        self.totalSize = 0;
+    });
+}
+
+#pragma mark - Internal methods
+
+- (void)countBlobWithSize:(unsigned long long)size hit:(BOOL)hit
+{
+    @synchronized (self)
+    {
+        if (hit)
+        {
+            self.hitCount += 1;
+            self.bytesSaved += size;
+        }
+        else
+        {
+            self.missCount += 1;
+        }
+    }
+}
+
+// Only called on the ioQueue. The modification date is the last use, so the order survives a relaunch
+- (void)usedBlobForKey:(NSString *)key exists:(BOOL)exists
+{
+    if (!exists)
+    {
+        self.totalSize -= self.blobs[key].size;
+        [self.blobs removeObjectForKey:key];
+        return;
+    }
+
+    NSDate *now = [NSDate date];
+
+    self.blobs[key].lastUsedDate = now;
+
+    [self.fileManager setAttributes:@{NSFileModificationDate : now}
+                       ofItemAtPath:[self.directoryURL URLByAppendingPathComponent:key].path
+                              error:nil];
+}
+
+// Only called on the ioQueue
+- (void)addedBlobForKey:(NSString *)key size:(unsigned long long)size
+{
+    MHVCachedBlob *blob = [MHVCachedBlob new];
+    blob.size = size;
+    blob.lastUsedDate = [NSDate date];
+
+    self.totalSize -= self.blobs[key].size;
+    self.totalSize += size;
+    self.blobs[key] = blob;
+
+    [self removeLeastRecentlyUsedBlobs];
+}
+
+// Only called on the ioQueue
+- (void)removeLeastRecentlyUsedBlobs
+{
+    if (self.totalSize <= self.sizeLimit)
+    {
+        return;
+    }
+
+    NSArray<NSString *> *keys = [self.blobs keysSortedByValueUsingComparator:^NSComparisonResult(MHVCachedBlob *blob1, MHVCachedBlob *blob2)
+    {
+        return [blob1.lastUsedDate compare:blob2.lastUsedDate];
+    }];
+
+    for (NSString *key in keys)
+    {
+        if (self.totalSize <= self.sizeLimit)
+        {
+            break;
+        }
+
+        [self.fileManager removeItemAtURL:[self.directoryURL URLByAppendingPathComponent:key] error:nil];
+
+        self.totalSize -= self.blobs[key].size;
+        [self.blobs removeObjectForKey:key];
+    }
+}
+
+// Only called on the ioQueue
+- (void)loadBlobs
+{
+    NSArray<NSURL *> *urls = [self.fileManager contentsOfDirectoryAtURL:self.directoryURL
+                                             includingPropertiesForKeys:@[NSURLFileSizeKey, NSURLContentModificationDateKey]
+                                                                options:NSDirectoryEnumerationSkipsHiddenFiles
+                                                                  error:nil];
+
+    for (NSURL *url in urls)
+    {
+        NSNumber *size = nil;
+        NSDate *modified = nil;
+        [url getResourceValue:&size forKey:NSURLFileSizeKey error:nil];
+        [url getResourceValue:&modified forKey:NSURLContentModificationDateKey error:nil];
+
+        MHVCachedBlob *blob = [MHVCachedBlob new];
+        blob.size = size.unsignedLongLongValue;
+        blob.lastUsedDate = modified ?: [NSDate distantPast];
+
+        self.blobs[url.lastPathComponent] = blob;
+        self.totalSize += blob.size;
+    }
+}
+
+@end
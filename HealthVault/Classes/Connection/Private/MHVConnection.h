@@ -19,7 +19,7 @@
 #import <Foundation/Foundation.h>
 #import "MHVConnectionProtocol.h"
 
-@class MHVConfiguration, MHVThingCacheConfiguration, MHVClientFactory, MHVServiceInstance, MHVApplicationCreationInfo;
+@class MHVConfiguration, MHVThingCacheConfiguration, MHVClientFactory, MHVServiceInstance, MHVApplicationCreationInfo, MHVMethodResponseCache, MHVRestResponseCache, MHVBlobCache, MHVPendingBlobUploadStore;
 
 @protocol MHVHttpServiceProtocol, MHVThingCacheConfigurationProtocol, MHVThingCacheSynchronizerProtocol;
 
@@ -30,6 +30,12 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, strong, nullable) MHVServiceInstance *serviceInstance;
 @property (nonatomic, strong, readonly, nullable) MHVPersonInfo *personInfo;
 @property (nonatomic, strong, readonly) MHVConfiguration *configuration;
+@property (nonatomic, strong, readonly) MHVMethodResponseCache *responseCache;
+// nil unless the configuration enables the REST response cache
+@property (nonatomic, strong, readonly, nullable) MHVRestResponseCache *restResponseCache;
+@property (nonatomic, strong, readonly) MHVBlobCache *blobCache;
+// Shared with the thing client, so uploads are kept and removed in order
+@property (nonatomic, strong, readonly) MHVPendingBlobUploadStore *pendingBlobUploadStore;
 
 - (instancetype)initWithConfiguration:(MHVConfiguration *)configuration
                     cacheSynchronizer:(id<MHVThingCacheSynchronizerProtocol>_Nullable)cacheSynchronizer
@@ -37,6 +43,11 @@ NS_ASSUME_NONNULL_BEGIN
                         clientFactory:(MHVClientFactory *)clientFactory
                           httpService:(id<MHVHttpServiceProtocol>)httpService;
 
+/**
+ Cancel the blob uploads in progress, and those waiting to be sent. Their completions get an NSURLErrorCancelled error
+ */
+- (void)cancelBlobUploads;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -24,7 +24,9 @@
 #import "MHVSessionCredential.h"
 #import "MHVRequestMessageCreatorProtocol.h"
 #import "MHVRequestMessageCreator.h"
+#import "MHVRequestMessageFragments.h"
 #import "MHVHttpServiceProtocol.h"
+#import "MHVHttpTaskProtocol.h"
 #import "MHVServiceInstance.h"
 #import "NSError+MHVError.h"
 #import "MHVErrorConstants.h"
@@ -43,6 +45,14 @@
 #import "MHVClientInfo.h"
 #import "MHVConnectionTaskResult.h"
 #import "MHVStringExtensions.h"
+#import "MHVRequestScheduler.h"
+#import "MHVMethodResponseCache.h"
+#import "MHVRestResponseCache.h"
+#import "MHVBlobCache.h"
+#import "MHVPendingBlobUploadStore.h"
+#import "MHVBlobHasher.h"
+#import "MHVJsonSerializer.h"
+#import "NSData+Utils.h"
 #if THING_CACHE
 #import "MHVThingCacheConfigurationProtocol.h"
 #import "MHVThingClient.h"
@@ -54,13 +64,24 @@ static NSString *const kCorrelationIdContextKey = @"WC_CorrelationId";
 static NSString *const kResponseIdContextKey = @"WC_ResponseId";
 
 static NSInteger kUnauthorizedServerError = 401;
-static NSInteger kInternalServerError = 500;
 
 @interface MHVConnection ()
 
 @property (nonatomic, strong) dispatch_queue_t completionQueue;
+// Requests waiting for the session credential to be refreshed. Only used on the completionQueue
 @property (nonatomic, strong) NSMutableArray<MHVHttpServiceRequest *> *requests;
+@property (nonatomic, strong) MHVSessionCredential *unrefreshedSessionCredential;
 @property (nonatomic, strong) MHVConfiguration *configuration;
+@property (nonatomic, strong) MHVRequestMessageFragments *messageFragments;
+@property (nonatomic, strong) MHVRequestScheduler *scheduler;
+
+// Completions waiting for read-only methods in progress, by inFlightKeyForOperation:
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSMutableArray *> *inFlightMethods;
+@property (nonatomic, assign) NSUInteger collapsedMethodCount;
+
+// Blob uploads that have been sent, and how many times they were cancelled. Guarded by @synchronized (self.blobUploadTasks)
+@property (nonatomic, strong) NSHashTable<id<MHVHttpTaskProtocol>> *blobUploadTasks;
+@property (nonatomic, assign) NSUInteger blobUploadCancelCount;
 
 // Clients
 @property (nonatomic, strong) id<MHVPlatformClientProtocol> platformClient;
@@ -105,8 +126,24 @@ static NSInteger kInternalServerError = 500;
         _clientFactory = clientFactory;
         _httpService = httpService;
         _requests = [NSMutableArray new];
+        _inFlightMethods = [NSMutableDictionary new];
+        _scheduler = [MHVRequestScheduler new];
+        _responseCache = [[MHVMethodResponseCache alloc] initWithDirectoryURL:[MHVMethodResponseCache defaultDirectoryURL]];
+        _restResponseCache = configuration.isRestResponseCacheEnabled ? [[MHVRestResponseCache alloc] initWithDirectoryURL:[MHVRestResponseCache defaultDirectoryURL]] : nil;
+        _blobCache = [[MHVBlobCache alloc] initWithDirectoryURL:[MHVBlobCache defaultDirectoryURL] sizeLimit:configuration.blobCacheSizeLimit];
+        _pendingBlobUploadStore = [[MHVPendingBlobUploadStore alloc] initWithDirectoryURL:[MHVPendingBlobUploadStore defaultDirectoryURL]];
+        _blobUploadTasks = [NSHashTable weakObjectsHashTable];
         _completionQueue = dispatch_queue_create("MHVConnection.requestQueue", DISPATCH_QUEUE_SERIAL);
         
+        if (!_restResponseCache)
+        {
+            // Remove responses kept before the REST cache was opt-in
+            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^
+            {
+                [[NSFileManager new] removeItemAtURL:[MHVRestResponseCache defaultDirectoryURL] error:nil];
+            });
+        }
+        
 #if THING_CACHE
         _cacheSynchronizer = cacheSynchronizer;
         _cacheSynchronizer.connection = self;
@@ -118,6 +155,16 @@ static NSInteger kInternalServerError = 500;
 
 #pragma mark - Public
 
+- (double)blobCacheHitRate
+{
+    return self.blobCache.hitRate;
+}
+
+- (unsigned long long)blobCacheBytesSaved
+{
+    return self.blobCache.bytesSaved;
+}
+
 - (NSUUID *_Nullable)applicationId;
 {
     return nil;
@@ -141,7 +188,9 @@ static NSInteger kInternalServerError = 500;
                        }
                        else
                        {
-                           [self executeHttpServiceRequest:[[MHVHttpServiceRequest alloc] initWithServiceOperation:operation completion:completion]];
+                           [self.configuration.retryPolicy didSendRequest];
+                           
+                           [self executeCachedHttpServiceOperation:operation completion:completion];
                        }
                    });
 }
@@ -185,10 +234,12 @@ static NSInteger kInternalServerError = 500;
     {
 #if THING_CACHE
         _thingClient = [self.clientFactory thingClientWithConnection:self
-                                                  thingCacheDatabase:self.cacheSynchronizer.database];
+                                                  thingCacheDatabase:self.cacheSynchronizer.database
+                                                     blobUploadStore:self.pendingBlobUploadStore];
 #else
         _thingClient = [self.clientFactory thingClientWithConnection:self
-                                                  thingCacheDatabase:nil];
+                                                  thingCacheDatabase:nil
+                                                     blobUploadStore:self.pendingBlobUploadStore];
 #endif
     }
     
@@ -217,7 +268,198 @@ static NSInteger kInternalServerError = 500;
 
 #pragma mark - Private
 
+// Responses to read-only methods are returned from the response cache while they're current
+- (void)executeCachedHttpServiceOperation:(id<MHVHttpServiceOperationProtocol>)operation
+                               completion:(void (^_Nullable)(MHVServiceResponse *_Nullable response, NSError *_Nullable error))completion
+{
+    if (![operation isKindOfClass:[MHVMethod class]])
+    {
+        [self executeSharedHttpServiceOperation:operation completion:completion];
+        return;
+    }
+    
+    MHVMethod *method = (MHVMethod *)operation;
+    
+    if (!method.isReadOnly)
+    {
+        // Remove what the write changes before and after it's sent, so reads in between don't get the old responses
+        [self.responseCache removeResponsesChangedByMethod:method];
+        
+        [self executeSharedHttpServiceOperation:method
+                                     completion:^(MHVServiceResponse *_Nullable response, NSError *_Nullable error)
+        {
+            [self.responseCache removeResponsesChangedByMethod:method];
+            
+            if (completion)
+            {
+                completion(response, error);
+            }
+        }];
+        
+        return;
+    }
+    
+    NSString *key = [self responseCacheKeyForMethod:method];
+    if (key)
+    {
+        BOOL isStale = NO;
+        MHVServiceResponse *cachedResponse = [self.responseCache responseForKey:key
+                                                                     timeToLive:[self.configuration.methodResponseTimeToLiveDurations[method.name] doubleValue]
+                                                                  staleDuration:self.configuration.methodResponseStaleDuration
+                                                                        isStale:&isStale];
+        if (cachedResponse)
+        {
+            MHVLOG(@"Execute Method: %@ returned a cached response%@", method.name, isStale ? @", fetching it again" : @"");
+            
+            if (completion)
+            {
+                completion(cachedResponse, nil);
+            }
+            
+            if (!isStale)
+            {
+                return;
+            }
+            
+            // The new response is only needed for the cache, so callers get the stale response without waiting.
+            // The caller's method is left as it was, in case it is sent again
+            method = [method copy];
+            method.priority = MHVRequestPriorityBackgroundSync;
+            completion = ^(MHVServiceResponse *_Nullable response, NSError *_Nullable error) { };
+        }
+    }
+    
+    [self executeSharedHttpServiceOperation:method completion:completion];
+}
+
+- (NSString *_Nullable)responseCacheKeyForMethod:(MHVMethod *)method
+{
+    // Streaming methods deliver their results into their own info object, so the response isn't kept
+    if (!method.isReadOnly || method.streamingInfo || [self.configuration.methodResponseTimeToLiveDurations[method.name] doubleValue] <= 0)
+    {
+        return nil;
+    }
+    
+    return [self.responseCache keyForMethod:method personId:self.personInfo.ID];
+}
+
+- (MHVHttpServiceRequest *)requestForOperation:(id<MHVHttpServiceOperationProtocol>)operation
+                                    completion:(void (^_Nullable)(MHVServiceResponse *_Nullable response, NSError *_Nullable error))completion
+{
+    MHVHttpServiceRequest *request = [[MHVHttpServiceRequest alloc] initWithServiceOperation:operation completion:completion];
+    
+    if ([operation isKindOfClass:[MHVMethod class]])
+    {
+        request.responseCacheKey = [self responseCacheKeyForMethod:(MHVMethod *)operation];
+        
+        if (request.responseCacheKey)
+        {
+            request.responseCacheGeneration = [self.responseCache generationForKey:request.responseCacheKey];
+        }
+    }
+    
+    return request;
+}
+
+// Identical read-only methods in progress at the same time are sent once, and every caller gets that response
+- (void)executeSharedHttpServiceOperation:(id<MHVHttpServiceOperationProtocol>)operation
+                               completion:(void (^_Nullable)(MHVServiceResponse *_Nullable response, NSError *_Nullable error))completion
+{
+    NSString *key = [self inFlightKeyForOperation:operation];
+    if (!key)
+    {
+        [self executeHttpServiceRequest:[self requestForOperation:operation completion:completion]];
+        return;
+    }
+    
+    void (^waiter)(MHVServiceResponse *, NSError *) = completion ?: ^(MHVServiceResponse *response, NSError *error) { };
+    
+    @synchronized (self.inFlightMethods)
+    {
+        NSMutableArray *waiters = self.inFlightMethods[key];
+        if (waiters)
+        {
+            [waiters addObject:waiter];
+            self.collapsedMethodCount += 1;
+            
+            MHVLOG(@"Execute Method: %@ is already in progress, sharing its response", ((MHVMethod *)operation).name);
+            return;
+        }
+        
+        self.inFlightMethods[key] = [NSMutableArray arrayWithObject:waiter];
+    }
+    
+    [self executeHttpServiceRequest:[self requestForOperation:operation
+                                                   completion:^(MHVServiceResponse *_Nullable response, NSError *_Nullable error)
+    {
+        NSArray *waiters;
+        
+        @synchronized (self.inFlightMethods)
+        {
+            waiters = self.inFlightMethods[key];
+            [self.inFlightMethods removeObjectForKey:key];
+        }
+        
+        for (void (^waiter)(MHVServiceResponse *, NSError *) in waiters)
+        {
+            waiter(response, error);
+        }
+    }]];
+}
+
+- (NSString *_Nullable)inFlightKeyForOperation:(id<MHVHttpServiceOperationProtocol>)operation
+{
+    if (![operation isKindOfClass:[MHVMethod class]])
+    {
+        return nil;
+    }
+    
+    MHVMethod *method = (MHVMethod *)operation;
+    
+    // Streaming methods deliver their results into their own info object, so can't be shared
+    if (!method.isReadOnly || method.streamingInfo)
+    {
+        return nil;
+    }
+    
+    NSString *parametersHash = method.parametersHash;
+    if (!parametersHash)
+    {
+        NSData *parameters = method.parametersData;
+        if (!parameters)
+        {
+            parameters = [method.parameters dataUsingEncoding:NSUTF8StringEncoding] ?: [NSData data];
+        }
+        
+        parametersHash = [[MHVCryptographer new] computeSha256HashOfData:parameters];
+    }
+    
+    return [NSString stringWithFormat:@"%@|%li|%@|%@", method.name, (long)method.version, method.recordId.UUIDString ?: @"", parametersHash];
+}
+
 - (void)executeHttpServiceRequest:(MHVHttpServiceRequest *)request
+{
+    if (request.serviceOperation.isAnonymous)
+    {
+        [self sendHttpServiceRequest:request];
+        return;
+    }
+    
+    dispatch_async(self.completionQueue, ^
+    {
+        // While the credential is being refreshed, new requests wait for it rather than being sent with the old one
+        if (self.requests.count > 0 || [self sessionCredentialNeedsRefresh])
+        {
+            [self waitForRefreshedCredentialWithRequest:request];
+        }
+        else
+        {
+            [self sendHttpServiceRequest:request];
+        }
+    });
+}
+
+- (void)sendHttpServiceRequest:(MHVHttpServiceRequest *)request
 {
     if ([request.serviceOperation isKindOfClass:[MHVMethod class]])
     {
@@ -249,6 +491,12 @@ static NSInteger kInternalServerError = 500;
 
     MHVLOG(@"Execute Method: %@", method.name);
     
+    if (method.streamingInfo)
+    {
+        [self executeStreamingMethodRequest:request];
+        return;
+    }
+    
     if (request.serviceOperation.cache)
     {
         // Handle returning cached values
@@ -260,50 +508,124 @@ static NSInteger kInternalServerError = 500;
         }
     }
     
-    [self.httpService sendRequestForURL:self.serviceInstance.healthServiceUrl
-                             httpMethod:nil
-                                   body:[[self messageForMethod:method] dataUsingEncoding:NSUTF8StringEncoding]
-                                headers:[self headersForMethod:method]
-                             completion:^(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error)
+    // The message is built when the request is sent, so its msg-time isn't spent waiting in the scheduler
+    [self.scheduler scheduleWithPriority:method.priority request:^(MHVScheduledRequestFinished finished)
     {
-        if (error)
+        request.sessionToken = self.sessionCredential.token;
+        
+        NSString *contentEncoding = nil;
+        NSData *body = [self messageForMethod:method contentEncoding:&contentEncoding];
+        
+        [self.httpService sendRequestForURL:self.serviceInstance.healthServiceUrl
+                                 httpMethod:nil
+                                       body:body
+                                    headers:[self headersForMethod:method contentEncoding:contentEncoding]
+                                 completion:^(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error)
         {
-            if (response.statusCode == kInternalServerError &&
-                request.retryAttempts < self.configuration.retryOnInternal500Count)
-            {
-                //For 500 errors, should retry after a delay
-                [self retryRequest:request];
-                
-                return;
-            }
-            else if (error.code == MHVErrorTypeUnauthorized)
+            finished();
+        
+            if ([self retryRequest:request statusCode:response.statusCode headers:response.headers error:error])
             {
-                [self refreshTokenAndReissueRequest:request];
-                
                 return;
             }
-            else
+            
+            if (error)
             {
-                MHVLOG(@"Execute %@ Method Error: %@", method.name, error.localizedDescription);
-                if (request.completion)
+                if (error.code == MHVErrorTypeUnauthorized)
                 {
-                    request.completion(nil, error);
+                    [self refreshTokenAndReissueRequest:request];
+                
+                    return;
                 }
+                else
+                {
+                    MHVLOG(@"Execute %@ Method Error: %@", method.name, error.localizedDescription);
+                    if (request.completion)
+                    {
+                        request.completion(nil, error);
+                    }
                 
-                return;
+                    return;
+                }
             }
-        }
-        else
-        {
+            else
+            {
             
-            [self parseResponse:response request:request isXML:YES completion:request.completion];
-        }
+                [self parseResponse:response request:request isXML:YES completion:request.completion];
+            }
+        }];
+    }];
+}
+
+- (void)executeStreamingMethodRequest:(MHVHttpServiceRequest *)request
+{
+    MHVMethod *method = request.serviceOperation;
+    
+    __block MHVServiceResponse *serviceResponse = nil;
+    __block NSDictionary<NSString *, NSString *> *responseHeaders = nil;
+    
+    [self.scheduler scheduleWithPriority:method.priority request:^(MHVScheduledRequestFinished finished)
+    {
+        request.sessionToken = self.sessionCredential.token;
+        
+        NSString *contentEncoding = nil;
+        NSData *body = [self messageForMethod:method contentEncoding:&contentEncoding];
+        
+        [self.httpService sendStreamingRequestForURL:self.serviceInstance.healthServiceUrl
+                                                body:body
+                                             headers:[self headersForMethod:method contentEncoding:contentEncoding]
+                                       streamHandler:^(NSInteger statusCode, NSDictionary<NSString *, NSString *> *headers, NSInputStream *stream)
+         {
+             responseHeaders = headers;
+             
+             // The info is deserialized into method.streamingInfo as the body arrives
+             serviceResponse = [[MHVServiceResponse alloc] initWithStatusCode:statusCode
+                                                                       stream:stream
+                                                                         info:method.streamingInfo];
+         }
+                                          completion:^(NSError * _Nullable error)
+         {
+             finished();
+         
+             // A failed transfer leaves a truncated body, so the network error takes precedence over the parse result
+             if (!error)
+             {
+                 error = serviceResponse ? serviceResponse.error : [NSError MHVNetworkError];
+             }
+         
+             if (!error)
+             {
+                 if (request.completion)
+                 {
+                     request.completion(serviceResponse, nil);
+                 }
+             }
+             // Things in a partial response were already delivered, so network errors are only retried before there is a response
+             else if ([self retryRequest:request
+                              statusCode:serviceResponse.statusCode
+                                 headers:responseHeaders
+                                   error:serviceResponse ? nil : error])
+             {
+                 return;
+             }
+             else if (error.code == MHVErrorTypeUnauthorized)
+             {
+                 [self refreshTokenAndReissueRequest:request];
+             }
+             else
+             {
+                 MHVLOG(@"Execute %@ Method Error: %@", method.name, error.localizedDescription);
+                 if (request.completion)
+                 {
+                     request.completion(nil, error);
+                 }
+             }
+         }];
     }];
 }
 
 - (void)executeRestRequest:(MHVHttpServiceRequest *)request
 {
-    // TODO: Add cache support
     MHVRestRequest *restRequest = request.serviceOperation;
     
     MHVLOG(@"Execute Request: %@", restRequest.path);
@@ -314,11 +636,40 @@ static NSInteger kInternalServerError = 500;
         [restRequest updateUrlWithServiceUrl:self.configuration.restHealthVaultUrl];
     }
     
+    // GET responses are kept following their Cache-Control and ETag headers, and other requests remove what they change
+    BOOL isReadOnly = [self isReadOnlyOperation:restRequest];
+    NSString *cacheKey = nil;
+    NSUInteger cacheGeneration = 0;
+    MHVCachedRestResponse *cachedResponse = nil;
+    
+    if (isReadOnly)
+    {
+        cacheKey = [self.restResponseCache keyForRequest:restRequest
+                                                personId:self.personInfo.ID
+                                                recordId:self.personInfo.selectedRecordID
+                                                 version:self.configuration.restVersion];
+        cacheGeneration = [self.restResponseCache generationForKey:cacheKey];
+        cachedResponse = [self.restResponseCache responseForKey:cacheKey];
+        
+        if (cachedResponse.isFresh)
+        {
+            MHVLOG(@"Execute Request: %@ returned a cached response", restRequest.path);
+            
+            [self completeRestRequest:request responseData:cachedResponse.responseData statusCode:200 cacheKey:cacheKey];
+            return;
+        }
+    }
+    else
+    {
+        [self.restResponseCache removeResponsesChangedByRequest:restRequest];
+    }
+    
     // Add authorization header
     NSMutableDictionary *headers = [[NSMutableDictionary alloc] init];
     if (!restRequest.isAnonymous)
     {
-        headers[@"Authorization"] = [NSString stringWithFormat:@"MSH-V1 app-token=%@,offline-person-id=%@,record-id=%@", self.sessionCredential.token, self.personInfo.ID, self.personInfo.selectedRecordID];
+        request.sessionToken = self.sessionCredential.token;
+        headers[@"Authorization"] = [NSString stringWithFormat:@"MSH-V1 app-token=%@,offline-person-id=%@,record-id=%@", request.sessionToken, self.personInfo.ID, self.personInfo.selectedRecordID];
     }
     
     // Add the required REST version header
@@ -328,156 +679,408 @@ static NSInteger kInternalServerError = 500;
     headers[@"version"] = [MHVClientInfo telemetryInfo];
     
     headers[@"Content-Type"] = @"application/json";
+    
+    if (cachedResponse.etag)
+    {
+        headers[@"If-None-Match"] = cachedResponse.etag;
+    }
 
-    [self.httpService sendRequestForURL:restRequest.url
-                             httpMethod:restRequest.httpMethod
-                                   body:restRequest.body
-                                headers:headers
-                             completion:^(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error)
+    [self.scheduler scheduleWithPriority:restRequest.priority request:^(MHVScheduledRequestFinished finished)
     {
-        if (response.statusCode == kInternalServerError &&
-            request.retryAttempts < self.configuration.retryOnInternal500Count)
+        [self.httpService sendRequestForURL:restRequest.url
+                                 httpMethod:restRequest.httpMethod
+                                       body:restRequest.body
+                                    headers:headers
+                                 completion:^(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error)
         {
-            //For 500 errors, should retry after a delay
-            [self retryRequest:request];
+            finished();
+        
+            if ([self retryRequest:request statusCode:response.statusCode headers:response.headers error:error])
+            {
+                return;
+            }
+            else if (error.code == MHVErrorTypeUnauthorized ||
+                     response.statusCode == kUnauthorizedServerError)
+            {
+                // If unauthorized, refresh token and retry request
+                [self refreshTokenAndReissueRequest:request];
             
-            return;
-        }
-        else if (error.code == MHVErrorTypeUnauthorized ||
-                 response.statusCode == kUnauthorizedServerError)
-        {
-            // If unauthorized, refresh token and retry request
-            [self refreshTokenAndReissueRequest:request];
+                return;
+            }
             
-            return;
-        }
+            if (!isReadOnly)
+            {
+                [self.restResponseCache removeResponsesChangedByRequest:restRequest];
+            }
+            
+            // Not modified since the cached response, which is used again along with its deserialized result
+            if (!error && response.statusCode == 304 && cacheKey)
+            {
+                MHVCachedRestResponse *refreshedResponse = [self.restResponseCache refreshResponseForKey:cacheKey headers:response.headers];
+                
+                if (refreshedResponse)
+                {
+                    [self completeRestRequest:request responseData:refreshedResponse.responseData statusCode:200 cacheKey:cacheKey];
+                    return;
+                }
+                
+                // The cached response was removed while the request was in progress, so a 304 has no body to use.
+                // Sent again, the request finds nothing cached and goes without If-None-Match
+                MHVLOG(@"Execute Request: %@ was not modified but its cached response is gone, sending it again", restRequest.path);
+                
+                [self executeRestRequest:request];
+                return;
+            }
         
-        if (response.hasError)
-        {
-            if (request.completion)
+            if (response.hasError)
             {
-                if (!error)
+                if (request.completion)
                 {
-                    error = [NSError error:[NSError MHVNetworkError] withDescription:[NSString stringWithFormat:@"Response:%@(%@) - %@", @(response.statusCode), response.errorText, response.responseAsString]];
+                    if (!error)
+                    {
+                        error = [NSError error:[NSError MHVNetworkError] withDescription:[NSString stringWithFormat:@"Response:%@(%@) - %@", @(response.statusCode), response.errorText, response.responseAsString]];
+                    }
+
+                    request.completion(nil, error);
                 }
 
-                request.completion(nil, error);
+                return;
+            }
+            else if (error)
+            {
+                if (request.completion)
+                {
+                    request.completion(nil, error);
+                }
+            
+                return;
+            }
+            else
+            {
+                if (cacheKey)
+                {
+                    [self.restResponseCache setResponse:response forKey:cacheKey generation:cacheGeneration];
+                }
+                
+                [self completeRestRequest:request responseData:response.responseAsData statusCode:response.statusCode cacheKey:cacheKey];
             }
+        }];
+    }];
+}
 
-            return;
-        }
-        else if (error)
+- (void)completeRestRequest:(MHVHttpServiceRequest *)request
+               responseData:(NSData *_Nullable)responseData
+                 statusCode:(NSInteger)statusCode
+                   cacheKey:(NSString *_Nullable)cacheKey
+{
+    if (!request.completion)
+    {
+        return;
+    }
+    
+    MHVRestRequest *restRequest = request.serviceOperation;
+    MHVHttpServiceResponse *response = [[MHVHttpServiceResponse alloc] initWithResponseData:responseData statusCode:statusCode];
+    MHVServiceResponse *serviceResponse = [[MHVServiceResponse alloc] initWithWebResponse:response isXML:NO];
+    
+    if (restRequest.resultClass)
+    {
+        id result = cacheKey ? [self.restResponseCache objectOfClass:restRequest.resultClass forKey:cacheKey] : nil;
+        
+        if (!result)
         {
-            if (request.completion)
+            result = [MHVJsonSerializer deserialize:[[NSString alloc] initWithData:responseData encoding:NSUTF8StringEncoding]
+                                            toClass:restRequest.resultClass
+                                        shouldCache:YES];
+            
+            if (result && cacheKey)
             {
-                request.completion(nil, error);
+                [self.restResponseCache setObject:result ofClass:restRequest.resultClass forKey:cacheKey];
             }
-            
-            return;
         }
-        else
+        
+        // A kept result is shared with later requests, so callers each get a copy they can change
+        if (cacheKey && [result conformsToProtocol:@protocol(NSCopying)])
         {
-            [self parseResponse:response request:request isXML:NO completion:request.completion];
+            result = [result copy];
         }
-    }];
+        
+        serviceResponse.resultObject = result;
+    }
+    
+    request.completion(serviceResponse, nil);
 }
 
 - (void)executeBlobDownloadRequest:(MHVHttpServiceRequest *)request
 {
-    // TODO: Add cache support
     MHVBlobDownloadRequest *blobDownloadRequest = request.serviceOperation;
-
-    if (blobDownloadRequest.toFilePath)
+    NSString *cacheKey = blobDownloadRequest.blobCacheKey;
+    NSUInteger cacheGeneration = self.blobCache.generation;
+    
+    // A cached blob is returned without waiting for the scheduler or the network
+    if (cacheKey)
     {
-        //Download to file
-        [self.httpService downloadFileWithUrl:blobDownloadRequest.url
-                                   toFilePath:blobDownloadRequest.toFilePath
-                                   completion:^(NSError * _Nullable error)
-         {
-             if (request.completion)
-             {
-                 request.completion(nil, error);
-             }
-         }];
+        if (blobDownloadRequest.toFilePath)
+        {
+            if ([self.blobCache copyBlobForKey:cacheKey toFilePath:blobDownloadRequest.toFilePath])
+            {
+                if (request.completion)
+                {
+                    request.completion(nil, nil);
+                }
+                
+                return;
+            }
+        }
+        else
+        {
+            NSData *data = [self.blobCache dataForKey:cacheKey];
+            if (data)
+            {
+                MHVHttpServiceResponse *response = [[MHVHttpServiceResponse alloc] initWithResponseData:data statusCode:200];
+                
+                [self parseResponse:response request:request isXML:NO completion:request.completion];
+                
+                return;
+            }
+        }
     }
-    else
+
+    [self.scheduler scheduleWithPriority:blobDownloadRequest.priority request:^(MHVScheduledRequestFinished finished)
     {
-        //Download as data
-        [self.httpService sendRequestForURL:blobDownloadRequest.url
-                                 httpMethod:nil
-                                       body:nil
-                                    headers:nil
-                                 completion:^(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error)
-         {
-             if (error)
+        if (blobDownloadRequest.toFilePath)
+        {
+            //Download to file
+            [self.httpService downloadFileWithUrl:blobDownloadRequest.url
+                                       toFilePath:blobDownloadRequest.toFilePath
+                                       completion:^(NSError * _Nullable error)
              {
+                 finished();
+                 
+                 if (!error)
+                 {
+                     unsigned long long length = [[[NSFileManager defaultManager] attributesOfItemAtPath:blobDownloadRequest.toFilePath error:nil] fileSize];
+                     
+                     if ([self shouldCacheBlobWithLength:length request:blobDownloadRequest])
+                     {
+                         [self.blobCache setBlobWithFilePath:blobDownloadRequest.toFilePath forKey:cacheKey generation:cacheGeneration];
+                     }
+                 }
+                 
                  if (request.completion)
                  {
                      request.completion(nil, error);
                  }
-             }
-             else
+             }];
+        }
+        else
+        {
+            //Download as data
+            [self.httpService sendRequestForURL:blobDownloadRequest.url
+                                     httpMethod:nil
+                                           body:nil
+                                        headers:nil
+                                     completion:^(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error)
              {
-                 [self parseResponse:response request:request isXML:NO completion:request.completion];
-             }
-         }];
-    }
+                 finished();
+                 
+                 if (error)
+                 {
+                     if (request.completion)
+                     {
+                         request.completion(nil, error);
+                     }
+                 }
+                 else
+                 {
+                     if (!response.hasError && response.responseAsData &&
+                         [self shouldCacheBlobWithLength:response.responseAsData.length request:blobDownloadRequest])
+                     {
+                         [self.blobCache setData:response.responseAsData forKey:cacheKey generation:cacheGeneration];
+                     }
+                     
+                     [self parseResponse:response request:request isXML:NO completion:request.completion];
+                 }
+             }];
+        }
+    }];
 }
 
+// Only blobs of the length HealthVault returned are cached, so an error page downloaded to a file isn't kept
+- (BOOL)shouldCacheBlobWithLength:(unsigned long long)length request:(MHVBlobDownloadRequest *)request
+{
+    return request.blobCacheKey && length > 0 && (request.blobLength <= 0 || (unsigned long long)request.blobLength == length);
+}
 
 - (void)executeBlobUploadRequest:(MHVHttpServiceRequest *)request
 {
     MHVBlobUploadRequest *blobUploadRequest = request.serviceOperation;
+    MHVBlobHasher *blobHasher = nil;
+    
+    if (blobUploadRequest.shouldComputeHash)
+    {
+        NSUInteger hashBlockSize = blobUploadRequest.hashBlockSize ?: (NSUInteger)MAX(self.configuration.inlineBlobHashBlockSize, 0);
+        
+        blobHasher = hashBlockSize > 0 ? [[MHVBlobHasher alloc] initWithBlockSize:hashBlockSize] : nil;
+    }
+
+    NSUInteger cancelCount = [self currentBlobUploadCancelCount];
 
-    [self.httpService uploadBlobSource:blobUploadRequest.blobSource
-                                 toUrl:blobUploadRequest.destinationURL
-                             chunkSize:blobUploadRequest.chunkSize
-                            completion:^(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error)
+    [self.scheduler scheduleWithPriority:blobUploadRequest.priority request:^(MHVScheduledRequestFinished finished)
     {
-        if (error)
+        // An upload still waiting to be sent when uploads were cancelled isn't sent
+        if (cancelCount != [self currentBlobUploadCancelCount])
         {
+            finished();
+            
             if (request.completion)
             {
-                request.completion(nil, error);
+                request.completion(nil, [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]);
             }
             return;
         }
         
-        MHVServiceResponse *serviceResponse = [[MHVServiceResponse alloc] initWithWebResponse:response isXML:NO];
-        if (serviceResponse.error)
+        id<MHVHttpTaskProtocol> task = [self.httpService uploadBlobSource:blobUploadRequest.blobSource
+                                     toUrl:blobUploadRequest.destinationURL
+                                 chunkSize:blobUploadRequest.chunkSize
+                               startOffset:blobUploadRequest.startOffset
+                        storedChunkDigests:blobUploadRequest.storedChunkDigests
+                    committedLengthHandler:blobUploadRequest.committedLengthHandler
+                                blobHasher:blobHasher
+                                completion:^(MHVHttpServiceResponse * _Nullable response, NSError * _Nullable error)
         {
-            if (request.completion)
+            finished();
+        
+            if (error)
+            {
+                if (request.completion)
+                {
+                    request.completion(nil, error);
+                }
+                return;
+            }
+        
+            MHVServiceResponse *serviceResponse = [[MHVServiceResponse alloc] initWithWebResponse:response isXML:NO];
+            if (!serviceResponse.error && response.hasError)
             {
-                request.completion(nil, serviceResponse.error);
+                // A chunk that wasn't stored means the blob is incomplete, so it must not be attached to a thing.
+                // Blob storage refuses an expired or unknown upload URL with a 4xx status, which retrying won't fix
+                NSError *error = response.statusCode >= 500 ? [NSError MHVNetworkError] : [NSError MHVOperationCannotBePerformed];
+                serviceResponse.error = [NSError error:error withDescription:response.errorText];
             }
-        }
-        else
+            
+            if (serviceResponse.error)
+            {
+                if (request.completion)
+                {
+                    request.completion(nil, serviceResponse.error);
+                }
+            }
+            else
+            {
+                // Only a hash of every byte of the blob is kept
+                if (blobHasher && blobHasher.length == blobUploadRequest.blobSource.length)
+                {
+                    blobUploadRequest.hashInfo = [blobHasher hashInfo];
+                }
+                
+                if (request.completion)
+                {
+                    request.completion(serviceResponse, nil);
+                }
+            }
+        }];
+        
+        @synchronized (self.blobUploadTasks)
         {
-            if (request.completion)
+            if (task)
             {
-                request.completion(serviceResponse, nil);
+                [self.blobUploadTasks addObject:task];
             }
         }
     }];
 }
 
-- (NSString *)messageForMethod:(MHVMethod *)method
+- (NSUInteger)currentBlobUploadCancelCount
+{
+    @synchronized (self.blobUploadTasks)
+    {
+        return self.blobUploadCancelCount;
+    }
+}
+
+- (void)cancelBlobUploads
+{
+    NSArray<id<MHVHttpTaskProtocol>> *tasks = nil;
+    
+    @synchronized (self.blobUploadTasks)
+    {
+        self.blobUploadCancelCount += 1;
+        tasks = self.blobUploadTasks.allObjects;
+        [self.blobUploadTasks removeAllObjects];
+    }
+    
+    for (id<MHVHttpTaskProtocol> task in tasks)
+    {
+        [task cancel];
+    }
+}
+
+- (NSData *)messageForMethod:(MHVMethod *)method contentEncoding:(NSString **)contentEncoding
 {
     MHVRequestMessageCreator *creator = [[MHVRequestMessageCreator alloc] initWithMethod:method
-                                                                            sharedSecret:self.sessionCredential.sharedSecret
-                                                                             authSession:[self authSession]
-                                                                           configuration:self.configuration
-                                                                                   appId:self.applicationId
+                                                                               fragments:[self messageFragments]
                                                                              messageTime:[NSDate date]
                                                                            cryptographer:[MHVCryptographer new]];
     
-    return creator.xmlString;
+    NSData *message = creator.xmlData;
+    NSString *compressionMethod = self.configuration.requestCompressionMethod;
+    
+    // Large bodies are mostly PutThings XML, which compresses well
+    if (compressionMethod && message.length > self.configuration.requestCompressionThreshold)
+    {
+        NSData *compressed = [message compressedDataWithContentEncoding:compressionMethod];
+        if (compressed && compressed.length < message.length)
+        {
+            *contentEncoding = compressionMethod;
+            return compressed;
+        }
+    }
+    
+    *contentEncoding = nil;
+    return message;
+}
+
+- (MHVRequestMessageFragments *)messageFragments
+{
+    NSString *sharedSecret = self.sessionCredential.sharedSecret;
+    MHVAuthSession *authSession = [self authSession];
+    NSUUID *appId = self.applicationId;
+    
+    @synchronized (self)
+    {
+        // The header fragments only change when the session does, so they are reused across requests
+        if (![_messageFragments matchesSharedSecret:sharedSecret authSession:authSession configuration:self.configuration appId:appId])
+        {
+            _messageFragments = [[MHVRequestMessageFragments alloc] initWithSharedSecret:sharedSecret
+                                                                             authSession:authSession
+                                                                           configuration:self.configuration
+                                                                                   appId:appId];
+        }
+        
+        return _messageFragments;
+    }
 }
 
-- (NSDictionary<NSString *, NSString *> *)headersForMethod:(MHVMethod *)method
+- (NSDictionary<NSString *, NSString *> *)headersForMethod:(MHVMethod *)method contentEncoding:(NSString *_Nullable)contentEncoding
 {
     NSUUID *correlationId = method.correlationId != nil ? method.correlationId : [NSUUID new];
     
+    if (contentEncoding)
+    {
+        return @{kCorrelationIdContextKey : correlationId.UUIDString,
+                 @"Content-Encoding" : contentEncoding};
+    }
+    
     return @{kCorrelationIdContextKey : correlationId.UUIDString};
 }
 
@@ -507,6 +1110,10 @@ static NSInteger kInternalServerError = 500;
         
         serviceResponse = nil;
     }
+    else if (request.responseCacheKey)
+    {
+        [self.responseCache setResponse:response forKey:request.responseCacheKey generation:request.responseCacheGeneration];
+    }
 
     if (completion)
     {
@@ -519,19 +1126,60 @@ static NSInteger kInternalServerError = 500;
     }
 }
 
-- (void)retryRequest:(MHVHttpServiceRequest *)request
+// Returns YES if the request will be sent again after a delay
+- (BOOL)retryRequest:(MHVHttpServiceRequest *)request
+          statusCode:(NSInteger)statusCode
+             headers:(NSDictionary<NSString *, NSString *> *_Nullable)headers
+               error:(NSError *_Nullable)error
 {
+    // A request that timed out, or failed at a gateway, may have been handled, so only retry it if doing so twice is harmless
+    if (![self isReadOnlyOperation:request.serviceOperation])
+    {
+        if ([self.configuration.retryPolicy.readOnlyRetryableStatusCodes containsObject:@(statusCode)])
+        {
+            return NO;
+        }
+        
+        error = nil;
+    }
+    
+    NSTimeInterval delay = [self.configuration.retryPolicy retryDelayForAttempt:request.retryAttempts
+                                                                     statusCode:statusCode
+                                                                        headers:headers
+                                                                          error:error];
+    if (delay < 0)
+    {
+        return NO;
+    }
+    
     request.retryAttempts += 1;
     
-    MHVLOG(@"500 error from server, retrying in %0.1f seconds", self.configuration.retryOnInternal500SleepDuration);
+    MHVLOG(@"Transient error from server (%li %@), retry %li in %0.2f seconds",
+           (long)statusCode, error.localizedDescription ?: @"", (long)request.retryAttempts, delay);
+    
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^
+    {
+        [self executeHttpServiceRequest:request];
+    });
+    
+    return YES;
+}
 
-    // Dispatch to main queue, so it holds a reference to the internal timer used by performSelector:withObject:afterDelay:
-    [[NSOperationQueue mainQueue] addOperationWithBlock:^
+- (BOOL)isReadOnlyOperation:(id<MHVHttpServiceOperationProtocol>)operation
+{
+    if ([operation isKindOfClass:[MHVMethod class]])
     {
-        [self performSelector:@selector(executeHttpServiceRequest:)
-                   withObject:request
-                   afterDelay:self.configuration.retryOnInternal500SleepDuration];
-    }];
+        return ((MHVMethod *)operation).isReadOnly;
+    }
+    
+    if ([operation isKindOfClass:[MHVRestRequest class]])
+    {
+        NSString *httpMethod = ((MHVRestRequest *)operation).httpMethod;
+        
+        return !httpMethod || [httpMethod isEqualToString:@"GET"];
+    }
+    
+    return NO;
 }
 
 - (void)refreshSessionCredentialWithCompletion:(void(^_Nullable)(NSError *_Nullable error))completion
@@ -558,44 +1206,83 @@ static NSInteger kInternalServerError = 500;
     
     dispatch_async(self.completionQueue, ^
     {
-        [self.requests addObject:request];
-        
-        if (self.requests.count > 1)
+        // Another request already refreshed the credential after this one was sent, so it only needs sending again
+        if (self.requests.count == 0 &&
+            request.sessionToken &&
+            ![request.sessionToken isEqualToString:self.sessionCredential.token])
         {
+            [self sendHttpServiceRequest:request];
             return;
         }
         
-        MHVLOG(@"Refreshing Credentials");
-        
-        [self refreshSessionCredentialWithCompletion:^(NSError * _Nullable error)
+        [self waitForRefreshedCredentialWithRequest:request];
+    });
+}
+
+// Must be called on the completionQueue. Only the first waiting request starts a refresh.
+- (void)waitForRefreshedCredentialWithRequest:(MHVHttpServiceRequest *)request
+{
+    [self.requests addObject:request];
+    
+    if (self.requests.count > 1)
+    {
+        return;
+    }
+    
+    MHVLOG(@"Refreshing Credentials");
+    
+    MHVSessionCredential *credential = self.sessionCredential;
+    
+    [self refreshSessionCredentialWithCompletion:^(NSError * _Nullable error)
+    {
+        dispatch_async(self.completionQueue, ^
         {
-            dispatch_async(self.completionQueue, ^
+            NSArray<MHVHttpServiceRequest *> *requests = [self.requests copy];
+            [self.requests removeAllObjects];
+            
+            if (error)
             {
-                MHVLOG(@"Refreshed token, re-issuing %li request(s)", (unsigned long)self.requests.count);
+                MHVLOG(@"Refreshing token failed: %@", error.localizedDescription);
                 
-                while (self.requests.count > 0)
+                // Keep using the credential until it is rejected, instead of trying again for every request
+                self.unrefreshedSessionCredential = credential;
+            }
+            else
+            {
+                MHVLOG(@"Refreshed token, re-issuing %li request(s)", (unsigned long)requests.count);
+            }
+            
+            for (MHVHttpServiceRequest *waitingRequest in requests)
+            {
+                if (error && waitingRequest.hasRefreshedToken)
                 {
-                    MHVHttpServiceRequest *request = [self.requests firstObject];
-                    
-                    [self.requests removeObject:request];
-                    
-                    if (error)
-                    {
-                        if (request.completion)
-                        {
-                            request.completion(nil, error);
-                        }
-                        
-                        return;
-                    }
-                    else
+                    if (waitingRequest.completion)
                     {
-                        [self executeHttpServiceRequest:request];
+                        waitingRequest.completion(nil, error);
                     }
                 }
-            });
-        }];
-    });
+                else
+                {
+                    // Requests that haven't been rejected can still be sent if the credential wasn't refreshed ahead of time
+                    [self sendHttpServiceRequest:waitingRequest];
+                }
+            }
+        });
+    }];
+}
+
+// Must be called on the completionQueue
+- (BOOL)sessionCredentialNeedsRefresh
+{
+    NSTimeInterval refreshInterval = self.configuration.sessionCredentialRefreshInterval;
+    MHVSessionCredential *credential = self.sessionCredential;
+    
+    if (refreshInterval <= 0 || !credential.createdDate || credential == self.unrefreshedSessionCredential)
+    {
+        return NO;
+    }
+    
+    return -[credential.createdDate timeIntervalSinceNow] >= refreshInterval;
 }
 
 - (void)performBackgroundTasks:(void(^_Nullable)(MHVConnectionTaskResult *taskResult))completion
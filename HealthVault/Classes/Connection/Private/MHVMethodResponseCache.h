@@ -0,0 +1,99 @@
+//
+//  MHVMethodResponseCache.h
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+@class MHVMethod, MHVServiceResponse, MHVHttpServiceResponse;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Keeps responses to read-only methods, so they can be returned without asking the service again.
+
+ Responses are kept parsed in memory and as the raw response on disk, so they outlive the app.
+ A key is "<record id>/<method name>/<hash of the request>", which groups the responses that
+ a write to a record makes out of date. Writes are matched to the reads they affect by method
+ name, e.g. PutThings and RemoveThings remove the record's GetThings responses.
+ */
+@interface MHVMethodResponseCache : NSObject
+
+/**
+ Caches/MHVMethodResponses in the app's container
+ */
++ (NSURL *)defaultDirectoryURL;
+
+/**
+ Create a cache
+
+ @param directoryURL Where responses are written. nil keeps responses in memory only.
+ */
+- (instancetype)initWithDirectoryURL:(NSURL *_Nullable)directoryURL;
+
+/**
+ The key a method's response is kept under.
+
+ @param method The method
+ @param personId The person the method is sent for, so people sharing a device don't share responses
+ @return The key
+ */
+- (NSString *)keyForMethod:(MHVMethod *)method personId:(NSUUID *_Nullable)personId;
+
+/**
+ Changes each time responses under the key are made out of date. A response is only kept if
+ the generation is the same as when its request was sent.
+ */
+- (NSUInteger)generationForKey:(NSString *)key;
+
+/**
+ Get a response
+
+ @param key The response's key
+ @param timeToLive How long after it was received the response is current
+ @param staleDuration How long after it is no longer current the response can still be returned
+ @param isStale Set to YES if the response is no longer current, and should be fetched again
+ @return The response, or nil if there isn't one that can be returned
+ */
+- (MHVServiceResponse *_Nullable)responseForKey:(NSString *)key
+                                     timeToLive:(NSTimeInterval)timeToLive
+                                  staleDuration:(NSTimeInterval)staleDuration
+                                        isStale:(BOOL *)isStale;
+
+/**
+ Keep a response. Ignored if responses under the key were made out of date since generation.
+
+ @param response The HTTP response to the method
+ @param key The response's key
+ @param generation generationForKey: when the request was sent
+ */
+- (void)setResponse:(MHVHttpServiceResponse *)response forKey:(NSString *)key generation:(NSUInteger)generation;
+
+/**
+ Remove the responses a method makes out of date, if it changes the record it's sent for.
+
+ @param method A method that has been, or is about to be, sent
+ */
+- (void)removeResponsesChangedByMethod:(MHVMethod *)method;
+
+/**
+ Remove every response, e.g. when the person signs out.
+ */
+- (void)removeAllResponses;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,311 @@
+//
+//  MHVMethodResponseCache.m
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "MHVMethodResponseCache.h"
+#import "MHVValidator.h"
+#import "MHVLogger.h"
+#import "MHVMethod.h"
+#import "MHVServiceResponse.h"
+#import "MHVHttpServiceResponse.h"
+#import "MHVResponseCacheGenerations.h"
+#import "NSData+Utils.h"
+
+static NSString *const kNoRecordKeyComponent = @"none";
+static NSString *const kDateKey = @"date";
+static NSString *const kStatusCodeKey = @"statusCode";
+static NSString *const kDataKey = @"data";
+static NSUInteger const kMemoryCountLimit = 200;
+
+@interface MHVCachedMethodResponse : NSObject
+
+@property (nonatomic, strong) MHVServiceResponse *response;
+@property (nonatomic, strong) NSDate *date;
+@property (nonatomic, assign) NSUInteger generation;
+
+@end
+
+@implementation MHVCachedMethodResponse
+
+@end
+
+@interface MHVMethodResponseCache ()
+
+@property (nonatomic, strong) NSURL *directoryURL;
+@property (nonatomic, strong) NSCache<NSString *, MHVCachedMethodResponse *> *memoryCache;
+@property (nonatomic, strong) NSFileManager *fileManager;
+
+// Generations by "<record id>/<method name>", and the queue disk reads and writes are made on
+@property (nonatomic, strong) MHVResponseCacheGenerations *generations;
+
+@end
+
+@implementation MHVMethodResponseCache
+
++ (NSURL *)defaultDirectoryURL
+{
+    NSURL *cachesURL = [[[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory inDomains:NSUserDomainMask] lastObject];
+
+    return [cachesURL URLByAppendingPathComponent:@"MHVMethodResponses" isDirectory:YES];
+}
+
+- (instancetype)initWithDirectoryURL:(NSURL *_Nullable)directoryURL
+{
+    self = [super init];
+
+    if (self)
+    {
+        _directoryURL = directoryURL;
+        _memoryCache = [NSCache new];
+        _memoryCache.countLimit = kMemoryCountLimit;
+        _fileManager = [NSFileManager new];
+        _generations = [[MHVResponseCacheGenerations alloc] initWithLabel:@"MHVMethodResponseCache.ioQueue"];
+    }
+
+    return self;
+}
+
+- (NSString *)keyForMethod:(MHVMethod *)method personId:(NSUUID *_Nullable)personId
+{
+    MHVASSERT_PARAMETER(method);
+
+    NSString *request = [NSString stringWithFormat:@"%@|%li|%@|%@|", method.name, (long)method.version, personId.UUIDString ?: @"", method.recordId.UUIDString ?: @""];
+
+    NSMutableData *canonical = [[request dataUsingEncoding:NSUTF8StringEncoding] mutableCopy];
+
+    // Large parameters are often already hashed as they were written
+    if (method.parametersHash)
+    {
+        [canonical appendData:[method.parametersHash dataUsingEncoding:NSUTF8StringEncoding]];
+    }
+    else if (method.parametersData)
+    {
+        [canonical appendData:method.parametersData];
+    }
+    else if (method.parameters)
+    {
+        [canonical appendData:[method.parameters dataUsingEncoding:NSUTF8StringEncoding]];
+    }
+
+    return [NSString stringWithFormat:@"%@/%@/%@", [self recordKeyComponentForMethod:method], method.name, [canonical SHA256]];
+}
+
+- (NSUInteger)generationForKey:(NSString *)key
+{
+    return [self.generations generationForKey:key];
+}
+
+- (MHVServiceResponse *_Nullable)responseForKey:(NSString *)key
+                                     timeToLive:(NSTimeInterval)timeToLive
+                                  staleDuration:(NSTimeInterval)staleDuration
+                                        isStale:(BOOL *)isStale
+{
+    MHVASSERT_PARAMETER(key);
+
+    NSUInteger generation = [self generationForKey:key];
+
+    MHVCachedMethodResponse *cached = [self.memoryCache objectForKey:key];
+    if (cached && cached.generation != generation)
+    {
+        [self.memoryCache removeObjectForKey:key];
+        cached = nil;
+    }
+
+    if (!cached && self.directoryURL)
+    {
+        cached = [self readResponseForKey:key];
+        cached.generation = generation;
+
+        if (cached)
+        {
+            [self.memoryCache setObject:cached forKey:key];
+        }
+    }
+
+    if (!cached)
+    {
+        return nil;
+    }
+
+    NSTimeInterval age = -[cached.date timeIntervalSinceNow];
+
+    if (age >= timeToLive + staleDuration)
+    {
+        [self removeResponseForKey:key];
+        return nil;
+    }
+
+    *isStale = age >= timeToLive;
+
+    return cached.response;
+}
+
+- (void)setResponse:(MHVHttpServiceResponse *)response forKey:(NSString *)key generation:(NSUInteger)generation
+{
+    MHVASSERT_PARAMETER(response);
+    MHVASSERT_PARAMETER(key);
+
+    if (!response.responseAsData || response.hasError)
+    {
+        return;
+    }
+
+    // A write to the record finished while this was being read, so the response may be out of date
+    if (generation != [self generationForKey:key])
+    {
+        return;
+    }
+
+    MHVCachedMethodResponse *cached = [MHVCachedMethodResponse new];
+    cached.response = [[MHVServiceResponse alloc] initWithWebResponse:response isXML:YES];
+    cached.date = [NSDate date];
+    cached.generation = generation;
+
+    [self.memoryCache setObject:cached forKey:key];
+
+    if (!self.directoryURL)
+    {
+        return;
+    }
+
+    NSDictionary *entry = @{kDateKey : cached.date,
+                            kStatusCodeKey : @(response.statusCode),
+                            kDataKey : response.responseAsData};
+
+    [self.generations writeForKey:key generation:generation block:^
+    {
+        NSData *data = [NSPropertyListSerialization dataWithPropertyList:entry format:NSPropertyListBinaryFormat_v1_0 options:0 error:nil];
+        NSURL *fileURL = [self.directoryURL URLByAppendingPathComponent:key];
+
+        [self.fileManager createDirectoryAtURL:[fileURL URLByDeletingLastPathComponent]
+                   withIntermediateDirectories:YES
+                                    attributes:@{NSFileProtectionKey : NSFileProtectionComplete}
+                                         error:nil];
+
+        NSError *error = nil;
+        if (![data writeToURL:fileURL options:NSDataWritingAtomic | NSDataWritingFileProtectionComplete error:&error])
+        {
+            MHVLOG(@"Could not write cached %@ response: %@", [key pathComponents][1], error.localizedDescription);
+        }
+    }];
+}
+
+- (void)removeResponsesChangedByMethod:(MHVMethod *)method
+{
+    MHVASSERT_PARAMETER(method);
+
+    NSArray<NSString *> *changedMethodNames = [MHVMethodResponseCache changedMethodNamesByMethodName][method.name];
+    if (!changedMethodNames || !method.recordId)
+    {
+        return;
+    }
+
+    NSString *recordKeyComponent = [self recordKeyComponentForMethod:method];
+
+    for (NSString *methodName in changedMethodNames)
+    {
+        NSString *group = [NSString stringWithFormat:@"%@/%@", recordKeyComponent, methodName];
+
+        // Responses in memory are dropped when they're next read with the new generation
+        [self.generations incrementGenerationForGroup:group];
+
+        if (self.directoryURL)
+        {
+            [self.generations write:^
+            {
+                [self.fileManager removeItemAtURL:[self.directoryURL URLByAppendingPathComponent:group isDirectory:YES] error:nil];
+            }];
+        }
+    }
+}
+
+- (void)removeAllResponses
+{
+    [self.generations incrementAllGenerations];
+
+    [self.memoryCache removeAllObjects];
+
+    if (self.directoryURL)
+    {
+        [self.generations write:^
+        {
+            [self.fileManager removeItemAtURL:self.directoryURL error:nil];
+        }];
+    }
+}
+
+#pragma mark - Internal methods
+
+// Reads made out of date by each write to a record
++ (NSDictionary<NSString *, NSArray<NSString *> *> *)changedMethodNamesByMethodName
+{
+    return @{@"PutThings" : @[@"GetThings"],
+             @"RemoveThings" : @[@"GetThings"]};
+}
+
+- (NSString *)recordKeyComponentForMethod:(MHVMethod *)method
+{
+    return method.recordId ? method.recordId.UUIDString : kNoRecordKeyComponent;
+}
+
+- (MHVCachedMethodResponse *_Nullable)readResponseForKey:(NSString *)key
+{
+    __block NSData *data = nil;
+
+    [self.generations read:^
+    {
+        data = [NSData dataWithContentsOfURL:[self.directoryURL URLByAppendingPathComponent:key]];
+    }];
+
+    if (!data)
+    {
+        return nil;
+    }
+
+    NSDictionary *entry = [NSPropertyListSerialization propertyListWithData:data options:NSPropertyListImmutable format:nil error:nil];
+    if (![entry isKindOfClass:[NSDictionary class]] ||
+        ![entry[kDateKey] isKindOfClass:[NSDate class]] ||
+        ![entry[kDataKey] isKindOfClass:[NSData class]])
+    {
+        [self removeResponseForKey:key];
+        return nil;
+    }
+
+    MHVHttpServiceResponse *response = [[MHVHttpServiceResponse alloc] initWithResponseData:entry[kDataKey]
+                                                                                 statusCode:[entry[kStatusCodeKey] integerValue]];
+
+    MHVCachedMethodResponse *cached = [MHVCachedMethodResponse new];
+    cached.response = [[MHVServiceResponse alloc] initWithWebResponse:response isXML:YES];
+    cached.date = entry[kDateKey];
+
+    return cached;
+}
+
+- (void)removeResponseForKey:(NSString *)key
+{
+    [self.memoryCache removeObjectForKey:key];
+
+    if (self.directoryURL)
+    {
+        [self.generations write:^
+        {
+            [self.fileManager removeItemAtURL:[self.directoryURL URLByAppendingPathComponent:key] error:nil];
+        }];
+    }
+}
+
+@end
@@ -0,0 +1,61 @@
+//
+//  MHVRequestScheduler.h
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+#import "MHVHttpServiceOperationProtocol.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Called by a scheduled request once its HTTP request has finished, so the next one can start.
+ */
+typedef void (^MHVScheduledRequestFinished)(void);
+
+/**
+ Decides when each HTTP request is sent.
+ 
+ Requests wait in one queue per priority. Whenever a request finishes, the next one is taken from
+ the most important queue that is under its limit, so a long run of background requests gives way
+ to an interactive request at the next request boundary. Running requests are never cancelled.
+ */
+@interface MHVRequestScheduler : NSObject
+
+/**
+ The most requests in progress at once, across all priorities. Defaults to 6.
+ */
+@property (nonatomic, assign) NSUInteger maxConcurrentRequests;
+
+/**
+ The most requests with the priority in progress at once.
+ Defaults to 6 interactive, 4 user initiated, 2 background sync and 2 blob transfer.
+ */
+- (NSUInteger)limitForPriority:(MHVRequestPriority)priority;
+- (void)setLimit:(NSUInteger)limit forPriority:(MHVRequestPriority)priority;
+
+/**
+ Schedule a request
+
+ @param priority The request's priority
+ @param request Invoked on a background queue when the request can be sent.
+        It must call finished exactly once, when the HTTP request completes.
+ */
+- (void)scheduleWithPriority:(MHVRequestPriority)priority request:(void (^)(MHVScheduledRequestFinished finished))request;
+
+@end
+
+NS_ASSUME_NONNULL_END
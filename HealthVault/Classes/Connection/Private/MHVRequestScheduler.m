@@ -0,0 +1,183 @@
+//
+//  MHVRequestScheduler.m
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "MHVRequestScheduler.h"
+#import "MHVValidator.h"
+
+typedef void (^MHVScheduledRequest)(MHVScheduledRequestFinished finished);
+
+static NSUInteger const kDefaultMaxConcurrentRequests = 6;
+static NSUInteger const kDefaultLimits[MHVRequestPriorityCount] = { 6, 4, 2, 2 };
+
+@interface MHVRequestScheduler ()
+{
+    NSUInteger _limits[MHVRequestPriorityCount];
+    NSUInteger _running[MHVRequestPriorityCount];
+}
+
+// Only used on the queue
+@property (nonatomic, strong) NSArray<NSMutableArray<MHVScheduledRequest> *> *waiting;
+@property (nonatomic, assign) NSUInteger runningCount;
+@property (nonatomic, strong) dispatch_queue_t queue;
+
+@end
+
+@implementation MHVRequestScheduler
+
+- (instancetype)init
+{
+    self = [super init];
+    
+    if (self)
+    {
+        NSMutableArray *waiting = [NSMutableArray new];
+        for (NSInteger priority = 0; priority < MHVRequestPriorityCount; priority++)
+        {
+            [waiting addObject:[NSMutableArray new]];
+            _limits[priority] = kDefaultLimits[priority];
+        }
+        
+        _waiting = waiting;
+        _maxConcurrentRequests = kDefaultMaxConcurrentRequests;
+        _queue = dispatch_queue_create("MHVRequestScheduler.queue", DISPATCH_QUEUE_SERIAL);
+    }
+    
+    return self;
+}
+
+- (NSUInteger)limitForPriority:(MHVRequestPriority)priority
+{
+    MHVASSERT(priority >= 0 && priority < MHVRequestPriorityCount);
+    
+    __block NSUInteger limit = 0;
+    dispatch_sync(self.queue, ^
+    {
+        limit = self->_limits[priority];
+    });
+    
+    return limit;
+}
+
+- (void)setLimit:(NSUInteger)limit forPriority:(MHVRequestPriority)priority
+{
+    MHVASSERT(priority >= 0 && priority < MHVRequestPriorityCount);
+    MHVASSERT(limit > 0);
+    
+    dispatch_sync(self.queue, ^
+    {
+        self->_limits[priority] = MAX(limit, 1);
+        [self startWaitingRequests];
+    });
+}
+
+- (void)setMaxConcurrentRequests:(NSUInteger)maxConcurrentRequests
+{
+    MHVASSERT(maxConcurrentRequests > 0);
+    
+    dispatch_sync(self.queue, ^
+    {
+        self->_maxConcurrentRequests = MAX(maxConcurrentRequests, 1);
+        [self startWaitingRequests];
+    });
+}
+
+- (void)scheduleWithPriority:(MHVRequestPriority)priority request:(void (^)(MHVScheduledRequestFinished finished))request
+{
+    MHVASSERT_PARAMETER(request);
+    
+    if (priority < 0 || priority >= MHVRequestPriorityCount)
+    {
+        priority = MHVRequestPriorityUserInitiated;
+    }
+    
+    dispatch_async(self.queue, ^
+    {
+        [self.waiting[priority] addObject:request];
+        [self startWaitingRequests];
+    });
+}
+
+#pragma mark - Internal methods
+
+// Must be called on the queue
+- (void)startWaitingRequests
+{
+    for (NSInteger priority = 0; priority < MHVRequestPriorityCount; priority++)
+    {
+        NSMutableArray<MHVScheduledRequest> *waiting = self.waiting[priority];
+        
+        while (waiting.count > 0 && self->_running[priority] < self->_limits[priority])
+        {
+            if (self.runningCount >= self->_maxConcurrentRequests)
+            {
+                return;
+            }
+            
+            MHVScheduledRequest request = waiting.firstObject;
+            [waiting removeObjectAtIndex:0];
+            
+            self->_running[priority] += 1;
+            self.runningCount += 1;
+            
+            [self startRequest:request priority:priority];
+        }
+    }
+}
+
+- (void)startRequest:(MHVScheduledRequest)request priority:(MHVRequestPriority)priority
+{
+    __block BOOL isFinished = NO;
+    
+    MHVScheduledRequestFinished finished = ^
+    {
+        dispatch_async(self.queue, ^
+        {
+            MHVASSERT(!isFinished);
+            if (isFinished)
+            {
+                return;
+            }
+            isFinished = YES;
+            
+            self->_running[priority] -= 1;
+            self.runningCount -= 1;
+            
+            [self startWaitingRequests];
+        });
+    };
+    
+    dispatch_async(dispatch_get_global_queue([self qosForPriority:priority], 0), ^
+    {
+        request(finished);
+    });
+}
+
+- (qos_class_t)qosForPriority:(MHVRequestPriority)priority
+{
+    switch (priority)
+    {
+        case MHVRequestPriorityInteractive:
+            return QOS_CLASS_USER_INTERACTIVE;
+        case MHVRequestPriorityUserInitiated:
+            return QOS_CLASS_USER_INITIATED;
+        default:
+            return QOS_CLASS_UTILITY;
+    }
+}
+
+@end
@@ -0,0 +1,78 @@
+//
+//  MHVResponseCacheGenerations.h
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Tracks when a response cache's entries go out of date, and orders its disk reads and writes.
+
+ A key is "<group>/<name>", and each group has a generation that changes when its responses are made
+ out of date. A response is only kept if its group's generation is the same as when its request was sent.
+ Removing responses changes the generation before the files are removed, and a write only happens if the
+ generation is still the same when it runs, so a response read before a removal is never written after it.
+ */
+@interface MHVResponseCacheGenerations : NSObject
+
+/**
+ Create the generations for a cache
+
+ @param label The label of the queue disk reads and writes are made on
+ */
+- (instancetype)initWithLabel:(NSString *)label;
+
+/**
+ The generation of the key's group
+ */
+- (NSUInteger)generationForKey:(NSString *)key;
+
+/**
+ Make the responses in a group out of date
+
+ @param group The group, the key without its last path component
+ */
+- (void)incrementGenerationForGroup:(NSString *)group;
+
+/**
+ Make every response out of date
+ */
+- (void)incrementAllGenerations;
+
+/**
+ Run a disk read, and wait for it
+ */
+- (void)read:(dispatch_block_t)block;
+
+/**
+ Run a disk write or removal after the reads and writes before it
+ */
+- (void)write:(dispatch_block_t)block;
+
+/**
+ Run a disk write after the reads and writes before it, if the key's generation is still the same then
+
+ @param key The key being written
+ @param generation generationForKey: when the response was read
+ @param block The write
+ */
+- (void)writeForKey:(NSString *)key generation:(NSUInteger)generation block:(dispatch_block_t)block;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,101 @@
+//
+//  MHVResponseCacheGenerations.m
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "MHVResponseCacheGenerations.h"
+#import "MHVValidator.h"
+
+@interface MHVResponseCacheGenerations ()
+
+// Disk reads are synchronous and writes asynchronous, both in order on this queue
+@property (nonatomic, strong) dispatch_queue_t ioQueue;
+
+// Generations by group. Guarded by @synchronized (self)
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *generations;
+@property (nonatomic, assign) NSUInteger removeAllCount;
+
+@end
+
+@implementation MHVResponseCacheGenerations
+
+- (instancetype)init
+{
+    return [self initWithLabel:@"MHVResponseCacheGenerations.ioQueue"];
+}
+
+- (instancetype)initWithLabel:(NSString *)label
+{
+    MHVASSERT_PARAMETER(label);
+
+    self = [super init];
+
+    if (self)
+    {
+        _ioQueue = dispatch_queue_create(label.UTF8String, DISPATCH_QUEUE_SERIAL);
+        _generations = [NSMutableDictionary new];
+    }
+
+    return self;
+}
+
+- (NSUInteger)generationForKey:(NSString *)key
+{
+    @synchronized (self)
+    {
+        return self.generations[[key stringByDeletingLastPathComponent]].unsignedIntegerValue + self.removeAllCount;
+    }
+}
+
+- (void)incrementGenerationForGroup:(NSString *)group
+{
+    @synchronized (self)
+    {
+        self.generations[group] = @(self.generations[group].unsignedIntegerValue + 1);
+    }
+}
+
+- (void)incrementAllGenerations
+{
+    @synchronized (self)
+    {
+        self.removeAllCount += 1;
+    }
+}
+
+- (void)read:(dispatch_block_t)block
+{
+    dispatch_sync(self.ioQueue, block);
+}
+
+- (void)write:(dispatch_block_t)block
+{
+    dispatch_async(self.ioQueue, block);
+}
+
+- (void)writeForKey:(NSString *)key generation:(NSUInteger)generation block:(dispatch_block_t)block
+{
+    dispatch_async(self.ioQueue, ^
+    {
+        // A removal changes the generation before it is queued, so while the generation is the same it runs after this write
+        if (generation == [self generationForKey:key])
+        {
+            block();
+        }
+    });
+}
+
+@end
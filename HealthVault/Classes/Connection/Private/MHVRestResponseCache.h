@@ -0,0 +1,144 @@
+//
+//  MHVRestResponseCache.h
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+@class MHVRestRequest, MHVHttpServiceResponse;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A REST response kept by MHVRestResponseCache
+ */
+@interface MHVCachedRestResponse : NSObject
+
+@property (nonatomic, strong, readonly) NSData *responseData;
+@property (nonatomic, strong, readonly, nullable) NSString *etag;
+@property (nonatomic, strong, readonly) NSDate *date;
+@property (nonatomic, assign, readonly) NSTimeInterval maxAge;
+
+/**
+ YES while the response is younger than its Cache-Control max-age, so it can be used without asking the service
+ */
+@property (nonatomic, assign, readonly) BOOL isFresh;
+
+@end
+
+/**
+ Keeps responses to REST GET requests following HTTP caching: a response is used without a request while
+ it is younger than its Cache-Control max-age, and after that is revalidated with its ETag. Responses marked
+ no-store, or with neither a max-age nor an ETag, aren't kept.
+
+ The models deserialized from a response are kept with it, in memory and on disk, so a response that is
+ used again isn't deserialized again. A key is "<first path component>/<hash of the request>", and a
+ POST, PUT, PATCH or DELETE removes the responses under its first path component, e.g. a PATCH to
+ /ActionPlans/{id} removes every kept /ActionPlans response.
+ */
+@interface MHVRestResponseCache : NSObject
+
+/**
+ Caches/MHVRestResponses in the app's container
+ */
++ (NSURL *)defaultDirectoryURL;
+
+/**
+ Create a cache. Responses on disk that haven't been used for a week are removed.
+
+ @param directoryURL Where responses are written. nil keeps responses in memory only.
+ */
+- (instancetype)initWithDirectoryURL:(NSURL *_Nullable)directoryURL;
+
+/**
+ The key a request's response is kept under. The request's url must be set.
+
+ @param request The request
+ @param personId The person the request is sent for
+ @param recordId The record the request is sent for
+ @param version The REST API version the request is sent with
+ @return The key
+ */
+- (NSString *)keyForRequest:(MHVRestRequest *)request
+                   personId:(NSUUID *_Nullable)personId
+                   recordId:(NSUUID *_Nullable)recordId
+                    version:(NSString *_Nullable)version;
+
+/**
+ Changes each time responses under the key are made out of date. A response is only kept if
+ the generation is the same as when its request was sent.
+ */
+- (NSUInteger)generationForKey:(NSString *)key;
+
+/**
+ Get a response, fresh or not
+
+ @param key The response's key
+ @return The response, or nil if there isn't one
+ */
+- (MHVCachedRestResponse *_Nullable)responseForKey:(NSString *)key;
+
+/**
+ Keep a response if its headers allow it, replacing the response and models kept under the key.
+
+ @param response A successful response
+ @param key The response's key
+ @param generation generationForKey: when the request was sent
+ */
+- (void)setResponse:(MHVHttpServiceResponse *)response forKey:(NSString *)key generation:(NSUInteger)generation;
+
+/**
+ Update a response's freshness from the headers of a 304 Not Modified response.
+
+ @param key The response's key
+ @param headers The 304 response's headers
+ @return The updated response, or nil if there isn't one
+ */
+- (MHVCachedRestResponse *_Nullable)refreshResponseForKey:(NSString *)key headers:(NSDictionary<NSString *, NSString *> *_Nullable)headers;
+
+/**
+ Get the model a kept response was deserialized into
+
+ @param resultClass The class the response was deserialized into
+ @param key The response's key
+ @return The model, or nil if there isn't one
+ */
+- (id _Nullable)objectOfClass:(Class)resultClass forKey:(NSString *)key;
+
+/**
+ Keep the model a kept response was deserialized into. Ignored if no response is kept under the key.
+
+ @param object The model
+ @param resultClass The class the response was deserialized into
+ @param key The response's key
+ */
+- (void)setObject:(id)object ofClass:(Class)resultClass forKey:(NSString *)key;
+
+/**
+ Remove the responses a request makes out of date, if it isn't a GET.
+
+ @param request A request that has been, or is about to be, sent
+ */
+- (void)removeResponsesChangedByRequest:(MHVRestRequest *)request;
+
+/**
+ Remove every response, e.g. when the person signs out.
+ */
+- (void)removeAllResponses;
+
+@end
+
+NS_ASSUME_NONNULL_END
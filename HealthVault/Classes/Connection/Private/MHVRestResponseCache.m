@@ -0,0 +1,531 @@
+//
+//  MHVRestResponseCache.m
+//  MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "MHVRestResponseCache.h"
+#import "MHVValidator.h"
+#import "MHVLogger.h"
+#import "MHVRestRequest.h"
+#import "MHVHttpServiceResponse.h"
+#import "MHVResponseCacheGenerations.h"
+#import "NSData+Utils.h"
+
+static NSString *const kResponseFileName = @"response";
+static NSString *const kRootGroup = @"root";
+static NSString *const kDateKey = @"date";
+static NSString *const kMaxAgeKey = @"maxAge";
+static NSString *const kETagKey = @"etag";
+static NSString *const kDataKey = @"data";
+static NSUInteger const kMemoryCountLimit = 100;
+static NSTimeInterval const kUnusedResponseLifetime = 60 * 60 * 24 * 7;
+
+@interface MHVCachedRestResponse ()
+
+@property (nonatomic, strong) NSData *responseData;
+@property (nonatomic, strong, nullable) NSString *etag;
+@property (nonatomic, strong) NSDate *date;
+@property (nonatomic, assign) NSTimeInterval maxAge;
+@property (nonatomic, assign) NSUInteger generation;
+
+// Deserialized models by class name. Guarded by @synchronized (self)
+@property (nonatomic, strong) NSMutableDictionary<NSString *, id> *objects;
+
+@end
+
+@implementation MHVCachedRestResponse
+
+- (instancetype)init
+{
+    self = [super init];
+
+    if (self)
+    {
+        _objects = [NSMutableDictionary new];
+    }
+
+    return self;
+}
+
+- (BOOL)isFresh
+{
+    return -[self.date timeIntervalSinceNow] < self.maxAge;
+}
+
+@end
+
+@interface MHVRestResponseCache ()
+
+@property (nonatomic, strong) NSURL *directoryURL;
+@property (nonatomic, strong) NSCache<NSString *, MHVCachedRestResponse *> *memoryCache;
+@property (nonatomic, strong) NSFileManager *fileManager;
+
+// Generations by first path component, and the queue disk reads and writes are made on
+@property (nonatomic, strong) MHVResponseCacheGenerations *generations;
+
+@end
+
+@implementation MHVRestResponseCache
+
++ (NSURL *)defaultDirectoryURL
+{
+    NSURL *cachesURL = [[[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory inDomains:NSUserDomainMask] lastObject];
+
+    return [cachesURL URLByAppendingPathComponent:@"MHVRestResponses" isDirectory:YES];
+}
+
+- (instancetype)initWithDirectoryURL:(NSURL *_Nullable)directoryURL
+{
+    self = [super init];
+
+    if (self)
+    {
+        _directoryURL = directoryURL;
+        _memoryCache = [NSCache new];
+        _memoryCache.countLimit = kMemoryCountLimit;
+        _fileManager = [NSFileManager new];
+        _generations = [[MHVResponseCacheGenerations alloc] initWithLabel:@"MHVRestResponseCache.ioQueue"];
+
+        if (directoryURL)
+        {
+            [_generations write:^
+            {
+                [self removeUnusedResponses];
+            }];
+        }
+    }
+
+    return self;
+}
+
+- (NSString *)keyForRequest:(MHVRestRequest *)request
+                   personId:(NSUUID *_Nullable)personId
+                   recordId:(NSUUID *_Nullable)recordId
+                    version:(NSString *_Nullable)version
+{
+    MHVASSERT_PARAMETER(request);
+    MHVASSERT_TRUE(request.url);
+
+    NSString *canonical = [NSString stringWithFormat:@"%@|%@|%@|%@", request.url.absoluteString, personId.UUIDString ?: @"", recordId.UUIDString ?: @"", version ?: @""];
+
+    return [NSString stringWithFormat:@"%@/%@", [self groupForRequest:request], [[canonical dataUsingEncoding:NSUTF8StringEncoding] SHA256]];
+}
+
+- (NSUInteger)generationForKey:(NSString *)key
+{
+    return [self.generations generationForKey:key];
+}
+
+- (MHVCachedRestResponse *_Nullable)responseForKey:(NSString *)key
+{
+    MHVASSERT_PARAMETER(key);
+
+    NSUInteger generation = [self generationForKey:key];
+
+    MHVCachedRestResponse *cached = [self.memoryCache objectForKey:key];
+    if (cached && cached.generation != generation)
+    {
+        [self.memoryCache removeObjectForKey:key];
+        cached = nil;
+    }
+
+    if (!cached && self.directoryURL)
+    {
+        cached = [self readResponseForKey:key];
+        cached.generation = generation;
+
+        if (cached)
+        {
+            [self.memoryCache setObject:cached forKey:key];
+        }
+    }
+
+    return cached;
+}
+
+- (void)setResponse:(MHVHttpServiceResponse *)response forKey:(NSString *)key generation:(NSUInteger)generation
+{
+    MHVASSERT_PARAMETER(response);
+    MHVASSERT_PARAMETER(key);
+
+    NSString *cacheControl = [[self valueForHeader:@"Cache-Control" inHeaders:response.headers] lowercaseString];
+    NSString *etag = [self valueForHeader:@"ETag" inHeaders:response.headers];
+    NSTimeInterval maxAge = [self maxAgeFromCacheControl:cacheControl];
+
+    BOOL isStorable = (response.responseAsData && !response.hasError &&
+                       ![cacheControl containsString:@"no-store"] &&
+                       (etag.length > 0 || maxAge > 0));
+
+    // A write to the same resources finished while this was being read, so the response may be out of date
+    if (!isStorable || generation != [self generationForKey:key])
+    {
+        [self removeResponseForKey:key];
+        return;
+    }
+
+    MHVCachedRestResponse *cached = [MHVCachedRestResponse new];
+    cached.responseData = response.responseAsData;
+    cached.etag = etag.length > 0 ? etag : nil;
+    cached.date = [NSDate date];
+    cached.maxAge = maxAge;
+    cached.generation = generation;
+
+    [self.memoryCache setObject:cached forKey:key];
+
+    if (self.directoryURL)
+    {
+        NSDictionary *entry = [self entryForResponse:cached];
+
+        [self.generations writeForKey:key generation:generation block:^
+        {
+            // The models deserialized from the previous response are removed with it
+            [self.fileManager removeItemAtURL:[self.directoryURL URLByAppendingPathComponent:key isDirectory:YES] error:nil];
+            [self writeEntry:entry forKey:key];
+        }];
+    }
+}
+
+- (MHVCachedRestResponse *_Nullable)refreshResponseForKey:(NSString *)key headers:(NSDictionary<NSString *, NSString *> *_Nullable)headers
+{
+    MHVASSERT_PARAMETER(key);
+
+    MHVCachedRestResponse *cached = [self responseForKey:key];
+    if (!cached)
+    {
+        return nil;
+    }
+
+    NSString *cacheControl = [[self valueForHeader:@"Cache-Control" inHeaders:headers] lowercaseString];
+    if (cacheControl)
+    {
+        cached.maxAge = [self maxAgeFromCacheControl:cacheControl];
+    }
+
+    cached.date = [NSDate date];
+
+    if (self.directoryURL)
+    {
+        NSDictionary *entry = [self entryForResponse:cached];
+
+        [self.generations writeForKey:key generation:cached.generation block:^
+        {
+            [self writeEntry:entry forKey:key];
+        }];
+    }
+
+    return cached;
+}
+
+- (id _Nullable)objectOfClass:(Class)resultClass forKey:(NSString *)key
+{
+    MHVASSERT_PARAMETER(resultClass);
+    MHVASSERT_PARAMETER(key);
+
+    MHVCachedRestResponse *cached = [self responseForKey:key];
+    if (!cached)
+    {
+        return nil;
+    }
+
+    NSString *className = NSStringFromClass(resultClass);
+
+    @synchronized (cached)
+    {
+        id object = cached.objects[className];
+        if (object || !self.directoryURL)
+        {
+            return object;
+        }
+    }
+
+    __block NSData *data = nil;
+    [self.generations read:^
+    {
+        data = [NSData dataWithContentsOfURL:[self objectURLForKey:key className:className]];
+    }];
+
+    if (!data)
+    {
+        return nil;
+    }
+
+    id object = nil;
+    @try
+    {
+        object = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+    }
+    @catch (NSException *exception)
+    {
+        MHVLOG(@"Could not read cached %@: %@", className, exception.reason);
+    }
+
+    if (!object)
+    {
+        return nil;
+    }
+
+    @synchronized (cached)
+    {
+        cached.objects[className] = object;
+    }
+
+    return object;
+}
+
+- (void)setObject:(id)object ofClass:(Class)resultClass forKey:(NSString *)key
+{
+    MHVASSERT_PARAMETER(object);
+    MHVASSERT_PARAMETER(resultClass);
+    MHVASSERT_PARAMETER(key);
+
+    MHVCachedRestResponse *cached = [self responseForKey:key];
+    if (!cached)
+    {
+        return;
+    }
+
+    NSString *className = NSStringFromClass(resultClass);
+
+    @synchronized (cached)
+    {
+        cached.objects[className] = object;
+    }
+
+    if (!self.directoryURL || ![object conformsToProtocol:@protocol(NSCoding)])
+    {
+        return;
+    }
+
+    [self.generations writeForKey:key generation:cached.generation block:^
+    {
+        NSData *data = nil;
+        @try
+        {
+            data = [NSKeyedArchiver archivedDataWithRootObject:object];
+        }
+        @catch (NSException *exception)
+        {
+            MHVLOG(@"Could not write cached %@: %@", className, exception.reason);
+        }
+
+        [data writeToURL:[self objectURLForKey:key className:className]
+                 options:NSDataWritingAtomic | NSDataWritingFileProtectionComplete
+                   error:nil];
+    }];
+}
+
+- (void)removeResponsesChangedByRequest:(MHVRestRequest *)request
+{
+    MHVASSERT_PARAMETER(request);
+
+    if (!request.httpMethod || [request.httpMethod isEqualToString:@"GET"])
+    {
+        return;
+    }
+
+    NSString *group = [self groupForRequest:request];
+
+    // Responses in memory are dropped when they're next read with the new generation
+    [self.generations incrementGenerationForGroup:group];
+
+    if (self.directoryURL)
+    {
+        [self.generations write:^
+        {
+            [self.fileManager removeItemAtURL:[self.directoryURL URLByAppendingPathComponent:group isDirectory:YES] error:nil];
+        }];
+    }
+}
+
+- (void)removeAllResponses
+{
+    [self.generations incrementAllGenerations];
+
+    [self.memoryCache removeAllObjects];
+
+    if (self.directoryURL)
+    {
+        [self.generations write:^
+        {
+            [self.fileManager removeItemAtURL:self.directoryURL error:nil];
+        }];
+    }
+}
+
+#pragma mark - Internal methods
+
+- (NSString *)groupForRequest:(MHVRestRequest *)request
+{
+    NSArray<NSString *> *components = [request.path pathComponents];
+
+    for (NSString *component in components)
+    {
+        if (![component isEqualToString:@"/"])
+        {
+            return component;
+        }
+    }
+
+    return kRootGroup;
+}
+
+- (NSString *_Nullable)valueForHeader:(NSString *)header inHeaders:(NSDictionary<NSString *, NSString *> *_Nullable)headers
+{
+    for (NSString *key in headers)
+    {
+        if ([key caseInsensitiveCompare:header] == NSOrderedSame)
+        {
+            return headers[key];
+        }
+    }
+
+    return nil;
+}
+
+// Seconds from a lowercased Cache-Control value. no-cache, or no max-age, means the response must be revalidated
+- (NSTimeInterval)maxAgeFromCacheControl:(NSString *_Nullable)cacheControl
+{
+    NSTimeInterval maxAge = 0;
+
+    for (NSString *directive in [cacheControl componentsSeparatedByString:@","])
+    {
+        NSString *trimmed = [directive stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+
+        if ([trimmed isEqualToString:@"no-cache"])
+        {
+            return 0;
+        }
+
+        if ([trimmed hasPrefix:@"max-age="])
+        {
+            maxAge = MAX([[trimmed substringFromIndex:@"max-age=".length] doubleValue], 0);
+        }
+    }
+
+    return maxAge;
+}
+
+- (NSDictionary *)entryForResponse:(MHVCachedRestResponse *)cached
+{
+    NSMutableDictionary *entry = [@{kDateKey : cached.date,
+                                    kMaxAgeKey : @(cached.maxAge),
+                                    kDataKey : cached.responseData} mutableCopy];
+    entry[kETagKey] = cached.etag;
+
+    return entry;
+}
+
+- (NSURL *)objectURLForKey:(NSString *)key className:(NSString *)className
+{
+    return [[self.directoryURL URLByAppendingPathComponent:key isDirectory:YES] URLByAppendingPathComponent:className];
+}
+
+// Only called on the ioQueue
+- (void)writeEntry:(NSDictionary *)entry forKey:(NSString *)key
+{
+    NSData *data = [NSPropertyListSerialization dataWithPropertyList:entry format:NSPropertyListBinaryFormat_v1_0 options:0 error:nil];
+    NSURL *responseURL = [[self.directoryURL URLByAppendingPathComponent:key isDirectory:YES] URLByAppendingPathComponent:kResponseFileName];
+
+    [self.fileManager createDirectoryAtURL:[responseURL URLByDeletingLastPathComponent]
+               withIntermediateDirectories:YES
+                                attributes:@{NSFileProtectionKey : NSFileProtectionComplete}
+                                     error:nil];
+
+    NSError *error = nil;
+    if (![data writeToURL:responseURL options:NSDataWritingAtomic | NSDataWritingFileProtectionComplete error:&error])
+    {
+        MHVLOG(@"Could not write cached /%@ response: %@", [key stringByDeletingLastPathComponent], error.localizedDescription);
+    }
+}
+
+- (MHVCachedRestResponse *_Nullable)readResponseForKey:(NSString *)key
+{
+    __block NSData *data = nil;
+
+    [self.generations read:^
+    {
+        NSURL *responseURL = [[self.directoryURL URLByAppendingPathComponent:key isDirectory:YES] URLByAppendingPathComponent:kResponseFileName];
+        data = [NSData dataWithContentsOfURL:responseURL];
+    }];
+
+    if (!data)
+    {
+        return nil;
+    }
+
+    NSDictionary *entry = [NSPropertyListSerialization propertyListWithData:data options:NSPropertyListImmutable format:nil error:nil];
+    if (![entry isKindOfClass:[NSDictionary class]] ||
+        ![entry[kDateKey] isKindOfClass:[NSDate class]] ||
+        ![entry[kDataKey] isKindOfClass:[NSData class]])
+    {
+        [self removeResponseForKey:key];
+        return nil;
+    }
+
+    MHVCachedRestResponse *cached = [MHVCachedRestResponse new];
+    cached.responseData = entry[kDataKey];
+    cached.etag = entry[kETagKey];
+    cached.date = entry[kDateKey];
+    cached.maxAge = [entry[kMaxAgeKey] doubleValue];
+
+    return cached;
+}
+
+- (void)removeResponseForKey:(NSString *)key
+{
+    [self.memoryCache removeObjectForKey:key];
+
+    if (self.directoryURL)
+    {
+        [self.generations write:^
+        {
+            [self.fileManager removeItemAtURL:[self.directoryURL URLByAppendingPathComponent:key isDirectory:YES] error:nil];
+        }];
+    }
+}
+
+// Only called on the ioQueue. Responses are written when received and revalidated, so an old file hasn't been used for a while
+- (void)removeUnusedResponses
+{
+    NSDirectoryEnumerator<NSURL *> *enumerator = [self.fileManager enumeratorAtURL:self.directoryURL
+                                                        includingPropertiesForKeys:@[NSURLContentModificationDateKey]
+                                                                           options:0
+                                                                      errorHandler:nil];
+    NSMutableArray<NSURL *> *unusedURLs = [NSMutableArray new];
+
+    for (NSURL *url in enumerator)
+    {
+        if (![url.lastPathComponent isEqualToString:kResponseFileName])
+        {
+            continue;
+        }
+
+        NSDate *modified = nil;
+        [url getResourceValue:&modified forKey:NSURLContentModificationDateKey error:nil];
+
+        if (modified && -[modified timeIntervalSinceNow] > kUnusedResponseLifetime)
+        {
+            [unusedURLs addObject:[url URLByDeletingLastPathComponent]];
+        }
+    }
+
+    for (NSURL *url in unusedURLs)
+    {
+        [self.fileManager removeItemAtURL:url error:nil];
+    }
+}
+
+@end
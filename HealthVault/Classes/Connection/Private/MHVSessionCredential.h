@@ -28,6 +28,12 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, strong, readonly) NSString *token;
 @property (nonatomic, strong, readonly) NSString *sharedSecret;
 
+/**
+ When the credential was created or deserialized. Not serialized, so a credential read from the keychain
+ is as old as the read.
+ */
+@property (nonatomic, strong, readonly) NSDate *createdDate;
+
 @end
 
 NS_ASSUME_NONNULL_END
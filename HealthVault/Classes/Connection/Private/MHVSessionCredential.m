@@ -35,6 +35,7 @@ static const xmlChar *x_element_shared_secret = XMLSTRINGCONST("shared-secret");
     {
         _token = token;
         _sharedSecret = sharedSecret;
+        _createdDate = [NSDate date];
     }
     
     return self;
@@ -44,6 +45,7 @@ static const xmlChar *x_element_shared_secret = XMLSTRINGCONST("shared-secret");
 {
     _token = [reader readStringElementWithXmlName:x_element_token];
     _sharedSecret = [reader readStringElementWithXmlName:x_element_shared_secret];
+    _createdDate = [NSDate date];
 }
 
 - (void)serialize:(XWriter *)writer
@@ -17,6 +17,10 @@
 // limitations under the License.
 
 #import "MHVSodaConnection.h"
+#import "MHVMethodResponseCache.h"
+#import "MHVRestResponseCache.h"
+#import "MHVBlobCache.h"
+#import "MHVPendingBlobUploadStore.h"
 #import "NSError+MHVError.h"
 #import "MHVKeychainServiceProtocol.h"
 #import "MHVApplicationCreationInfo.h"
@@ -227,6 +231,11 @@ static NSString *const kBlankUUID = @"00000000-0000-0000-0000-000000000000";
                 _sessionCredential = nil;
                 _personInfo = nil;
                 
+                [self.responseCache removeAllResponses];
+                [self.restResponseCache removeAllResponses];
+                [self.blobCache removeAllBlobs];
+                [self removeAllPendingBlobUploads];
+                
                 [self finishAuthWithError:error completion:completion];
             }];
         }
@@ -541,6 +550,19 @@ static NSString *const kBlankUUID = @"00000000-0000-0000-0000-000000000000";
     _applicationCreationInfo = nil;
     _sessionCredential = nil;
     _personInfo = nil;
+    
+    [self.responseCache removeAllResponses];
+    [self.restResponseCache removeAllResponses];
+    [self.blobCache removeAllBlobs];
+    [self removeAllPendingBlobUploads];
+}
+
+// Uploads that were stopped part way, or are still in progress, belong to the person signing out.
+// The removal is queued after the store's writes, and a write from an upload started before it is ignored
+- (void)removeAllPendingBlobUploads
+{
+    [self cancelBlobUploads];
+    [self.pendingBlobUploadStore removeAllUploads];
 }
 
 - (BOOL)removeConnectionPropertiesFromKeychain
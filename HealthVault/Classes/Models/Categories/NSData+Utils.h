@@ -21,7 +21,16 @@
 
 @interface NSData (Utils)
 
+- (NSString *)SHA256;
 - (NSString *)SHA512;
 - (NSString *)hexadecimalString;
 
+/**
+ Compresses the data for an HTTP Content-Encoding.
+
+ @param contentEncoding @"gzip" or @"deflate"
+ @return The compressed data, or nil if the encoding isn't supported
+ */
+- (NSData *)compressedDataWithContentEncoding:(NSString *)contentEncoding;
+
 @end
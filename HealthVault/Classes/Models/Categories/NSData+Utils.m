@@ -18,10 +18,30 @@
 //
 
 #import <CommonCrypto/CommonDigest.h>
+#import <zlib.h>
 #import "NSData+Utils.h"
 
+// zlib window bits: 15 is the largest window, +16 writes a gzip wrapper instead of zlib
+static int const kZlibWindowBits = 15;
+static int const kGzipWindowBits = 15 + 16;
+
 @implementation NSData (Utils)
 
+- (NSString *)SHA256
+{
+    unsigned char buffer[CC_SHA256_DIGEST_LENGTH];
+    
+    CC_SHA256(self.bytes, (CC_LONG)self.length, buffer);
+    
+    NSMutableString *output = [NSMutableString stringWithCapacity:CC_SHA256_DIGEST_LENGTH * 2];
+    for(int i = 0; i < CC_SHA256_DIGEST_LENGTH; i++)
+    {
+        [output appendFormat:@"%02x", buffer[i]];
+    }
+    
+    return output;
+}
+
 - (NSString *)SHA512
 {
     // Create byte array of unsigned chars
@@ -58,4 +78,43 @@
     return [NSString stringWithString:hexString];
 }
 
+- (NSData *)compressedDataWithContentEncoding:(NSString *)contentEncoding
+{
+    int windowBits;
+    
+    if ([contentEncoding isEqualToString:@"gzip"])
+    {
+        windowBits = kGzipWindowBits;
+    }
+    else if ([contentEncoding isEqualToString:@"deflate"])
+    {
+        // HTTP's "deflate" is the zlib format
+        windowBits = kZlibWindowBits;
+    }
+    else
+    {
+        return nil;
+    }
+    
+    z_stream stream = {0};
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return nil;
+    }
+    
+    // deflateBound includes the gzip wrapper, so the whole output fits and one call is enough
+    NSMutableData *compressed = [[NSMutableData alloc] initWithLength:deflateBound(&stream, (uLong)self.length)];
+    
+    stream.next_in = (Bytef *)self.bytes;
+    stream.avail_in = (uInt)self.length;
+    stream.next_out = compressed.mutableBytes;
+    stream.avail_out = (uInt)compressed.length;
+    
+    int result = deflate(&stream, Z_FINISH);
+    compressed.length = stream.total_out;
+    deflateEnd(&stream);
+    
+    return result == Z_STREAM_END ? compressed : nil;
+}
+
 @end
@@ -18,8 +18,7 @@
 
 #import "MHVDateExtensions.h"
 #import "MHVValidator.h"
-
-static NSString *kHealthVaultDateFormat = @"yyyy-MM-dd'T'HH:mm:ss.SSS'Z'";
+#import "XConverter.h"
 
 @implementation NSDate (MHVExtensions)
 
@@ -129,16 +128,10 @@ static NSString *kHealthVaultDateFormat = @"yyyy-MM-dd'T'HH:mm:ss.SSS'Z'";
 
 - (NSString *)dateToUtcString
 {
-    NSDateFormatter *formatter = [NSDateFormatter new];
-    NSLocale *locale = [NSDateFormatter newCultureNeutralLocale];
-
-    [formatter setLocale:locale];
-
-    [formatter setDateFormat:kHealthVaultDateFormat];
-    [formatter setTimeZone:[NSTimeZone timeZoneWithAbbreviation:@"UTC"]];
-    NSString *utcDateString = [formatter stringFromDate:self];
+    char chars[XDateTimeFormatLength];
+    size_t length = XFormatDateTime(self.timeIntervalSinceReferenceDate, NULL, chars);
 
-    return utcDateString;
+    return [[NSString alloc] initWithBytes:chars length:length encoding:NSASCIIStringEncoding];
 }
 
 @end
@@ -0,0 +1,69 @@
+//
+// MHVHttpResponseStream.h
+// MHVLib
+//
+//  Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A pipe that lets a response body be consumed while it is still being received.
+ Chunks are appended as they arrive from the network and read, on another thread, from inputStream.
+ Reads block until more data is appended or the stream is finished. Appending never blocks; instead the
+ writer is asked to pause while the buffer is full, e.g. by suspending the task the body comes from.
+ */
+@interface MHVHttpResponseStream : NSObject
+
+/**
+ The stream to read the response body from. Reads return 0 once finish has been called and all appended data has been read.
+ */
+@property (nonatomic, strong, readonly) NSInputStream *inputStream;
+
+/**
+ Called once bufferSize bytes are waiting to be read, so the writer stops sending more.
+ Called while the stream is locked, so it must not use the stream.
+ */
+@property (nonatomic, copy, nullable) void (^pauseHandler)(void);
+
+/**
+ Called after a pause, once the reader has emptied half of the buffer or closed inputStream.
+ Called while the stream is locked, so it must not use the stream.
+ */
+@property (nonatomic, copy, nullable) void (^resumeHandler)(void);
+
+/**
+ @param bufferSize the number of bytes buffered between the writer and the reader before the writer is paused.
+ */
+- (instancetype)initWithBufferSize:(NSUInteger)bufferSize;
+
+/**
+ Write a chunk of the response body. Does not block: a chunk that arrives while the writer is paused is still kept.
+ The chunk is dropped after the reader has closed inputStream.
+ 
+ @param data the next chunk of the body
+ */
+- (void)appendData:(NSData *)data;
+
+/**
+ Signal the end of the body, once all previously appended data has been written.
+ */
+- (void)finish;
+
+@end
+
+NS_ASSUME_NONNULL_END
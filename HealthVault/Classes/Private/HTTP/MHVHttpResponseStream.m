@@ -0,0 +1,285 @@
+//
+// MHVHttpResponseStream.m
+// MHVLib
+//
+//  Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "MHVHttpResponseStream.h"
+#import "MHVLogger.h"
+
+// Holds the buffered body, and is read directly. Only the synchronous NSInputStream methods are supported
+@interface MHVHttpResponseInputStream : NSInputStream
+
+@property (nonatomic, assign) NSUInteger bufferSize;
+@property (nonatomic, copy) void (^pauseHandler)(void);
+@property (nonatomic, copy) void (^resumeHandler)(void);
+
+// Guards everything below. Readers wait on it for data to be appended
+@property (nonatomic, strong) NSCondition *condition;
+@property (nonatomic, strong) NSMutableData *buffer;
+@property (nonatomic, assign) NSUInteger readOffset;
+@property (nonatomic, assign) NSStreamStatus status;
+@property (nonatomic, assign) BOOL isFinished;
+@property (nonatomic, assign) BOOL isPaused;
+
+@end
+
+@implementation MHVHttpResponseInputStream
+
+@synthesize delegate = _delegate;
+
+- (instancetype)initWithBufferSize:(NSUInteger)bufferSize
+{
+    self = [super init];
+    if (self)
+    {
+        _bufferSize = MAX(bufferSize, 1);
+        _condition = [NSCondition new];
+        _buffer = [NSMutableData new];
+    }
+    
+    return self;
+}
+
+- (void)appendData:(NSData *)data
+{
+    [self.condition lock];
+    
+    if (self.status == NSStreamStatusClosed)
+    {
+        MHVLOG(@"Response stream closed by reader, discarding %li bytes", (long)data.length);
+    }
+    else
+    {
+        [self.buffer appendData:data];
+        
+        // Chunks already on their way are still kept, so the buffer can run a little past bufferSize
+        if (!self.isPaused && self.buffer.length - self.readOffset >= self.bufferSize)
+        {
+            self.isPaused = YES;
+            
+            if (self.pauseHandler)
+            {
+                self.pauseHandler();
+            }
+        }
+        
+        [self.condition broadcast];
+    }
+    
+    [self.condition unlock];
+}
+
+- (void)finish
+{
+    [self.condition lock];
+    
+    self.isFinished = YES;
+    [self.condition broadcast];
+    
+    [self.condition unlock];
+}
+
+// Only called while the condition is locked
+- (void)resumeIfBelowLength:(NSUInteger)length
+{
+    if (self.isPaused && self.buffer.length - self.readOffset < length)
+    {
+        self.isPaused = NO;
+        
+        if (self.resumeHandler)
+        {
+            self.resumeHandler();
+        }
+    }
+}
+
+#pragma mark - NSInputStream
+
+- (void)open
+{
+    [self.condition lock];
+    
+    if (self.status == NSStreamStatusNotOpen)
+    {
+        self.status = NSStreamStatusOpen;
+    }
+    
+    [self.condition unlock];
+}
+
+- (void)close
+{
+    [self.condition lock];
+    
+    self.status = NSStreamStatusClosed;
+    self.buffer = [NSMutableData new];
+    self.readOffset = 0;
+    
+    // Lets the rest of the body arrive and be dropped, so the request finishes
+    [self resumeIfBelowLength:NSUIntegerMax];
+    
+    [self.condition broadcast];
+    [self.condition unlock];
+}
+
+- (NSStreamStatus)streamStatus
+{
+    [self.condition lock];
+    
+    NSStreamStatus status = self.status;
+    
+    [self.condition unlock];
+    
+    return status;
+}
+
+- (NSError *)streamError
+{
+    return nil;
+}
+
+- (NSInteger)read:(uint8_t *)buffer maxLength:(NSUInteger)len
+{
+    [self.condition lock];
+    
+    while (self.buffer.length == self.readOffset && !self.isFinished && self.status != NSStreamStatusClosed)
+    {
+        [self.condition wait];
+    }
+    
+    NSUInteger count = MIN(len, self.buffer.length - self.readOffset);
+    
+    if (count > 0)
+    {
+        memcpy(buffer, (const uint8_t *)self.buffer.bytes + self.readOffset, count);
+        self.readOffset += count;
+        
+        // Moves the unread bytes down once a buffer's worth has been read, rather than on every read
+        if (self.readOffset >= self.bufferSize)
+        {
+            [self.buffer replaceBytesInRange:NSMakeRange(0, self.readOffset) withBytes:NULL length:0];
+            self.readOffset = 0;
+        }
+        
+        [self resumeIfBelowLength:self.bufferSize / 2];
+    }
+    else if (self.status != NSStreamStatusClosed)
+    {
+        self.status = NSStreamStatusAtEnd;
+    }
+    
+    [self.condition unlock];
+    
+    return (NSInteger)count;
+}
+
+- (BOOL)getBuffer:(uint8_t **)buffer length:(NSUInteger *)len
+{
+    return NO;
+}
+
+- (BOOL)hasBytesAvailable
+{
+    [self.condition lock];
+    
+    BOOL hasBytesAvailable = self.buffer.length > self.readOffset || (!self.isFinished && self.status != NSStreamStatusClosed);
+    
+    [self.condition unlock];
+    
+    return hasBytesAvailable;
+}
+
+- (id)propertyForKey:(NSStreamPropertyKey)key
+{
+    return nil;
+}
+
+- (BOOL)setProperty:(id)property forKey:(NSStreamPropertyKey)key
+{
+    return NO;
+}
+
+- (void)scheduleInRunLoop:(NSRunLoop *)aRunLoop forMode:(NSRunLoopMode)mode
+{
+}
+
+- (void)removeFromRunLoop:(NSRunLoop *)aRunLoop forMode:(NSRunLoopMode)mode
+{
+}
+
+@end
+
+@interface MHVHttpResponseStream ()
+
+@property (nonatomic, strong) MHVHttpResponseInputStream *bufferStream;
+
+@end
+
+@implementation MHVHttpResponseStream
+
+- (instancetype)initWithBufferSize:(NSUInteger)bufferSize
+{
+    self = [super init];
+    if (self)
+    {
+        _bufferStream = [[MHVHttpResponseInputStream alloc] initWithBufferSize:bufferSize];
+        [_bufferStream open];
+    }
+    
+    return self;
+}
+
+- (NSInputStream *)inputStream
+{
+    return self.bufferStream;
+}
+
+- (void)setPauseHandler:(void (^)(void))pauseHandler
+{
+    [self.bufferStream.condition lock];
+    self.bufferStream.pauseHandler = pauseHandler;
+    [self.bufferStream.condition unlock];
+}
+
+- (void (^)(void))pauseHandler
+{
+    return self.bufferStream.pauseHandler;
+}
+
+- (void)setResumeHandler:(void (^)(void))resumeHandler
+{
+    [self.bufferStream.condition lock];
+    self.bufferStream.resumeHandler = resumeHandler;
+    [self.bufferStream.condition unlock];
+}
+
+- (void (^)(void))resumeHandler
+{
+    return self.bufferStream.resumeHandler;
+}
+
+- (void)appendData:(NSData *)data
+{
+    [self.bufferStream appendData:data];
+}
+
+- (void)finish
+{
+    [self.bufferStream finish];
+}
+
+@end
@@ -25,6 +25,11 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface MHVHttpService : NSObject <MHVHttpServiceProtocol>
 
+/**
+ The number of chunks of a blob upload sent at the same time. Defaults to MHVConfiguration blobUploadConcurrentChunkCount
+ */
+@property (nonatomic, assign) NSUInteger blobUploadConcurrentChunkCount;
+
 /**
  Create MHV HTTP Service
 
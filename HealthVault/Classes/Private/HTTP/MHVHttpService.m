@@ -17,6 +17,7 @@
 // limitations under the License.
 //
 
+#import <CommonCrypto/CommonDigest.h>
 #import "MHVHttpService.h"
 #import "MHVHttpServiceResponse.h"
 #import "MHVLogger.h"
@@ -24,13 +25,85 @@
 #import "MHVValidator.h"
 #import "MHVHttpTask.h"
 #import "MHVConfiguration.h"
+#import "MHVConfigurationConstants.h"
 #import "NSError+MHVError.h"
+#import "MHVHttpResponseStream.h"
+#import "MHVBlobHasher.h"
 
-@interface MHVHttpService () <NSURLSessionDelegate>
+// Bytes buffered between the network and a streaming response's reader
+static NSUInteger const kStreamingBufferSize = 64 * 1024;
+
+@interface MHVHttpStreamingRequest : NSObject
+
+@property (nonatomic, copy) MHVHttpServiceStreamHandler streamHandler;
+@property (nonatomic, strong) MHVHttpResponseStream *responseStream;
+@property (nonatomic, strong) dispatch_group_t group;
+@property (nonatomic, strong) NSError *error;
+
+@end
+
+@implementation MHVHttpStreamingRequest
+
+@end
+
+// A blob upload in progress. Only used on its queue
+@interface MHVHttpBlobUpload : NSObject
+
+@property (nonatomic, strong) id<MHVBlobSourceProtocol> blobSource;
+@property (nonatomic, strong) NSURL *url;
+@property (nonatomic, assign) NSUInteger chunkSize;
+@property (nonatomic, strong) MHVHttpTask *httpTask;
+@property (nonatomic, copy) MHVHttpServiceCompletion completion;
+@property (nonatomic, strong) dispatch_queue_t queue;
+
+// Chunks are read from the blob source on this queue, so a source that waits for more of the blob, like a stream,
+// doesn't hold up the chunks that finish meanwhile
+@property (nonatomic, strong) dispatch_queue_t readQueue;
+
+@property (nonatomic, copy) MHVHttpServiceCommittedLengthHandler committedLengthHandler;
+@property (nonatomic, strong) MHVBlobHasher *blobHasher;
+
+// The SHA256 of each chunk from the start of the blob to committedLength, of each chunk sent after it,
+// and of each chunk stored before the upload started, which the blob is checked against
+@property (nonatomic, strong) NSMutableData *committedChunkDigests;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, NSData *> *sentChunkDigests;
+@property (nonatomic, strong) NSData *storedChunkDigests;
+
+@property (nonatomic, assign) NSUInteger nextChunkOffset;
+@property (nonatomic, assign) NSUInteger inFlightChunkCount;
+
+// The length stored from the start of the blob, and the offsets of chunks stored after it
+@property (nonatomic, assign) NSUInteger committedLength;
+@property (nonatomic, strong) NSMutableIndexSet *storedChunkOffsets;
+@property (nonatomic, assign) BOOL isLastChunkSent;
+@property (nonatomic, assign) BOOL isFinished;
+
+// The chunk at nextChunkOffset, read while earlier chunks are sent
+@property (nonatomic, strong) NSData *readAheadData;
+@property (nonatomic, assign) BOOL isReadingAhead;
+
+@end
+
+@implementation MHVHttpBlobUpload
+
+@end
+
+static NSData *MHVChunkDigest(NSData *data)
+{
+    NSMutableData *digest = [NSMutableData dataWithLength:CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256(data.bytes, (CC_LONG)data.length, digest.mutableBytes);
+    
+    return digest;
+}
+
+@interface MHVHttpService () <NSURLSessionDataDelegate>
 
 @property (nonatomic, strong) NSURLSession *urlSession;
 @property (nonatomic, strong) NSOperationQueue *certificateCheckQueue;
 
+// Streaming requests in flight, keyed by task identifier
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, MHVHttpStreamingRequest *> *streamingRequests;
+
 @property (nonatomic, assign) NSInteger requestCount;
 
 @end
@@ -56,6 +129,8 @@
                                                delegateQueue:nil];
         
         _certificateCheckQueue = [[NSOperationQueue alloc] init];
+        _streamingRequests = [NSMutableDictionary new];
+        _blobUploadConcurrentChunkCount = configuration ? configuration.blobUploadConcurrentChunkCount : kDefaultBlobUploadConcurrentChunkCount;
     }
     
     return self;
@@ -71,6 +146,8 @@
         _urlSession = urlSession;
         
         _certificateCheckQueue = [[NSOperationQueue alloc] init];
+        _streamingRequests = [NSMutableDictionary new];
+        _blobUploadConcurrentChunkCount = kDefaultBlobUploadConcurrentChunkCount;
     }
     
     return self;
@@ -147,6 +224,65 @@
     return [[MHVHttpTask alloc] initWithURLSessionTask:task];
 }
 
+- (id<MHVHttpTaskProtocol>)sendStreamingRequestForURL:(NSURL *)url
+                                                 body:(NSData *_Nullable)body
+                                              headers:(NSDictionary<NSString *, NSString *> *_Nullable)headers
+                                        streamHandler:(MHVHttpServiceStreamHandler)streamHandler
+                                           completion:(MHVHttpServiceStreamCompletion)completion
+{
+    MHVASSERT_PARAMETER(url);
+    MHVASSERT_PARAMETER(streamHandler);
+    MHVASSERT([url.scheme isEqualToString:@"https"]);
+    
+    if (!url || !streamHandler)
+    {
+        if (completion)
+        {
+            completion([NSError MVHInvalidParameter]);
+        }
+        return nil;
+    }
+    
+    NSMutableURLRequest *request = [[self requestWithUrl:url body:body] mutableCopy];
+    
+    for (NSString *key in headers.allKeys)
+    {
+        [request setValue:headers[key] forHTTPHeaderField:key];
+    }
+    
+    NSInteger currentRequest = (++self.requestCount);
+    NSDate *startDate = [NSDate date];
+    
+    MHVLOG(@"Begin streaming request #%li", (long)currentRequest);
+    
+    // No completion handler, so the body is delivered to the delegate methods below as it arrives
+    NSURLSessionDataTask *task = [self.urlSession dataTaskWithRequest:request];
+    
+    MHVHttpStreamingRequest *streamingRequest = [MHVHttpStreamingRequest new];
+    streamingRequest.streamHandler = streamHandler;
+    streamingRequest.group = dispatch_group_create();
+    
+    // Left when the task completes; the stream handler holds the group too while it runs
+    dispatch_group_enter(streamingRequest.group);
+    dispatch_group_notify(streamingRequest.group, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^
+    {
+        MHVLOG(@"Streaming request #%li complete (%0.4f seconds)", (long)currentRequest, [[NSDate date] timeIntervalSinceDate:startDate]);
+        
+        if (completion)
+        {
+            completion(streamingRequest.error);
+        }
+    });
+    
+    @synchronized(self.streamingRequests)
+    {
+        self.streamingRequests[@(task.taskIdentifier)] = streamingRequest;
+    }
+    
+    [task resume];
+    return [[MHVHttpTask alloc] initWithURLSessionTask:task];
+}
+
 - (id<MHVHttpTaskProtocol>)downloadFileWithUrl:(NSURL *)url
                                     toFilePath:(NSString *)path
                                     completion:(MHVHttpServiceFileDownloadCompletion)completion
@@ -248,25 +384,33 @@
 {
     return [self uploadBlobSource:blobSource
                             toUrl:url
-                      chunkOffset:0
                         chunkSize:chunkSize
-                         httpTask:[[MHVHttpTask alloc] initWithURLSessionTask:nil totalSize:blobSource.length]
+                      startOffset:0
+               storedChunkDigests:nil
+           committedLengthHandler:nil
+                       blobHasher:nil
                        completion:completion];
 }
 
 - (id<MHVHttpTaskProtocol>)uploadBlobSource:(id<MHVBlobSourceProtocol>)blobSource
                                       toUrl:(NSURL *)url
-                                chunkOffset:(NSUInteger)chunkOffset
                                   chunkSize:(NSUInteger)chunkSize
-                                   httpTask:(MHVHttpTask *)httpTask
+                                startOffset:(NSUInteger)startOffset
+                         storedChunkDigests:(NSData *_Nullable)storedChunkDigests
+                     committedLengthHandler:(MHVHttpServiceCommittedLengthHandler _Nullable)committedLengthHandler
+                                 blobHasher:(MHVBlobHasher *_Nullable)blobHasher
                                  completion:(MHVHttpServiceCompletion)completion
 {
     MHVASSERT_PARAMETER(blobSource);
     MHVASSERT_PARAMETER(url);
     MHVASSERT([url.scheme isEqualToString:@"https"]);
     MHVASSERT(chunkSize != 0);
+    MHVASSERT(chunkSize == 0 || startOffset % chunkSize == 0 || startOffset == blobSource.length);
+    MHVASSERT(startOffset == 0 || storedChunkDigests);
     
-    if (!blobSource || !url || chunkSize == 0)
+    if (!blobSource || !url || chunkSize == 0 || startOffset > blobSource.length ||
+        (startOffset % chunkSize != 0 && startOffset != blobSource.length) ||
+        (startOffset > 0 && !storedChunkDigests))
     {
         if (completion)
         {
@@ -275,63 +419,289 @@
         return nil;
     }
     
-    NSUInteger thisChunkSize = MIN(chunkSize, (blobSource.length - chunkOffset));
+    MHVHttpBlobUpload *upload = [MHVHttpBlobUpload new];
+    upload.blobSource = blobSource;
+    upload.url = url;
+    upload.chunkSize = chunkSize;
+    upload.httpTask = [[MHVHttpTask alloc] initWithURLSessionTask:nil totalSize:blobSource.length];
+    upload.completion = completion;
+    upload.committedLengthHandler = committedLengthHandler;
+    upload.blobHasher = blobHasher;
+    upload.nextChunkOffset = startOffset;
+    upload.committedLength = startOffset;
+    upload.storedChunkOffsets = [NSMutableIndexSet new];
+    upload.committedChunkDigests = [NSMutableData new];
+    upload.sentChunkDigests = [NSMutableDictionary new];
+    upload.storedChunkDigests = storedChunkDigests;
+    upload.queue = dispatch_queue_create("MHVHttpService.blobUploadQueue", DISPATCH_QUEUE_SERIAL);
+    upload.readQueue = dispatch_queue_create("MHVHttpService.blobReadQueue", DISPATCH_QUEUE_SERIAL);
+    
+    dispatch_async(upload.queue, ^
+    {
+        if (![self checkStoredPartOfUpload:upload])
+        {
+            return;
+        }
+        
+        // The whole blob was stored before, and has only been checked and hashed
+        if (upload.committedLength > 0 && upload.committedLength == blobSource.length)
+        {
+            [self finishUpload:upload response:[[MHVHttpServiceResponse alloc] initWithResponseData:nil statusCode:200] error:nil];
+            return;
+        }
+        
+        [self sendChunksForUpload:upload];
+    });
+    
+    return upload.httpTask;
+}
+
+#pragma mark - Blob upload
+
+// Only called on the upload's queue. Keeps up to blobUploadConcurrentChunkCount chunks in flight, so a large blob
+// doesn't wait a round trip per chunk, and reads the next chunk from the blob source while they're sent.
+- (void)sendChunksForUpload:(MHVHttpBlobUpload *)upload
+{
+    NSUInteger length = upload.blobSource.length;
+    NSUInteger concurrentChunkCount = MAX(self.blobUploadConcurrentChunkCount, 1);
+    
+    while (!upload.isLastChunkSent && upload.inFlightChunkCount < concurrentChunkCount)
+    {
+        if (upload.httpTask.isCancelled)
+        {
+            [self finishUpload:upload response:nil error:[NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCancelled userInfo:nil]];
+            return;
+        }
+        
+        NSUInteger chunkOffset = upload.nextChunkOffset;
+        NSUInteger chunkLength = MIN(upload.chunkSize, length - chunkOffset);
+        BOOL isLastChunk = chunkOffset + chunkLength == length;
+        
+        // The last chunk completes the blob, so it's only sent once every other chunk has been stored
+        if (isLastChunk && upload.inFlightChunkCount > 0)
+        {
+            break;
+        }
+        
+        // Sending continues once the chunk has been read
+        if (!upload.readAheadData)
+        {
+            break;
+        }
+        
+        NSData *data = upload.readAheadData;
+        upload.readAheadData = nil;
+        
+        // A short chunk would be stored at the wrong offsets, and the blob left incomplete
+        if (data.length != chunkLength)
+        {
+            MHVLOG(@"Blob upload read %li bytes at offset %li, expected %li", (long)data.length, (long)chunkOffset, (long)chunkLength);
+            
+            [self finishUpload:upload response:nil error:[NSError error:[NSError MHVIOError] withDescription:@"The blob source could not be read"]];
+            return;
+        }
+        
+        // Chunks are sent in order, so the hash is computed as the blob goes out, without reading it again
+        [upload.blobHasher appendData:data];
+        upload.sentChunkDigests[@(chunkOffset)] = MHVChunkDigest(data);
+        
+        [self sendChunk:data atOffset:chunkOffset isLastChunk:isLastChunk forUpload:upload];
+        
+        upload.nextChunkOffset = chunkOffset + chunkLength;
+        upload.isLastChunkSent = isLastChunk;
+    }
+    
+    if (!upload.isLastChunkSent && !upload.readAheadData)
+    {
+        [self readAheadForUpload:upload];
+    }
+}
+
+// Only called on the upload's queue. Reads the chunk at nextChunkOffset on the read queue, then sends chunks again
+- (void)readAheadForUpload:(MHVHttpBlobUpload *)upload
+{
+    if (upload.isReadingAhead)
+    {
+        return;
+    }
+    
+    upload.isReadingAhead = YES;
+    
+    NSUInteger chunkOffset = upload.nextChunkOffset;
+    NSUInteger chunkLength = MIN(upload.chunkSize, upload.blobSource.length - chunkOffset);
     
-    NSData *data = [blobSource readStartAt:chunkOffset chunkSize:thisChunkSize];
+    dispatch_async(upload.readQueue, ^
+    {
+        // A source that can't be read gives an empty chunk, which fails the upload when it's sent
+        NSData *data = [upload.blobSource readStartAt:chunkOffset chunkSize:chunkLength] ?: [NSData data];
+        
+        dispatch_async(upload.queue, ^
+        {
+            upload.isReadingAhead = NO;
+            
+            if (upload.isFinished)
+            {
+                return;
+            }
+            
+            upload.readAheadData = data;
+            
+            [self sendChunksForUpload:upload];
+        });
+    });
+}
+
+// Only called on the upload's queue. A continued upload only sends the rest of the blob, so the part already stored
+// is read again, to check it hasn't changed since it was stored and to add it to the blob's hash
+- (BOOL)checkStoredPartOfUpload:(MHVHttpBlobUpload *)upload
+{
+    NSUInteger offset = 0;
+    
+    while (offset < upload.committedLength)
+    {
+        @autoreleasepool
+        {
+            NSUInteger chunkLength = MIN(upload.chunkSize, upload.committedLength - offset);
+            NSData *data = [upload.blobSource readStartAt:offset chunkSize:chunkLength];
+            
+            if (data.length != chunkLength)
+            {
+                [self finishUpload:upload response:nil error:[NSError error:[NSError MHVIOError] withDescription:@"The blob source could not be read"]];
+                return NO;
+            }
+            
+            NSData *digest = MHVChunkDigest(data);
+            NSUInteger digestOffset = upload.committedChunkDigests.length;
+            
+            if (upload.storedChunkDigests.length < digestOffset + digest.length ||
+                ![[upload.storedChunkDigests subdataWithRange:NSMakeRange(digestOffset, digest.length)] isEqualToData:digest])
+            {
+                MHVLOG(@"Blob upload can't continue, the blob has changed at offset %li", (long)offset);
+                
+                [self finishUpload:upload response:nil error:[NSError error:[NSError MHVOperationCannotBePerformed] withDescription:@"The blob has changed since part of it was stored"]];
+                return NO;
+            }
+            
+            [upload.blobHasher appendData:data];
+            [upload.committedChunkDigests appendData:digest];
+            
+            offset += chunkLength;
+        }
+    }
     
-    NSURLRequest *request = [self requestWithUrl:url
+    return YES;
+}
+
+// Only called on the upload's queue
+- (void)sendChunk:(NSData *)data atOffset:(NSUInteger)chunkOffset isLastChunk:(BOOL)isLastChunk forUpload:(MHVHttpBlobUpload *)upload
+{
+    NSURLRequest *request = [self requestWithUrl:upload.url
                                             data:data
                                      chunkOffset:chunkOffset
-                                       totalSize:blobSource.length];
+                                       totalSize:upload.blobSource.length];
     
     MHVLOG(@"Blob upload chunk at offset %li", (long)chunkOffset);
     NSDate *startDate = [NSDate date];
-    NSURLSessionTask *task = [self.urlSession dataTaskWithRequest:(NSURLRequest *)request
-                                                completionHandler:^(NSData * _Nullable data, NSURLResponse * _Nullable response, NSError * _Nullable error)
+    NSUInteger chunkLength = data.length;
+    
+    NSURLSessionTask *task = [self.urlSession dataTaskWithRequest:request
+                                                completionHandler:^(NSData * _Nullable responseData, NSURLResponse * _Nullable response, NSError * _Nullable error)
                               {
-                                  if (!error)
-                                  {
-                                      MHVLOG(@"Blob upload chunk size %li in %0.4f seconds", (long)thisChunkSize, [[NSDate date] timeIntervalSinceDate:startDate]);
-                                  }
-                                  
-                                  if (!error && chunkOffset + thisChunkSize < blobSource.length)
-                                  {
-                                      //Update offset and call this method again to send the next chunk
-                                      [self uploadBlobSource:blobSource
-                                                       toUrl:url
-                                                 chunkOffset:chunkOffset + thisChunkSize
-                                                   chunkSize:chunkSize
-                                                    httpTask:httpTask
-                                                  completion:completion];
-                                      return;
-                                  }
-                                  else
+                                  dispatch_async(upload.queue, ^
                                   {
+                                      upload.inFlightChunkCount -= 1;
+                                      
+                                      if (upload.isFinished)
+                                      {
+                                          return;
+                                      }
+                                      
                                       if (error)
                                       {
                                           MHVLOG(@"Blob upload error: %@", error.localizedDescription);
                                           
-                                          if (completion)
-                                          {
-                                              completion(nil, error);
-                                          }
+                                          [self finishUpload:upload response:nil error:error];
+                                          return;
                                       }
-                                      else
+                                      
+                                      MHVLOG(@"Blob upload chunk size %li in %0.4f seconds", (long)chunkLength, [[NSDate date] timeIntervalSinceDate:startDate]);
+                                      
+                                      MHVHttpServiceResponse *httpResponse = [self responseFromData:responseData urlResponse:response];
+                                      
+                                      if (!httpResponse.hasError)
+                                      {
+                                          [self storedChunkAtOffset:chunkOffset length:chunkLength forUpload:upload];
+                                      }
+                                      
+                                      // A chunk that wasn't stored ends the upload, with the response explaining why
+                                      if (isLastChunk || httpResponse.hasError)
                                       {
-                                          MHVLOG(@"Blob upload complete");
+                                          MHVLOG(@"Blob upload %@", httpResponse.hasError ? @"failed" : @"complete");
                                           
-                                          if (completion)
-                                          {
-                                              completion([self responseFromData:data urlResponse:response], nil);
-                                          }
+                                          [self finishUpload:upload response:httpResponse error:nil];
                                       }
-                                  }
+                                      else
+                                      {
+                                          [self sendChunksForUpload:upload];
+                                      }
+                                  });
                               }];
     
+    upload.inFlightChunkCount += 1;
+    
     [task resume];
-    [httpTask addTask:task];
+    [upload.httpTask addTask:task];
+}
+
+// Only called on the upload's queue. Chunks finish out of order, but an upload can only continue after the stored prefix
+- (void)storedChunkAtOffset:(NSUInteger)chunkOffset length:(NSUInteger)chunkLength forUpload:(MHVHttpBlobUpload *)upload
+{
+    [upload.storedChunkOffsets addIndex:chunkOffset];
+    
+    NSUInteger committedLength = upload.committedLength;
+    
+    while ([upload.storedChunkOffsets containsIndex:committedLength])
+    {
+        [upload.storedChunkOffsets removeIndex:committedLength];
+        
+        [upload.committedChunkDigests appendData:upload.sentChunkDigests[@(committedLength)]];
+        [upload.sentChunkDigests removeObjectForKey:@(committedLength)];
+        
+        committedLength += MIN(upload.chunkSize, upload.blobSource.length - committedLength);
+        
+        if (committedLength == upload.blobSource.length)
+        {
+            break;
+        }
+    }
     
-    return httpTask;
+    if (committedLength != upload.committedLength)
+    {
+        upload.committedLength = committedLength;
+        
+        if (upload.committedLengthHandler)
+        {
+            upload.committedLengthHandler(committedLength, [upload.committedChunkDigests copy]);
+        }
+    }
+}
+
+// Only called on the upload's queue
+- (void)finishUpload:(MHVHttpBlobUpload *)upload response:(MHVHttpServiceResponse *)response error:(NSError *)error
+{
+    upload.isFinished = YES;
+    upload.readAheadData = nil;
+    
+    if (response.hasError || error)
+    {
+        // Stop the other chunks in flight
+        [upload.httpTask cancel];
+    }
+    
+    if (upload.completion)
+    {
+        upload.completion(response, error);
+    }
 }
 
 #pragma mark - Internal methods
@@ -341,7 +711,7 @@
 {
     NSMutableURLRequest *request = [[NSMutableURLRequest alloc] initWithURL:url];
     
-    [request setValue:@"gzip" forHTTPHeaderField:@"Accept-Encoding"];
+    [request setValue:@"gzip, deflate" forHTTPHeaderField:@"Accept-Encoding"];
     
     if (body)
     {
@@ -364,7 +734,7 @@
     request.HTTPMethod = @"POST";
     request.HTTPBody = data;
     
-    [request setValue:@"gzip" forHTTPHeaderField:@"Accept-Encoding"];
+    [request setValue:@"gzip, deflate" forHTTPHeaderField:@"Accept-Encoding"];
     [request setValue:@"application/octet-stream" forHTTPHeaderField:@"Content-Type"];
     
     NSString *contentRange = [NSString stringWithFormat:@"bytes %lu-%lu/*", (unsigned long)chunkOffset, (unsigned long)chunkOffset + data.length - 1];
@@ -379,12 +749,28 @@
     return request;
 }
 
+- (MHVHttpStreamingRequest *)streamingRequestForTask:(NSURLSessionTask *)task remove:(BOOL)remove
+{
+    @synchronized(self.streamingRequests)
+    {
+        MHVHttpStreamingRequest *streamingRequest = self.streamingRequests[@(task.taskIdentifier)];
+        
+        if (remove)
+        {
+            [self.streamingRequests removeObjectForKey:@(task.taskIdentifier)];
+        }
+        
+        return streamingRequest;
+    }
+}
+
 - (MHVHttpServiceResponse *)responseFromData:(NSData *)data urlResponse:(NSURLResponse *)response
 {
-    NSInteger statusCode = ((NSHTTPURLResponse *)response).statusCode;
+    NSHTTPURLResponse *httpResponse = (NSHTTPURLResponse *)response;
     
     return [[MHVHttpServiceResponse alloc] initWithResponseData:data
-                                                     statusCode:statusCode];
+                                                     statusCode:httpResponse.statusCode
+                                                        headers:httpResponse.allHeaderFields];
 }
 
 #pragma mark - NSURLSessionDelegate
@@ -414,4 +800,67 @@ didReceiveChallenge:(NSURLAuthenticationChallenge *)challenge
      }];
 }
 
+#pragma mark - NSURLSessionDataDelegate
+
+- (void)URLSession:(NSURLSession *)session
+          dataTask:(NSURLSessionDataTask *)dataTask
+didReceiveResponse:(NSURLResponse *)response
+ completionHandler:(void (^)(NSURLSessionResponseDisposition disposition))completionHandler
+{
+    MHVHttpStreamingRequest *streamingRequest = [self streamingRequestForTask:dataTask remove:NO];
+    
+    if (streamingRequest && !streamingRequest.responseStream)
+    {
+        streamingRequest.responseStream = [[MHVHttpResponseStream alloc] initWithBufferSize:kStreamingBufferSize];
+        
+        // The delegate queue is shared by every task, so a slow reader holds back only its own task, by suspending it
+        streamingRequest.responseStream.pauseHandler = ^
+        {
+            [dataTask suspend];
+        };
+        streamingRequest.responseStream.resumeHandler = ^
+        {
+            [dataTask resume];
+        };
+        
+        NSInteger statusCode = ((NSHTTPURLResponse *)response).statusCode;
+        NSDictionary<NSString *, NSString *> *headers = ((NSHTTPURLResponse *)response).allHeaderFields;
+        NSInputStream *inputStream = streamingRequest.responseStream.inputStream;
+        MHVHttpServiceStreamHandler streamHandler = streamingRequest.streamHandler;
+        
+        // The handler reads synchronously until the end of the body, so it can not run on the delegate queue
+        dispatch_group_async(streamingRequest.group, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^
+        {
+            streamHandler(statusCode, headers, inputStream);
+            
+            [inputStream close];
+        });
+    }
+    
+    completionHandler(NSURLSessionResponseAllow);
+}
+
+- (void)URLSession:(NSURLSession *)session
+          dataTask:(NSURLSessionDataTask *)dataTask
+    didReceiveData:(NSData *)data
+{
+    [[self streamingRequestForTask:dataTask remove:NO].responseStream appendData:data];
+}
+
+- (void)URLSession:(NSURLSession *)session
+              task:(NSURLSessionTask *)task
+didCompleteWithError:(NSError *)error
+{
+    MHVHttpStreamingRequest *streamingRequest = [self streamingRequestForTask:task remove:YES];
+    
+    if (streamingRequest)
+    {
+        streamingRequest.error = error;
+        
+        [streamingRequest.responseStream finish];
+        
+        dispatch_group_leave(streamingRequest.group);
+    }
+}
+
 @end
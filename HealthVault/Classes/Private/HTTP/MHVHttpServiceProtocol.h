@@ -19,10 +19,13 @@
 
 #import <Foundation/Foundation.h>
 @protocol MHVBlobSourceProtocol, MHVHttpTaskProtocol;
-@class MHVHttpServiceResponse;
+@class MHVHttpServiceResponse, MHVBlobHasher;
 
 typedef void (^MHVHttpServiceCompletion)(MHVHttpServiceResponse *_Nullable response, NSError *_Nullable error);
 typedef void (^MHVHttpServiceFileDownloadCompletion)(NSError *_Nullable error);
+typedef void (^MHVHttpServiceStreamHandler)(NSInteger statusCode, NSDictionary<NSString *, NSString *> *_Nullable headers, NSInputStream *_Nonnull stream);
+typedef void (^MHVHttpServiceStreamCompletion)(NSError *_Nullable error);
+typedef void (^MHVHttpServiceCommittedLengthHandler)(NSUInteger committedLength, NSData *_Nonnull chunkDigests);
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -57,6 +60,24 @@ NS_ASSUME_NONNULL_BEGIN
                                      headers:(NSDictionary<NSString *, NSString *> *_Nullable)headers
                                   completion:(MHVHttpServiceCompletion)completion;
 
+/**
+ Send a request to HealthVault service, reading the response body while it downloads
+ 
+ @param url the endpoint for the request
+ @param body data to send as POST body
+ @param headers HTTP headers to add to the request for authentication, etc.
+ @param streamHandler invoked on a background queue with the status code and headers once the response headers arrive.
+ Reads from the stream block until more of the body is received, and return 0 at the end of the body.
+ @param completion invoked after streamHandler has returned and the request has finished,
+ with an error if the request failed
+ @return a task that can be cancelled
+ */
+- (id<MHVHttpTaskProtocol>)sendStreamingRequestForURL:(NSURL *)url
+                                                 body:(NSData *_Nullable)body
+                                              headers:(NSDictionary<NSString *, NSString *> *_Nullable)headers
+                                        streamHandler:(MHVHttpServiceStreamHandler)streamHandler
+                                           completion:(MHVHttpServiceStreamCompletion)completion;
+
 /**
  Download a blob from HealthVault service to a local file path
  
@@ -94,6 +115,32 @@ NS_ASSUME_NONNULL_BEGIN
                                   chunkSize:(NSUInteger)chunkSize
                                  completion:(MHVHttpServiceCompletion)completion;
 
+/**
+ Upload to HealthVault blob storage, continuing from the part of the blob already stored
+ 
+ @param blobSource data source for blob (NSData, file, etc)
+ @param toUrl the endpoint for the request
+ @param chunkSize size is given by HealthVault service when requesting to upload a blob
+ @param startOffset the length of the blob already stored at the endpoint, a multiple of chunkSize or the whole blob
+ @param storedChunkDigests the chunk digests committedLengthHandler was last given for the part already stored.
+        That part is read again and checked against them, and the upload fails with MHVErrorTypeOperationCannotBePerformed
+        if the blob has changed since. Required when startOffset isn't 0
+ @param committedLengthHandler called each time the length stored from the start of the blob grows, as chunks finish,
+        with the SHA256 of each chunk in that length
+ @param blobHasher given each part of the blob in order as it is sent, so the blob's hash is ready when the upload
+        finishes. When continuing an upload, the part already stored is hashed as it is checked
+ @param completion response containing result of the operation, or error
+ @return a task that can be cancelled
+ */
+- (id<MHVHttpTaskProtocol>)uploadBlobSource:(id<MHVBlobSourceProtocol>)blobSource
+                                      toUrl:(NSURL *)toUrl
+                                  chunkSize:(NSUInteger)chunkSize
+                                startOffset:(NSUInteger)startOffset
+                         storedChunkDigests:(NSData *_Nullable)storedChunkDigests
+                     committedLengthHandler:(MHVHttpServiceCommittedLengthHandler _Nullable)committedLengthHandler
+                                 blobHasher:(MHVBlobHasher *_Nullable)blobHasher
+                                 completion:(MHVHttpServiceCompletion)completion;
+
 @end
 
 NS_ASSUME_NONNULL_END
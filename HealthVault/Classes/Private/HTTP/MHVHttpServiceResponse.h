@@ -35,9 +35,16 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (nonatomic, assign, readonly) NSInteger statusCode;
 
+// The HTTP response headers
+@property (nonatomic, strong, readonly, nullable) NSDictionary<NSString *, NSString *> *headers;
+
 - (instancetype)initWithResponseData:(NSData *_Nullable)responseData
                           statusCode:(NSInteger)statusCode;
 
+- (instancetype)initWithResponseData:(NSData *_Nullable)responseData
+                          statusCode:(NSInteger)statusCode
+                             headers:(NSDictionary<NSString *, NSString *> *_Nullable)headers;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -23,12 +23,20 @@
 
 - (instancetype)initWithResponseData:(NSData *_Nullable)responseData
                           statusCode:(NSInteger)statusCode
+{
+    return [self initWithResponseData:responseData statusCode:statusCode headers:nil];
+}
+
+- (instancetype)initWithResponseData:(NSData *_Nullable)responseData
+                          statusCode:(NSInteger)statusCode
+                             headers:(NSDictionary<NSString *, NSString *> *_Nullable)headers
 {
     self = [super init];
     if (self)
     {
         _responseAsData = responseData;
         _statusCode = statusCode;
+        _headers = headers;
         _hasError = (statusCode >= 400);
         
         if (_hasError)
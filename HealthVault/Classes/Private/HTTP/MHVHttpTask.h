@@ -28,6 +28,15 @@ NS_ASSUME_NONNULL_BEGIN
 - (instancetype)initWithURLSessionTask:(NSURLSessionTask *_Nullable)task totalSize:(NSUInteger)totalSize;
 - (instancetype)init __unavailable;
 
+/**
+ YES once cancel has been called, so no more tasks should be added
+ */
+@property (nonatomic, assign, readonly) BOOL isCancelled;
+
+/**
+ Add a task to the tasks that are cancelled together and whose bytes sent make the progress.
+ Can be called from any thread, as tasks of a blob upload finish.
+ */
 - (void)addTask:(NSURLSessionTask *)task;
 
 @end
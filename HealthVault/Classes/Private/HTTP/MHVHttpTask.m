@@ -27,9 +27,10 @@ static NSString *kProgressKeyPath = @"progress";
 @interface MHVHttpTask ()
 
 @property (nonatomic, assign) double progress;
+@property (nonatomic, assign) BOOL isCancelled;
 @property (nonatomic, strong) NSNumber *totalSize;
 
-//A Blob upload can have several tasks, as it is uploaded in chunks. Array for all tasks
+//A Blob upload can have several tasks, as it is uploaded in chunks, several at a time. Array for all tasks, guarded by @synchronized (self)
 @property (nonatomic, strong) NSMutableArray<NSURLSessionTask *> *tasks;
 
 @end
@@ -75,14 +76,30 @@ static NSString *kProgressKeyPath = @"progress";
     
     [self startObserving:task];
 
-    [self.tasks addObject:task];
+    @synchronized (self)
+    {
+        [self.tasks addObject:task];
+        
+        if (self.isCancelled)
+        {
+            [task cancel];
+        }
+    }
     
     [self updateProgress];
 }
 
 - (void)cancel
 {
-    for (NSURLSessionTask *task in self.tasks)
+    NSArray<NSURLSessionTask *> *tasks = nil;
+    
+    @synchronized (self)
+    {
+        self.isCancelled = YES;
+        tasks = [self.tasks copy];
+    }
+    
+    for (NSURLSessionTask *task in tasks)
     {
         [task cancel];
     }
@@ -94,8 +111,14 @@ static NSString *kProgressKeyPath = @"progress";
     double countOfBytesSent = 0;
     double countOfBytesExpectedToSend = 0;
     double countOfBytesExpectedToReceive = 0;
+    NSArray<NSURLSessionTask *> *tasks = nil;
+    
+    @synchronized (self)
+    {
+        tasks = [self.tasks copy];
+    }
 
-    for (NSURLSessionTask *task in self.tasks)
+    for (NSURLSessionTask *task in tasks)
     {
         countOfBytesReceived += task.countOfBytesReceived;
         countOfBytesSent += task.countOfBytesSent;
@@ -63,6 +63,7 @@ typedef NS_ENUM (NSInteger, MHVServerStatusCode)
 @property (nonatomic, assign) int statusCode;
 
 /// Gets or sets the informational part of the response.
+/// For XML responses this is extracted from the raw response bytes on first access.
 @property (nonatomic, strong) NSString *infoXml;
 
 /// Gets the response data
@@ -70,10 +71,35 @@ typedef NS_ENUM (NSInteger, MHVServerStatusCode)
 
 @property (nonatomic, strong) NSError *error;
 
+/// For REST requests with a resultClass, the response deserialized into that class.
+/// A result returned from the cache is a copy, so changing it doesn't change later responses.
+@property (nonatomic, strong) id resultObject;
+
 /// Initializes a new instance of the MHVServiceResponse class.
 /// The response will be parsed into infoXml
 /// @param response - the web response from server side.
 /// @param isXML - whether the response HealthVault XML and infoXml should be filled.
 - (instancetype)initWithWebResponse:(MHVHttpServiceResponse *)response isXML:(BOOL)isXML;
 
+/// Initializes a new instance from an XML response body that is still downloading.
+/// The info element is deserialized into info as the body is read from the stream, so
+/// parsing overlaps the download. infoXml is not filled.
+/// @param statusCode - the http status code of the response.
+/// @param stream - the response body. Reads block until more of the body arrives.
+/// @param info - the XSerializable object the info element should be read into.
+- (instancetype)initWithStatusCode:(NSInteger)statusCode stream:(NSInputStream *)stream info:(id)info;
+
+/// Deserializes the informational part of the response into a new instance of classObj.
+/// The info element is read straight from the response bytes in a single pass,
+/// without first being copied into infoXml.
+/// @param classObj - the XSerializable class the info element should be read into.
+/// @returns the deserialized object, or nil if the response has no info.
+- (id)infoAsClass:(Class)classObj;
+
+/// Deserializes the informational part of the response into an existing object,
+/// for objects that need to be configured before they are read.
+/// @param info - the XSerializable object the info element should be read into.
+/// @returns YES if the response had info to read.
+- (BOOL)readInfoIntoObject:(id)info;
+
 @end
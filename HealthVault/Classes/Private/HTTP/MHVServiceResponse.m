@@ -18,13 +18,26 @@
 
 #import "MHVValidator.h"
 #import "MHVServiceResponse.h"
-#import "MHVResponse.h"
+#import "MHVResponseStatus.h"
 #import "NSError+MHVError.h"
 #import "MHVErrorConstants.h"
 #import "MHVHttpServiceResponse.h"
+#import "XSerializer.h"
+
+static const xmlChar *x_element_response = XMLSTRINGCONST("response");
+static const xmlChar *x_element_status = XMLSTRINGCONST("status");
+
+@interface MHVServiceResponse ()
+
+// Raw bytes of an XML response. The info element is parsed from these on demand.
+@property (nonatomic, strong) NSData *xmlData;
+
+@end
 
 @implementation MHVServiceResponse
 
+@synthesize infoXml = _infoXml;
+
 - (instancetype)initWithWebResponse:(MHVHttpServiceResponse *)response isXML:(BOOL)isXML
 {
     self = [super init];
@@ -42,13 +55,14 @@
         }
         else if (isXML)
         {
-            NSString *xml = response.responseAsString;
+            _xmlData = response.responseAsData;
             
-            BOOL xmlReaderResult = [self deserializeXml:xml];
+            BOOL xmlReaderResult = [self deserializeStatus];
             
             if (!xmlReaderResult)
             {
-                _error = [NSError error:[NSError MHVUnknownError] withDescription:[NSString stringWithFormat:@"Response was not a valid HealthVault response.\n%@",xml]];
+                _xmlData = nil;
+                _error = [NSError error:[NSError MHVUnknownError] withDescription:[NSString stringWithFormat:@"Response was not a valid HealthVault response.\n%@", response.responseAsString]];
             }
         }
         else
@@ -60,17 +74,143 @@
     return self;
 }
 
-- (BOOL)deserializeXml:(NSString *)xml
+- (instancetype)initWithStatusCode:(NSInteger)statusCode stream:(NSInputStream *)stream info:(id)info
+{
+    MHVASSERT_PARAMETER(stream);
+    MHVASSERT_PARAMETER(info);
+    
+    self = [super init];
+    
+    if (self)
+    {
+        _statusCode = (int)statusCode;
+        
+        if (statusCode >= 400)
+        {
+            if (_statusCode == 401)
+            {
+                _error = [NSError error:[NSError MHVUnauthorizedError] withDescription:@"The Authorization token is missing, malformed or expired."];
+            }
+            else
+            {
+                _error = [NSError error:[NSError MHVNetworkError] withDescription:[NSHTTPURLResponse localizedStringForStatusCode:statusCode]];
+            }
+            
+            return self;
+        }
+        
+        XReader *reader = [[XReader alloc] initFromStream:stream];
+        MHVResponseStatus *status = nil;
+        
+        if (![self moveReader:reader pastStatus:&status])
+        {
+            _error = [NSError error:[NSError MHVUnknownError] withDescription:@"Response was not a valid HealthVault response."];
+            return self;
+        }
+        
+        [self applyStatus:status];
+        
+        if (!self.error && [reader isStartElement])
+        {
+            [reader readElementContentIntoObject:info];
+        }
+    }
+    
+    return self;
+}
+
+- (NSString *)infoXml
+{
+    // Responses are shared between callers waiting on the same request and by the method cache
+    @synchronized (self)
+    {
+        if (!_infoXml && self.xmlData)
+        {
+            XReader *reader = [self newReaderAfterStatus:nil];
+            
+            if ([reader isStartElement])
+            {
+                _infoXml = [reader readOuterXml];
+            }
+        }
+        
+        return _infoXml;
+    }
+}
+
+- (void)setInfoXml:(NSString *)infoXml
+{
+    @synchronized (self)
+    {
+        _infoXml = infoXml;
+    }
+}
+
+- (id)infoAsClass:(Class)classObj
+{
+    MHVCHECK_NOTNULL(classObj);
+    
+    id info = [[classObj alloc] init];
+    MHVCHECK_OOM(info);
+    
+    if (![self readInfoIntoObject:info])
+    {
+        return nil;
+    }
+    
+    return info;
+}
+
+- (BOOL)readInfoIntoObject:(id)info
+{
+    MHVCHECK_NOTNULL(info);
+    
+    XReader *reader = nil;
+    
+    if (self.xmlData)
+    {
+        reader = [self newReaderAfterStatus:nil];
+    }
+    else
+    {
+        NSString *infoXml = self.infoXml;
+        
+        if (infoXml)
+        {
+            reader = [[XReader alloc] initFromString:infoXml];
+        }
+    }
+    
+    if (![reader isStartElement])
+    {
+        return NO;
+    }
+    
+    [reader readElementContentIntoObject:info];
+    
+    return YES;
+}
+
+#pragma mark - Internal methods
+
+- (BOOL)deserializeStatus
 {
-    MHVResponse *response = (MHVResponse *)[NSObject newFromString:xml withRoot:@"response" asClass:[MHVResponse class]];
+    MHVResponseStatus *status = nil;
+    
+    XReader *reader = [self newReaderAfterStatus:&status];
     
-    if (!response)
+    if (!reader)
     {
         return NO;
     }
     
-    MHVResponseStatus *status = response.status;
+    [self applyStatus:status];
     
+    return YES;
+}
+
+- (void)applyStatus:(MHVResponseStatus *)status
+{
     if (status)
     {
         if (status.code == MHVServerStatusCodeAuthSessionTokenExpired)
@@ -91,8 +231,52 @@
             }
         }
     }
+}
+
+//
+// Returns a reader over the raw response positioned just past the <status> element,
+// i.e. on the <info> element if the response has one.
+// Only the bytes up to that point are tokenized, so this is cheap even for very large responses.
+//
+- (XReader *)newReaderAfterStatus:(MHVResponseStatus **)status
+{
+    if (self.xmlData.length == 0)
+    {
+        return nil;
+    }
+    
+    XReader *reader = [[XReader alloc] initFromMemory:self.xmlData];
+    MHVCHECK_NOTNULL(reader);
     
-    self.infoXml = response.body;
+    if (![self moveReader:reader pastStatus:status])
+    {
+        return nil;
+    }
+    
+    return reader;
+}
+
+- (BOOL)moveReader:(XReader *)reader pastStatus:(MHVResponseStatus **)status
+{
+    if (![reader isStartElementWithXmlName:x_element_response])
+    {
+        return NO;
+    }
+    
+    if (![reader readStartElementWithXmlName:x_element_response])
+    {
+        // <response/> - valid, but has neither status nor info
+        return YES;
+    }
+    
+    if (status)
+    {
+        *status = [reader readElementWithXmlName:x_element_status asClass:[MHVResponseStatus class]];
+    }
+    else
+    {
+        [reader skipSingleElementWithXmlName:x_element_status];
+    }
     
     return YES;
 }
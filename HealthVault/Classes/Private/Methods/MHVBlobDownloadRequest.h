@@ -28,6 +28,16 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, strong, readonly, nullable) NSString      *toFilePath;
 @property (nonatomic, assign, readonly)           BOOL          isAnonymous;
 
+/**
+ * Key of the blob in the connection's blob cache. If nil, the blob is always downloaded
+ */
+@property (nonatomic, strong, nullable)           NSString      *blobCacheKey;
+
+/**
+ * Length of the blob in bytes, if known. A download with a different length isn't cached
+ */
+@property (nonatomic, assign)                     NSInteger     blobLength;
+
 /**
  * Create blob download request
  *
@@ -24,6 +24,7 @@
 @implementation MHVBlobDownloadRequest
 
 @synthesize cache = _cache;
+@synthesize priority = _priority;
 
 - (instancetype)initWithURL:(NSURL *)url
                  toFilePath:(NSString *)toFilePath
@@ -37,6 +38,7 @@
         _url = url;
         _toFilePath = toFilePath;
         _isAnonymous = YES;
+        _priority = MHVRequestPriorityBlobTransfer;
     }
     return self;
 }
@@ -20,6 +20,8 @@
 #import "MHVBlobSource.h"
 #import "MHVHttpServiceOperationProtocol.h"
 
+@class MHVBlobHashInfo;
+
 NS_ASSUME_NONNULL_BEGIN
 
 @interface MHVBlobUploadRequest : NSObject <MHVHttpServiceOperationProtocol>
@@ -39,6 +41,40 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic, assign, readonly) NSUInteger chunkSize;
 
+/**
+ Length of the blob already stored at the destination url, when continuing an upload that stopped part way. Defaults to 0.
+ If it is the whole blob, nothing is sent, but the blob is still checked and hashed
+ */
+@property (nonatomic, assign) NSUInteger startOffset;
+
+/**
+ The chunk digests committedLengthHandler was last given, when continuing an upload. The upload fails with
+ MHVErrorTypeOperationCannotBePerformed if the part of the blob already stored doesn't match them
+ */
+@property (nonatomic, strong, nullable) NSData *storedChunkDigests;
+
+/**
+ Called each time the length of the blob stored from its start grows, so the upload can be continued from there,
+ with the SHA256 of each chunk in that length
+ */
+@property (nonatomic, copy, nullable) void (^committedLengthHandler)(NSUInteger committedLength, NSData *chunkDigests);
+
+/**
+ Compute the blob's SHA256Block hash as it is uploaded. Defaults to NO
+ */
+@property (nonatomic, assign) BOOL shouldComputeHash;
+
+/**
+ Block size for the hash, as given by HealthVault when requesting to upload a blob.
+ If 0, the configuration's inlineBlobHashBlockSize is used
+ */
+@property (nonatomic, assign) NSUInteger hashBlockSize;
+
+/**
+ The hash of the whole blob, set when the upload succeeds if shouldComputeHash is YES
+ */
+@property (nonatomic, strong, nullable) MHVBlobHashInfo *hashInfo;
+
 /**
  * Create blob upload request
  *
@@ -32,6 +32,7 @@
 @implementation MHVBlobUploadRequest
 
 @synthesize cache = _cache;
+@synthesize priority = _priority;
 
 - (instancetype)initWithBlobSource:(id<MHVBlobSourceProtocol>)blobSource
                     destinationURL:(NSURL *)destinationURL
@@ -47,6 +48,7 @@
         _destinationURL = destinationURL;
         _chunkSize = chunkSize != 0 ? chunkSize : kDefaultBlobChunkSizeInBytes;
         _isAnonymous = YES;
+        _priority = MHVRequestPriorityBlobTransfer;
     }
     return self;
 }
@@ -18,6 +18,9 @@
 //
 
 #import <Foundation/Foundation.h>
+#import "MHVRequestPriority.h"
+
+static NSInteger const MHVRequestPriorityCount = MHVRequestPriorityBlobTransfer + 1;
 
 @protocol MHVHttpServiceOperationProtocol <NSObject>
 
@@ -34,6 +37,11 @@
  */
 @property (nonatomic, readwrite) NSCache *cache;
 
+/**
+ When the operation is sent if the connection is busy
+ */
+@property (nonatomic, assign) MHVRequestPriority priority;
+
 /**
  Returns the unique key or hash which should be used to store an operation in a cache.
  */
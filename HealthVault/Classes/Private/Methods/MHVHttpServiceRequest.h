@@ -32,6 +32,13 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, assign) NSInteger retryAttempts;
 @property (nonatomic, assign) BOOL hasRefreshedToken;
 
+// The session token the request was last sent with
+@property (nonatomic, strong, nullable) NSString *sessionToken;
+
+// Where the response is kept in the connection's response cache, if it is kept
+@property (nonatomic, strong, nullable) NSString *responseCacheKey;
+@property (nonatomic, assign) NSUInteger responseCacheGeneration;
+
 - (instancetype)initWithServiceOperation:(id<MHVHttpServiceOperationProtocol>)serviceOperation
                               completion:(MHVRequestCompletion _Nullable)completion;
 
@@ -21,7 +21,7 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@interface MHVMethod : NSObject <MHVHttpServiceOperationProtocol>
+@interface MHVMethod : NSObject <MHVHttpServiceOperationProtocol, NSCopying>
 
 /**
  The name of the method to be called. Reference at: http://developer.healthvault.com/pages/methods/methods.aspx
@@ -35,9 +35,28 @@ NS_ASSUME_NONNULL_BEGIN
 
 /**
  Method parameters, which will be serialized into infoxml - Optional.
+ @note If parametersData is set, this returns the same xml as a string.
  */
 @property (nonatomic, strong, nullable) NSString *parameters;
 
+/**
+ Method parameters as UTF-8 xml, copied into the request body as is - Optional.
+ Setting parametersData replaces parameters, and setting parameters replaces parametersData.
+ */
+@property (nonatomic, strong, nullable) NSData *parametersData;
+
+/**
+ Base64 SHA256 of parametersData, if it was computed while the data was written - Optional.
+ Setting parameters or parametersData clears it, so set it after parametersData.
+ */
+@property (nonatomic, strong, nullable) NSString *parametersHash;
+
+/**
+ Whether the method only reads data (Get and Search methods), so identical calls made
+ at the same time can share one response.
+ */
+@property (nonatomic, assign, readonly) BOOL isReadOnly;
+
 /**
  The record id for the person - Required if the method is record specfic (i.e. "GetThings").
  */
@@ -48,6 +67,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic, strong, nullable) NSUUID *correlationId;
 
+/**
+ An optional XSerializable object to deserialize the response info into while the response downloads.
+ When set, the response is not buffered, and the MHVServiceResponse passed to the completion has no infoXml.
+ */
+@property (nonatomic, strong, nullable) id streamingInfo;
+
 /**
  Pre-allocates a DOPU package id.
 
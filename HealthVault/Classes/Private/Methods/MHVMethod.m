@@ -27,6 +27,8 @@
 @implementation MHVMethod
 
 @synthesize cache = _cache;
+@synthesize priority = _priority;
+@synthesize parameters = _parameters;
 
 - (instancetype)initWithName:(NSString *)name version:(int)version isAnonymous:(BOOL)isAnonymous
 {
@@ -37,16 +39,64 @@
         _name = name;
         _version = version;
         _isAnonymous = isAnonymous;
+        _priority = MHVRequestPriorityUserInitiated;
     }
     
     return self;
 }
 
+- (NSString *)parameters
+{
+    if (!_parameters && _parametersData)
+    {
+        return [[NSString alloc] initWithData:_parametersData encoding:NSUTF8StringEncoding];
+    }
+    
+    return _parameters;
+}
+
+- (void)setParameters:(NSString *)parameters
+{
+    _parameters = parameters;
+    _parametersData = nil;
+    _parametersHash = nil;
+}
+
+- (void)setParametersData:(NSData *)parametersData
+{
+    _parametersData = parametersData;
+    _parameters = nil;
+    _parametersHash = nil;
+}
+
+- (BOOL)isReadOnly
+{
+    return [self.name hasPrefix:@"Get"] || [self.name hasPrefix:@"Search"];
+}
+
 - (NSString *)getCacheKey
 {
     return (self.parameters != nil) ? [self.name stringByAppendingString:self.parameters] : self.name;
 }
 
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    MHVMethod *method = [[self.class alloc] initWithName:_name version:(int)_version isAnonymous:_isAnonymous];
+    
+    method->_parameters = _parameters;
+    method->_parametersData = _parametersData;
+    method->_parametersHash = _parametersHash;
+    method->_recordId = _recordId;
+    method->_correlationId = _correlationId;
+    method->_streamingInfo = _streamingInfo;
+    method->_cache = _cache;
+    method->_priority = _priority;
+    
+    return method;
+}
+
 + (MHVMethod *)allocatePackageId;
 {
     return [[MHVMethod alloc] initWithName:@"AllocatePackageId" version:1 isAnonymous:NO];
@@ -41,7 +41,9 @@
         _parameters = [method.parameters copy];
         _recordId = [method.recordId copy];
         _correlationId = [method.correlationId copy];
-
+        
+        // Pending methods are sent when the thing cache syncs
+        self.priority = MHVRequestPriorityBackgroundSync;
     }
     
     return self;
@@ -58,6 +60,8 @@
         _identifier = [identifier copy];
         _originalRequestDate = [originalRequestDate copy];
         _name = [methodName copy];
+        
+        self.priority = MHVRequestPriorityBackgroundSync;
     }
     
     return self;
@@ -33,6 +33,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (nonatomic, strong, readonly)           NSURL         *url;
 
+// The class the response is deserialized into by the connection, so models can be kept with cached responses
+@property (nonatomic, strong, nullable)           Class         resultClass;
+
 - (instancetype)initWithPath:(NSString *)path
                   httpMethod:(NSString *)httpMethod
                   pathParams:(NSDictionary<NSString *, NSString *> *_Nullable)pathParams
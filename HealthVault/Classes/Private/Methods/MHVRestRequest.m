@@ -26,6 +26,7 @@
 @implementation MHVRestRequest
 
 @synthesize cache = _cache;
+@synthesize priority = _priority;
 
 - (instancetype)initWithPath:(NSString *)path
                   httpMethod:(NSString *)httpMethod
@@ -46,6 +47,7 @@
         _queryParams = queryParams;
         _body = body;
         _isAnonymous = isAnonymous;
+        _priority = MHVRequestPriorityUserInitiated;
     }
     return self;
 }
@@ -19,7 +19,7 @@
 #import <Foundation/Foundation.h>
 #import "MHVRequestMessageCreatorProtocol.h"
 
-@class MHVMethod, MHVAuthSession, MHVConfiguration, MHVCryptographer;
+@class MHVMethod, MHVAuthSession, MHVConfiguration, MHVCryptographer, MHVRequestMessageFragments;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -36,6 +36,15 @@ NS_ASSUME_NONNULL_BEGIN
                    messageTime:(NSDate *)messageTime
                  cryptographer:(MHVCryptographer *)cryptographer;
 
+/**
+ Create a request using header fragments that were already built for the session.
+ Connections sending many requests share one MHVRequestMessageFragments between them.
+ */
+- (instancetype)initWithMethod:(MHVMethod *)method
+                     fragments:(MHVRequestMessageFragments *)fragments
+                   messageTime:(NSDate *)messageTime
+                 cryptographer:(MHVCryptographer *)cryptographer;
+
 @end
 
 NS_ASSUME_NONNULL_END
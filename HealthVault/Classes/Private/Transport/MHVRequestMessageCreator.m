@@ -17,23 +17,31 @@
 // limitations under the License.
 
 #import "MHVRequestMessageCreator.h"
-#import "MHVDateExtensions.h"
-#import "MHVStringExtensions.h"
+#import "MHVRequestMessageFragments.h"
 #import "MHVCryptographer.h"
 #import "MHVValidator.h"
 #import "MHVMethod.h"
-#import "MHVValidator.h"
-#import "MHVConfiguration.h"
-#import "MHVAuthSession.h"
-#import "MHVClientInfo.h"
+#import "XConverter.h"
+
+static const char kRequestStart[] = "<wc-request:request xmlns:wc-request=\"urn:com.microsoft.wc.request\">";
+static const char kRequestEnd[] = "</wc-request:request>";
+static const char kAuthStart[] = "<auth><hmac-data algName=\"HMACSHA256\">";
+static const char kAuthEnd[] = "</hmac-data></auth>";
+static const char kInfoHashStart[] = "<info-hash><hash-data algName=\"SHA256\">";
+static const char kInfoHashEnd[] = "</hash-data></info-hash>";
+
+// Base64 of a SHA256 digest
+static const NSUInteger kDigestBase64Length = 44;
+
+// Room for the method, record and time headers, which are built per request
+static const NSUInteger kPerRequestHeaderCapacity = 256;
+
+#define MHVAppendLiteral(data, literal) [data appendBytes:literal length:sizeof(literal) - 1]
 
 @interface MHVRequestMessageCreator ()
 
 @property (nonatomic, strong) MHVMethod *method;
-@property (nonatomic, strong) NSString *sharedSecret;
-@property (nonatomic, strong) MHVAuthSession *authSession;
-@property (nonatomic, strong) MHVConfiguration *configuration;
-@property (nonatomic, strong) NSUUID *appId;
+@property (nonatomic, strong) MHVRequestMessageFragments *fragments;
 @property (nonatomic, strong) NSDate *messageTime;
 @property (nonatomic, strong) MHVCryptographer *cryptographer;
 
@@ -49,9 +57,27 @@
                    messageTime:(NSDate *)messageTime
                  cryptographer:(MHVCryptographer *)cryptographer
 {
-    MHVASSERT_PARAMETER(method);
     MHVASSERT_PARAMETER(authSession);
     MHVASSERT_PARAMETER(configuration);
+    
+    MHVRequestMessageFragments *fragments = [[MHVRequestMessageFragments alloc] initWithSharedSecret:sharedSecret
+                                                                                         authSession:authSession
+                                                                                       configuration:configuration
+                                                                                               appId:appId];
+    
+    return [self initWithMethod:method
+                      fragments:fragments
+                    messageTime:messageTime
+                  cryptographer:cryptographer];
+}
+
+- (instancetype)initWithMethod:(MHVMethod *)method
+                     fragments:(MHVRequestMessageFragments *)fragments
+                   messageTime:(NSDate *)messageTime
+                 cryptographer:(MHVCryptographer *)cryptographer
+{
+    MHVASSERT_PARAMETER(method);
+    MHVASSERT_PARAMETER(fragments);
     MHVASSERT_PARAMETER(messageTime);
     MHVASSERT_PARAMETER(cryptographer);
     
@@ -60,10 +86,7 @@
     if (self)
     {
         _method = method;
-        _sharedSecret = sharedSecret;
-        _authSession = authSession;
-        _configuration = configuration;
-        _appId = appId;
+        _fragments = fragments;
         _messageTime = messageTime;
         _cryptographer = cryptographer;
     }
@@ -73,114 +96,148 @@
 
 - (NSString *)xmlString
 {
-    NSMutableString *xml = [NSMutableString new];
+    return [[NSString alloc] initWithData:[self xmlData] encoding:NSUTF8StringEncoding];
+}
+
+- (NSData *)xmlData
+{
+    NSData *info = self.method.parametersData;
+    if (!info)
+    {
+        info = [(self.method.parameters != nil ? self.method.parameters : @"<info />") dataUsingEncoding:NSUTF8StringEncoding];
+    }
     
-    [xml appendString:@"<wc-request:request xmlns:wc-request=\"urn:com.microsoft.wc.request\">"];
+    NSData *sessionHeader = [self sessionHeader];
+    BOOL isSigned = self.fragments.hmacKey != nil && !self.method.isAnonymous;
     
-    NSString *infoString = self.method.parameters != nil ? self.method.parameters : @"<info />";
+    //
+    // The whole envelope is written into one buffer sized up front. The header is signed
+    // where it lies in that buffer, and the signature is written into space reserved before it.
+    //
+    NSUInteger capacity = sizeof(kRequestStart) + sizeof(kAuthStart) + kDigestBase64Length + sizeof(kAuthEnd) +
+                          sessionHeader.length + self.fragments.standardHeaders.length + kPerRequestHeaderCapacity +
+                          sizeof(kInfoHashStart) + kDigestBase64Length + sizeof(kInfoHashEnd) +
+                          info.length + sizeof(kRequestEnd);
     
-    NSMutableString *header = [[NSMutableString alloc] init];
+    NSMutableData *xml = [[NSMutableData alloc] initWithCapacity:capacity];
+    MHVCHECK_OOM(xml);
     
-    [self writeHeader:header forBody:infoString];
+    MHVAppendLiteral(xml, kRequestStart);
     
-    [self writeAuth:xml forHeader:header];
+    NSUInteger hmacOffset = 0;
+    if (isSigned)
+    {
+        MHVAppendLiteral(xml, kAuthStart);
+        hmacOffset = xml.length;
+        [xml increaseLengthBy:kDigestBase64Length];
+        MHVAppendLiteral(xml, kAuthEnd);
+    }
     
-    [xml appendString:header];
+    NSUInteger headerOffset = xml.length;
     
-    [xml appendString:infoString];
+    [self writeHeader:xml session:sessionHeader forBody:info];
     
-    [xml appendString:@"</wc-request:request>"];
+    if (isSigned)
+    {
+        NSData *header = [[NSData alloc] initWithBytesNoCopy:(uint8_t *)xml.mutableBytes + headerOffset
+                                                      length:xml.length - headerOffset
+                                                freeWhenDone:NO];
+        NSString *base64Hmac = [self.cryptographer computeSha256HmacOfData:header key:self.fragments.hmacKey];
+        NSData *hmac = [base64Hmac dataUsingEncoding:NSUTF8StringEncoding];
+        MHVASSERT(hmac.length == kDigestBase64Length);
+        
+        [xml replaceBytesInRange:NSMakeRange(hmacOffset, kDigestBase64Length) withBytes:hmac.bytes length:hmac.length];
+    }
+    
+    [xml appendData:info];
+    MHVAppendLiteral(xml, kRequestEnd);
     
     return xml;
+}
+
+- (NSData *)sessionHeader
+{
+    if (!self.fragments.authSessionHeader || self.method.isAnonymous)
+    {
+        return self.fragments.appIdHeader;
+    }
     
+    return self.fragments.authSessionHeader;
 }
 
-- (void)writeHeader:(NSMutableString *)header forBody:(NSString *)body
+- (void)writeHeader:(NSMutableData *)header session:(NSData *)sessionHeader forBody:(NSData *)body
 {
-    [header appendXmlElementStart:@"header"];
+    MHVAppendLiteral(header, "<header>");
     
     [self writeMethodHeaders:header];
     [self writeRecordHeaders:header];
-    [self writeAuthSessionHeader:header];
+    [header appendData:sessionHeader];
     [self writeStandardHeaders:header];
     [self writeHashHeader:header forBody:body];
     
-    [header appendXmlElementEnd:@"header"];
+    MHVAppendLiteral(header, "</header>");
 }
 
-- (void)writeMethodHeaders:(NSMutableString *)header
+- (void)writeMethodHeaders:(NSMutableData *)header
 {
-    [header appendXmlElement:@"method" text:self.method.name];
-    [header appendXmlElementStart:@"method-version"];
-    [header appendFormat:@"%li",(long)self.method.version];
-    [header appendXmlElementEnd:@"method-version"];
+    MHVAppendLiteral(header, "<method>");
+    [self appendString:self.method.name toData:header];
+    MHVAppendLiteral(header, "</method><method-version>");
+    
+    char version[24];
+    int length = snprintf(version, sizeof(version), "%li", (long)self.method.version);
+    [header appendBytes:version length:length];
+    
+    MHVAppendLiteral(header, "</method-version>");
 }
 
-- (void)writeRecordHeaders:(NSMutableString *)header
+- (void)writeRecordHeaders:(NSMutableData *)header
 {
     if (self.method.recordId)
     {
-        [header appendXmlElement:@"record-id" text:self.method.recordId.UUIDString];
+        MHVAppendLiteral(header, "<record-id>");
+        [self appendString:self.method.recordId.UUIDString toData:header];
+        MHVAppendLiteral(header, "</record-id>");
     }
 }
 
-- (void)writeStandardHeaders:(NSMutableString *)header
-{
-    [header appendXmlElement:@"msg-time" text:[self.messageTime dateToUtcString]];
-    [header appendXmlElementStart:@"msg-ttl"];
-    [header appendFormat:@"%ld", (long)self.configuration.requestTimeToLiveDuration];
-    [header appendXmlElementEnd:@"msg-ttl"];
-    [header appendXmlElement:@"version" text:[MHVClientInfo telemetryInfo]];
-}
-
-- (void)writeAuthSessionHeader:(NSMutableString *)header
+- (void)writeStandardHeaders:(NSMutableData *)header
 {
-    if ([NSString isNilOrEmpty:self.authSession.authToken] || self.method.isAnonymous)
-    {
-        NSUUID *appId = self.appId != nil ? self.appId : self.configuration.masterApplicationId;
-        
-        [header appendXmlElement:@"app-id" text:appId.UUIDString];
-        return;
-    }
+    char time[XDateTimeFormatLength];
+    size_t length = XFormatDateTime(self.messageTime.timeIntervalSinceReferenceDate, NULL, time);
     
-    [header appendXmlElementStart:@"auth-session"];
-    [header appendXmlElement:@"auth-token" text:self.authSession.authToken];
-    
-    if (self.authSession.userAuthToken)
-    {
-        [header appendXmlElement:@"user-auth-token" text:self.authSession.userAuthToken];
-    }
-    else if (self.authSession.offlinePersonId)
-    {
-        [header appendXmlElementStart:@"offline-person-info"];
-        [header appendXmlElement:@"offline-person-id" text:self.authSession.offlinePersonId.UUIDString];
-        [header appendXmlElementEnd:@"offline-person-info"];
-    }
+    MHVAppendLiteral(header, "<msg-time>");
+    [header appendBytes:time length:length];
+    MHVAppendLiteral(header, "</msg-time>");
     
-    [header appendXmlElementEnd:@"auth-session"];
+    [header appendData:self.fragments.standardHeaders];
 }
 
-- (void)writeHashHeader:(NSMutableString *)header forBody:(NSString *)body
+- (void)writeHashHeader:(NSMutableData *)header forBody:(NSData *)body
 {
     if (self.method.isAnonymous)
     {
         return;
     }
     
-    [header appendXmlElementStart:@"info-hash"];
-    [header appendFormat:@"<hash-data algName=\"SHA256\">%@</hash-data>", [self.cryptographer computeSha256Hash:body]];
-    [header appendXmlElementEnd:@"info-hash"];
+    // Bodies written by XWriter are usually hashed while they are written
+    NSString *hash = self.method.parametersHash;
+    if (!hash)
+    {
+        hash = [self.cryptographer computeSha256HashOfData:body];
+    }
+    
+    MHVAppendLiteral(header, kInfoHashStart);
+    [self appendString:hash toData:header];
+    MHVAppendLiteral(header, kInfoHashEnd);
 }
 
-- (void)writeAuth:(NSMutableString *)xml forHeader:(NSString *)header
+- (void)appendString:(NSString *)string toData:(NSMutableData *)data
 {
-    if (self.sharedSecret && !self.method.isAnonymous)
+    const char *chars = string.UTF8String;
+    if (chars)
     {
-        NSData *decodedKey = [[NSData alloc] initWithBase64EncodedString:self.sharedSecret options:0];
-        
-        [xml appendXmlElementStart:@"auth"];
-        [xml appendFormat:@"<hmac-data algName=\"HMACSHA256\">%@</hmac-data>", [self.cryptographer computeSha256Hmac:decodedKey data:header]];
-        [xml appendXmlElementEnd:@"auth"];
+        [data appendBytes:chars length:strlen(chars)];
     }
 }
 
@@ -29,6 +29,13 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (NSString *)xmlString;
 
+/**
+ Creates the UTF-8 request XML for a given method, ready to be used as the HTTP body.
+ 
+ @return The request XML.
+ */
+- (NSData *)xmlData;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -0,0 +1,66 @@
+//
+// MHVRequestMessageFragments.h
+// MHVLib
+//
+// Copyright 2017 Microsoft Corp.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+@class MHVAuthSession, MHVConfiguration;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The parts of a request header that only change with the session, already encoded as UTF-8.
+ A connection keeps one instance and reuses it until the credentials change.
+ */
+@interface MHVRequestMessageFragments : NSObject
+
+- (instancetype)initWithSharedSecret:(NSString *_Nullable)sharedSecret
+                         authSession:(MHVAuthSession *_Nullable)authSession
+                       configuration:(MHVConfiguration *)configuration
+                               appId:(NSUUID *_Nullable)appId;
+
+/**
+ Whether the fragments were built from the same values, so they can be reused.
+ */
+- (BOOL)matchesSharedSecret:(NSString *_Nullable)sharedSecret
+                authSession:(MHVAuthSession *_Nullable)authSession
+              configuration:(MHVConfiguration *)configuration
+                      appId:(NSUUID *_Nullable)appId;
+
+/**
+ The decoded shared secret headers are signed with, or nil if requests aren't signed.
+ */
+@property (nonatomic, strong, readonly, nullable) NSData *hmacKey;
+
+/**
+ <auth-session>, or nil if there is no auth token.
+ */
+@property (nonatomic, strong, readonly, nullable) NSData *authSessionHeader;
+
+/**
+ <app-id>, used for anonymous methods and before there is an auth token.
+ */
+@property (nonatomic, strong, readonly) NSData *appIdHeader;
+
+/**
+ <msg-ttl> and <version>, which follow <msg-time>.
+ */
+@property (nonatomic, strong, readonly) NSData *standardHeaders;
+
+@end
+
+NS_ASSUME_NONNULL_END
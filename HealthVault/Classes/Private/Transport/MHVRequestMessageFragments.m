@@ -0,0 +1,134 @@
+//
+// MHVRequestMessageFragments.m
+// MHVLib
+//
+// Copyright 2017 Microsoft Corp.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "MHVRequestMessageFragments.h"
+#import "MHVStringExtensions.h"
+#import "MHVValidator.h"
+#import "MHVConfiguration.h"
+#import "MHVAuthSession.h"
+#import "MHVClientInfo.h"
+
+@interface MHVRequestMessageFragments ()
+
+@property (nonatomic, strong) NSString *sharedSecret;
+@property (nonatomic, strong) NSString *authToken;
+@property (nonatomic, strong) NSString *userAuthToken;
+@property (nonatomic, strong) NSUUID *offlinePersonId;
+@property (nonatomic, strong) NSUUID *appId;
+@property (nonatomic, assign) NSTimeInterval timeToLive;
+
+@property (nonatomic, strong) NSData *hmacKey;
+@property (nonatomic, strong) NSData *authSessionHeader;
+@property (nonatomic, strong) NSData *appIdHeader;
+@property (nonatomic, strong) NSData *standardHeaders;
+
+@end
+
+@implementation MHVRequestMessageFragments
+
+- (instancetype)initWithSharedSecret:(NSString *_Nullable)sharedSecret
+                         authSession:(MHVAuthSession *_Nullable)authSession
+                       configuration:(MHVConfiguration *)configuration
+                               appId:(NSUUID *_Nullable)appId
+{
+    MHVASSERT_PARAMETER(configuration);
+
+    self = [super init];
+
+    if (self)
+    {
+        _sharedSecret = sharedSecret;
+        _authToken = authSession.authToken;
+        _userAuthToken = authSession.userAuthToken;
+        _offlinePersonId = authSession.offlinePersonId;
+        _appId = appId;
+        _timeToLive = configuration.requestTimeToLiveDuration;
+
+        if (sharedSecret)
+        {
+            NSData *key = [[NSData alloc] initWithBase64EncodedString:sharedSecret options:0];
+            _hmacKey = key != nil ? key : [NSData data];
+        }
+
+        _authSessionHeader = [self newAuthSessionHeader];
+
+        NSUUID *headerAppId = appId != nil ? appId : configuration.masterApplicationId;
+        NSMutableString *header = [NSMutableString new];
+        [header appendXmlElement:@"app-id" text:headerAppId.UUIDString ?: @""];
+        _appIdHeader = [header dataUsingEncoding:NSUTF8StringEncoding];
+
+        header = [NSMutableString new];
+        [header appendXmlElementStart:@"msg-ttl"];
+        [header appendFormat:@"%ld", (long)_timeToLive];
+        [header appendXmlElementEnd:@"msg-ttl"];
+        [header appendXmlElement:@"version" text:[MHVClientInfo telemetryInfo]];
+        _standardHeaders = [header dataUsingEncoding:NSUTF8StringEncoding];
+    }
+
+    return self;
+}
+
+- (BOOL)matchesSharedSecret:(NSString *_Nullable)sharedSecret
+                authSession:(MHVAuthSession *_Nullable)authSession
+              configuration:(MHVConfiguration *)configuration
+                      appId:(NSUUID *_Nullable)appId
+{
+    return ([self value:self.sharedSecret isEqual:sharedSecret] &&
+            [self value:self.authToken isEqual:authSession.authToken] &&
+            [self value:self.userAuthToken isEqual:authSession.userAuthToken] &&
+            [self value:self.offlinePersonId isEqual:authSession.offlinePersonId] &&
+            [self value:self.appId isEqual:appId] &&
+            self.timeToLive == configuration.requestTimeToLiveDuration);
+}
+
+#pragma mark - Internal methods
+
+- (BOOL)value:(id)value isEqual:(id)other
+{
+    return value == other || [value isEqual:other];
+}
+
+- (NSData *)newAuthSessionHeader
+{
+    if ([NSString isNilOrEmpty:self.authToken])
+    {
+        return nil;
+    }
+
+    NSMutableString *header = [NSMutableString new];
+
+    [header appendXmlElementStart:@"auth-session"];
+    [header appendXmlElement:@"auth-token" text:self.authToken];
+
+    if (self.userAuthToken)
+    {
+        [header appendXmlElement:@"user-auth-token" text:self.userAuthToken];
+    }
+    else if (self.offlinePersonId)
+    {
+        [header appendXmlElementStart:@"offline-person-info"];
+        [header appendXmlElement:@"offline-person-id" text:self.offlinePersonId.UUIDString];
+        [header appendXmlElementEnd:@"offline-person-info"];
+    }
+
+    [header appendXmlElementEnd:@"auth-session"];
+
+    return [header dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+@end
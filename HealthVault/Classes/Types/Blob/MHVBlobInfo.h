@@ -19,6 +19,7 @@
 
 #import <Foundation/Foundation.h>
 #import "MHVBaseTypes.h"
+#import "MHVBlobHashInfo.h"
 
 @interface MHVBlobInfo : MHVType
 
@@ -36,6 +37,10 @@
 // (Optional) MIME type for this blob
 //
 @property (readwrite, nonatomic, strong) NSString *contentType;
+//
+// (Optional) Hash of the blob's content, returned by HealthVault for stored blobs
+//
+@property (readwrite, nonatomic, strong) MHVBlobHashInfo *hashInfo;
 
 // -------------------------
 //
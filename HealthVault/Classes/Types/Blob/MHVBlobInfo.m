@@ -22,6 +22,7 @@
 
 static NSString *const c_element_name = @"name";
 static NSString *const c_element_contentType = @"content-type";
+static NSString *const c_element_hashInfo = @"hash-info";
 
 @interface MHVBlobInfo ()
 
@@ -85,6 +86,7 @@ static NSString *const c_element_contentType = @"content-type";
 
     MHVVALIDATE_OPTIONAL(self.nameValue);
     MHVVALIDATE_OPTIONAL(self.contentTypeValue);
+    MHVVALIDATE_OPTIONAL(self.hashInfo);
 
     MHVVALIDATE_SUCCESS
 }
@@ -93,12 +95,14 @@ static NSString *const c_element_contentType = @"content-type";
 {
     [writer writeElement:c_element_name content:self.nameValue];
     [writer writeElement:c_element_contentType content:self.contentTypeValue];
+    [writer writeElement:c_element_hashInfo content:self.hashInfo];
 }
 
 - (void)deserialize:(XReader *)reader
 {
     self.nameValue = [reader readElement:c_element_name asClass:[MHVStringZ255 class]];
     self.contentTypeValue = [reader readElement:c_element_contentType asClass:[MHVStringZ1024 class]];
+    self.hashInfo = [reader readElement:c_element_hashInfo asClass:[MHVBlobHashInfo class]];
 }
 
 @end
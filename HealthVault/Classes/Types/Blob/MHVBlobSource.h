@@ -31,6 +31,11 @@
 
 - (NSData *)readStartAt:(NSInteger)offset chunkSize:(NSInteger)chunkSize;
 
+@optional
+
+// YES if each part of the blob can only be read once, in order. An upload of such a source can't be resumed
+@property (readonly, nonatomic) BOOL isSequential;
+
 @end
 
 @interface MHVBlobMemorySource : NSObject <MHVBlobSourceProtocol>
@@ -44,3 +49,23 @@
 - (instancetype)initWithFilePath:(NSString *)filePath;
 
 @end
+
+// Maps the file into memory, so the file is read ahead of the upload and only the chunks being uploaded use memory.
+// Each chunk is a copy, and a file that is truncated while it's uploaded gives a short read
+@interface MHVBlobMappedFileSource : NSObject<MHVBlobSourceProtocol>
+
+- (instancetype)initWithFilePath:(NSString *)filePath;
+
+@end
+
+// Reads a blob of known length from a stream as it's uploaded, e.g. a recording that is still being made.
+// Chunks must be read in order, and only the chunk being read is held in memory
+@interface MHVBlobStreamSource : NSObject<MHVBlobSourceProtocol>
+
+- (instancetype)initWithInputStream:(NSInputStream *)inputStream length:(NSUInteger)length;
+
+// Creates a source with a bounded buffer. Write the blob to outputStream from another thread; writes wait while
+// bufferSize bytes are waiting to be uploaded. Close outputStream when the whole blob has been written
+- (instancetype)initWithLength:(NSUInteger)length bufferSize:(NSUInteger)bufferSize outputStream:(NSOutputStream **)outputStream;
+
+@end
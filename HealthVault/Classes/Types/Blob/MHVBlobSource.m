@@ -19,6 +19,10 @@
 
 #import "MHVBlobSource.h"
 #import "MHVValidator.h"
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <fcntl.h>
+#import <unistd.h>
 
 // ------------------------------
 //
@@ -117,3 +121,242 @@
 }
 
 @end
+
+// ------------------------------
+//
+// MHVBlobMappedFileSource
+//
+// ------------------------------
+@interface MHVBlobMappedFileSource ()
+
+@property (nonatomic, assign) int fileDescriptor;
+@property (nonatomic, assign) uint8_t *bytes;
+@property (nonatomic, assign) NSUInteger size;
+
+@end
+
+@implementation MHVBlobMappedFileSource
+
+- (NSUInteger)length
+{
+    return self.size;
+}
+
+- (instancetype)init
+{
+    return [self initWithFilePath:nil];
+}
+
+- (instancetype)initWithFilePath:(NSString *)filePath
+{
+    self = [super init];
+    if (self)
+    {
+        _fileDescriptor = -1;
+
+        MHVCHECK_NOTNULL(filePath);
+
+        // Kept open to check the file still covers each chunk before it's read
+        _fileDescriptor = open(filePath.fileSystemRepresentation, O_RDONLY);
+        MHVCHECK_TRUE(_fileDescriptor >= 0);
+
+        struct stat fileStat;
+        if (fstat(_fileDescriptor, &fileStat) != 0)
+        {
+            return nil;
+        }
+
+        _size = (NSUInteger)fileStat.st_size;
+
+        // An empty file can't be mapped, and has nothing to read
+        if (_size > 0)
+        {
+            void *bytes = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, _fileDescriptor, 0);
+            MHVCHECK_TRUE(bytes != MAP_FAILED);
+
+            // Chunks are read in order, so the pages ahead can be read from disk early
+            madvise(bytes, _size, MADV_SEQUENTIAL);
+
+            _bytes = bytes;
+        }
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_bytes)
+    {
+        munmap(_bytes, _size);
+    }
+
+    if (_fileDescriptor >= 0)
+    {
+        close(_fileDescriptor);
+    }
+}
+
+- (NSData *)readStartAt:(NSInteger)offset chunkSize:(NSInteger)chunkSize
+{
+    if (offset < 0 || chunkSize < 0 || (NSUInteger)offset > self.size)
+    {
+        return nil;
+    }
+
+    NSUInteger length = MIN((NSUInteger)chunkSize, self.size - offset);
+
+    if (length == 0)
+    {
+        return [NSData data];
+    }
+
+    // Reading a page the file no longer covers raises SIGBUS, so a file truncated since it was mapped gives a short read.
+    // The chunk is copied out here, rather than read later through the mapping by whatever sends it
+    struct stat fileStat;
+    if (fstat(self.fileDescriptor, &fileStat) != 0 || (NSUInteger)fileStat.st_size < offset + length)
+    {
+        return nil;
+    }
+
+    NSData *data = [NSData dataWithBytes:self.bytes + offset length:length];
+
+    // The chunk's pages are given back, so memory use stays at the chunks still being uploaded
+    uintptr_t pageMask = (uintptr_t)getpagesize() - 1;
+    uintptr_t pageStart = (uintptr_t)(self.bytes + offset) & ~pageMask;
+
+    madvise((void *)pageStart, length + ((uintptr_t)(self.bytes + offset) - pageStart), MADV_DONTNEED);
+
+    return data;
+}
+
+@end
+
+// ------------------------------
+//
+// MHVBlobStreamSource
+//
+// ------------------------------
+@interface MHVBlobStreamSource ()
+
+@property (nonatomic, strong) NSInputStream *stream;
+@property (nonatomic, assign) NSUInteger size;
+
+// The offset of the next byte in the stream. Guarded by @synchronized (self)
+@property (nonatomic, assign) NSUInteger streamOffset;
+
+@end
+
+@implementation MHVBlobStreamSource
+
+- (NSUInteger)length
+{
+    return self.size;
+}
+
+- (BOOL)isSequential
+{
+    return YES;
+}
+
+- (instancetype)init
+{
+    return [self initWithInputStream:nil length:0];
+}
+
+- (instancetype)initWithInputStream:(NSInputStream *)inputStream length:(NSUInteger)length
+{
+    MHVCHECK_NOTNULL(inputStream);
+
+    self = [super init];
+    if (self)
+    {
+        _stream = inputStream;
+        _size = length;
+    }
+
+    return self;
+}
+
+- (instancetype)initWithLength:(NSUInteger)length bufferSize:(NSUInteger)bufferSize outputStream:(NSOutputStream **)outputStream
+{
+    MHVCHECK_NOTNULL(outputStream);
+    MHVCHECK_TRUE(bufferSize > 0);
+
+    CFReadStreamRef readStream = NULL;
+    CFWriteStreamRef writeStream = NULL;
+    CFStreamCreateBoundPair(kCFAllocatorDefault, &readStream, &writeStream, (CFIndex)bufferSize);
+
+    *outputStream = CFBridgingRelease(writeStream);
+
+    return [self initWithInputStream:CFBridgingRelease(readStream) length:length];
+}
+
+- (void)dealloc
+{
+    [_stream close];
+}
+
+- (NSData *)readStartAt:(NSInteger)offset chunkSize:(NSInteger)chunkSize
+{
+    @synchronized (self)
+    {
+        // Bytes that were already read are gone
+        MHVASSERT(offset >= 0 && (NSUInteger)offset >= self.streamOffset);
+
+        if (offset < 0 || chunkSize < 0 || (NSUInteger)offset < self.streamOffset)
+        {
+            return nil;
+        }
+
+        if (self.stream.streamStatus == NSStreamStatusNotOpen)
+        {
+            [self.stream open];
+        }
+
+        // Skip ahead to the offset, then read the chunk. Reads wait until the stream has more bytes, or ends
+        if (![self readLength:offset - self.streamOffset intoData:nil])
+        {
+            return nil;
+        }
+
+        NSMutableData *data = [NSMutableData dataWithCapacity:chunkSize];
+
+        if (![self readLength:chunkSize intoData:data])
+        {
+            return nil;
+        }
+
+        return data;
+    }
+}
+
+// Only called inside @synchronized (self). Returns NO if the stream failed; a stream that ends early gives a short read
+- (BOOL)readLength:(NSUInteger)length intoData:(NSMutableData *)data
+{
+    uint8_t buffer[16 * 1024];
+
+    while (length > 0)
+    {
+        NSInteger count = [self.stream read:buffer maxLength:MIN(sizeof(buffer), length)];
+
+        if (count < 0)
+        {
+            return NO;
+        }
+
+        if (count == 0)
+        {
+            break;
+        }
+
+        [data appendBytes:buffer length:count];
+
+        length -= count;
+        self.streamOffset += count;
+    }
+
+    return YES;
+}
+
+@end
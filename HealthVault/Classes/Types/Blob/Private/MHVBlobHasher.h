@@ -0,0 +1,58 @@
+//
+// MHVBlobHasher.h
+// MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+@class MHVBlobHashInfo;
+
+static NSString *const kMHVBlobHashAlgorithmSHA256Block = @"SHA256Block";
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The SHA256Block hash of a blob, computed as the blob is read. The blob is split into blocks of blockSize bytes,
+ each block is hashed with SHA256, and the blob's hash is the SHA256 of the block hashes in order.
+ Not thread safe; data must be added from one queue.
+ */
+@interface MHVBlobHasher : NSObject
+
+- (instancetype)initWithBlockSize:(NSUInteger)blockSize;
+
+@property (nonatomic, assign, readonly) NSUInteger blockSize;
+
+/**
+ The number of bytes hashed so far
+ */
+@property (nonatomic, assign, readonly) NSUInteger length;
+
+/**
+ Add the next part of the blob
+ */
+- (void)appendData:(NSData *)data;
+
+/**
+ Finishes the hash. No more data can be added after this is called.
+
+ @return The hash, with its algorithm and block size, for the blob's MHVBlobInfo
+ */
+- (MHVBlobHashInfo *)hashInfo;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,114 @@
+//
+// MHVBlobHasher.m
+// MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#import "MHVBlobHasher.h"
+#import "MHVBlobHashInfo.h"
+#import "MHVCryptographer.h"
+#import "MHVValidator.h"
+
+@interface MHVBlobHasher ()
+
+@property (nonatomic, assign) NSUInteger length;
+
+@property (nonatomic, strong) MHVSha256Hash *blockHash;
+@property (nonatomic, assign) NSUInteger blockLength;
+@property (nonatomic, assign) NSUInteger blockCount;
+
+// Hashes the block hashes as each block finishes, so they don't need to be kept
+@property (nonatomic, strong) MHVSha256Hash *blobHash;
+
+@end
+
+@implementation MHVBlobHasher
+
+- (instancetype)init
+{
+    return [self initWithBlockSize:0];
+}
+
+- (instancetype)initWithBlockSize:(NSUInteger)blockSize
+{
+    MHVCHECK_TRUE(blockSize > 0);
+
+    self = [super init];
+    if (self)
+    {
+        _blockSize = blockSize;
+        _blockHash = [MHVSha256Hash new];
+        _blobHash = [MHVSha256Hash new];
+    }
+
+    return self;
+}
+
+- (void)appendData:(NSData *)data
+{
+    [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop)
+    {
+        const uint8_t *next = bytes;
+        NSUInteger remaining = byteRange.length;
+
+        while (remaining > 0)
+        {
+            NSUInteger count = MIN(remaining, self.blockSize - self.blockLength);
+
+            [self.blockHash updateWithBytes:next length:count];
+
+            next += count;
+            remaining -= count;
+            self.blockLength += count;
+            self.length += count;
+
+            if (self.blockLength == self.blockSize)
+            {
+                [self finishBlock];
+            }
+        }
+    }];
+}
+
+- (MHVBlobHashInfo *)hashInfo
+{
+    // An empty blob is a single empty block
+    if (self.blockLength > 0 || self.blockCount == 0)
+    {
+        [self finishBlock];
+    }
+
+    MHVBlobHashInfo *hashInfo = [MHVBlobHashInfo new];
+    hashInfo.algorithm = kMHVBlobHashAlgorithmSHA256Block;
+    hashInfo.params = [MHVBlobHashAlgorithmParams new];
+    hashInfo.params.blockSize = [[MHVPositiveInt alloc] initWith:(int)self.blockSize];
+    hashInfo.hash = [self.blobHash base64Digest];
+
+    return hashInfo;
+}
+
+#pragma mark - Internal methods
+
+- (void)finishBlock
+{
+    [self.blobHash updateWithData:[self.blockHash digest]];
+
+    self.blockHash = [MHVSha256Hash new];
+    self.blockLength = 0;
+    self.blockCount += 1;
+}
+
+@end
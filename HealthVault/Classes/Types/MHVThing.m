@@ -18,8 +18,11 @@
 
 #import "MHVValidator.h"
 #import "MHVThing.h"
+#import "MHVThingInternal.h"
 
 static NSString* const c_element_state = @"thing-state";
+static NSString* const c_element_data = @"data-xml";
+static NSString* const c_element_info = @"info";
 
 static const xmlChar  *x_element_key = XMLSTRINGCONST("thing-id");
 static const xmlChar  *x_element_type = XMLSTRINGCONST("type-id");
@@ -36,6 +39,9 @@ static const xmlChar  *x_element_updatedEndDate = XMLSTRINGCONST("updated-end-da
 
 @implementation MHVThing
 
+@synthesize data = _data;
+@synthesize dataXml = _dataXml;
+
 - (BOOL)hasKey
 {
     return self.key != nil;
@@ -48,7 +54,60 @@ static const xmlChar  *x_element_updatedEndDate = XMLSTRINGCONST("updated-end-da
 
 - (BOOL)hasData
 {
-    return self.data != nil;
+    @synchronized (self)
+    {
+        return _data != nil || _dataXml != nil;
+    }
+}
+
+- (BOOL)hasDeferredData
+{
+    return self.dataXml != nil;
+}
+
+// Things read from a query may be used from several threads, so data and dataXml are only changed together under the lock
+- (MHVThingData *)data
+{
+    @synchronized (self)
+    {
+        if (!_data && _dataXml)
+        {
+            // Xml that can't be parsed is kept, so the thing still serializes what HealthVault returned
+            MHVThingData *data = [self newDataFromXml:_dataXml];
+            if (data)
+            {
+                _data = data;
+                _dataXml = nil;
+            }
+        }
+        
+        return _data;
+    }
+}
+
+- (void)setData:(MHVThingData *)data
+{
+    @synchronized (self)
+    {
+        _data = data;
+        _dataXml = nil;
+    }
+}
+
+- (NSString *)dataXml
+{
+    @synchronized (self)
+    {
+        return _dataXml;
+    }
+}
+
+- (void)setDataXml:(NSString *)dataXml
+{
+    @synchronized (self)
+    {
+        _dataXml = dataXml;
+    }
 }
 
 - (BOOL)hasTypedData
@@ -291,7 +350,12 @@ static const xmlChar  *x_element_updatedEndDate = XMLSTRINGCONST("updated-end-da
     thing.effectiveDate = self.effectiveDate;
     thing.created = self.created;
     thing.updated = self.updated;
-    if (self.hasData)
+    NSString *dataXml = self.dataXml;
+    if (dataXml)
+    {
+        thing.dataXml = dataXml;
+    }
+    else if (self.hasData)
     {
         thing.data = self.data;
     }
@@ -330,7 +394,11 @@ static const xmlChar  *x_element_updatedEndDate = XMLSTRINGCONST("updated-end-da
     
     MHVVALIDATE_OPTIONAL(self.key);
     MHVVALIDATE_OPTIONAL(self.type);
-    MHVVALIDATE_OPTIONAL(self.data);
+    if (!self.hasDeferredData)
+    {
+        // Deferred data is unchanged from what HealthVault returned
+        MHVVALIDATE_OPTIONAL(self.data);
+    }
     MHVVALIDATE_OPTIONAL(self.blobs);
     
     MHVVALIDATE_SUCCESS;
@@ -345,7 +413,15 @@ static const xmlChar  *x_element_updatedEndDate = XMLSTRINGCONST("updated-end-da
     [writer writeElementXmlName:x_element_effectiveDate dateValue:self.effectiveDate];
     [writer writeElementXmlName:x_element_created content:self.created];
     [writer writeElementXmlName:x_element_updated content:self.updated];
-    [writer writeElementXmlName:x_element_data content:self.data];
+    NSString *dataXml = self.dataXml;
+    if (dataXml)
+    {
+        [writer writeRaw:dataXml];
+    }
+    else
+    {
+        [writer writeElementXmlName:x_element_data content:self.data];
+    }
     if ([self hasBlobData])
     {
         [writer writeElementXmlName:x_element_blobs content:self.blobs];
@@ -368,7 +444,15 @@ static const xmlChar  *x_element_updatedEndDate = XMLSTRINGCONST("updated-end-da
     self.effectiveDate = [reader readDateElementXmlName:x_element_effectiveDate];
     self.created = [reader readElementWithXmlName:x_element_created asClass:[MHVAudit class]];
     self.updated = [reader readElementWithXmlName:x_element_updated asClass:[MHVAudit class]];
-    self.data = [reader readElementWithXmlName:x_element_data asClass:[MHVThingData class]];
+    if (self.shouldDeferData)
+    {
+        self.data = nil;
+        self.dataXml = [reader readElementRawWithXmlName:x_element_data];
+    }
+    else
+    {
+        self.data = [reader readElementWithXmlName:x_element_data asClass:[MHVThingData class]];
+    }
     self.blobs = [reader readElementWithXmlName:x_element_blobs asClass:[MHVBlobPayload class]];
     [reader skipElementWithXmlName:x_element_permissions];
     [reader skipElementWithXmlName:x_element_tags];
@@ -383,12 +467,51 @@ static const xmlChar  *x_element_updatedEndDate = XMLSTRINGCONST("updated-end-da
 
 - (NSString *)toXmlString
 {
-    return [self toXmlStringWithRoot:@"info"];
+    return [self toXmlStringWithRoot:c_element_info];
 }
 
 + (MHVThing *)newFromXmlString:(NSString *)xml
 {
-    return (MHVThing *)[NSObject newFromString:xml withRoot:@"info" asClass:[MHVThing class]];
+    return [MHVThing newFromXmlString:xml deferData:NO];
+}
+
++ (MHVThing *)newFromXmlString:(NSString *)xml deferData:(BOOL)deferData
+{
+    MHVCHECK_STRING(xml);
+    
+    XReader *reader = [[XReader alloc] initFromString:xml];
+    MHVCHECK_NOTNULL(reader);
+    
+    MHVThing *thing = [[MHVThing alloc] init];
+    thing.shouldDeferData = deferData;
+    
+    if ([XSerializer deserialize:reader withRoot:c_element_info into:thing])
+    {
+        return thing;
+    }
+    
+    return nil;
+}
+
+#pragma mark - Internal methods
+
+- (MHVThingData *)newDataFromXml:(NSString *)xml
+{
+    XReader *reader = [[XReader alloc] initFromString:xml];
+    MHVCHECK_NOTNULL(reader);
+    
+    // MHVThingData finds the class for the typed data through the reader's context,
+    // which MHVThingType sets when the whole thing is deserialized
+    reader.context = self.type;
+    
+    MHVThingData *data = [[MHVThingData alloc] init];
+    
+    if ([XSerializer deserialize:reader withRoot:c_element_data into:data])
+    {
+        return data;
+    }
+    
+    return nil;
 }
 
 @end
@@ -66,6 +66,10 @@
 - (MHVThingDataTyped *)newFromTypeID:(NSString *)typeID;
 - (Class)getClassForTypeID:(NSString *)typeID;
 - (NSString *)getTypeIDForClassName:(NSString *)name;
+//
+// All registered type IDs, sorted
+//
+- (NSArray<NSString *> *)typeIDs;
 - (BOOL)addClass:(Class)class forTypeID:(NSString *)typeID;
 
 @end
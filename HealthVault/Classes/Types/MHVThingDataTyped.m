@@ -212,6 +212,14 @@ static MHVTypeSystem *s_typeRegistry;
     return [self.identifiers objectForKey:name];
 }
 
+- (NSArray<NSString *> *)typeIDs
+{
+    @synchronized(self.types)
+    {
+        return [self.types.allKeys sortedArrayUsingSelector:@selector(compare:)];
+    }
+}
+
 - (BOOL)addClass:(Class)class forTypeID : (NSString *)typeID
 {
     MHVCHECK_NOTNULL(typeID);
@@ -77,6 +77,17 @@
  */
 @property (readwrite, nonatomic) BOOL shouldUseCachedResults;
 
+/**
+ Flag to indicate if the data xml of the returned Things should be kept as raw xml, and only deserialized into typed objects when a Thing's data is first accessed. The default value is NO.
+ @note Useful when only keys, types and dates are displayed for a large number of Things. A Thing whose data is never accessed is serialized back (e.g. for PutThings or the Thing cache) using the original xml.
+ */
+@property (readwrite, nonatomic) BOOL shouldDeferTypedData;
+
+/**
+ Flag to indicate the user is waiting on the results, e.g. a screen that is loading. When the connection is busy, the query is sent ahead of other requests. The default value is NO.
+ */
+@property (readwrite, nonatomic) BOOL isInteractive;
+
 /**
  Initializes a new query and adds the given Thing Filter to the filters collection.
 
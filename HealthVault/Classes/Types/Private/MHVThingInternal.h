@@ -0,0 +1,39 @@
+//
+// MHVThingInternal.h
+// MHVLib
+//
+// Copyright (c) 2017 Microsoft Corporation. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+#import "MHVThing.h"
+
+@interface MHVThing ()
+
+//
+// When set before the thing is deserialized, <data-xml> is kept as raw xml
+// and only deserialized into MHVThingData when data is first accessed
+//
+@property (readwrite, nonatomic) BOOL shouldDeferData;
+//
+// The raw <data-xml> element, until data is accessed or replaced.
+// While set, the thing serializes this xml verbatim
+//
+@property (readwrite, nonatomic, strong) NSString *dataXml;
+
+@property (readonly, nonatomic) BOOL hasDeferredData;
+
++ (MHVThing *)newFromXmlString:(NSString *)xml deferData:(BOOL)deferData;
+
+@end
@@ -44,6 +44,19 @@
 //
 @property (readwrite, nonatomic, assign) BOOL isCachedResult;
 //
+// Optional. When set, each thing is handed to this block as soon as it has been read,
+// instead of being collected into things, so a streamed response never holds more than one thing
+//
+@property (readwrite, nonatomic, copy) void (^thingHandler)(MHVThing *thing, NSString *resultName);
+//
+// When set, things keep their data xml raw until their data is accessed
+//
+@property (readwrite, nonatomic) BOOL shouldDeferTypedData;
+//
+// The number of things handed to thingHandler
+//
+@property (readonly, nonatomic) NSUInteger streamedThingCount;
+//
 // Convenience properties
 //
 @property (readonly, nonatomic) BOOL hasThings;
@@ -19,11 +19,23 @@
 #import "MHVValidator.h"
 #import "MHVThingQueryResultInternal.h"
 #import "NSArray+Utils.h"
+#import "MHVThingInternal.h"
 
 static NSString *const c_element_thing = @"thing";
 static NSString *const c_element_pending = @"unprocessed-thing-key-info";
 static NSString *const c_attribute_name = @"name";
 
+static const xmlChar *x_element_thing = XMLSTRINGCONST("thing");
+
+// Results up to this size are not worth copying out for concurrent deserialization
+static const NSUInteger c_sequentialThingCount = 64;
+
+@interface MHVThingQueryResultInternal ()
+
+@property (readwrite, nonatomic) NSUInteger streamedThingCount;
+
+@end
+
 @implementation MHVThingQueryResultInternal
 
 - (instancetype)init
@@ -79,9 +91,30 @@ static NSString *const c_attribute_name = @"name";
 
 - (void)deserialize:(XReader *)reader
 {
-    self.things = [reader readElementArray:c_element_thing
-                                   asClass:[MHVThing class]
-                             andArrayClass:[NSMutableArray class]];
+    if (self.thingHandler)
+    {
+        while ([reader isStartElementWithXmlName:x_element_thing])
+        {
+            self.thingHandler([self readThing:reader], self.name);
+            self.streamedThingCount += 1;
+        }
+    }
+    else
+    {
+        BOOL shouldDeferData = self.shouldDeferTypedData;
+        
+        // Large results are deserialized on several threads, in the order HealthVault returned them
+        self.things = [reader readElementArrayWithXmlName:x_element_thing
+                                          sequentialCount:c_sequentialThingCount
+                                           maxConcurrency:[NSProcessInfo processInfo].activeProcessorCount
+                                                newObject:^id<XSerializable>
+                       {
+                           MHVThing *thing = [[MHVThing alloc] init];
+                           thing.shouldDeferData = shouldDeferData;
+                           return thing;
+                       }];
+    }
+    
     self.pendingThings = [reader readElementArray:c_element_pending
                                           asClass:[MHVPendingThing class]
                                     andArrayClass:[NSMutableArray class]];
@@ -89,6 +122,16 @@ static NSString *const c_attribute_name = @"name";
 
 #pragma mark - Internal methods
 
+- (MHVThing *)readThing:(XReader *)reader
+{
+    MHVThing *thing = [[MHVThing alloc] init];
+    thing.shouldDeferData = self.shouldDeferTypedData;
+    
+    [reader readElementRequiredWithXmlName:x_element_thing intoObject:thing];
+    
+    return thing;
+}
+
 - (void)appendFoundThings:(NSArray<MHVThing *> *)things
 {
     if (!self.things)
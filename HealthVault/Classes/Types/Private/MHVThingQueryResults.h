@@ -27,5 +27,14 @@
 @property (readwrite, nonatomic, strong) NSArray<MHVThingQueryResultInternal *> *results;
 @property (readonly, nonatomic) BOOL hasResults;
 @property (readonly, nonatomic, strong) MHVThingQueryResultInternal *firstResult;
+//
+// Optional. Passed on to each result as it is read - see MHVThingQueryResultInternal
+//
+@property (readwrite, nonatomic, copy) void (^thingHandler)(MHVThing *thing, NSString *resultName);
+//
+// Optional. Names of the results whose things should defer deserializing their typed data
+// - see MHVThingQuery shouldDeferTypedData
+//
+@property (readwrite, nonatomic, strong) NSSet<NSString *> *deferredResultNames;
 
 @end
@@ -21,6 +21,7 @@
 #import "NSArray+Utils.h"
 
 static NSString *const c_element_result = @"group";
+static NSString *const c_attribute_name = @"name";
 
 @implementation MHVThingQueryResults
 
@@ -41,6 +42,24 @@ static NSString *const c_element_result = @"group";
 
 - (void)deserialize:(XReader *)reader
 {
+    if (self.thingHandler || self.deferredResultNames.count > 0)
+    {
+        NSMutableArray<MHVThingQueryResultInternal *> *results = [NSMutableArray new];
+        
+        while ([reader isStartElementWithName:c_element_result])
+        {
+            MHVThingQueryResultInternal *result = [[MHVThingQueryResultInternal alloc] init];
+            result.thingHandler = self.thingHandler;
+            result.shouldDeferTypedData = [self.deferredResultNames containsObject:[reader readAttribute:c_attribute_name]];
+            
+            [reader readElementRequired:c_element_result intoObject:result];
+            [results addObject:result];
+        }
+        
+        self.results = results;
+        return;
+    }
+    
     self.results = [reader readElementArray:c_element_result
                                     asClass:[MHVThingQueryResultInternal class]
                               andArrayClass:[NSMutableArray class]];
@@ -23,10 +23,33 @@
 @protocol MHVCryptographer <NSObject>
 
 -(NSString *)computeSha256Hash: (NSString *)data;
+-(NSString *)computeSha256HashOfData:(NSData *)data;
 -(NSString *)computeSha256Hmac:(NSData *)key data:(NSString *)data;
+-(NSString *)computeSha256HmacOfData:(NSData *)data key:(NSData *)key;
 
 @end
 
 @interface MHVCryptographer : NSObject<MHVCryptographer>
 
 @end
+
+/**
+ Incremental SHA256, for hashing data in chunks as it is produced.
+ */
+@interface MHVSha256Hash : NSObject
+
+-(void)updateWithBytes:(const void *)bytes length:(NSUInteger)length;
+-(void)updateWithData:(NSData *)data;
+
+/**
+ Finishes the hash. No more data can be added after this is called.
+ */
+-(NSString *)base64Digest;
+
+/**
+ Finishes the hash, returning the digest bytes. No more data can be added after this is called.
+ */
+-(NSData *)digest;
+
+@end
+
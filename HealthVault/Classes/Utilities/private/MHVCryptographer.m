@@ -21,6 +21,13 @@
 #import "MHVCryptographer.h"
 #import <CommonCrypto/CommonHMAC.h>
 
+static NSString *MHVBase64Digest(const unsigned char *digest)
+{
+    NSData *data = [[NSData alloc] initWithBytesNoCopy:(void *)digest length:CC_SHA256_DIGEST_LENGTH freeWhenDone:NO];
+    
+    return [data base64EncodedStringWithOptions:kNilOptions];
+}
+
 @implementation MHVCryptographer
 
 - (NSString *)computeSha256Hash: (NSString *)data
@@ -28,30 +35,84 @@
     const char *chars = [data cStringUsingEncoding: NSUTF8StringEncoding];
     NSData *keyData = [NSData dataWithBytes: chars length: [data lengthOfBytesUsingEncoding:NSUTF8StringEncoding]];
     
-    uint8_t digest[CC_SHA256_DIGEST_LENGTH] = {0};
-    CC_SHA256(keyData.bytes, (uint)keyData.length, digest);
-    
-    NSString *base64String = [[NSData dataWithBytes:digest length:CC_SHA256_DIGEST_LENGTH] base64EncodedStringWithOptions:kNilOptions];
+    return [self computeSha256HashOfData:keyData];
+}
+
+- (NSString *)computeSha256HashOfData:(NSData *)data
+{
+    MHVSha256Hash *hash = [MHVSha256Hash new];
+    [hash updateWithData:data];
     
-    return base64String;
+    return [hash base64Digest];
 }
 
 - (NSString *)computeSha256Hmac: (NSData *)key data:(NSString *)data
 {
-    NSUInteger len = [key length];
-    char *cKey = (char *)[key bytes];
+    return [self computeSha256HmacOfData:[data dataUsingEncoding:NSUTF8StringEncoding] key:key];
+}
+
+- (NSString *)computeSha256HmacOfData:(NSData *)data key:(NSData *)key
+{
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
     
-    const char *cData = [data cStringUsingEncoding: NSUTF8StringEncoding];
+    CCHmac(kCCHmacAlgSHA256, key.bytes, key.length, data.bytes, data.length, digest);
     
-    unsigned char cHMAC[CC_SHA256_DIGEST_LENGTH];
+    return MHVBase64Digest(digest);
+}
+
+@end
+
+@implementation MHVSha256Hash
+{
+    CC_SHA256_CTX _context;
+}
+
+- (instancetype)init
+{
+    self = [super init];
     
-    CCHmac(kCCHmacAlgSHA256, cKey, len, cData, [data lengthOfBytesUsingEncoding:NSUTF8StringEncoding], cHMAC);
+    if (self)
+    {
+        CC_SHA256_Init(&_context);
+    }
     
-    NSData *hmac = [[NSData alloc] initWithBytes: cHMAC length: sizeof(cHMAC)];
+    return self;
+}
+
+- (void)updateWithBytes:(const void *)bytes length:(NSUInteger)length
+{
+    // CC_SHA256_Update takes a 32 bit length
+    while (length > 0)
+    {
+        CC_LONG chunk = (CC_LONG)MIN(length, (NSUInteger)UINT32_MAX);
+        CC_SHA256_Update(&_context, bytes, chunk);
+        bytes = (const uint8_t *)bytes + chunk;
+        length -= chunk;
+    }
+}
+
+- (void)updateWithData:(NSData *)data
+{
+    [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop)
+    {
+        [self updateWithBytes:bytes length:byteRange.length];
+    }];
+}
+
+- (NSString *)base64Digest
+{
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256_Final(digest, &_context);
     
-    NSString *base64String = [hmac base64EncodedStringWithOptions:kNilOptions];
+    return MHVBase64Digest(digest);
+}
+
+- (NSData *)digest
+{
+    NSMutableData *digest = [NSMutableData dataWithLength:CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256_Final(digest.mutableBytes, &_context);
     
-    return base64String;
+    return digest;
 }
 
 @end
@@ -18,15 +18,52 @@
 
 #import <Foundation/Foundation.h>
 #import <CoreFoundation/CoreFoundation.h>
+#import "XString.h"
+
+//
+// Number parsing and formatting on character buffers, such as XReader.valueRaw,
+// without NSScanner or NSString allocations.
+// Parsing follows NSScanner: leading whitespace is skipped and trailing characters are ignored.
+// Formatting writes a null terminated string of at most XNumberFormatLength chars, and returns its length.
+// Doubles are written with the fewest of 15-17 significant digits that read back as the same value.
+//
+BOOL XParseInt(const char *chars, int *result);
+BOOL XParseFloat(const char *chars, float *result);
+BOOL XParseDouble(const char *chars, double *result);
+size_t XFormatInt(int value, char *buffer);
+size_t XFormatFloat(float value, char *buffer);
+size_t XFormatDouble(double value, char *buffer);
+
+#define XNumberFormatLength 48
+
+//
+// xsd:dateTime support that does not need an NSDateFormatter, and does not allocate.
+//
+// Parses yyyy-MM-dd, yy-MM-dd and yyyy-MM-ddTHH:mm:ss[.fraction][Z|+hh:mm|-hh:mm].
+// HealthVault dates are time zone agnostic: a time with no offset, or with a 'Z' designator,
+// is read as wall clock time in timeZone. Only an explicit offset pins the time to UTC.
+// A NULL timeZone is UTC.
+//
+BOOL XParseDateTime(const char *chars, size_t length, CFTimeZoneRef timeZone, CFAbsoluteTime *result);
+
+//
+// Writes yyyy-MM-ddTHH:mm:ss.SSSZ, as wall clock time in timeZone, into buffer.
+// buffer must hold at least XDateTimeFormatLength chars. It is not null terminated.
+//
+size_t XFormatDateTime(CFAbsoluteTime time, CFTimeZoneRef timeZone, char *buffer);
+
+#define XDateTimeFormatLength 24
 
 @interface XConverter : NSObject
 
 - (BOOL)tryString:(NSString *)source toInt:(int *)result;
+- (BOOL)tryXmlString:(const xmlChar *)source toInt:(int *)result;
 - (int)stringToInt:(NSString *)source;
 - (BOOL)tryInt:(int)source toString:(NSString **)result;
 - (NSString *)intToString:(int)source;
 
 - (BOOL)tryString:(NSString *)source toFloat:(float *)result;
+- (BOOL)tryXmlString:(const xmlChar *)source toFloat:(float *)result;
 - (float)stringToFloat:(NSString *)source;
 - (BOOL)tryFloat:(float)source toString:(NSString **)result;
 - (NSString *)floatToString:(float)source;
@@ -36,6 +73,7 @@
 // Automatically takes care of trimming for leading/trailing spaces
 //
 - (BOOL)tryString:(NSString *)source toDouble:(double *)result;
+- (BOOL)tryXmlString:(const xmlChar *)source toDouble:(double *)result;
 - (double)stringToDouble:(NSString *)source;
 
 - (BOOL)tryDouble:(double)source toString:(NSString **)result;
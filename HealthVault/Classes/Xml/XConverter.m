@@ -19,30 +19,543 @@
 #import "MHVValidator.h"
 #import "XConverter.h"
 #import "MHVLogger.h"
+#import <xlocale.h>
 
-static int const c_xDateFormatCount = 6;
-static NSString *s_xDateFormats[c_xDateFormatCount] =
-{
-    @"yyyy'-'MM'-'dd'T'HHmmss'Z'",          // Zulu form
-    @"yyyy'-'MM'-'dd'T'HHmmss.SSS'Z'",      // Zulu form
-    @"yyyy'-'MM'-'dd'T'HHmmss.SSSZZZZ",     // Time zone form
-    @"yyyy'-'MM'-'dd'T'HHmmssZZZZ",          // Time zone form,
-    @"yyyy'-'MM'-'dd",
-    @"yy'-'MM'-'dd"
-};
-
-static NSString *const c_POSITIVEINF = @"INF";
-static NSString *const c_NEGATIVEINF = @"-INF";
 static NSString *const c_TRUE = @"true";
 static NSString *const c_FALSE = @"false";
 
+static int64_t const c_secondsPerDay = 86400;
+
+#pragma mark - xsd:dateTime
+
+//
+// Days since 1970-01-01 in the proleptic Gregorian calendar, and back again.
+// See http://howardhinnant.github.io/date_algorithms.html
+//
+static int64_t XDaysFromCivil(int64_t year, int month, int day)
+{
+    year -= (month <= 2);
+
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yearOfEra = year - era * 400;
+    int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+    return era * 146097 + dayOfEra - 719468;
+}
+
+static void XCivilFromDays(int64_t days, int64_t *year, int *month, int *day)
+{
+    days += 719468;
+
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t dayOfEra = days - era * 146097;
+    int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int64_t monthIndex = (5 * dayOfYear + 2) / 153;
+
+    *day = (int)(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+    *month = (int)(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+    *year = yearOfEra + era * 400 + (*month <= 2);
+}
+
+static int XDaysInMonth(int64_t year, int month)
+{
+    static const int daysInMonth[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+    if (month == 2 && (year % 4 == 0) && ((year % 100 != 0) || (year % 400 == 0)))
+    {
+        return 29;
+    }
+
+    return daysInMonth[month - 1];
+}
+
+//
+// Same window NSDateFormatter uses for 'yy': the 100 years starting 80 years ago
+//
+static int64_t XExpandTwoDigitYear(int year)
+{
+    int64_t currentYear;
+    int month, day;
+    XCivilFromDays((int64_t)floor((CFAbsoluteTimeGetCurrent() + kCFAbsoluteTimeIntervalSince1970) / c_secondsPerDay), &currentYear, &month, &day);
+
+    int64_t startYear = currentYear - 80;
+    int64_t expanded = (startYear / 100) * 100 + year;
+
+    return (expanded < startYear) ? expanded + 100 : expanded;
+}
+
+static BOOL XScanDigits(const char **cursor, const char *end, int count, int *value)
+{
+    const char *chars = *cursor;
+    if (end - chars < count)
+    {
+        return FALSE;
+    }
+
+    int result = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (chars[i] < '0' || chars[i] > '9')
+        {
+            return FALSE;
+        }
+        result = result * 10 + (chars[i] - '0');
+    }
+
+    *value = result;
+    *cursor = chars + count;
+
+    return TRUE;
+}
+
+static BOOL XScanChar(const char **cursor, const char *end, char c)
+{
+    if (*cursor < end && **cursor == c)
+    {
+        ++(*cursor);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+static char *XWriteDigits(char *buffer, int64_t value, int count)
+{
+    for (int i = count - 1; i >= 0; --i)
+    {
+        buffer[i] = (char)('0' + (value % 10));
+        value /= 10;
+    }
+
+    return buffer + count;
+}
+
+static CFTimeInterval XSecondsFromGMT(CFTimeZoneRef timeZone, CFAbsoluteTime time)
+{
+    return timeZone ? CFTimeZoneGetSecondsFromGMT(timeZone, time) : 0;
+}
+
+BOOL XParseDateTime(const char *chars, size_t length, CFTimeZoneRef timeZone, CFAbsoluteTime *result)
+{
+    if (!chars || !result)
+    {
+        return FALSE;
+    }
+
+    const char *cursor = chars;
+    const char *end = chars + length;
+
+    while (cursor < end && isspace((unsigned char)*cursor))
+    {
+        ++cursor;
+    }
+    while (end > cursor && isspace((unsigned char)end[-1]))
+    {
+        --end;
+    }
+
+    //
+    // Date: yyyy-MM-dd, or yy-MM-dd
+    //
+    const char *yearEnd = cursor;
+    while (yearEnd < end && *yearEnd >= '0' && *yearEnd <= '9')
+    {
+        ++yearEnd;
+    }
+
+    int yearDigits = (int)(yearEnd - cursor);
+    int yearValue, month, day;
+
+    if ((yearDigits != 4 && yearDigits != 2) || !XScanDigits(&cursor, end, yearDigits, &yearValue))
+    {
+        return FALSE;
+    }
+
+    int64_t year = (yearDigits == 2) ? XExpandTwoDigitYear(yearValue) : yearValue;
+
+    if (!XScanChar(&cursor, end, '-') || !XScanDigits(&cursor, end, 2, &month) ||
+        !XScanChar(&cursor, end, '-') || !XScanDigits(&cursor, end, 2, &day))
+    {
+        return FALSE;
+    }
+
+    if (month < 1 || month > 12 || day < 1 || day > XDaysInMonth(year, month))
+    {
+        return FALSE;
+    }
+
+    //
+    // Optional time: THH:mm:ss[.fraction][Z|+hh:mm|-hh:mm]
+    //
+    double seconds = 0;
+    int offset = 0;
+    BOOL hasOffset = FALSE;
+
+    if (cursor < end)
+    {
+        int hour, minute, second;
+
+        if (yearDigits != 4 || !XScanChar(&cursor, end, 'T') ||
+            !XScanDigits(&cursor, end, 2, &hour) || !XScanChar(&cursor, end, ':') ||
+            !XScanDigits(&cursor, end, 2, &minute) || !XScanChar(&cursor, end, ':') ||
+            !XScanDigits(&cursor, end, 2, &second))
+        {
+            return FALSE;
+        }
+
+        if (hour > 23 || minute > 59 || second > 59)
+        {
+            return FALSE;
+        }
+
+        seconds = hour * 3600 + minute * 60 + second;
+
+        if (XScanChar(&cursor, end, '.'))
+        {
+            // Nanosecond precision is plenty; further digits are ignored
+            int64_t fraction = 0;
+            int64_t scale = 1;
+            const char *fractionStart = cursor;
+
+            for (; cursor < end && *cursor >= '0' && *cursor <= '9'; ++cursor)
+            {
+                if (scale < 1000000000)
+                {
+                    fraction = fraction * 10 + (*cursor - '0');
+                    scale *= 10;
+                }
+            }
+
+            if (cursor == fractionStart)
+            {
+                return FALSE;
+            }
+
+            seconds += (double)fraction / (double)scale;
+        }
+
+        if (cursor < end && (*cursor == '+' || *cursor == '-'))
+        {
+            int sign = (*cursor == '-') ? -1 : 1;
+            int offsetHours, offsetMinutes;
+
+            ++cursor;
+            if (!XScanDigits(&cursor, end, 2, &offsetHours))
+            {
+                return FALSE;
+            }
+            XScanChar(&cursor, end, ':');
+            if (!XScanDigits(&cursor, end, 2, &offsetMinutes) || offsetHours > 14 || offsetMinutes > 59)
+            {
+                return FALSE;
+            }
+
+            offset = sign * (offsetHours * 3600 + offsetMinutes * 60);
+            hasOffset = TRUE;
+        }
+        else
+        {
+            XScanChar(&cursor, end, 'Z');
+        }
+
+        if (cursor != end)
+        {
+            return FALSE;
+        }
+    }
+
+    CFAbsoluteTime time = (double)(XDaysFromCivil(year, month, day) * c_secondsPerDay) - kCFAbsoluteTimeIntervalSince1970 + seconds;
+
+    if (hasOffset)
+    {
+        *result = time - offset;
+    }
+    else
+    {
+        //
+        // time is the wall clock reading; find the instant at which timeZone shows it.
+        // The second lookup corrects for a DST transition between the two instants.
+        // A wall clock time skipped by DST (2:30am on the day clocks go forward) never matches;
+        // it resolves to the later instant, i.e. 3:30am, rather than failing.
+        //
+        CFAbsoluteTime guess = time - XSecondsFromGMT(timeZone, time);
+        CFTimeInterval offsetAtGuess = XSecondsFromGMT(timeZone, guess);
+        CFAbsoluteTime instant = time - offsetAtGuess;
+
+        *result = (XSecondsFromGMT(timeZone, instant) == offsetAtGuess) ? instant : MAX(guess, instant);
+    }
+
+    return TRUE;
+}
+
+size_t XFormatDateTime(CFAbsoluteTime time, CFTimeZoneRef timeZone, char *buffer)
+{
+    if (!buffer)
+    {
+        return 0;
+    }
+
+    CFAbsoluteTime wallClock = time + XSecondsFromGMT(timeZone, time) + kCFAbsoluteTimeIntervalSince1970;
+
+    //
+    // Round to the microsecond first, so that representation error (.373 stored as .37299999)
+    // does not lose a millisecond when truncating
+    //
+    int64_t milliseconds = (int64_t)llround(wallClock * 1000000.0);
+    milliseconds = (milliseconds >= 0) ? milliseconds / 1000 : -((-milliseconds + 999) / 1000);
+
+    int64_t millisecondsPerDay = c_secondsPerDay * 1000;
+    int64_t days = milliseconds / millisecondsPerDay;
+    int64_t millisecondOfDay = milliseconds % millisecondsPerDay;
+    if (millisecondOfDay < 0)
+    {
+        millisecondOfDay += millisecondsPerDay;
+        days -= 1;
+    }
+
+    int64_t year;
+    int month, day;
+    XCivilFromDays(days, &year, &month, &day);
+
+    int64_t secondOfDay = millisecondOfDay / 1000;
+    char *cursor = buffer;
+
+    cursor = XWriteDigits(cursor, year, 4);
+    *cursor++ = '-';
+    cursor = XWriteDigits(cursor, month, 2);
+    *cursor++ = '-';
+    cursor = XWriteDigits(cursor, day, 2);
+    *cursor++ = 'T';
+    cursor = XWriteDigits(cursor, secondOfDay / 3600, 2);
+    *cursor++ = ':';
+    cursor = XWriteDigits(cursor, (secondOfDay / 60) % 60, 2);
+    *cursor++ = ':';
+    cursor = XWriteDigits(cursor, secondOfDay % 60, 2);
+    *cursor++ = '.';
+    cursor = XWriteDigits(cursor, millisecondOfDay % 1000, 3);
+    *cursor++ = 'Z';
+
+    return (size_t)(cursor - buffer);
+}
+
+#pragma mark - Numbers
+
+//
+// NSScanner compatible number scanning: leading whitespace is skipped, and trailing characters are ignored.
+// The _l variants with a NULL locale always use the C locale, so '.' is the decimal separator regardless of
+// the user's settings, the same as NSScanner and stringWithFormat: did.
+//
+static const char *XSkipNumberPrefix(const char *chars)
+{
+    while (isspace((unsigned char)*chars))
+    {
+        ++chars;
+    }
+
+    return chars;
+}
+
+//
+// strtod also accepts hex, inf and nan, which NSScanner does not: only hand it decimal numbers
+//
+static BOOL XIsDecimalNumber(const char *chars)
+{
+    if (*chars == '+' || *chars == '-')
+    {
+        ++chars;
+    }
+
+    if (*chars == '.')
+    {
+        ++chars;
+    }
+    else if (chars[0] == '0' && (chars[1] == 'x' || chars[1] == 'X'))
+    {
+        return FALSE;
+    }
+
+    return (*chars >= '0' && *chars <= '9');
+}
+
+static BOOL XIsInfinity(const char *chars, double *result)
+{
+    if (strcmp(chars, "INF") == 0)
+    {
+        *result = INFINITY;
+        return TRUE;
+    }
+
+    if (strcmp(chars, "-INF") == 0)
+    {
+        *result = -INFINITY;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+BOOL XParseInt(const char *chars, int *result)
+{
+    if (!chars || !result)
+    {
+        return FALSE;
+    }
+
+    const char *cursor = XSkipNumberPrefix(chars);
+    BOOL negative = (*cursor == '-');
+    if (*cursor == '-' || *cursor == '+')
+    {
+        ++cursor;
+    }
+
+    if (*cursor < '0' || *cursor > '9')
+    {
+        return FALSE;
+    }
+
+    // Out of range values clamp to INT_MAX/INT_MIN, like NSScanner
+    int64_t value = 0;
+    for (; *cursor >= '0' && *cursor <= '9'; ++cursor)
+    {
+        if (value <= (int64_t)INT_MAX + 1)
+        {
+            value = value * 10 + (*cursor - '0');
+        }
+    }
+
+    value = negative ? -value : value;
+    *result = (int)MAX(MIN(value, (int64_t)INT_MAX), (int64_t)INT_MIN);
+
+    return TRUE;
+}
+
+BOOL XParseDouble(const char *chars, double *result)
+{
+    if (!chars || !result)
+    {
+        return FALSE;
+    }
+
+    const char *cursor = XSkipNumberPrefix(chars);
+    if (!XIsDecimalNumber(cursor))
+    {
+        return XIsInfinity(chars, result);
+    }
+
+    *result = strtod_l(cursor, NULL, NULL);
+
+    return TRUE;
+}
+
+BOOL XParseFloat(const char *chars, float *result)
+{
+    if (!chars || !result)
+    {
+        return FALSE;
+    }
+
+    const char *cursor = XSkipNumberPrefix(chars);
+    if (!XIsDecimalNumber(cursor))
+    {
+        double infinity;
+        if (XIsInfinity(chars, &infinity))
+        {
+            *result = (float)infinity;
+            return TRUE;
+        }
+        return FALSE;
+    }
+
+    *result = strtof_l(cursor, NULL, NULL);
+
+    return TRUE;
+}
+
+size_t XFormatInt(int value, char *buffer)
+{
+    char digits[XNumberFormatLength];
+    char *cursor = digits + sizeof(digits);
+    int64_t magnitude = (value < 0) ? -(int64_t)value : value;
+
+    do
+    {
+        *--cursor = (char)('0' + (magnitude % 10));
+        magnitude /= 10;
+    }
+    while (magnitude > 0);
+
+    if (value < 0)
+    {
+        *--cursor = '-';
+    }
+
+    size_t length = (size_t)(digits + sizeof(digits) - cursor);
+    memcpy(buffer, cursor, length);
+    buffer[length] = '\0';
+
+    return length;
+}
+
+size_t XFormatFloat(float value, char *buffer)
+{
+    if (isinf(value))
+    {
+        return (size_t)snprintf_l(buffer, XNumberFormatLength, NULL, "%s", (value < 0) ? "-INF" : "INF");
+    }
+
+    // Same as the %f format previously used; XNumberFormatLength has room for FLT_MAX
+    return (size_t)snprintf_l(buffer, XNumberFormatLength, NULL, "%f", value);
+}
+
+size_t XFormatDouble(double value, char *buffer)
+{
+    if (isinf(value))
+    {
+        return (size_t)snprintf_l(buffer, XNumberFormatLength, NULL, "%s", (value < 0) ? "-INF" : "INF");
+    }
+
+    //
+    // Shortest of 15, 16 or 17 significant digits that reads back as the same double.
+    // 17 digits always round trip.
+    //
+    int length = 0;
+    for (int precision = 15; precision <= 17; ++precision)
+    {
+        length = snprintf_l(buffer, XNumberFormatLength, NULL, "%.*g", precision, value);
+        if (precision == 17 || strtod_l(buffer, NULL, NULL) == value)
+        {
+            break;
+        }
+    }
+
+    return (size_t)length;
+}
+
+//
+// Numbers are short; copy them into a stack buffer rather than allocating a UTF8String
+//
+static const char *XCharsFromString(NSString *source, char *buffer, size_t bufferSize)
+{
+    const char *chars = CFStringGetCStringPtr((__bridge CFStringRef)source, kCFStringEncodingUTF8);
+    if (chars)
+    {
+        return chars;
+    }
+
+    if ([source getCString:buffer maxLength:bufferSize encoding:NSUTF8StringEncoding])
+    {
+        return buffer;
+    }
+
+    return source.UTF8String;
+}
+
+#pragma mark - XConverter
+
 @interface XConverter ()
 
-@property (nonatomic, strong) NSDateFormatter *parser;
-@property (nonatomic, strong) NSDateFormatter *utcParser;
-@property (nonatomic, strong) NSDateFormatter *formatter;
-@property (nonatomic, strong) NSCalendar *calendar;
-@property (nonatomic, strong) NSLocale *dateLocale;
 @property (nonatomic, strong) NSMutableString *stringBuffer;
 
 @end
@@ -65,10 +578,18 @@ static NSString *const c_FALSE = @"false";
 {
     MHVCHECK_STRING(source);
     MHVCHECK_NOTNULL(result);
-    
-    NSScanner *scanner = [[NSScanner alloc] initWithString:source];
 
-    return [scanner scanInt:result];
+    char buffer[XNumberFormatLength];
+
+    return XParseInt(XCharsFromString(source, buffer, sizeof(buffer)), result);
+}
+
+- (BOOL)tryXmlString:(const xmlChar *)source toInt:(int *)result
+{
+    MHVCHECK_NOTNULL(source);
+    MHVCHECK_NOTNULL(result);
+
+    return XParseInt((const char *)source, result);
 }
 
 - (int)stringToInt:(NSString *)source
@@ -88,7 +609,10 @@ static NSString *const c_FALSE = @"false";
 {
     MHVCHECK_NOTNULL(result);
 
-    *result = [NSString stringWithFormat:@"%d", source];
+    char buffer[XNumberFormatLength];
+    size_t length = XFormatInt(source, buffer);
+
+    *result = [[NSString alloc] initWithBytes:buffer length:length encoding:NSASCIIStringEncoding];
     MHVCHECK_STRING(*result);
 
     return TRUE;
@@ -111,27 +635,18 @@ static NSString *const c_FALSE = @"false";
 {
     MHVCHECK_STRING(source);
     MHVCHECK_NOTNULL(result);
-    
-    NSScanner *scanner = [[NSScanner alloc] initWithString:source];
 
-    if ([scanner scanFloat:result])
-    {
-        return TRUE;
-    }
+    char buffer[XNumberFormatLength];
 
-    if ([source isEqualToString:c_NEGATIVEINF])
-    {
-        *result = -INFINITY;
-        return TRUE;
-    }
+    return XParseFloat(XCharsFromString(source, buffer, sizeof(buffer)), result);
+}
 
-    if ([source isEqualToString:c_POSITIVEINF])
-    {
-        *result = INFINITY;
-        return TRUE;
-    }
+- (BOOL)tryXmlString:(const xmlChar *)source toFloat:(float *)result
+{
+    MHVCHECK_NOTNULL(source);
+    MHVCHECK_NOTNULL(result);
 
-    return FALSE;
+    return XParseFloat((const char *)source, result);
 }
 
 - (float)stringToFloat:(NSString *)source
@@ -151,19 +666,10 @@ static NSString *const c_FALSE = @"false";
 {
     MHVCHECK_NOTNULL(result);
 
-    if (source == -INFINITY)
-    {
-        *result = c_NEGATIVEINF;
-        return TRUE;
-    }
-
-    if (source == INFINITY)
-    {
-        *result = c_POSITIVEINF;
-        return TRUE;
-    }
+    char buffer[XNumberFormatLength];
+    size_t length = XFormatFloat(source, buffer);
 
-    *result = [NSString stringWithFormat:@"%f", source];
+    *result = [[NSString alloc] initWithBytes:buffer length:length encoding:NSASCIIStringEncoding];
     MHVCHECK_STRING(*result);
 
     return TRUE;
@@ -186,27 +692,18 @@ static NSString *const c_FALSE = @"false";
 {
     MHVCHECK_STRING(source);
     MHVCHECK_NOTNULL(result);
-    
-    NSScanner *scanner = [[NSScanner alloc] initWithString:source];
 
-    if ([scanner scanDouble:result])
-    {
-        return TRUE;
-    }
+    char buffer[XNumberFormatLength];
 
-    if ([source isEqualToString:c_NEGATIVEINF])
-    {
-        *result = -INFINITY;
-        return TRUE;
-    }
+    return XParseDouble(XCharsFromString(source, buffer, sizeof(buffer)), result);
+}
 
-    if ([source isEqualToString:c_POSITIVEINF])
-    {
-        *result = INFINITY;
-        return TRUE;
-    }
+- (BOOL)tryXmlString:(const xmlChar *)source toDouble:(double *)result
+{
+    MHVCHECK_NOTNULL(source);
+    MHVCHECK_NOTNULL(result);
 
-    return FALSE;
+    return XParseDouble((const char *)source, result);
 }
 
 - (double)stringToDouble:(NSString *)source
@@ -224,24 +721,7 @@ static NSString *const c_FALSE = @"false";
 
 - (BOOL)tryDouble:(double)source toString:(NSString **)result
 {
-    MHVCHECK_NOTNULL(result);
-
-    if (source == -INFINITY)
-    {
-        *result = c_NEGATIVEINF;
-        return TRUE;
-    }
-
-    if (source == INFINITY)
-    {
-        *result = c_POSITIVEINF;
-        return TRUE;
-    }
-
-    [self tryDoubleRoundtrip:source toString:result];
-    MHVCHECK_STRING(*result);
-
-    return TRUE;
+    return [self tryDoubleRoundtrip:source toString:result];
 }
 
 //
@@ -250,21 +730,15 @@ static NSString *const c_FALSE = @"false";
 //
 - (BOOL)tryDoubleRoundtrip:(double)source toString:(NSString **)result
 {
-    NSString *asString = [NSString stringWithFormat:@"%.15g", source];
+    MHVCHECK_NOTNULL(result);
 
-    MHVCHECK_NOTNULL(asString);
+    char buffer[XNumberFormatLength];
+    size_t length = XFormatDouble(source, buffer);
 
-    double parsedBack = [self stringToDouble:asString];
-    if (parsedBack == source)
-    {
-        *result = asString;
-    }
-    else
-    {
-        *result = [NSString stringWithFormat:@"%.17g", source];
-    }
+    *result = [[NSString alloc] initWithBytes:buffer length:length encoding:NSASCIIStringEncoding];
+    MHVCHECK_STRING(*result);
 
-    return *result != nil;
+    return TRUE;
 }
 
 - (NSString *)doubleToString:(double)source
@@ -337,46 +811,23 @@ static NSString *const c_FALSE = @"false";
     MHVCHECK_NOTNULL(result);
 
     //
-    // Since NSDateFormatter is otherwise incapable of parsing xsd:datetime
-    // ISO 8601 expresses UTC/GMT offsets as "2001-10-26T21:32:52+02:00"
-    // DateFormatter does not like the : in the +02:00
-    // So, we simply whack all : in the string, and change our dateformat strings accordingly
-    //
-    // Use a mutable string, so we don't have to keep allocating new strings
+    // Dates are ASCII, and short - so copy into a stack buffer rather than asking for UTF8String
     //
-    [self.stringBuffer setString:source];
-    
-    MHVCHECK_TRUE((self.stringBuffer.length == source.length));
-    
-    [self.stringBuffer replaceOccurrencesOfString:@":"
-     withString:@""
-     options:0
-     range:NSMakeRange(0, self.stringBuffer.length)];
-
-    NSDateFormatter *parser = [self ensureDateParser];
-    for (int i = 0; i < c_xDateFormatCount; ++i)
+    char chars[64];
+    if (![source getCString:chars maxLength:sizeof(chars) encoding:NSASCIIStringEncoding])
     {
-        NSString *format = s_xDateFormats[i];
-
-        [parser setDateFormat:format];
-        *result = [parser dateFromString:self.stringBuffer];
-        if (*result)
-        {
-            return TRUE;
-        }
+        return FALSE;
     }
 
-    NSTimeZone *tz = parser.timeZone;
-    if (tz.isDaylightSavingTime)
+    CFAbsoluteTime time;
+    if (!XParseDateTime(chars, strlen(chars), (__bridge CFTimeZoneRef)[NSTimeZone defaultTimeZone], &time))
     {
-        *result = [self stringToDateWithWithDaylightSavings:self.stringBuffer inTimeZone:tz];
-        if (*result)
-        {
-            return TRUE;
-        }
+        return FALSE;
     }
 
-    return FALSE;
+    *result = [NSDate dateWithTimeIntervalSinceReferenceDate:time];
+
+    return TRUE;
 }
 
 - (NSDate *)stringToDate:(NSString *)source
@@ -397,8 +848,10 @@ static NSString *const c_FALSE = @"false";
     MHVCHECK_NOTNULL(source);
     MHVCHECK_NOTNULL(result);
 
-    NSDateFormatter *formatter = [self ensureDateFormatter];
-    *result = [formatter stringFromDate:source];
+    char chars[XDateTimeFormatLength];
+    size_t length = XFormatDateTime(source.timeIntervalSinceReferenceDate, (__bridge CFTimeZoneRef)[NSTimeZone defaultTimeZone], chars);
+
+    *result = [[NSString alloc] initWithBytes:chars length:length encoding:NSASCIIStringEncoding];
     MHVCHECK_STRING(*result);
 
     return TRUE;
@@ -435,119 +888,4 @@ static NSString *const c_FALSE = @"false";
     return [uuid UUIDString];
 }
 
-#pragma mark - Internal methods
-
-- (NSDateFormatter *)ensureDateFormatter
-{
-    if (!self.formatter)
-    {
-        NSDateFormatter *formatter = [NSDateFormatter new];
-        [formatter setDateFormat:@"yyyy'-'MM'-'dd'T'HH:mm:ss.SSS'Z'"]; // Zulu time format
-        
-        self.formatter = formatter;
-        MHVCHECK_OOM(self.formatter);
-        [self.formatter setLocale:[self ensureLocale]];
-    }
-
-    return self.formatter;
-}
-
-- (NSDateFormatter *)ensureDateParser
-{
-    if (!self.parser)
-    {
-        self.parser = [NSDateFormatter new];
-        MHVCHECK_OOM(self.parser);
-        [self.parser setLocale:[self ensureLocale]];
-    }
-
-    return self.parser;
-}
-
-- (NSDateFormatter *)ensureUtcDateParser
-{
-    if (!self.utcParser)
-    {
-        NSDateFormatter *formatter = [NSDateFormatter new];
-        [formatter setTimeZone:[NSTimeZone timeZoneWithAbbreviation:@"UTC"]];
-        
-        self.utcParser = formatter;
-        MHVCHECK_OOM(self.utcParser);
-        [self.utcParser setLocale:[self ensureLocale]];
-    }
-
-    return self.utcParser;
-}
-
-- (NSCalendar *)ensureGregorianCalendar
-{
-    if (!self.calendar)
-    {
-        self.calendar = [[NSCalendar alloc] initWithCalendarIdentifier:NSCalendarIdentifierGregorian];
-        MHVCHECK_OOM(self.calendar);
-    }
-
-    return self.calendar;
-}
-
-- (NSLocale *)ensureLocale
-{
-    if (!self.dateLocale)
-    {
-        self.dateLocale = [[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"];
-        MHVCHECK_OOM(self.dateLocale);
-    }
-
-    return self.dateLocale;
-}
-
-//
-// HealthVault dates can be time zone agnostic. This is because historical data from 3rd parties may never have captured the original time zone.
-// Dates are always interpreted as 'local' - in whatever time zone the user is currently in.
-//
-// This means that you can end up with dates that never "existed" in some time zones because of Daylight
-// Savings Time
-// E.g. the local time 2014:03-09'T'02:30:00 is legal in India.
-// But that particular time never existed in USA local time.
-// Daylight savings went from 1.00 AM to 3.00 AM, skipping 2.00 am entirely.
-//
-// DateTimeFormatter, when running with local time zone, helpfully decides that since such dates do not exist, it must not return them.
-// So we have to do this workaround
-//
-- (NSDate *)stringToDateWithWithDaylightSavings:(NSString *)source inTimeZone:(NSTimeZone *)tz
-{
-    NSDateFormatter *parser = [self ensureUtcDateParser];
-    NSCalendar *calendar = [self ensureGregorianCalendar];
-
-    for (int i = 0; i < c_xDateFormatCount; ++i)
-    {
-        NSString *format = s_xDateFormats[i];
-        [parser setDateFormat:format];
-
-        NSDate *utcDate = [parser dateFromString:source];
-        if (utcDate)
-        {
-            NSTimeInterval daylightSavingsOffset = [tz daylightSavingTimeOffset];
-            utcDate = [utcDate dateByAddingTimeInterval:daylightSavingsOffset];
-            
-            [calendar setTimeZone:[NSTimeZone timeZoneWithAbbreviation:@"UTC"]];
-            
-            NSDateComponents *components = [calendar components:NSCalendarUnitDay       |
-                                                                NSCalendarUnitMonth     |
-                                                                NSCalendarUnitYear      |
-                                                                NSCalendarUnitHour      |
-                                                                NSCalendarUnitMinute    |
-                                                                NSCalendarUnitSecond
-                                                       fromDate:utcDate];
-            [components setCalendar:calendar];
-            [components setTimeZone:tz];
-
-            NSDate *localDate = [components date];
-            return localDate;
-        }
-    }
-
-    return nil;
-}
-
 @end
@@ -56,6 +56,8 @@
 - (instancetype)initFromFile:(NSString *)fileName withConverter:(XConverter *)converter;
 - (instancetype)initFromMemory:(NSData *)buffer;
 - (instancetype)initFromMemory:(NSData *)buffer withConverter:(XConverter *)converter;
+- (instancetype)initFromStream:(NSInputStream *)stream;
+- (instancetype)initFromStream:(NSInputStream *)stream withConverter:(XConverter *)converter;
 - (instancetype)initFromString:(NSString *)string;
 - (instancetype)initFromString:(NSString *)string withConverter:(XConverter *)converter;
 
@@ -99,4 +101,11 @@
 
 - (BOOL)skip;
 
+//
+// A reader over a copy of the current element and its children, which may be read on another thread.
+// Copying the element the reader has already parsed is much cheaper than readOuterXml, which serializes
+// it to be parsed again. This reader stays on the element; call skip to move past it.
+//
+- (XReader *)newReaderForElementCopyWithConverter:(XConverter *)converter;
+
 @end
@@ -57,9 +57,50 @@ xmlTextReader *XAllocFileReader(NSString *fileName)
     return xmlNewTextReaderFilename([fileName UTF8String]); // further error checking delegated
 }
 
+static int XStreamReaderRead(void *context, char *buffer, int length)
+{
+    NSInputStream *stream = (__bridge NSInputStream *)context;
+    
+    //
+    // Blocks until bytes are available. Returns 0 at the end of the stream, which libxml treats as EOF
+    //
+    NSInteger count = [stream read:(uint8_t *)buffer maxLength:(NSUInteger)length];
+    
+    return (count < 0) ? -1 : (int)count;
+}
+
+static int XStreamReaderClose(void *context)
+{
+    // The stream is owned, and closed, by whoever supplied it
+    return 0;
+}
+
+xmlTextReader *XAllocStreamReader(NSInputStream *stream)
+{
+    if (!stream)
+    {
+        return nil;
+    }
+    
+    if (stream.streamStatus == NSStreamStatusNotOpen)
+    {
+        [stream open];
+    }
+
+    return xmlReaderForIO(XStreamReaderRead, XStreamReaderClose, (__bridge void *)stream, nil, nil, 0);
+}
+
 @interface XReader ()
+{
+    // Interned in the reader's dictionary, and valid until the reader moves
+    const xmlChar *_localNameRaw;
+}
 
 @property (readonly, nonatomic) xmlTextReader *reader;
+@property (readonly, nonatomic, strong) NSData *buffer;
+@property (readonly, nonatomic, strong) NSInputStream *stream;
+// A copied element read by a walker, owned by the reader
+@property (nonatomic, assign) xmlDocPtr document;
 @property (nonatomic, assign) XNodeType nodeType;
 @property (nonatomic, strong) NSString *localName;
 @property (nonatomic, strong) NSString *namespaceUri;
@@ -137,7 +178,12 @@ xmlTextReader *XAllocFileReader(NSString *fileName)
 
 - (const xmlChar *)localNameRaw
 {
-    return xmlTextReaderConstLocalName(self.reader);
+    if (_localNameRaw == NULL)
+    {
+        _localNameRaw = xmlTextReaderConstLocalName(self.reader);
+    }
+
+    return _localNameRaw;
 }
 
 - (const xmlChar *)prefix
@@ -224,7 +270,35 @@ xmlTextReader *XAllocFileReader(NSString *fileName)
 
 - (instancetype)initFromMemory:(NSData *)buffer withConverter:(XConverter *)converter
 {
-    return [self initWithCreatedReader:XAllocBufferReader(buffer) withConverter:converter];
+    self = [self initWithCreatedReader:XAllocBufferReader(buffer) withConverter:converter];
+    if (self)
+    {
+        //
+        // The reader parses the buffer in place, without copying it, so keep it alive for our lifetime
+        //
+        _buffer = buffer;
+    }
+
+    return self;
+}
+
+- (instancetype)initFromStream:(NSInputStream *)stream
+{
+    return [self initFromStream:stream withConverter:nil];
+}
+
+- (instancetype)initFromStream:(NSInputStream *)stream withConverter:(XConverter *)converter
+{
+    self = [self initWithCreatedReader:XAllocStreamReader(stream) withConverter:converter];
+    if (self)
+    {
+        //
+        // Bytes are pulled from the stream as the document is read, so nodes become available
+        // as soon as they arrive rather than once the whole document has been received
+        //
+        _stream = stream;
+    }
+    return self;
 }
 
 - (instancetype)initFromString:(NSString *)string
@@ -261,6 +335,7 @@ xmlTextReader *XAllocFileReader(NSString *fileName)
 - (void)clear
 {
     _nodeType = XUnknown;
+    _localNameRaw = NULL;
     _localName = nil;
     _namespaceUri = nil;
     _value = nil;
@@ -383,18 +458,26 @@ xmlTextReader *XAllocFileReader(NSString *fileName)
     return ([name isEqualToString:self.localName]) && [ns isEqualToString:self.namespaceUri];
 }
 
+//
+// Deserializers test the current element against each element they expect, in turn, so most calls are misses
+// on the same node. The node type and name are cached until the reader moves, so a miss is a single name compare.
+//
 - (BOOL)isStartElementWithXmlName:(const xmlChar *)name
 {
     MHVCHECK_NOTNULL(name);
 
-    if (![self isStartElement])
+    if (_nodeType != XElement && ![self isStartElement])
     {
         return FALSE;
     }
 
     const xmlChar *rawName = self.localNameRaw;
+    if (rawName == name)
+    {
+        return TRUE;
+    }
 
-    return rawName && xmlStrEqual(rawName, name);
+    return rawName && rawName[0] == name[0] && xmlStrEqual(rawName, name);
 }
 
 - (XNodeType)moveToContent
@@ -594,6 +677,37 @@ xmlTextReader *XAllocFileReader(NSString *fileName)
     return [self isSuccess:xmlTextReaderNext(self.reader)];
 }
 
+- (XReader *)newReaderForElementCopyWithConverter:(XConverter *)converter
+{
+    xmlNodePtr node = xmlTextReaderExpand(self.reader);
+    MHVCHECK_NOTNULL(node);
+
+    xmlDocPtr document = xmlNewDoc(XMLSTRINGCONST("1.0"));
+    MHVCHECK_OOM(document);
+
+    //
+    // Namespaces declared on the element's ancestors are declared again on the copy
+    //
+    xmlNodePtr copy = xmlDocCopyNode(node, document, 1);
+    if (!copy)
+    {
+        xmlFreeDoc(document);
+        return nil;
+    }
+    xmlDocSetRootElement(document, copy);
+
+    XReader *reader = [[XReader alloc] initWithCreatedReader:xmlReaderWalker(document) withConverter:converter];
+    if (!reader)
+    {
+        xmlFreeDoc(document);
+        return nil;
+    }
+
+    reader.document = document;
+
+    return reader;
+}
+
 #pragma mark - Internal methods
 
 - (instancetype)initWithCreatedReader:(xmlTextReader *)reader
@@ -657,6 +771,15 @@ xmlTextReader *XAllocFileReader(NSString *fileName)
         xmlFreeTextReader(self.reader);
         _reader = nil;
     }
+
+    if (self.document)
+    {
+        xmlFreeDoc(self.document);
+        self.document = NULL;
+    }
+
+    _buffer = nil;
+    _stream = nil;
 }
 
 - (BOOL)isSuccess:(int)result
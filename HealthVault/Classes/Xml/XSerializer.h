@@ -144,6 +144,17 @@
 - (NSMutableArray *)readElementArrayWithXmlName:(const xmlChar *)xName asClass:(Class)classObj;
 - (NSMutableArray *)readElementArrayWithXmlName:(const xmlChar *)xName asClass:(Class)classObj andArrayClass:(Class)arrayClassObj;
 - (NSMutableArray *)readElementArrayWithXmlName:(const xmlChar *)xName thingName:(const xmlChar *)thingName asClass:(Class)classObj andArrayClass:(Class)arrayClassObj;
+//
+// Reads consecutive xName elements like readElementArrayWithXmlName:asClass:, into objects made by newObject.
+// After the first sequentialCount elements, each of the rest is copied out of the reader as the element libxml
+// has already parsed, and deserialized on up to maxConcurrency worker threads, each with its own XReader and
+// XConverter, while this reader moves on. Parsing and copying the elements is still done here, one at a time.
+// The array keeps the order of the elements. newObject may be called on any thread.
+//
+- (NSMutableArray *)readElementArrayWithXmlName:(const xmlChar *)xName
+                                sequentialCount:(NSUInteger)sequentialCount
+                                 maxConcurrency:(NSUInteger)maxConcurrency
+                                      newObject:(id<XSerializable> (^)(void))newObject;
 
 - (NSString *)readAttributeWithXmlName:(const xmlChar *)xmlName;
 - (NSString *)readElementRawWithXmlName:(const xmlChar *)xmlName;
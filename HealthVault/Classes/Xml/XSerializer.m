@@ -21,6 +21,9 @@
 #import "MHVLogger.h"
 #import "NSArray+Utils.h"
 
+// Elements are copied out and handed to workers in batches, so each worker amortizes its dispatch over several elements
+static const NSUInteger c_concurrentElementBatchSize = 32;
+
 @implementation XSerializer
 
 + (NSString *)serializeToString:(id)obj withRoot:(NSString *)root
@@ -270,6 +273,28 @@
     return value;
 }
 
+//
+// Like readValueEnsure, but returns the reader's own buffer rather than a new NSString.
+// The pointer is only valid until the reader moves.
+//
+- (const xmlChar *)rawValueEnsure
+{
+    if (!self.isTextualNode)
+    {
+        MHVLOG(@"Could not read value because the current node is not textual.");
+        return NULL;
+    }
+
+    const xmlChar *value = self.valueRaw;
+    if (!value)
+    {
+        MHVLOG(@"Could not read value because the value is nil.");
+        return NULL;
+    }
+
+    return value;
+}
+
 - (NSUUID *)readUuid
 {
     return [self.converter stringToUuid:[self readValueEnsure]];
@@ -277,17 +302,56 @@
 
 - (int)readInt
 {
-    return [self.converter stringToInt:[self readValueEnsure]];
+    int value = -1;
+
+    const xmlChar *raw = [self rawValueEnsure];
+    if (raw)
+    {
+        if (![self.converter tryXmlString:raw toInt:&value])
+        {
+            MHVLOG(@"Failed to parse int: %s", (const char *)raw);
+            value = -1;
+        }
+        [self read];
+    }
+
+    return value;
 }
 
 - (float)readFloat
 {
-    return [self.converter stringToFloat:[self readValueEnsure]];
+    float value = -1;
+
+    const xmlChar *raw = [self rawValueEnsure];
+    if (raw)
+    {
+        if (![self.converter tryXmlString:raw toFloat:&value])
+        {
+            MHVLOG(@"Failed to parse float: %s", (const char *)raw);
+            value = -1;
+        }
+        [self read];
+    }
+
+    return value;
 }
 
 - (double)readDouble
 {
-    return [self.converter stringToDouble:[self readValueEnsure]];
+    double value = -1;
+
+    const xmlChar *raw = [self rawValueEnsure];
+    if (raw)
+    {
+        if (![self.converter tryXmlString:raw toDouble:&value])
+        {
+            MHVLOG(@"Failed to parse double: %s", (const char *)raw);
+            value = -1;
+        }
+        [self read];
+    }
+
+    return value;
 }
 
 - (BOOL)readBool
@@ -370,26 +434,39 @@
 
 - (int)readNextInt
 {
-    NSString *string = [self readNextElement];
+    int value = 0;
 
-    if ([self isNilOrEmptyString:string])
+    if ([self readStartElement])
     {
-        return 0;
+        const xmlChar *raw = self.isTextualNode ? self.valueRaw : NULL;
+
+        if (raw)
+        {
+            if (*raw && ![self.converter tryXmlString:raw toInt:&value])
+            {
+                MHVLOG(@"Failed to parse int: %s", (const char *)raw);
+                value = -1;
+            }
+            [self read];
+        }
+
+        if (raw || self.nodeType == XEndElement)
+        {
+            [self readEndElement];
+        }
     }
 
-    return [self.converter stringToInt:string];
+    return value;
 }
 
 - (int)readIntElement:(NSString *)name
 {
-    NSString *string = [self readStringElement:name];
-
-    if ([self isNilOrEmptyString:string])
+    if ([self isStartElementWithName:name])
     {
-        return 0;
+        return [self readNextInt];
     }
 
-    return [self.converter stringToInt:string];
+    return 0;
 }
 
 - (BOOL)readIntElement:(NSString *)name into:(NSInteger *)value
@@ -405,26 +482,39 @@
 
 - (double)readNextDouble
 {
-    NSString *string = [self readNextElement];
+    double value = 0.0;
 
-    if ([self isNilOrEmptyString:string])
+    if ([self readStartElement])
     {
-        return 0.0;
+        const xmlChar *raw = self.isTextualNode ? self.valueRaw : NULL;
+
+        if (raw)
+        {
+            if (*raw && ![self.converter tryXmlString:raw toDouble:&value])
+            {
+                MHVLOG(@"Failed to parse double: %s", (const char *)raw);
+                value = -1;
+            }
+            [self read];
+        }
+
+        if (raw || self.nodeType == XEndElement)
+        {
+            [self readEndElement];
+        }
     }
 
-    return [self.converter stringToDouble:string];
+    return value;
 }
 
 - (double)readDoubleElement:(NSString *)name
 {
-    NSString *string = [self readStringElement:name];
-
-    if ([self isNilOrEmptyString:string])
+    if ([self isStartElementWithName:name])
     {
-        return 0.0;
+        return [self readNextDouble];
     }
 
-    return [self.converter stringToDouble:string];
+    return 0.0;
 }
 
 - (BOOL)readDoubleElement:(NSString *)name into:(double *)value
@@ -669,8 +759,12 @@
         return FALSE;
     }
 
-    NSString *string = self.value;
-    *value = [self.converter stringToInt:string];
+    const xmlChar *raw = self.valueRaw;
+    if (!raw || ![self.converter tryXmlString:raw toInt:value])
+    {
+        MHVLOG(@"Failed to parse int attribute: %@", name);
+        *value = -1;
+    }
 
     [self moveToElement];
 
@@ -699,8 +793,12 @@
         return FALSE;
     }
 
-    NSString *string = self.value;
-    *value = [self.converter stringToDouble:string];
+    const xmlChar *raw = self.valueRaw;
+    if (!raw || ![self.converter tryXmlString:raw toDouble:value])
+    {
+        MHVLOG(@"Failed to parse double attribute: %@", name);
+        *value = -1;
+    }
 
     [self moveToElement];
 
@@ -714,8 +812,12 @@
         return FALSE;
     }
 
-    NSString *string = self.value;
-    *value = [self.converter stringToFloat:string];
+    const xmlChar *raw = self.valueRaw;
+    if (!raw || ![self.converter tryXmlString:raw toFloat:value])
+    {
+        MHVLOG(@"Failed to parse float attribute: %@", name);
+        *value = -1;
+    }
 
     [self moveToElement];
 
@@ -853,14 +955,12 @@
 
 - (int)readIntElementXmlName:(const xmlChar *)xmlName
 {
-    NSString *string = [self readStringElementWithXmlName:xmlName];
-
-    if ([self isNilOrEmptyString:string])
+    if ([self isStartElementWithXmlName:xmlName])
     {
-        return 0;
+        return [self readNextInt];
     }
 
-    return [self.converter stringToInt:string];
+    return 0;
 }
 
 - (BOOL)readIntElementXmlName:(const xmlChar *)xmlName into:(int *)value
@@ -876,14 +976,12 @@
 
 - (double)readDoubleElementXmlName:(const xmlChar *)xmlName
 {
-    NSString *string = [self readStringElementWithXmlName:xmlName];
-
-    if ([self isNilOrEmptyString:string])
+    if ([self isStartElementWithXmlName:xmlName])
     {
-        return 0.0;
+        return [self readNextDouble];
     }
 
-    return [self.converter stringToDouble:string];
+    return 0.0;
 }
 
 - (BOOL)readDoubleElementXmlName:(const xmlChar *)xmlName into:(double *)value
@@ -984,6 +1082,113 @@
     return array;
 }
 
+- (NSMutableArray *)readElementArrayWithXmlName:(const xmlChar *)xName
+                                sequentialCount:(NSUInteger)sequentialCount
+                                 maxConcurrency:(NSUInteger)maxConcurrency
+                                      newObject:(id<XSerializable> (^)(void))newObject
+{
+    MHVCHECK_NOTNULL(xName);
+    MHVCHECK_NOTNULL(newObject);
+    
+    NSMutableArray *elements = nil;
+    
+    while ([self isStartElementWithXmlName:xName])
+    {
+        if (elements == nil)
+        {
+            elements = [[NSMutableArray alloc] init];
+            MHVCHECK_OOM(elements);
+        }
+        
+        if (maxConcurrency > 1 && elements.count >= sequentialCount)
+        {
+            [self readRemainingElementsWithXmlName:xName
+                                    maxConcurrency:maxConcurrency
+                                         newObject:newObject
+                                           intoArray:elements];
+            break;
+        }
+        
+        id<XSerializable> obj = newObject();
+        MHVCHECK_OOM(obj);
+        
+        [self readElementRequiredWithXmlName:xName intoObject:obj];
+        [elements addObject:obj];
+    }
+    
+    return elements;
+}
+
+- (void)readRemainingElementsWithXmlName:(const xmlChar *)xName
+                          maxConcurrency:(NSUInteger)maxConcurrency
+                               newObject:(id<XSerializable> (^)(void))newObject
+                               intoArray:(NSMutableArray *)elements
+{
+    NSMutableArray<NSArray *> *batches = [[NSMutableArray alloc] init];
+    NSObject *lock = [[NSObject alloc] init];
+    
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    dispatch_group_t group = dispatch_group_create();
+    dispatch_semaphore_t workers = dispatch_semaphore_create((long)maxConcurrency);
+    
+    while ([self isStartElementWithXmlName:xName])
+    {
+        // Each worker reads its batch with its own converter, so it is made here and only used by that worker
+        XConverter *converter = [[XConverter alloc] init];
+        NSMutableArray<XReader *> *readerBatch = [[NSMutableArray alloc] initWithCapacity:c_concurrentElementBatchSize];
+        
+        while (readerBatch.count < c_concurrentElementBatchSize && [self isStartElementWithXmlName:xName])
+        {
+            XReader *reader = [self newReaderForElementCopyWithConverter:converter];
+            if (reader)
+            {
+                [readerBatch addObject:reader];
+            }
+            
+            [self skipSingleElementWithXmlName:xName];
+        }
+        
+        NSUInteger batchIndex;
+        @synchronized(lock)
+        {
+            batchIndex = batches.count;
+            [batches addObject:@[]];
+        }
+        
+        // Wait for a free worker, so at most maxConcurrency batches of copied elements are waiting in memory
+        dispatch_semaphore_wait(workers, DISPATCH_TIME_FOREVER);
+        dispatch_group_async(group, queue, ^
+        {
+            NSMutableArray *batch = [[NSMutableArray alloc] initWithCapacity:readerBatch.count];
+            
+            for (XReader *reader in readerBatch)
+            {
+                id<XSerializable> obj = newObject();
+                
+                if (obj)
+                {
+                    [reader readElementRequiredWithXmlName:xName intoObject:obj];
+                    [batch addObject:obj];
+                }
+            }
+            
+            @synchronized(lock)
+            {
+                batches[batchIndex] = batch;
+            }
+            
+            dispatch_semaphore_signal(workers);
+        });
+    }
+    
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    
+    for (NSArray *batch in batches)
+    {
+        [elements addObjectsFromArray:batch];
+    }
+}
+
 - (BOOL)skipElementWithXmlName:(const xmlChar *)xmlName
 {
     while ([self isStartElementWithXmlName:xmlName])
@@ -1018,19 +1223,31 @@ void logWriterError(void)
     [self writeText:[self.converter uuidToString:uuid]];
 }
 
+//
+// Numbers never need escaping, so they are formatted on the stack and copied straight into the writer's buffer
+//
 - (void)writeInt:(int)value
 {
-    [self writeText:[self.converter intToString:value]];
+    char buffer[XNumberFormatLength];
+    size_t length = XFormatInt(value, buffer);
+
+    MHVCHECK_XWRITE([self writeRawXmlChars:(const xmlChar *)buffer length:length]);
 }
 
 - (void)writeFloat:(float)value
 {
-    [self writeText:[self.converter floatToString:value]];
+    char buffer[XNumberFormatLength];
+    size_t length = XFormatFloat(value, buffer);
+
+    MHVCHECK_XWRITE([self writeRawXmlChars:(const xmlChar *)buffer length:length]);
 }
 
 - (void)writeDouble:(double)value
 {
-    [self writeText:[self.converter doubleToString:value]];
+    char buffer[XNumberFormatLength];
+    size_t length = XFormatDouble(value, buffer);
+
+    MHVCHECK_XWRITE([self writeRawXmlChars:(const xmlChar *)buffer length:length]);
 }
 
 - (void)writeBool:(BOOL)value
@@ -1209,7 +1426,10 @@ void logWriterError(void)
 
 - (void)writeAttribute:(NSString *)name intValue:(int)value
 {
-    [self writeAttribute:name value:[self.converter intToString:value]];
+    char buffer[XNumberFormatLength];
+    XFormatInt(value, buffer);
+
+    [self writeAttributeXmlName:[name toXmlString] xmlValue:(const xmlChar *)buffer];
 }
 
 - (void)writeText:(NSString *)value
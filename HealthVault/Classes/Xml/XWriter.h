@@ -25,9 +25,25 @@
 
 @property (readonly, nonatomic, strong) XConverter *converter;
 @property (readwrite, nonatomic, strong) id context;
+//
+// The output of a writer created with initWithData:, nil otherwise
+//
+@property (readonly, nonatomic, strong) NSMutableData *data;
+//
+// For writers created with initWithData:, called with each chunk of output as it is appended to data.
+// Lets callers process the output (e.g. hash it) in the same pass that writes it.
+//
+@property (readwrite, nonatomic, copy) void (^dataObserver)(const void *bytes, NSUInteger length);
 
 - (instancetype)initWithBufferSize:(size_t)size;
 - (instancetype)initWithBufferSize:(size_t)size andConverter:(XConverter *)converter;
+//
+// Appends UTF-8 output straight to data, without an intermediate libxml buffer or NSString.
+// Output is only guaranteed to be in data after flush (or getXml, getLength or newXmlString).
+// Callers can reuse one NSMutableData for several writers, by setting its length to 0 in between.
+//
+- (instancetype)initWithData:(NSMutableData *)data;
+- (instancetype)initWithData:(NSMutableData *)data andConverter:(XConverter *)converter;
 - (instancetype)initFromFile:(NSString *)filePath;
 - (instancetype)initFromFile:(NSString *)filePath andConverter:(XConverter *)converter;
 
@@ -40,6 +56,7 @@
 - (BOOL)writeAttribute:(NSString *)name prefix:(NSString *)prefix NS:(NSString *)ns value:(NSString *)value;
 - (BOOL)writeAttributeXmlName:(const xmlChar *)xmlName value:(NSString *)value;
 - (BOOL)writeAttributeXmlName:(const xmlChar *)xmlName prefix:(const xmlChar *)xmlPrefix NS:(const xmlChar *)xmlNs value:(NSString *)value;
+- (BOOL)writeAttributeXmlName:(const xmlChar *)xmlName xmlValue:(const xmlChar *)xmlValue;
 
 - (BOOL)writeStartElement:(NSString *)name;
 - (BOOL)writeStartElement:(NSString *)name prefix:(NSString *)prefix NS:(NSString *)ns;
@@ -49,6 +66,7 @@
 
 - (BOOL)writeString:(NSString *)value;
 - (BOOL)writeRaw:(NSString *)xml;
+- (BOOL)writeRawXmlChars:(const xmlChar *)chars length:(size_t)length;
 
 - (xmlChar *)getXml;
 - (size_t)getLength;
@@ -51,6 +51,54 @@ xmlTextWriterPtr XAllocFileWriter(NSString *filePath)
     return xmlNewTextWriterFilename([filePath UTF8String], FALSE);
 }
 
+//
+// Where the output of a data writer goes
+//
+@interface XDataOutput : NSObject
+
+@property (nonatomic, strong) NSMutableData *data;
+@property (nonatomic, copy) void (^observer)(const void *bytes, NSUInteger length);
+
+@end
+
+@implementation XDataOutput
+
+@end
+
+static int XDataWriteCallback(void *context, const char *buffer, int length)
+{
+    XDataOutput *output = (__bridge XDataOutput *)context;
+    
+    [output.data appendBytes:buffer length:(NSUInteger)length];
+    
+    if (output.observer)
+    {
+        output.observer(buffer, (NSUInteger)length);
+    }
+    
+    return length;
+}
+
+//
+// The output is owned by the XWriter, which frees the text writer before releasing the output
+//
+xmlTextWriterPtr XAllocDataWriter(XDataOutput *dataOutput)
+{
+    xmlOutputBufferPtr output = xmlOutputBufferCreateIO(XDataWriteCallback, NULL, (__bridge void *)dataOutput, NULL);
+    if (!output)
+    {
+        return NULL;
+    }
+    
+    xmlTextWriterPtr writer = xmlNewTextWriter(output);
+    if (!writer)
+    {
+        xmlOutputBufferClose(output);
+    }
+    
+    return writer;
+}
+
 // ---------------------
 //
 // XWriter
@@ -60,6 +108,7 @@ xmlTextWriterPtr XAllocFileWriter(NSString *filePath)
 
 @property (readonly, nonatomic, assign) xmlTextWriterPtr writer;
 @property (nonatomic, assign) xmlBufferPtr buffer;
+@property (nonatomic, strong) XDataOutput *dataOutput;
 
 @end
 
@@ -135,6 +184,47 @@ xmlTextWriterPtr XAllocFileWriter(NSString *filePath)
     return [self initWithBufferSize:size andConverter:nil];
 }
 
+- (instancetype)initWithData:(NSMutableData *)data andConverter:(XConverter *)converter
+{
+    MHVCHECK_NOTNULL(data);
+    
+    XDataOutput *dataOutput = [XDataOutput new];
+    dataOutput.data = data;
+    
+    xmlTextWriterPtr writer = XAllocDataWriter(dataOutput);
+    if (!writer)
+    {
+        return nil;
+    }
+    
+    self = [self initWithWriter:writer buffer:NULL andConverter:converter];
+    if (!self)
+    {
+        xmlFreeTextWriter(writer);
+        return nil;
+    }
+    
+    _data = data;
+    _dataOutput = dataOutput;
+    
+    return self;
+}
+
+- (instancetype)initWithData:(NSMutableData *)data
+{
+    return [self initWithData:data andConverter:nil];
+}
+
+- (void (^)(const void *, NSUInteger))dataObserver
+{
+    return self.dataOutput.observer;
+}
+
+- (void)setDataObserver:(void (^)(const void *, NSUInteger))dataObserver
+{
+    self.dataOutput.observer = dataObserver;
+}
+
 - (instancetype)initFromFile:(NSString *)filePath andConverter:(XConverter *)converter
 {
     xmlTextWriterPtr writer = XAllocFileWriter(filePath);
@@ -250,6 +340,14 @@ xmlTextWriterPtr XAllocFileWriter(NSString *filePath)
     return [self isSuccess:xmlTextWriterWriteAttributeNS(self.writer, xmlPrefix, xmlName, xmlNs, xmlValue)];
 }
 
+- (BOOL)writeAttributeXmlName:(const xmlChar *)xmlName xmlValue:(const xmlChar *)xmlValue
+{
+    MHVCHECK_NOTNULL(xmlName);
+    MHVCHECK_NOTNULL(xmlValue);
+
+    return [self isSuccess:xmlTextWriterWriteAttribute(self.writer, xmlName, xmlValue)];
+}
+
 - (BOOL)writeStartElement:(NSString *)name
 {
     MHVASSERT_STRING(name);
@@ -312,9 +410,21 @@ xmlTextWriterPtr XAllocFileWriter(NSString *filePath)
     return [self isSuccess:xmlTextWriterWriteRaw(self.writer, xmlValue)];
 }
 
+- (BOOL)writeRawXmlChars:(const xmlChar *)chars length:(size_t)length
+{
+    MHVCHECK_NOTNULL(chars);
+
+    return [self isSuccess:xmlTextWriterWriteRawLen(self.writer, chars, (int)length)];
+}
+
 - (xmlChar *)getXml
 {
     [self flush];
+    if (self.data)
+    {
+        return (xmlChar *)self.data.mutableBytes;
+    }
+    
     if (self.buffer == nil)
     {
         return nil;
@@ -326,6 +436,11 @@ xmlTextWriterPtr XAllocFileWriter(NSString *filePath)
 - (size_t)getLength
 {
     [self flush];
+    if (self.data)
+    {
+        return self.data.length;
+    }
+    
     if (self.buffer == nil)
     {
         return 0;
@@ -337,6 +452,10 @@ xmlTextWriterPtr XAllocFileWriter(NSString *filePath)
 - (NSString *)newXmlString
 {
     [self flush];
+    if (self.data)
+    {
+        return [[NSString alloc] initWithData:self.data encoding:NSUTF8StringEncoding];
+    }
 
     return [[NSString alloc] initWithBytes:self.buffer->content length:self.buffer->use encoding:NSUTF8StringEncoding];
 }